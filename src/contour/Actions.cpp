@@ -31,6 +31,7 @@ optional<Action> fromString(string const& name)
         mapAction<actions::CancelSelection>("CancelSelection"),
         mapAction<actions::ChangeProfile>("ChangeProfile"),
         mapAction<actions::ClearHistoryAndReset>("ClearHistoryAndReset"),
+        mapAction<actions::CopyCommandOutput>("CopyCommandOutput"),
         mapAction<actions::CopyPreviousMarkRange>("CopyPreviousMarkRange"),
         mapAction<actions::CopySelection>("CopySelection"),
         mapAction<actions::CreateDebugDump>("CreateDebugDump"),
@@ -67,10 +68,12 @@ optional<Action> fromString(string const& name)
         mapAction<actions::ScrollToTop>("ScrollToTop"),
         mapAction<actions::ScrollUp>("ScrollUp"),
         mapAction<actions::SearchReverse>("SearchReverse"),
+        mapAction<actions::SelectCommandOutput>("SelectCommandOutput"),
         mapAction<actions::SendChars>("SendChars"),
         mapAction<actions::ToggleAllKeyMaps>("ToggleAllKeyMaps"),
         mapAction<actions::ToggleFullscreen>("ToggleFullscreen"),
         mapAction<actions::ToggleInputProtection>("ToggleInputProtection"),
+        mapAction<actions::TogglePerformanceTrace>("TogglePerformanceTrace"),
         mapAction<actions::ToggleStatusLine>("ToggleStatusLine"),
         mapAction<actions::ToggleTitleBar>("ToggleTitleBar"),
         mapAction<actions::TraceBreakAtEmptyQueue>("TraceBreakAtEmptyQueue"),
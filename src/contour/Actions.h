@@ -32,6 +32,7 @@ enum class CopyFormat : uint8_t
 struct CancelSelection{};
 struct ChangeProfile{ std::string name; };
 struct ClearHistoryAndReset{};
+struct CopyCommandOutput{};
 struct CopyPreviousMarkRange{};
 struct CopySelection{ CopyFormat format = CopyFormat::Text; };
 struct CreateDebugDump{};
@@ -68,10 +69,12 @@ struct ScrollToBottom{};
 struct ScrollToTop{};
 struct ScrollUp{};
 struct SearchReverse{};
+struct SelectCommandOutput{};
 struct SendChars{ std::string chars; };
 struct ToggleAllKeyMaps{};
 struct ToggleFullscreen{};
 struct ToggleInputProtection{};
+struct TogglePerformanceTrace{};
 struct ToggleStatusLine{};
 struct ToggleTitleBar{};
 struct TraceBreakAtEmptyQueue{};
@@ -94,6 +97,7 @@ struct SwitchToTabRight{};
 using Action = std::variant<CancelSelection,
                             ChangeProfile,
                             ClearHistoryAndReset,
+                            CopyCommandOutput,
                             CopyPreviousMarkRange,
                             CopySelection,
                             CreateDebugDump,
@@ -130,10 +134,12 @@ using Action = std::variant<CancelSelection,
                             ScrollToTop,
                             ScrollUp,
                             SearchReverse,
+                            SelectCommandOutput,
                             SendChars,
                             ToggleAllKeyMaps,
                             ToggleFullscreen,
                             ToggleInputProtection,
+                            TogglePerformanceTrace,
                             ToggleStatusLine,
                             ToggleTitleBar,
                             TraceBreakAtEmptyQueue,
@@ -165,6 +171,10 @@ namespace documentation
         "Clears the history, performs a terminal hard reset and attempts to force a redraw of the currently "
         "running application."
     };
+    constexpr inline std::string_view CopyCommandOutput {
+        "Copies the output of the most recently executed shell command into clipboard (requires shell "
+        "integration)."
+    };
     constexpr inline std::string_view CopyPreviousMarkRange {
         "Copies the most recent range that is delimited by vertical line marks into clipboard."
     };
@@ -236,6 +246,9 @@ namespace documentation
     constexpr inline std::string_view SearchReverse {
         "Initiates search mode (starting to search at current cursor position, moving upwards)."
     };
+    constexpr inline std::string_view SelectCommandOutput {
+        "Selects the output of the most recently executed shell command (requires shell integration)."
+    };
     constexpr inline std::string_view SendChars {
         "Writes given characters in `chars` member to the applications input."
     };
@@ -244,6 +257,9 @@ namespace documentation
                                                          "others)." };
     constexpr inline std::string_view ToggleFullscreen { "Enables/disables full screen mode." };
     constexpr inline std::string_view ToggleInputProtection { "Enables/disables terminal input protection." };
+    constexpr inline std::string_view TogglePerformanceTrace {
+        "Starts recording a performance timeline, or stops it and saves it in Chrome's trace event format."
+    };
     constexpr inline std::string_view ToggleStatusLine {
         "Shows/hides the VT320 compatible Indicator status line."
     };
@@ -288,6 +304,7 @@ inline auto getDocumentation()
         std::tuple { Action { CancelSelection {} }, documentation::CancelSelection },
         std::tuple { Action { ChangeProfile {} }, documentation::ChangeProfile },
         std::tuple { Action { ClearHistoryAndReset {} }, documentation::ClearHistoryAndReset },
+        std::tuple { Action { CopyCommandOutput {} }, documentation::CopyCommandOutput },
         std::tuple { Action { CopyPreviousMarkRange {} }, documentation::CopyPreviousMarkRange },
         std::tuple { Action { CopySelection {} }, documentation::CopySelection },
         std::tuple { Action { CreateDebugDump {} }, documentation::CreateDebugDump },
@@ -324,10 +341,12 @@ inline auto getDocumentation()
         std::tuple { Action { ScrollToTop {} }, documentation::ScrollToTop },
         std::tuple { Action { ScrollUp {} }, documentation::ScrollUp },
         std::tuple { Action { SearchReverse {} }, documentation::SearchReverse },
+        std::tuple { Action { SelectCommandOutput {} }, documentation::SelectCommandOutput },
         std::tuple { Action { SendChars {} }, documentation::SendChars },
         std::tuple { Action { ToggleAllKeyMaps {} }, documentation::ToggleAllKeyMaps },
         std::tuple { Action { ToggleFullscreen {} }, documentation::ToggleFullscreen },
         std::tuple { Action { ToggleInputProtection {} }, documentation::ToggleInputProtection },
+        std::tuple { Action { TogglePerformanceTrace {} }, documentation::TogglePerformanceTrace },
         std::tuple { Action { ToggleStatusLine {} }, documentation::ToggleStatusLine },
         std::tuple { Action { ToggleTitleBar {} }, documentation::ToggleTitleBar },
         std::tuple { Action { TraceBreakAtEmptyQueue {} }, documentation::TraceBreakAtEmptyQueue },
@@ -365,6 +384,7 @@ inline auto getDocumentation()
 DECLARE_ACTION_FMT(CancelSelection)
 DECLARE_ACTION_FMT(ChangeProfile)
 DECLARE_ACTION_FMT(ClearHistoryAndReset)
+DECLARE_ACTION_FMT(CopyCommandOutput)
 DECLARE_ACTION_FMT(CopyPreviousMarkRange)
 DECLARE_ACTION_FMT(CopySelection)
 DECLARE_ACTION_FMT(CreateDebugDump)
@@ -401,10 +421,12 @@ DECLARE_ACTION_FMT(ScrollToBottom)
 DECLARE_ACTION_FMT(ScrollToTop)
 DECLARE_ACTION_FMT(ScrollUp)
 DECLARE_ACTION_FMT(SearchReverse)
+DECLARE_ACTION_FMT(SelectCommandOutput)
 DECLARE_ACTION_FMT(SendChars)
 DECLARE_ACTION_FMT(ToggleAllKeyMaps)
 DECLARE_ACTION_FMT(ToggleFullscreen)
 DECLARE_ACTION_FMT(ToggleInputProtection)
+DECLARE_ACTION_FMT(TogglePerformanceTrace)
 DECLARE_ACTION_FMT(ToggleStatusLine)
 DECLARE_ACTION_FMT(ToggleTitleBar)
 DECLARE_ACTION_FMT(TraceBreakAtEmptyQueue)
@@ -457,6 +479,7 @@ struct std::formatter<contour::actions::Action>: std::formatter<std::string>
         HANDLE_ACTION(CancelSelection);
         HANDLE_ACTION(ChangeProfile);
         HANDLE_ACTION(ClearHistoryAndReset);
+        HANDLE_ACTION(CopyCommandOutput);
         HANDLE_ACTION(CopyPreviousMarkRange);
         HANDLE_ACTION(CopySelection);
         HANDLE_ACTION(CreateDebugDump);
@@ -492,10 +515,12 @@ struct std::formatter<contour::actions::Action>: std::formatter<std::string>
         HANDLE_ACTION(ScrollToTop);
         HANDLE_ACTION(ScrollUp);
         HANDLE_ACTION(SearchReverse);
+        HANDLE_ACTION(SelectCommandOutput);
         HANDLE_ACTION(SendChars);
         HANDLE_ACTION(ToggleAllKeyMaps);
         HANDLE_ACTION(ToggleFullscreen);
         HANDLE_ACTION(ToggleInputProtection);
+        HANDLE_ACTION(TogglePerformanceTrace);
         HANDLE_ACTION(ToggleStatusLine);
         HANDLE_ACTION(ToggleTitleBar);
         HANDLE_ACTION(TraceBreakAtEmptyQueue);
@@ -317,7 +317,9 @@ bool captureScreen(CaptureSettings const& settings)
         output = *customOutput;
     }
 
-    if (tty.write(std::format("\033[>{};{}t", settings.logicalLines ? '1' : '0', settings.lineCount)) < 0)
+    auto const mode = settings.commandCount != 0 ? '2' : settings.logicalLines ? '1' : '0';
+    auto const count = settings.commandCount != 0 ? settings.commandCount : settings.lineCount.as<unsigned>();
+    if (tty.write(std::format("\033[>{};{}t", mode, count)) < 0)
     {
         cerr << "Could not request screen capture.\r\n";
         return false;
@@ -16,6 +16,7 @@ struct CaptureSettings
     std::string outputFile;    // -o <outputfile>
     int verbosityLevel = 0;    // -v, -q (XXX intentionally not parsed currently!)
     vtbackend::LineCount lineCount = vtbackend::LineCount { 0 }; // (use terminal default)
+    unsigned commandCount = 0; // capture the output of that many recent commands instead of lines
 };
 
 bool captureScreen(CaptureSettings const& settings);
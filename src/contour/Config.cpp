@@ -355,6 +355,7 @@ void YAMLConfigReader::load(Config& c)
         loadFromEntry("early_exit_threshold", c.earlyExitThreshold);
         loadFromEntry("spawn_new_process", c.spawnNewProcess);
         loadFromEntry("reflow_on_resize", c.reflowOnResize);
+        loadFromEntry("lazy_history_reflow", c.lazyHistoryReflow);
         loadFromEntry("experimental", c.experimentalFeatures);
         loadFromEntry("bypass_mouse_protocol_modifier", c.bypassMouseProtocolModifiers);
         loadFromEntry("on_mouse_select", c.onMouseSelection);
@@ -827,6 +828,7 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
         loadFromEntry(child, "public_key", where.publicKeyFile);
         loadFromEntry(child, "known_hosts", where.publicKeyFile);
         loadFromEntry(child, "forward_agent", where.forwardAgent);
+        loadFromEntry(child, "compression", where.compression);
     }
 }
 
@@ -1322,6 +1324,7 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
         loadFromEntry(child, "locator", where.fontLocator);
         loadFromEntry(child, "text_shaping.engine", where.textShapingEngine);
         loadFromEntry(child, "builtin_box_drawing", where.builtinBoxDrawing);
+        loadFromEntry(child, "builtin_braille", where.builtinBraille);
         loadFromEntry(child, "render_mode", where.renderMode);
         loadFromEntry(child, "regular", where.regular);
 
@@ -379,6 +379,7 @@ const inline vtrasterizer::FontDescriptions defaultFont = vtrasterizer::FontDesc
     .textShapingEngine = vtrasterizer::TextShapingEngine::OpenShaper,
     .fontLocator = vtrasterizer::FontLocatorEngine::Native,
     .builtinBoxDrawing = true,
+    .builtinBraille = true,
 };
 
 struct TerminalProfile
@@ -762,6 +763,7 @@ struct Config
     };
     ConfigEntry<bool, documentation::SpawnNewProcess> spawnNewProcess { false };
     ConfigEntry<bool, documentation::ReflowOnResize> reflowOnResize { true };
+    ConfigEntry<bool, documentation::LazyHistoryReflow> lazyHistoryReflow { true };
     ConfigEntry<vtbackend::Modifiers, documentation::BypassMouseProtocolModifiers>
         bypassMouseProtocolModifiers { vtbackend::Modifier::Shift };
     ConfigEntry<vtbackend::Modifiers, documentation::MouseBlockSelectionModifiers>
@@ -1128,6 +1130,7 @@ struct Writer
                       v.fontLocator,
                       v.textShapingEngine,
                       v.builtinBoxDrawing,
+                      v.builtinBraille,
                       v.renderMode,
                       "true",
                       v.regular.familyName,
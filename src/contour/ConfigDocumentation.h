@@ -92,6 +92,11 @@ constexpr StringLiteral SshHostConfigConfig {
     "{comment}     {comment} Default value currently is `false` (agent forwarding disabled),\n"
     "{comment}     {comment} and is for security reasons also the recommended way.\n"
     "{comment}     forward_agent: false\n"
+    "{comment}\n"
+    "{comment}     {comment} Mandates whether or not to compress the SSH transport.\n"
+    "{comment}     {comment} This may speed up bulk output over slow links, but costs CPU time on both "
+    "ends.\n"
+    "{comment}     compression: false\n"
     "\n"
 };
 
@@ -263,6 +268,11 @@ constexpr StringLiteral FontsConfig {
     "    {comment} will be used (Default: true).\n"
     "    builtin_box_drawing: {}\n"
     "\n"
+    "    {comment} Uses builtin textures for pixel-perfect Braille patterns (U+2800..U+28FF).\n"
+    "    {comment} If disabled, the font's provided Braille glyphs will be used,\n"
+    "    {comment} regardless of builtin_box_drawing (Default: true).\n"
+    "    builtin_braille: {}\n"
+    "\n"
     "    {comment} Font render modes tell the font rasterizer engine what rendering technique to use.\n"
     "    {comment}\n"
     "    {comment} Modes available are:\n"
@@ -579,6 +589,13 @@ constexpr StringLiteral ReflowOnResizeConfig {
     "reflow_on_resize: {} \n"
 };
 
+constexpr StringLiteral LazyHistoryReflowConfig {
+    "\n"
+    "{comment} Whether or not to reflow the scrollback lines only once they are needed, \n"
+    "{comment} such as when they are scrolled into view or searched, rather than right on resize. \n"
+    "lazy_history_reflow: {} \n"
+};
+
 constexpr StringLiteral ColorSchemesConfig {
     "{comment} Color Profiles\n"
     "{comment} --------------\n"
@@ -726,6 +743,8 @@ constexpr StringLiteral InputMappingsConfig {
     "{comment} - ClearHistoryAndReset    Clears the history, performs a terminal hard reset and attempts "
     "to "
     "force a redraw of the currently running application.\n"
+    "{comment} - CopyCommandOutput Copies the output of the most recently executed shell command into "
+    "clipboard (requires shell integration).\n"
     "{comment} - CopyPreviousMarkRange   Copies the most recent range that is delimited by vertical line "
     "marks "
     "into clipboard.\n"
@@ -782,6 +801,8 @@ constexpr StringLiteral InputMappingsConfig {
     "{comment} - SearchReverse     Initiates search mode (starting to search at current cursor position, "
     "moving "
     "upwards).\n"
+    "{comment} - SelectCommandOutput Selects the output of the most recently executed shell command "
+    "(requires shell integration).\n"
     "{comment} - SendChars         Writes given characters in `chars` member to the applications input.\n"
     "{comment} - SwitchToTab       Switches to the tab position, given by extra parameter \"position\".\n"
     "{comment}                     The positions start at number 1.\n"
@@ -795,6 +816,8 @@ constexpr StringLiteral InputMappingsConfig {
     "when disabling all others).\n"
     "{comment} - ToggleFullScreen  Enables/disables full screen mode.\n"
     "{comment} - ToggleInputProtection Enables/disables terminal input protection.\n"
+    "{comment} - TogglePerformanceTrace Starts recording a performance timeline, or stops it and saves it "
+    "in Chrome's trace event format.\n"
     "{comment} - ToggleStatusLine  Shows/hides the VT320 compatible Indicator status line.\n"
     "{comment} - ToggleTitleBar    Shows/Hides titlebar\n"
     "{comment} - TraceBreakAtEmptyQueue Executes any pending VT sequence from the VT sequence buffer in "
@@ -1098,6 +1121,12 @@ constexpr StringLiteral ReflowOnResizeWeb {
     "The default value is `true`."
 };
 
+constexpr StringLiteral LazyHistoryReflowWeb {
+    "option controls whether or not the scrollback lines are reflowed only once they are needed, "
+    "such as when they are scrolled into view or searched, rather than right when a resize event occurs. "
+    "The default value is `true`."
+};
+
 constexpr StringLiteral BypassMouseProtocolModifiersWeb {
     "option specifies the keyboard modifier (e.g., Shift) that can be used to bypass the terminal's mouse "
     "protocol and select screen content."
@@ -1182,6 +1211,7 @@ constexpr StringLiteral SshHostConfigWeb {
     "      public_key: \"path/to/key.pub\"\n"
     "      known_hosts: \"~/.ssh/known_hosts\"\n"
     "      forward_agent: false\n"
+    "      compression: false\n"
     "```\n"
     "\n"
     "Note, only `host` option is required. Everything else is defaulted.\n"
@@ -1202,6 +1232,8 @@ constexpr StringLiteral SshHostConfigWeb {
     ":octicons-horizontal-rule-16: ==ssh.forward_agent== Boolean, indicating wether or not the local SSH "
     "auth agent should be requested to be forwarded. Note: this is currently not working due to an issue "
     "related to the underlying library being used, but is hopefully resolved soon.\n"
+    ":octicons-horizontal-rule-16: ==ssh.compression== Boolean, indicating whether or not the SSH transport "
+    "should be compressed. This can speed up bulk output over slow links. Defaults to `false`.\n"
     "\n"
     "Note, custom environment variables may be passed as well, when connecting to an SSH server using this "
     "builtin-feature. Mind,\n"
@@ -1405,6 +1437,7 @@ constexpr StringLiteral FontsWeb {
     "      text_shaping:\n"
     "        engine: native\n"
     "      builtin_box_drawing: true\n"
+    "      builtin_braille: true\n"
     "      render_mode: gray\n"
     "      strict_spacing: true\n"
     "      regular:\n"
@@ -1427,6 +1460,9 @@ constexpr StringLiteral FontsWeb {
     ":octicons-horizontal-rule-16: ==builtin_box_drawing== Specifies whether to use built-in textures for "
     "pixel-perfect box drawing. If disabled, the font's provided box drawing characters will be used. The "
     "default value is true.<br/>\n"
+    ":octicons-horizontal-rule-16: ==builtin_braille== Specifies whether to use built-in textures for "
+    "Braille patterns (U+2800..U+28FF). If disabled, the font's provided Braille glyphs will be used. The "
+    "default value is true.<br/>\n"
     ":octicons-horizontal-rule-16: ==render_mode== Specifies the font render mode, which tells the font "
     "rasterizer engine what rendering technique to use. Available modes are lcd, light, gray, and "
     "monochrome.  <br/>\n"
@@ -1776,6 +1812,7 @@ using Renderer = DocumentationEntry<RendererConfig, RendererWeb>;
 using PTYReadBufferSize = DocumentationEntry<PTYReadBufferSizeConfig, PTYReadBufferSizeWeb>;
 using PTYBufferObjectSize = DocumentationEntry<PTYBufferObjectSizeConfig, PTYBufferObjectSizeWeb>;
 using ReflowOnResize = DocumentationEntry<ReflowOnResizeConfig, ReflowOnResizeWeb>;
+using LazyHistoryReflow = DocumentationEntry<LazyHistoryReflowConfig, LazyHistoryReflowWeb>;
 using ColorSchemes = DocumentationEntry<ColorSchemesConfig, Dummy>;
 using Profiles = DocumentationEntry<ProfilesConfig, ProfilesWeb>;
 using DefaultProfiles = DocumentationEntry<StringLiteral { "default_profile: {}\n" }, DefaultProfilesWeb>;
@@ -304,6 +304,7 @@ pty_buffer_size: 1048576
 default_profile: main
 spawn_new_process: false
 reflow_on_resize: true
+lazy_history_reflow: true
 bypass_mouse_protocol_modifier: Shift
 mouse_block_selection_modifier: Control
 on_mouse_select: CopyToSelectionClipboard
@@ -458,6 +459,7 @@ int ContourApp::captureAction()
     captureSettings.words = parameters().get<bool>("contour.capture.words");
     captureSettings.timeout = parameters().get<double>("contour.capture.timeout");
     captureSettings.lineCount = vtbackend::LineCount::cast_from(parameters().get<unsigned>("contour.capture.lines"));
+    captureSettings.commandCount = parameters().get<unsigned>("contour.capture.commands");
     captureSettings.outputFile = parameters().get<string>("contour.capture.to");
     // clang-format on
 
@@ -591,6 +593,11 @@ crispy::cli::command ContourApp::parameterDefinition() const
                                   "Sets timeout seconds to wait for terminal to respond.",
                                   "SECONDS" },
                     CLI::option { "lines", CLI::value { 0u }, "The number of lines to capture", "COUNT" },
+                    CLI::option { "commands",
+                                  CLI::value { 0u },
+                                  "Captures the output of the given number of most recently executed "
+                                  "commands instead of lines. This requires shell integration.",
+                                  "COUNT" },
                     CLI::option { "to",
                                   CLI::value { ""s },
                                   "Output file name to store the screen capture to. If - (dash) is given, "
@@ -9,6 +9,7 @@
 
 #include <crispy/CLI.h>
 #include <crispy/logstore.h>
+#include <crispy/trace.h>
 #include <crispy/utils.h>
 
 #include <QtCore/QProcess>
@@ -112,6 +113,11 @@ crispy::cli::command ContourGuiApp::parameterDefinition() const
                     CLI::value { ""s },
                     "Dumps internal state at exit into the given directory. This is for debugging contour.",
                     "PATH" },
+                CLI::option { "trace",
+                              CLI::value { ""s },
+                              "Records a performance timeline from startup on, and writes it in Chrome's "
+                              "trace event format (viewable with Perfetto) into the given file at exit.",
+                              "FILE" },
                 CLI::option { "early-exit-threshold",
                               CLI::value { -1 },
                               "If the spawned process exits earlier than the given threshold seconds, an "
@@ -345,6 +351,10 @@ int ContourGuiApp::terminalGuiAction()
     if (!loadConfig("terminal"))
         return EXIT_FAILURE;
 
+    auto const traceFilePath = parameters().get<string>("contour.terminal.trace");
+    if (!traceFilePath.empty())
+        crispy::trace::start();
+
 #if defined(__APPLE__)
     QGuiApplication::setAttribute(Qt::AA_MacDontSwapCtrlAndMeta, true);
 #endif
@@ -478,6 +488,13 @@ int ContourGuiApp::terminalGuiAction()
 
     auto rv = QApplication::exec();
 
+    if (!traceFilePath.empty())
+    {
+        crispy::trace::stop();
+        if (!crispy::trace::save_chrome_trace(traceFilePath))
+            errorLog()("Failed to write performance trace to {}.", traceFilePath);
+    }
+
     if (_exitStatus.has_value())
     {
 #if defined(VTPTY_LIBSSH2)
@@ -15,6 +15,7 @@
 
 #include <crispy/StackTrace.h>
 #include <crispy/assert.h>
+#include <crispy/trace.h>
 #include <crispy/utils.h>
 
 #include <QtCore/QDebug>
@@ -71,6 +72,24 @@ namespace
         return std::format("{}: Unhandled exception caught ({}). {}", where, typeid(e).name(), e.what());
     }
 
+    // Selections spanning more lines than this are copied to the clipboard on a worker thread.
+    constexpr auto AsyncSelectionCopyLineThreshold = 10'000;
+
+    // Delay before retrying to write pending input to a PTY that cannot notify about being writable.
+    constexpr auto FlushInputRetryDelay = chrono::milliseconds(10);
+
+    struct PendingSelectionCopy
+    {
+        string text;
+        weak_ptr<SelectionTextExtraction> extraction;
+    };
+
+    void setClipboardText(string const& text, QClipboard::Mode mode)
+    {
+        if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
+            clipboard->setText(QString::fromUtf8(text.data(), static_cast<int>(text.size())), mode);
+    }
+
     void setThreadName(char const* name)
     {
 #if defined(__APPLE__)
@@ -154,6 +173,7 @@ namespace
         if (auto const* p = preferredColorPalette(profile.colors.value(), colorPreference))
             settings.colorPalette = *p;
         settings.primaryScreen.allowReflowOnResize = config.reflowOnResize.value();
+        settings.primaryScreen.lazyHistoryReflow = config.lazyHistoryReflow.value();
         settings.highlightDoubleClickedWord = profile.highlightDoubleClickedWord.value();
         settings.highlightTimeout = profile.highlightTimeout.value();
         settings.frozenModes = profile.frozenModes.value();
@@ -225,6 +245,12 @@ TerminalSession::~TerminalSession()
     sessionLog()("Destroying terminal session.");
     _terminating = true;
     _terminal.device().wakeupReader();
+    if (_selectionCopy)
+    {
+        _selectionCopy->cancel();
+        _selectionCopy->wait();
+        crispy::locked(_terminal, [this]() { _selectionCopy->releaseSnapshot(); });
+    }
     if (_exitWatcherThread->isRunning())
         _exitWatcherThread->terminate();
     if (_screenUpdateThread)
@@ -350,11 +376,39 @@ void TerminalSession::screenUpdated()
 
 void TerminalSession::flushInput()
 {
-    terminal().flushInput();
-    if (terminal().hasInput() && _display)
+    if (!terminal().flushInput())
+        flushInputWhenWritable();
+    else if (terminal().hasInput() && _display)
         _display->post(bind(&TerminalSession::flushInput, this));
 }
 
+// Retries flushing the pending input once the PTY accepts input again, rather than spinning on it.
+void TerminalSession::flushInputWhenWritable()
+{
+    if (QThread::currentThread() != thread())
+    {
+        postToObject(this, [this]() { flushInputWhenWritable(); });
+        return;
+    }
+
+    if (!_ptyWritableNotifier)
+    {
+        auto const handle = terminal().device().writeNotificationHandle();
+        if (!handle)
+        {
+            QTimer::singleShot(FlushInputRetryDelay, this, [this]() { flushInput(); });
+            return;
+        }
+        _ptyWritableNotifier =
+            make_unique<QSocketNotifier>(static_cast<qintptr>(*handle), QSocketNotifier::Write);
+        connect(_ptyWritableNotifier.get(), &QSocketNotifier::activated, this, [this]() {
+            _ptyWritableNotifier->setEnabled(false);
+            flushInput();
+        });
+    }
+    _ptyWritableNotifier->setEnabled(true);
+}
+
 void TerminalSession::renderBufferUpdated()
 {
     if (!_display)
@@ -429,12 +483,12 @@ void TerminalSession::updateColorPreference(vtbackend::ColorPreference preferenc
     }
 }
 
-void TerminalSession::requestCaptureBuffer(LineCount lines, bool logical)
+void TerminalSession::requestCaptureBuffer(CaptureBufferMode mode, int count)
 {
     if (!_display)
         return;
 
-    _pendingBufferCapture = CaptureBufferRequest { .lines = lines, .logical = logical };
+    _pendingBufferCapture = CaptureBufferRequest { .mode = mode, .count = count };
 
     emit requestPermissionForBufferCapture();
     // _display->post(
@@ -455,7 +509,7 @@ void TerminalSession::executePendingBufferCapture(bool allow, bool remember)
     if (!allow)
         return;
 
-    _terminal.primaryScreen().captureBuffer(capture.lines, capture.logical);
+    _terminal.primaryScreen().captureBuffer(capture.mode, capture.count);
 
     displayLog()("requestCaptureBuffer: Finished. Waking up I/O thread.");
     flushInput();
@@ -691,6 +745,8 @@ void TerminalSession::pasteFromClipboard(unsigned count, bool strip)
                 fullPaste += strippedText;
             terminal().sendPaste(string_view { fullPaste });
         }
+        // Large pastes are written in bounded chunks, keep flushing until all is written.
+        flushInput();
     }
     else
         sessionLog()("Could not access clipboard.");
@@ -714,6 +770,7 @@ void TerminalSession::applyPendingPaste(bool allow, bool remember)
     auto* clipboard = _pendingBigPaste.value();
     auto text = clipboard->text(QClipboard::Clipboard);
     terminal().sendPaste(string_view { text.toStdString() });
+    flushInput();
 }
 
 void TerminalSession::onSelectionCompleted()
@@ -723,24 +780,73 @@ void TerminalSession::onSelectionCompleted()
         case config::SelectionAction::CopyToSelectionClipboard:
             if (QClipboard* clipboard = QGuiApplication::clipboard();
                 clipboard != nullptr && clipboard->supportsSelection())
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Selection);
-            }
-            break;
-        case config::SelectionAction::CopyToClipboard:
-            if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Clipboard);
-            }
+                copySelectionToClipboard(QClipboard::Selection);
             break;
+        case config::SelectionAction::CopyToClipboard: copySelectionToClipboard(QClipboard::Clipboard); break;
         case config::SelectionAction::Nothing: break;
     }
 }
 
+void TerminalSession::copySelectionToClipboard(QClipboard::Mode mode)
+{
+    discardSelectionCopy();
+
+    auto const* selection = terminal().selector();
+    if (!selection)
+        return;
+
+    auto const lineCount = std::abs(unbox(selection->to().line) - unbox(selection->from().line)) + 1;
+    if (lineCount <= AsyncSelectionCopyLineThreshold)
+    {
+        setClipboardText(terminal().extractSelectionText(), mode);
+        return;
+    }
+
+    // Huge selections are assembled in the background, so that neither the GUI nor the terminal
+    // is blocked meanwhile. The clipboard is only updated once the full text is available.
+    auto pending = make_shared<PendingSelectionCopy>();
+    _selectionCopy = terminal().extractSelectionTextAsync([this, pending, mode](string chunk, bool last) {
+        pending->text += chunk;
+        if (!last)
+        {
+            postToObject(this, [this]() { emit selectionCopyProgressChanged(); });
+            return;
+        }
+        postToObject(this, [this, pending, mode]() {
+            if (auto const extraction = pending->extraction.lock(); extraction && !extraction->cancelled())
+            {
+                setClipboardText(pending->text, mode);
+                sessionLog()("Copied {} bytes of selected text to the clipboard.", pending->text.size());
+                extraction->wait();
+                crispy::locked(_terminal, [&]() { extraction->releaseSnapshot(); });
+            }
+            emit selectionCopyProgressChanged();
+        });
+    });
+    pending->extraction = _selectionCopy;
+    emit selectionCopyProgressChanged();
+}
+
+void TerminalSession::cancelSelectionCopy()
+{
+    crispy::locked(_terminal, [this]() { discardSelectionCopy(); });
+}
+
+// Cancels the selection copy in flight, if any, while the terminal is locked by the caller,
+// as the snapshotted lines may only be released while holding the terminal lock.
+void TerminalSession::discardSelectionCopy()
+{
+    if (!_selectionCopy)
+        return;
+
+    // The worker invokes the sink, which refers to this session, until it has noticed the cancellation.
+    _selectionCopy->cancel();
+    _selectionCopy->wait();
+    _selectionCopy->releaseSnapshot();
+    _selectionCopy.reset();
+    emit selectionCopyProgressChanged();
+}
+
 void TerminalSession::requestWindowResize(LineCount lines, ColumnCount columns)
 {
     if (!_display)
@@ -1030,6 +1136,12 @@ bool TerminalSession::operator()(actions::ClearHistoryAndReset)
     return true;
 }
 
+bool TerminalSession::operator()(actions::CopyCommandOutput)
+{
+    crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractCommandOutput(0)); });
+    return true;
+}
+
 bool TerminalSession::operator()(actions::CopyPreviousMarkRange)
 {
     crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractLastMarkRange()); });
@@ -1043,7 +1155,7 @@ bool TerminalSession::operator()(actions::CopySelection copySelection)
     {
         case actions::CopyFormat::Text:
             // Copy the selection in pure text, plus whitespaces and newline.
-            crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractSelectionText()); });
+            crispy::locked(_terminal, [&]() { copySelectionToClipboard(QClipboard::Clipboard); });
             break;
         case actions::CopyFormat::HTML:
             // TODO: This requires walking through each selected cell and construct HTML+CSS for it.
@@ -1210,6 +1322,7 @@ bool TerminalSession::operator()(actions::PasteSelection paste)
             terminal().sendRawInput(string_view { text + "\n" });
         else
             terminal().sendPaste(string_view { text });
+        flushInput();
     }
 
     return true;
@@ -1351,6 +1464,11 @@ bool TerminalSession::operator()(actions::SearchReverse)
     return true;
 }
 
+bool TerminalSession::operator()(actions::SelectCommandOutput)
+{
+    return crispy::locked(_terminal, [&]() { return terminal().selectCommandOutput(0); });
+}
+
 bool TerminalSession::operator()(actions::SendChars const& event)
 {
     // auto const now = steady_clock::now();
@@ -1389,6 +1507,31 @@ bool TerminalSession::operator()(actions::ToggleInputProtection)
     return true;
 }
 
+bool TerminalSession::operator()(actions::TogglePerformanceTrace)
+{
+    if (!crispy::trace::is_recording())
+    {
+        crispy::trace::start();
+        sessionLog()("Recording performance trace.");
+        return true;
+    }
+
+    crispy::trace::stop();
+
+    auto const savePath =
+        app().dumpStateAtExit().value_or(crispy::app::instance()->localStateDir())
+        / fs::path(std::format("contour-trace-{:%Y-%m-%d-%H-%M-%S}.json", chrono::system_clock::now()));
+    auto const message = crispy::trace::save_chrome_trace(savePath)
+                             ? std::format("Saved performance trace to {}", savePath.string())
+                             : std::format("Failed to save performance trace to {}", savePath.string());
+    sessionLog()(message);
+
+    _display->post([this, message]() {
+        emit showNotification("Performance trace", QString::fromStdString(message));
+    });
+    return true;
+}
+
 bool TerminalSession::operator()(actions::ToggleStatusLine)
 {
     auto const l = scoped_lock { _terminal };
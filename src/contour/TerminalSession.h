@@ -14,7 +14,9 @@
 
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QFileSystemWatcher>
+#include <QtCore/QSocketNotifier>
 #include <QtCore/QThread>
+#include <QtGui/QClipboard>
 #include <QtQml/QJSValue>
 
 #include <cstdint>
@@ -80,6 +82,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     Q_PROPERTY(int fontSize READ getFontSize)
     Q_PROPERTY(int upTime READ getUptime)
     Q_PROPERTY(QString bellSource READ getBellSource NOTIFY onBell)
+    Q_PROPERTY(float selectionCopyProgress READ getSelectionCopyProgress NOTIFY selectionCopyProgressChanged)
 
     // Q_PROPERTY(QString profileName READ profileName NOTIFY profileNameChanged)
 
@@ -108,6 +111,12 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     }
 
     int getFontSize() const noexcept { return static_cast<int>(_profile.fonts.value().size.pt); }
+    /// Progress of the selection currently being copied in the background, or 1.0 if there is none.
+    float getSelectionCopyProgress() const noexcept
+    {
+        return _selectionCopy && !_selectionCopy->finished() ? _selectionCopy->progress() : 1.0f;
+    }
+
     float getOpacity() const noexcept
     {
         return static_cast<float>(_profile.background.value().opacity) / std::numeric_limits<uint8_t>::max();
@@ -246,12 +255,13 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     Q_INVOKABLE void executePendingBufferCapture(bool allow, bool remember);
     Q_INVOKABLE void executeShowHostWritableStatusLine(bool allow, bool remember);
     Q_INVOKABLE void resizeTerminalToDisplaySize();
+    Q_INVOKABLE void cancelSelectionCopy();
 
     void updateColorPreference(vtbackend::ColorPreference preference);
 
     // vtbackend::Events
     //
-    void requestCaptureBuffer(vtbackend::LineCount lines, bool logical) override;
+    void requestCaptureBuffer(vtbackend::CaptureBufferMode mode, int count) override;
     void bell() override;
     void bufferChanged(vtbackend::ScreenType) override;
     void renderBufferUpdated() override;
@@ -307,6 +317,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool operator()(actions::CancelSelection);
     bool operator()(actions::ChangeProfile const&);
     bool operator()(actions::ClearHistoryAndReset);
+    bool operator()(actions::CopyCommandOutput);
     bool operator()(actions::CopyPreviousMarkRange);
     bool operator()(actions::CopySelection);
     bool operator()(actions::CreateDebugDump);
@@ -343,10 +354,12 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool operator()(actions::ScrollToTop);
     bool operator()(actions::ScrollUp);
     bool operator()(actions::SearchReverse);
+    bool operator()(actions::SelectCommandOutput);
     bool operator()(actions::SendChars const& event);
     bool operator()(actions::ToggleAllKeyMaps);
     bool operator()(actions::ToggleFullscreen);
     bool operator()(actions::ToggleInputProtection);
+    bool operator()(actions::TogglePerformanceTrace);
     bool operator()(actions::ToggleStatusLine);
     bool operator()(actions::ToggleTitleBar);
     bool operator()(actions::TraceBreakAtEmptyQueue);
@@ -407,6 +420,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     void requestPermissionForShowHostWritableStatusLine();
     void showNotification(QString const& title, QString const& content);
     void fontSizeChanged();
+    void selectionCopyProgressChanged();
 
     // Tab handling signals
     void createNewTab();
@@ -437,7 +451,10 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     void configureCursor(config::CursorConfig const& cursorConfig);
     uint8_t matchModeFlags() const;
     void flushInput();
+    void flushInputWhenWritable();
     void mainLoop();
+    void copySelectionToClipboard(QClipboard::Mode mode);
+    void discardSelectionCopy();
 
     // private data
     //
@@ -458,6 +475,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     display::TerminalDisplay* _display = nullptr;
 
     std::unique_ptr<QFileSystemWatcher> _configFileChangeWatcher;
+    std::unique_ptr<QSocketNotifier> _ptyWritableNotifier; // armed while the PTY does not accept input
 
     bool _terminating = false;
     std::thread::id _mainLoopThreadID {};
@@ -475,12 +493,13 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
 
     struct CaptureBufferRequest
     {
-        vtbackend::LineCount lines;
-        bool logical;
+        vtbackend::CaptureBufferMode mode;
+        int count;
     };
     std::optional<CaptureBufferRequest> _pendingBufferCapture;
     std::optional<vtbackend::FontDef> _pendingFontChange;
     std::optional<QClipboard*> _pendingBigPaste;
+    std::shared_ptr<vtbackend::SelectionTextExtraction> _selectionCopy;
     PermissionCache _rememberedPermissions;
     std::unique_ptr<QThread> _exitWatcherThread;
 
@@ -11,6 +11,7 @@
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/defines.h>
+#include <crispy/trace.h>
 #include <crispy/utils.h>
 
 #include <range/v3/all.hpp>
@@ -22,8 +23,11 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstddef>
+#include <format>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <utility>
 #include <vector>
 
@@ -114,6 +118,64 @@ namespace
         return mat;
     }
 
+    // Appends the two triangles of a textured rectangle to the given vertex buffer.
+    //
+    // @param x, y     target position
+    // @param r, s     target width and height
+    // @param texture  normalized texture coordinates of the source rectangle
+    // @param u        fragment shader selector
+    // @param color    color associated with the texture
+    void appendTexturedQuad(vector<GLfloat>& buffer,
+                            GLfloat x,
+                            GLfloat y,
+                            GLfloat r,
+                            GLfloat s,
+                            atlas::NormalizedTileLocation const& texture,
+                            GLfloat u,
+                            std::array<float, 4> const& color)
+    {
+        auto const z = ZAxisDepths::Text;
+
+        // normalized TexCoords
+        GLfloat const nx = texture.x;
+        GLfloat const ny = texture.y;
+        GLfloat const nw = texture.width;
+        GLfloat const nh = texture.height;
+
+        // These two are currently not used.
+        // This used to be used for the z-plane into the 3D texture,
+        // but I've reverted back to a 2D texture atlas for now.
+        GLfloat const i = 0;
+
+        // color
+        GLfloat const cr = color[0];
+        GLfloat const cg = color[1];
+        GLfloat const cb = color[2];
+        GLfloat const ca = color[3];
+
+        // clang-format off
+        GLfloat const vertices[6 * 11] = {
+            // first triangle
+        // <X      Y      Z> <X        Y        I  U>  <R   G   B   A>
+            x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
+            x,     y,     z,  nx,      ny,      i, u,  cr, cg, cb, ca, // left bottom
+            x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
+
+            // second triangle
+            x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
+            x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
+            x + r, y + s, z,  nx + nw, ny + nh, i, u,  cr, cg, cb, ca, // right top
+
+            // buffer contains
+            // - 3 vertex coordinates (XYZ)
+            // - 4 texture coordinates (XYIU), I is unused currently, U selects which texture to use
+            // - 4 color values (RGBA)
+        };
+        // clang-format on
+
+        crispy::copy(vertices, back_inserter(buffer));
+    }
+
     GLenum glFormat(vtbackend::ImageFormat format)
     {
         switch (format)
@@ -168,6 +230,7 @@ namespace
  */
 
 OpenGLRenderer::OpenGLRenderer(ShaderConfig textShaderConfig,
+                               ShaderConfig textInstancedShaderConfig,
                                ShaderConfig rectShaderConfig,
                                vtbackend::ImageSize viewSize,
                                vtbackend::ImageSize targetSurfaceSize,
@@ -177,6 +240,7 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig textShaderConfig,
     _viewSize { viewSize },
     _margin { margin },
     _textShaderConfig { std::move(textShaderConfig) },
+    _textInstancedShaderConfig { std::move(textInstancedShaderConfig) },
     _rectShaderConfig { std::move(rectShaderConfig) }
 {
     displayLog()("OpenGLRenderer: Constructing with render size {}.", _renderTargetSize);
@@ -274,7 +338,43 @@ void OpenGLRenderer::initializeTextureRendering()
     // static const GLuint indices[6] = { 0, 1, 3, 1, 2, 3 };
     // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-    // glVertexAttribDivisor(0, 1); // TODO: later for instanced rendering
+    CHECKED_GL(glBindVertexArray(0));
+}
+
+void OpenGLRenderer::initializeInstancedTextureRendering()
+{
+    CHECKED_GL(glGenVertexArrays(1, &_textInstancedVAO));
+    CHECKED_GL(glBindVertexArray(_textInstancedVAO));
+
+    CHECKED_GL(glGenBuffers(1, &_textInstancedVBO));
+    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _textInstancedVBO));
+    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
+
+    constexpr auto const BufferStride = static_cast<GLsizei>(sizeof(RenderTileInstance));
+    const auto* const PositionOffset = (void const*) offsetof(RenderTileInstance, x);         // NOLINT
+    const auto* const TileLocationOffset = (void const*) offsetof(RenderTileInstance, tileX); // NOLINT
+    const auto* const ExtentOffset = (void const*) offsetof(RenderTileInstance, extent);      // NOLINT
+    const auto* const ColorOffset = (void const*) offsetof(RenderTileInstance, rgba);         // NOLINT
+
+    // 0 (ivec2): target position
+    CHECKED_GL(glVertexAttribIPointer(0, 2, GL_SHORT, BufferStride, PositionOffset));
+    CHECKED_GL(glEnableVertexAttribArray(0));
+    CHECKED_GL(glVertexAttribDivisor(0, 1));
+
+    // 1 (uvec2): tile location in the texture atlas
+    CHECKED_GL(glVertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, BufferStride, TileLocationOffset));
+    CHECKED_GL(glEnableVertexAttribArray(1));
+    CHECKED_GL(glVertexAttribDivisor(1, 1));
+
+    // 2 (uint): bitmap extent and fragment shader selector
+    CHECKED_GL(glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, BufferStride, ExtentOffset));
+    CHECKED_GL(glEnableVertexAttribArray(2));
+    CHECKED_GL(glVertexAttribDivisor(2, 1));
+
+    // 3 (vec4): color, normalized from RGBA8
+    CHECKED_GL(glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, BufferStride, ColorOffset));
+    CHECKED_GL(glEnableVertexAttribArray(3));
+    CHECKED_GL(glVertexAttribDivisor(3, 1));
 
     CHECKED_GL(glBindVertexArray(0));
 }
@@ -284,6 +384,10 @@ OpenGLRenderer::~OpenGLRenderer()
     displayLog()("~OpenGLRenderer");
     CHECKED_GL(glDeleteVertexArrays(1, &_rectVAO));
     CHECKED_GL(glDeleteBuffers(1, &_rectVBO));
+    CHECKED_GL(glDeleteVertexArrays(1, &_textInstancedVAO));
+    CHECKED_GL(glDeleteBuffers(1, &_textInstancedVBO));
+    for (auto const& [imageId, textureId]: _imageTextures)
+        CHECKED_GL(glDeleteTextures(1, &textureId));
 }
 
 void OpenGLRenderer::initialize()
@@ -305,6 +409,11 @@ void OpenGLRenderer::initialize()
     CHECKED_GL(_textProjectionLocation = _textShader->uniformLocation("vs_projection")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
     CHECKED_GL(_textTextureAtlasLocation = _textShader->uniformLocation("fs_textureAtlas"));
     CHECKED_GL(_textTimeLocation = _textShader->uniformLocation("u_time")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textInstancedShader = createShader(_textInstancedShaderConfig));
+    CHECKED_GL(_textInstancedProjectionLocation = _textInstancedShader->uniformLocation("vs_projection")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textInstancedAtlasSizeLocation = _textInstancedShader->uniformLocation("vs_atlasSize")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textInstancedTextureAtlasLocation = _textInstancedShader->uniformLocation("fs_textureAtlas")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textInstancedTimeLocation = _textInstancedShader->uniformLocation("u_time")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
     CHECKED_GL(_rectShader = createShader(_rectShaderConfig));
     CHECKED_GL(_rectProjectionLocation = _rectShader->uniformLocation("u_projection")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
     CHECKED_GL(_rectTimeLocation = _rectShader->uniformLocation("u_time")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
@@ -323,8 +432,15 @@ void OpenGLRenderer::initialize()
         CHECKED_GL(_textShader->setUniformValue(_textTextureAtlasLocation, 0)); // GL_TEXTURE0?
     });
 
+    bound(*_textInstancedShader, [&]() {
+        auto const textureAtlasWidth = unbox<GLfloat>(_textureAtlas.textureSize.width);
+        CHECKED_GL(_textInstancedShader->setUniformValue("pixel_x", 1.0f / textureAtlasWidth));
+        CHECKED_GL(_textInstancedShader->setUniformValue(_textInstancedTextureAtlasLocation, 0));
+    });
+
     initializeRectRendering();
     initializeTextureRendering();
+    initializeInstancedTextureRendering();
 
     logInfo();
 }
@@ -420,64 +536,59 @@ void OpenGLRenderer::uploadTile(atlas::UploadTile tile)
     _scheduledExecutions.uploadTiles.emplace_back(std::move(tile));
 }
 
+void OpenGLRenderer::renderTileInstance(atlas::RenderTileInstance const& instance)
+{
+    _scheduledExecutions.renderBatch.instances.emplace_back(instance);
+}
+
 void OpenGLRenderer::renderTile(atlas::RenderTile tile)
 {
+    if (auto const instance = atlas::encodeRenderTile(tile))
+    {
+        renderTileInstance(*instance);
+        return;
+    }
+
     RenderBatch& batch = _scheduledExecutions.renderBatch;
 
     // atlas texture Vertices to locate the tile
     auto const x = static_cast<GLfloat>(tile.x.value);
     auto const y = static_cast<GLfloat>(tile.y.value);
-    auto const z = ZAxisDepths::Text;
 
     // tile bitmap size on target render surface
     GLfloat const r = unbox<GLfloat>(firstNonZero(tile.targetSize.width, tile.bitmapSize.width));
     GLfloat const s = unbox<GLfloat>(firstNonZero(tile.targetSize.height, tile.bitmapSize.height));
 
-    // normalized TexCoords
-    GLfloat const nx = tile.normalizedLocation.x;
-    GLfloat const ny = tile.normalizedLocation.y;
-    GLfloat const nw = tile.normalizedLocation.width;
-    GLfloat const nh = tile.normalizedLocation.height;
-
-    // These two are currently not used.
-    // This used to be used for the z-plane into the 3D texture,
-    // but I've reverted back to a 2D texture atlas for now.
-    GLfloat const i = 0;
-
     // Tile dependant userdata.
     // This is current the fragment shader's selector that
     // determines how to operate on this tile (images vs gray-scale anti-aliased
     // glyphs vs LCD subpixel antialiased glyphs)
     auto const u = static_cast<GLfloat>(tile.fragmentShaderSelector);
 
-    // color
-    GLfloat const cr = tile.color[0];
-    GLfloat const cg = tile.color[1];
-    GLfloat const cb = tile.color[2];
-    GLfloat const ca = tile.color[3];
+    batch.renderTiles.emplace_back(tile);
+    appendTexturedQuad(batch.buffer, x, y, r, s, tile.normalizedLocation, u, tile.color);
+}
 
-    // clang-format off
-    GLfloat const vertices[6 * 11] = {
-        // first triangle
-    // <X      Y      Z> <X        Y        I  U>  <R   G   B   A>
-        x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
-        x,     y,     z,  nx,      ny,      i, u,  cr, cg, cb, ca, // left bottom
-        x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
+void OpenGLRenderer::uploadImage(atlas::UploadImage image)
+{
+    _scheduledExecutions.uploadImages.emplace_back(std::move(image));
+}
 
-        // second triangle
-        x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
-        x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
-        x + r, y + s, z,  nx + nw, ny + nh, i, u,  cr, cg, cb, ca, // right top
-
-        // buffer contains
-        // - 3 vertex coordinates (XYZ)
-        // - 4 texture coordinates (XYIU), I is unused currently, U selects which texture to use
-        // - 4 color values (RGBA)
-    };
-    // clang-format on
+void OpenGLRenderer::renderImage(atlas::RenderImage const& image)
+{
+    appendTexturedQuad(_scheduledExecutions.renderBatch.images[image.imageId],
+                       static_cast<GLfloat>(image.x.value),
+                       static_cast<GLfloat>(image.y.value),
+                       unbox<GLfloat>(image.targetSize.width),
+                       unbox<GLfloat>(image.targetSize.height),
+                       image.source,
+                       static_cast<GLfloat>(FRAGMENT_SELECTOR_IMAGE_BGRA),
+                       atlas::normalize(RGBAColor::White));
+}
 
-    batch.renderTiles.emplace_back(tile);
-    crispy::copy(vertices, back_inserter(batch.buffer));
+void OpenGLRenderer::releaseImage(uint32_t imageId)
+{
+    _scheduledExecutions.releaseImages.emplace_back(imageId);
 }
 // }}}
 
@@ -539,6 +650,7 @@ void OpenGLRenderer::execute(std::chrono::steady_clock::time_point now)
 {
     Require(_initialized);
 
+    auto const traceSpan = crispy::trace::span { "OpenGLRenderer::execute" };
     auto const _ = ScopedRenderEnvironment { *this };
 
     auto const timeValue = uptime(now);
@@ -580,21 +692,50 @@ void OpenGLRenderer::execute(std::chrono::steady_clock::time_point now)
     //
     if (!_scheduledExecutions.uploadTiles.empty())
     {
+        auto const uploadSpan = crispy::trace::span { "OpenGLRenderer::uploadTiles" };
+        crispy::trace::counter("atlas.uploads",
+                               static_cast<int64_t>(_scheduledExecutions.uploadTiles.size()));
         _textureAtlas.gpuTexture.bind();
         for (auto const& params: _scheduledExecutions.uploadTiles)
             executeUploadTile(params);
         _textureAtlas.gpuTexture.release();
     }
 
+    // release discarded images and upload new ones into textures of their own
+    //
+    for (auto const imageId: _scheduledExecutions.releaseImages)
+        executeReleaseImage(imageId);
+    if (!_scheduledExecutions.uploadImages.empty())
+    {
+        auto const uploadSpan = crispy::trace::span { "OpenGLRenderer::uploadImages" };
+        for (auto const& params: _scheduledExecutions.uploadImages)
+            executeUploadImage(params);
+    }
+
     // render textures
     //
+    if (!_scheduledExecutions.renderBatch.instances.empty())
+    {
+        bound(*_textInstancedShader, [&]() {
+            _textInstancedShader->setUniformValue(_textInstancedProjectionLocation, mvp);
+            _textInstancedShader->setUniformValue(_textInstancedTimeLocation, timeValue);
+            _textInstancedShader->setUniformValue(_textInstancedAtlasSizeLocation,
+                                                  unbox<GLfloat>(_textureAtlas.textureSize.width),
+                                                  unbox<GLfloat>(_textureAtlas.textureSize.height));
+            executeRenderTextureInstances();
+        });
+    }
+
     bound(*_textShader, [&]() {
         // TODO: only upload when it actually DOES change
         _textShader->setUniformValue(_textProjectionLocation, mvp);
         _textShader->setUniformValue(_textTimeLocation, timeValue);
         executeRenderTextures();
+        executeRenderImages();
     });
 
+    _scheduledExecutions.clear();
+
     if (_pendingScreenshotCallback)
     {
         auto result = takeScreenshot();
@@ -603,8 +744,31 @@ void OpenGLRenderer::execute(std::chrono::steady_clock::time_point now)
     }
 }
 
+void OpenGLRenderer::executeRenderTextureInstances()
+{
+    // Upload the compact instance records (16 bytes per tile) and let the
+    // vertex shader expand each of them into a quad.
+    auto const& instances = _scheduledExecutions.renderBatch.instances;
+
+    _textureAtlas.gpuTexture.bind();
+    glBindVertexArray(_textInstancedVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _textInstancedVBO);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(instances.size() * sizeof(atlas::RenderTileInstance)),
+                 instances.data(),
+                 GL_STREAM_DRAW);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+
+    glBindVertexArray(0);
+    _textureAtlas.gpuTexture.release();
+}
+
 void OpenGLRenderer::executeRenderTextures()
 {
+    // NB: Only tiles that could not be compactly encoded end up here,
+    // and are therefore rendered on top of the instanced ones.
+
     // upload vertices and render
     RenderBatch& batch = _scheduledExecutions.renderBatch;
     if (!batch.renderTiles.empty())
@@ -623,8 +787,52 @@ void OpenGLRenderer::executeRenderTextures()
         glBindVertexArray(0);
         _textureAtlas.gpuTexture.release();
     }
+}
 
-    _scheduledExecutions.clear();
+void OpenGLRenderer::executeRenderImages()
+{
+    // Images are rendered last, as they are meant to be drawn on top of text.
+    // Each image is sampled from its own texture, so there is one draw call per visible image.
+    glBindVertexArray(_textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, _textVBO);
+
+    for (auto const& [imageId, vertices]: _scheduledExecutions.renderBatch.images)
+    {
+        auto const texture = _imageTextures.find(imageId);
+        if (vertices.empty() || texture == _imageTextures.end())
+            continue;
+
+        glBindTexture(GL_TEXTURE_2D, texture->second);
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(vertices.size() * sizeof(GLfloat)),
+                     vertices.data(),
+                     GL_STREAM_DRAW);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 11));
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+}
+
+void OpenGLRenderer::executeUploadImage(atlas::UploadImage const& param)
+{
+    executeReleaseImage(param.imageId);
+
+    auto const imageSize = QSize(unbox<int>(param.size.width), unbox<int>(param.size.height));
+    _imageTextures[param.imageId] =
+        createAndUploadImage(imageSize, vtbackend::ImageFormat::RGBA, 1, param.pixels->data());
+}
+
+void OpenGLRenderer::executeReleaseImage(uint32_t imageId)
+{
+    // Only the texture is released. Quads already queued for this frame are left alone, as the image
+    // may be re-uploaded right away; quads of an image without texture are skipped when rendering.
+    auto const texture = _imageTextures.find(imageId);
+    if (texture == _imageTextures.end())
+        return;
+
+    CHECKED_GL(glDeleteTextures(1, &texture->second));
+    _imageTextures.erase(texture);
 }
 
 void OpenGLRenderer::executeConfigureAtlas(atlas::ConfigureAtlas const& param)
@@ -814,8 +1022,26 @@ pair<ImageSize, vector<uint8_t>> OpenGLRenderer::takeScreenshot()
 }
 // }}}
 
-void OpenGLRenderer::inspect(std::ostream& /*output*/) const
+void OpenGLRenderer::setDamage(std::vector<vtrasterizer::RenderDamage> const& damage)
+{
+    _damageStats.rectangles = damage.size();
+    _damageStats.pixels = 0;
+    for (auto const& rect: damage)
+        _damageStats.pixels += unbox<uint64_t>(rect.width) * unbox<uint64_t>(rect.height);
+    ++_damageStats.frames;
+    if (damage.empty())
+        ++_damageStats.undamagedFrames;
+}
+
+void OpenGLRenderer::inspect(std::ostream& output) const
 {
+    output << "OpenGLRenderer\n";
+    output << "------------------------\n";
+    output << std::format("damage (last frame) : {} rectangles, {} pixels\n",
+                          _damageStats.rectangles,
+                          _damageStats.pixels);
+    output << std::format("frames w/o damage   : {}/{}\n", _damageStats.undamagedFrames, _damageStats.frames);
+    output << '\n';
 }
 
 // {{{ background (image)
@@ -48,6 +48,9 @@ class OpenGLRenderer final:
     using ConfigureAtlas = vtrasterizer::atlas::ConfigureAtlas;
     using UploadTile = vtrasterizer::atlas::UploadTile;
     using RenderTile = vtrasterizer::atlas::RenderTile;
+    using RenderTileInstance = vtrasterizer::atlas::RenderTileInstance;
+    using UploadImage = vtrasterizer::atlas::UploadImage;
+    using RenderImage = vtrasterizer::atlas::RenderImage;
 
   public:
     /**
@@ -57,6 +60,7 @@ class OpenGLRenderer final:
      * @param tileSize          size in pixels for each tile. This should be the grid cell size.
      */
     OpenGLRenderer(ShaderConfig textShaderConfig,
+                   ShaderConfig textInstancedShaderConfig,
                    ShaderConfig rectShaderConfig,
                    vtbackend::ImageSize viewSize,
                    vtbackend::ImageSize targetSurfaceSize,
@@ -72,6 +76,11 @@ class OpenGLRenderer final:
     void configureAtlas(ConfigureAtlas atlas) override;
     void uploadTile(UploadTile tile) override;
     void renderTile(RenderTile tile) override;
+    void renderTileInstance(RenderTileInstance const& instance) override;
+    [[nodiscard]] bool supportsImageTextures() const noexcept override { return true; }
+    void uploadImage(UploadImage image) override;
+    void renderImage(RenderImage const& image) override;
+    void releaseImage(uint32_t imageId) override;
 
     // RenderTarget implementation
     void setRenderSize(vtbackend::ImageSize targetSurfaceSize) override;
@@ -83,6 +92,7 @@ class OpenGLRenderer final:
     AtlasBackend& textureScheduler() override;
     void scheduleScreenshot(ScreenshotCallback callback) override;
     void renderRectangle(int x, int y, Width, Height, RGBAColor color) override;
+    void setDamage(std::vector<vtrasterizer::RenderDamage> const& damage) override;
     void execute(std::chrono::steady_clock::time_point now) override;
 
     std::pair<vtbackend::ImageSize, std::vector<uint8_t>> takeScreenshot();
@@ -110,6 +120,7 @@ class OpenGLRenderer final:
     void logInfo();
     void initializeBackgroundRendering();
     void initializeTextureRendering();
+    void initializeInstancedTextureRendering();
     void initializeRectRendering();
     int maxTextureDepth();
     int maxTextureSize();
@@ -121,7 +132,11 @@ class OpenGLRenderer final:
                                 int rowAlignment,
                                 uint8_t const* pixels);
 
+    void executeRenderTextureInstances();
     void executeRenderTextures();
+    void executeRenderImages();
+    void executeUploadImage(UploadImage const& param);
+    void executeReleaseImage(uint32_t imageId);
     void executeConfigureAtlas(ConfigureAtlas const& param);
     void executeUploadTile(UploadTile const& param);
     void executeRenderTile(RenderTile const& param);
@@ -135,14 +150,27 @@ class OpenGLRenderer final:
     // {{{ scheduling data
     struct RenderBatch
     {
+        // Tiles that could not be compactly encoded (e.g. scaled tiles),
+        // expanded into 6 vertices each.
         std::vector<vtrasterizer::atlas::RenderTile> renderTiles;
         std::vector<GLfloat> buffer;
+
+        // Compactly encoded tiles, rendered via instancing.
+        std::vector<vtrasterizer::atlas::RenderTileInstance> instances;
+
+        // Sub-rectangles of images that live in textures of their own,
+        // expanded into 6 vertices each and grouped by image ID.
+        std::unordered_map<uint32_t, std::vector<GLfloat>> images;
+
         uint32_t userdata = 0;
 
         void clear()
         {
             renderTiles.clear();
             buffer.clear();
+            instances.clear();
+            for (auto& [imageId, vertices]: images)
+                vertices.clear();
         }
     };
 
@@ -150,12 +178,16 @@ class OpenGLRenderer final:
     {
         std::optional<vtrasterizer::atlas::ConfigureAtlas> configureAtlas = std::nullopt;
         std::vector<vtrasterizer::atlas::UploadTile> uploadTiles {};
+        std::vector<vtrasterizer::atlas::UploadImage> uploadImages {};
+        std::vector<uint32_t> releaseImages {};
         RenderBatch renderBatch {};
 
         void clear()
         {
             configureAtlas.reset();
             uploadTiles.clear();
+            uploadImages.clear();
+            releaseImages.clear();
             renderBatch.clear();
         }
     };
@@ -179,12 +211,21 @@ class OpenGLRenderer final:
     int _textTextureAtlasLocation = -1;
     int _textTimeLocation = -1;
 
+    std::unique_ptr<QOpenGLShaderProgram> _textInstancedShader;
+    int _textInstancedProjectionLocation = -1;
+    int _textInstancedAtlasSizeLocation = -1;
+    int _textInstancedTextureAtlasLocation = -1;
+    int _textInstancedTimeLocation = -1;
+
     // private data members for rendering textures
     //
     GLuint _textVAO {}; // Vertex Array Object, covering all buffer objects
     GLuint _textVBO {}; // Buffer containing the vertex coordinates
     // TODO: GLuint ebo_{};
 
+    GLuint _textInstancedVAO {}; // Vertex Array Object for instanced tile rendering
+    GLuint _textInstancedVBO {}; // Buffer containing the RenderTileInstance records
+
     // index equals AtlasID
     struct AtlasAttributes
     {
@@ -194,6 +235,9 @@ class OpenGLRenderer final:
     };
     AtlasAttributes _textureAtlas {};
 
+    // Maps image IDs to the textures holding the whole image.
+    std::unordered_map<uint32_t, GLuint> _imageTextures;
+
     [[nodiscard]] GLuint textureAtlasId() const noexcept
     {
         assert(_textureAtlas.gpuTexture.textureId() != 0);
@@ -203,6 +247,7 @@ class OpenGLRenderer final:
     // private data members for rendering filled rectangles
     //
     ShaderConfig _textShaderConfig;
+    ShaderConfig _textInstancedShaderConfig;
     ShaderConfig _rectShaderConfig;
 
     std::vector<GLfloat> _rectBuffer;
@@ -225,6 +270,17 @@ class OpenGLRenderer final:
         QSize backgroundResolution;
         crispy::strong_hash backgroundImageHash {};
     } _renderStateCache;
+
+    // Damage reported for the most recent frame.
+    // QtQuick does not preserve the framebuffer across frames, so the full scene is
+    // still redrawn, but the damage is kept for introspection.
+    struct
+    {
+        size_t rectangles = 0;
+        uint64_t pixels = 0;
+        uint64_t frames = 0;
+        uint64_t undamagedFrames = 0;
+    } _damageStats;
 };
 
 } // namespace contour::display
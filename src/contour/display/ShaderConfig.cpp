@@ -85,8 +85,12 @@ ShaderConfig builtinShaderConfig(ShaderClass shaderClass)
                                   .contents = QString::fromStdString(fileHeader + fileContents) };
         };
         QString const basename = QString::fromStdString(to_string(shaderClass));
+        // The instanced text shader only differs in its vertex stage.
+        QString const fragmentBasename =
+            shaderClass == ShaderClass::TextInstanced ? QString::fromStdString(to_string(ShaderClass::Text))
+                                                      : basename;
         return ShaderConfig { .vertexShader = makeSource(basename + ".vert"),
-                              .fragmentShader = makeSource(basename + ".frag") };
+                              .fragmentShader = makeSource(fragmentBasename + ".frag") };
     };
     return makeConfig(shaderClass);
 }
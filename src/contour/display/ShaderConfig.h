@@ -26,7 +26,8 @@ namespace contour::display
 enum class ShaderClass : uint8_t
 {
     Background,
-    Text
+    Text,
+    TextInstanced
 };
 
 struct ShaderSource
@@ -50,6 +51,7 @@ inline std::string to_string(ShaderClass shaderClass)
     {
         case ShaderClass::Background: return "background";
         case ShaderClass::Text: return "text";
+        case ShaderClass::TextInstanced: return "text_instanced";
     }
 
     crispy::unreachable();
@@ -619,6 +619,7 @@ void TerminalDisplay::createRenderer()
     }
 
     _renderTarget = new OpenGLRenderer(builtinShaderConfig(ShaderClass::Text),
+                                       builtinShaderConfig(ShaderClass::TextInstanced),
                                        builtinShaderConfig(ShaderClass::Background),
                                        precalculatedViewSize,
                                        precalculatedTargetSize,
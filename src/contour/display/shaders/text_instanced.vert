@@ -0,0 +1,25 @@
+uniform highp mat4 vs_projection;                 // projection matrix (flips around the coordinate system)
+uniform highp vec2 vs_atlasSize;                  // texture atlas size in pixels
+
+// Per-instance attributes, see vtrasterizer::atlas::RenderTileInstance.
+layout (location = 0) in highp ivec2 vs_position;  // target position
+layout (location = 1) in highp uvec2 vs_tileLocation; // tile offset into the texture atlas
+layout (location = 2) in highp uint vs_extent;     // bits 0..11: width, 12..23: height, 24..31: fragment selector
+layout (location = 3) in highp vec4 vs_colors;     // custom foreground colors
+
+out highp vec4 fs_TexCoord;
+out highp vec4 fs_textColor;
+
+void main()
+{
+    // The quad is drawn as triangle strip: (0, 0), (1, 0), (0, 1), (1, 1).
+    highp vec2 corner = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1));
+    highp vec2 extent = vec2(float(vs_extent & 0xFFFu), float((vs_extent >> 12) & 0xFFFu));
+    highp float selector = float(vs_extent >> 24);
+
+    highp vec2 offset = corner * extent;
+    gl_Position = vs_projection * vec4(vec2(vs_position) + offset, 0.0, 1.0);
+
+    fs_TexCoord = vec4((vec2(vs_tileLocation) + offset) / vs_atlasSize, 0.0, selector);
+    fs_textColor = vs_colors;
+}
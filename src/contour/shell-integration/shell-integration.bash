@@ -382,8 +382,10 @@ fi;
 # Actual customized code (for Contour) starts here:
 
 preexec() {
-    printf "\\e[?2028h";
+    printf "\\e[?2028h\\e]133;C\\e\\\\";
 }
 precmd() {
-    printf "\\e[?2028l\\e[>M\\e]7;$PWD\\e\\\\";
+    local exitCode=$?
+    printf "\\e]133;D;$exitCode\\e\\\\\\e[?2028l\\e]133;A\\e\\\\\\e]7;$PWD\\e\\\\";
+    [[ $PS1 == *'133;B'* ]] || PS1+='\[\e]133;B\e\\\]'
 }
@@ -16,12 +16,17 @@
 
 
 function precmd_hook_contour -d "Shell Integration hook to be invoked before each prompt" -e fish_prompt
+    set -l exit_code $status
+
+    # Reports the previous command (if any) as finished, along with its exit code.
+    printf "\e]133;D;$exit_code\e\\"
+
     # Disable text reflow for the command prompt (and below).
     printf '\e[?2028l'
 
-    # Marks the current line (command prompt) so that you can jump to it via key bindings.
-    #printf '\e[>M'
-    printf "\e[>M"
+    # Marks the current line (command prompt) so that you can jump to it via key bindings,
+    # and reports the start of the prompt, so that the terminal can tell commands and their output apart.
+    printf "\e]133;A\e\\"
 
     # Informs contour terminal about the current working directory, so that e.g. OpenFileManager works.
     printf "\e]7;$PWD\e\\"
@@ -33,4 +38,7 @@ end
 function preexec_hook_contour -d "Run after printing prompt" -e fish_preexec
     # Enables text reflow for the main page area again, so that a window resize will reflow again.
     printf "\e[?2028h"
+
+    # Reports the command as being executed, with its output starting right here.
+    printf "\e]133;C\e\\"
 end
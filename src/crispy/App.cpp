@@ -241,6 +241,9 @@ void app::customizeLogStoreOutput()
 {
     logstore::sink::console().set_enabled(true);
 
+    // Keep formatting and writing log messages off the threads doing the actual work.
+    logstore::sink::console().set_async(true);
+
     // A curated list of colors.
     static const bool colorized =
 #if !defined(_WIN32)
@@ -279,7 +282,7 @@ void app::customizeLogStoreOutput()
             else
             {
                 // clang-format off
-                auto const now = chrono::system_clock::now();
+                auto const now = msg.time();
                 std::time_t const nowTimeT = std::chrono::system_clock::to_time_t(now);
                 std::tm const* tm = std::localtime(&nowTimeT);
                 std::stringstream dateTimeStrStream;
@@ -140,6 +140,9 @@ class buffer_object: public std::enable_shared_from_this<buffer_object<T>>
  * buffer_object objects that are about to be disposed
  * are not gettings its resources deleted but ownership moved
  * back to buffer_object_pool.
+ *
+ * Buffer objects may be released on any thread, also after the pool has been destroyed,
+ * in which case they are simply freed.
  */
 template <BufferObjectElementType T>
 class buffer_object_pool
@@ -149,15 +152,23 @@ class buffer_object_pool
     ~buffer_object_pool();
 
     void releaseUnusedBuffers();
-    [[nodiscard]] size_t unusedBuffers() const noexcept;
+    [[nodiscard]] size_t unusedBuffers() const;
     [[nodiscard]] buffer_object_ptr<T> allocateBufferObject();
 
   private:
-    void release(buffer_object<T>* ptr);
+    // The state shared with the release callbacks of the buffer objects allocated from this pool.
+    struct state
+    {
+        std::mutex mutex;
+        bool reuseBuffers = true;
+        std::list<buffer_object_ptr<T>> unusedBuffers;
+    };
+
+    static buffer_object_release<T> releaser(std::weak_ptr<state> pool);
+    static void release(std::shared_ptr<state> const& pool, buffer_object<T>* ptr);
 
-    bool _reuseBuffers = true;
     size_t _bufferSize;
-    std::list<buffer_object_ptr<T>> _unusedBuffers;
+    std::shared_ptr<state> _state = std::make_shared<state>();
 };
 
 /**
@@ -351,55 +362,83 @@ buffer_object_pool<T>::buffer_object_pool(size_t bufferSize): _bufferSize { buff
 template <BufferObjectElementType T>
 buffer_object_pool<T>::~buffer_object_pool()
 {
-    _reuseBuffers = false;
+    // Buffer objects still in use may outlive the pool, so make them free themselves.
+    auto const _ = std::lock_guard { _state->mutex };
+    _state->reuseBuffers = false;
 }
 
 template <BufferObjectElementType T>
-size_t buffer_object_pool<T>::unusedBuffers() const noexcept
+size_t buffer_object_pool<T>::unusedBuffers() const
 {
-    return _unusedBuffers.size();
+    auto const _ = std::lock_guard { _state->mutex };
+    return _state->unusedBuffers.size();
 }
 
 template <BufferObjectElementType T>
 void buffer_object_pool<T>::releaseUnusedBuffers()
 {
-    _reuseBuffers = false;
-    _unusedBuffers.clear();
-    _reuseBuffers = true;
+    auto unused = std::list<buffer_object_ptr<T>> {};
+    {
+        auto const _ = std::lock_guard { _state->mutex };
+        _state->reuseBuffers = false;
+        unused.swap(_state->unusedBuffers);
+    }
+    unused.clear();
+    auto const _ = std::lock_guard { _state->mutex };
+    _state->reuseBuffers = true;
 }
 
 template <BufferObjectElementType T>
 buffer_object_ptr<T> buffer_object_pool<T>::allocateBufferObject()
 {
-    if (_unusedBuffers.empty())
-        return buffer_object<T>::create(_bufferSize, [this](auto p) { release(p); });
+    auto buffer = buffer_object_ptr<T> {};
+    {
+        auto const _ = std::lock_guard { _state->mutex };
+        if (!_state->unusedBuffers.empty())
+        {
+            buffer = std::move(_state->unusedBuffers.front());
+            _state->unusedBuffers.pop_front();
+        }
+    }
+
+    if (!buffer)
+        return buffer_object<T>::create(_bufferSize, releaser(_state));
 
-    buffer_object_ptr<T> buffer = std::move(_unusedBuffers.front());
     if (bufferObjectLog)
         bufferObjectLog()("Recycling BufferObject from pool: @{}.", (void*) buffer.get());
-    _unusedBuffers.pop_front();
     return buffer;
 }
 
 template <BufferObjectElementType T>
-void buffer_object_pool<T>::release(buffer_object<T>* ptr)
+buffer_object_release<T> buffer_object_pool<T>::releaser(std::weak_ptr<state> pool)
 {
-    if (_reuseBuffers)
+    return [pool = std::move(pool)](buffer_object<T>* ptr) {
+        release(pool.lock(), ptr);
+    };
+}
+
+template <BufferObjectElementType T>
+void buffer_object_pool<T>::release(std::shared_ptr<state> const& pool, buffer_object<T>* ptr)
+{
+    if (pool)
     {
-        if (bufferObjectLog)
-            bufferObjectLog()("Releasing BufferObject from pool: @{}", (void*) ptr);
-        ptr->reset();
-        _unusedBuffers.emplace_back(ptr, [this](auto p) { release(p); });
+        auto const _ = std::lock_guard { pool->mutex };
+        if (pool->reuseBuffers)
+        {
+            if (bufferObjectLog)
+                bufferObjectLog()("Releasing BufferObject from pool: @{}", (void*) ptr);
+            ptr->reset();
+            pool->unusedBuffers.emplace_back(ptr, releaser(pool));
+            return;
+        }
     }
-    else
-    {
+
 #if defined(BUFFER_OBJECT_INLINE)
-        std::destroy_n(ptr, 1);
-        free(ptr);
+    std::destroy_n(ptr, 1);
+    free(ptr);
 #else
-        delete ptr;
+    delete ptr;
 #endif
-    }
 }
 // }}}
 
@@ -3,7 +3,33 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <thread>
+
 TEST_CASE("buffer_object", "[buffer_object]")
 {
     // TODO
 }
+
+TEST_CASE("buffer_object_pool.release_on_other_thread", "[buffer_object]")
+{
+    auto pool = crispy::buffer_object_pool<char>(64);
+    auto buffer = pool.allocateBufferObject();
+    auto const* const address = buffer.get();
+
+    std::thread([buffer = std::move(buffer)]() mutable { buffer.reset(); }).join();
+    CHECK(pool.unusedBuffers() == 1);
+    CHECK(pool.allocateBufferObject().get() == address);
+}
+
+TEST_CASE("buffer_object_pool.release_after_pool", "[buffer_object]")
+{
+    auto buffer = crispy::buffer_object_ptr<char> {};
+    {
+        auto pool = crispy::buffer_object_pool<char>(64);
+        buffer = pool.allocateBufferObject();
+    }
+
+    // The buffer object outlives its pool and is freed rather than recycled when released.
+    CHECK(buffer->capacity() >= 64);
+    buffer.reset();
+}
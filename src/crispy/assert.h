@@ -101,6 +101,7 @@ inline void set_fail_handler(fail_handler_t handler)
         fatalLog(location)("Fatal error. {}", message);
     else
         fatalLog(location)("Fatal error.");
+    logstore::flush();
     std::abort();
 }
 
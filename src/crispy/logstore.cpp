@@ -1,9 +1,209 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <crispy/logstore.h>
 
+#include <optional>
+#include <thread>
+
 namespace logstore
 {
 
+namespace
+{
+    // Bounded lock-free queue of messages to be written by a single consumer thread.
+    //
+    // Each slot carries a sequence number telling whether it is free to be written by the producer
+    // at the given position, or ready to be read by the consumer, so that producers never wait
+    // for each other nor for the consumer.
+    class message_queue
+    {
+      public:
+        struct record
+        {
+            sink* target;
+            message_builder message;
+        };
+
+        explicit message_queue(size_t capacity): _slots(capacity), _mask { capacity - 1 }
+        {
+            assert((capacity & _mask) == 0 && "Capacity must be a power of two.");
+            for (size_t i = 0; i < capacity; ++i)
+                _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool try_push(sink& target, message_builder&& message)
+        {
+            auto position = _tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                auto& entry = _slots[position & _mask];
+                auto const sequence = entry.sequence.load(std::memory_order_acquire);
+                auto const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (diff == 0)
+                {
+                    if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        entry.value.emplace(record { .target = &target, .message = std::move(message) });
+                        entry.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                    return false; // full
+                else
+                    position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Must only be called by the consumer thread.
+        std::optional<record> try_pop()
+        {
+            auto& entry = _slots[_head & _mask];
+            if (entry.sequence.load(std::memory_order_acquire) != _head + 1)
+                return std::nullopt;
+
+            auto result = std::move(entry.value);
+            entry.value.reset();
+            entry.sequence.store(_head + _mask + 1, std::memory_order_release);
+            ++_head;
+            return result;
+        }
+
+      private:
+        struct slot
+        {
+            std::atomic<size_t> sequence;
+            std::optional<record> value;
+        };
+
+        std::vector<slot> _slots;
+        size_t _mask;
+        alignas(64) std::atomic<size_t> _tail = 0;
+        alignas(64) size_t _head = 0;
+    };
+
+    // Formats and writes the messages of all asynchronous sinks on a background thread.
+    class async_writer
+    {
+      public:
+        static constexpr size_t Capacity = 16384;
+
+        // Consecutive messages to the same sink are written in one go, up to this many bytes.
+        static constexpr size_t MaxBatchSize = 64 * 1024;
+
+        static async_writer& get()
+        {
+            static auto instance = async_writer {};
+            return instance;
+        }
+
+        static std::atomic<bool>& alive()
+        {
+            static auto value = std::atomic<bool> { false };
+            return value;
+        }
+
+        async_writer(): _queue { Capacity }, _thread { [this]() { run(); } } { alive() = true; }
+
+        async_writer(async_writer const&) = delete;
+        async_writer(async_writer&&) = delete;
+        async_writer& operator=(async_writer const&) = delete;
+        async_writer& operator=(async_writer&&) = delete;
+
+        ~async_writer()
+        {
+            alive() = false;
+            _stopping.store(true);
+            _signal.fetch_add(1);
+            _signal.notify_one();
+            _thread.join();
+        }
+
+        void push(sink& target, message_builder&& message)
+        {
+            if (!_queue.try_push(target, std::move(message)))
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            _accepted.fetch_add(1, std::memory_order_relaxed);
+            _signal.fetch_add(1);
+            if (_sleeping.load())
+                _signal.notify_one();
+        }
+
+        void flush()
+        {
+            auto const accepted = _accepted.load(std::memory_order_relaxed);
+            auto written = _written.load(std::memory_order_acquire);
+            while (written < accepted)
+            {
+                _written.wait(written, std::memory_order_acquire);
+                written = _written.load(std::memory_order_acquire);
+            }
+        }
+
+      private:
+        void run()
+        {
+            auto batch = std::string {};
+            sink* batchTarget = nullptr;
+
+            auto const writeBatch = [&]() {
+                if (batchTarget && !batch.empty())
+                    batchTarget->write_raw(batch);
+                batch.clear();
+            };
+
+            while (true)
+            {
+                auto const signal = _signal.load();
+
+                auto count = uint64_t { 0 };
+                while (auto record = _queue.try_pop())
+                {
+                    if (record->target != batchTarget || batch.size() >= MaxBatchSize)
+                    {
+                        writeBatch();
+                        batchTarget = record->target;
+                    }
+                    batch += record->message.message();
+                    record->message.discard();
+                    ++count;
+                }
+
+                auto const dropped = _dropped.exchange(0, std::memory_order_relaxed);
+                if (dropped && batchTarget)
+                    batch += std::format("[logstore] {} messages dropped, as the queue was full.\n", dropped);
+
+                writeBatch();
+
+                if (count)
+                {
+                    _written.fetch_add(count, std::memory_order_release);
+                    _written.notify_all();
+                }
+
+                if (_stopping.load())
+                    return;
+
+                _sleeping.store(true);
+                _signal.wait(signal);
+                _sleeping.store(false);
+            }
+        }
+
+        message_queue _queue;
+        std::atomic<uint64_t> _signal = 0;
+        std::atomic<uint64_t> _accepted = 0;
+        std::atomic<uint64_t> _written = 0;
+        std::atomic<uint64_t> _dropped = 0;
+        std::atomic<bool> _sleeping = false;
+        std::atomic<bool> _stopping = false;
+        std::thread _thread;
+    };
+} // namespace
+
 sink::sink(bool enabled, writer wr): _enabled { enabled }, _writer { std::move(wr) }
 {
 }
@@ -24,6 +224,27 @@ sink::sink(bool enabled, std::shared_ptr<std::ostream> f):
 {
 }
 
+void sink::set_async(bool async)
+{
+    if (async)
+        async_writer::get(); // starts the background thread
+    else
+        flush();
+    _async = async;
+}
+
+void sink::write(message_builder&& message)
+{
+    if (_async && async_writer::alive())
+    {
+        if (_enabled)
+            async_writer::get().push(*this, std::move(message));
+        return;
+    }
+
+    write(message);
+}
+
 sink& sink::console()
 {
     static auto instance = sink(false, std::cout);
@@ -36,4 +257,10 @@ sink& sink::error_console() // NOLINT(readability-identifier-naming)
     return instance;
 }
 
+void flush()
+{
+    if (async_writer::alive())
+        async_writer::get().flush();
+}
+
 } // namespace logstore
@@ -7,7 +7,11 @@
 #include <gsl/pointers>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <format>
 #include <functional>
 #include <iostream>
@@ -15,6 +19,9 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #if defined __has_include
@@ -71,49 +78,161 @@ using source_location = source_location_custom;
     #endif
 #endif
 
+/// Tells whether arguments of type T may be copied into a log message, to be formatted later on
+/// by the background thread of an asynchronous sink.
+///
+/// Specialize this for cheap to copy value types, whose formatting depends on nothing but their value.
+/// Strings are always copied.
+template <typename T>
+struct is_deferrable: std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+{
+};
+
+namespace detail
+{
+    template <typename T>
+    constexpr bool is_string_arg = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+                                   || std::is_same_v<T, char const*> || std::is_same_v<T, char*>;
+
+    template <typename T>
+    constexpr bool is_deferrable_arg =
+        is_string_arg<std::decay_t<T>> || is_deferrable<std::decay_t<T>>::value;
+
+    // The copy of an argument kept for deferred formatting.
+    template <typename T>
+    using deferred_arg = std::conditional_t<is_string_arg<std::decay_t<T>>, std::string, std::decay_t<T>>;
+
+    // A part of a log message, whose formatting is deferred to the thread writing the message.
+    class deferred_part
+    {
+      public:
+        deferred_part() = default;
+        deferred_part(deferred_part const&) = delete;
+        deferred_part(deferred_part&&) = delete;
+        deferred_part& operator=(deferred_part const&) = delete;
+        deferred_part& operator=(deferred_part&&) = delete;
+        virtual ~deferred_part() = default;
+
+        virtual void format_to(std::string& output) const = 0;
+    };
+
+    template <typename... Ts>
+    class deferred_format final: public deferred_part
+    {
+      public:
+        explicit deferred_format(std::string_view fmt, Ts const&... args): _format { fmt }, _args { args... }
+        {
+        }
+
+        void format_to(std::string& output) const override
+        {
+            std::apply(
+                [&](auto const&... args) { output += std::vformat(_format, std::make_format_args(args...)); },
+                _args);
+        }
+
+      private:
+        std::string _format;
+        std::tuple<deferred_arg<Ts>...> _args;
+    };
+
+    // Maps a steady clock time point to the system clock, such that logging a message only needs
+    // to take the steady clock's time, leaving the conversion to the thread writing the message.
+    inline std::chrono::system_clock::time_point to_system_time(std::chrono::steady_clock::time_point time)
+    {
+        using std::chrono::steady_clock;
+        using std::chrono::system_clock;
+        static auto const origin = std::pair { steady_clock::now(), system_clock::now() };
+        return origin.second + std::chrono::duration_cast<system_clock::duration>(time - origin.first);
+    }
+} // namespace detail
+
+/// Builds a single log message, and writes it to the category's sink when going out of scope.
+///
+/// Messages discarded by the category's sampling or rate limit are not formatted at all.
+/// Messages to an asynchronous sink keep copies of their format arguments (see is_deferrable),
+/// leaving the formatting to the sink's background thread.
 class message_builder
 {
   private:
     gsl::not_null<category const*> _category;
     source_location _location;
-    std::string _buffer;
+    std::chrono::steady_clock::time_point _time;
+    mutable std::string _buffer;
+    mutable std::vector<std::unique_ptr<detail::deferred_part>> _deferred; // to be appended to _buffer
+    bool _admitted;
+    bool _deferring; // whether formatting is left to the thread writing the message
+
+    // Formats the deferred parts of the message into the buffer.
+    void format_deferred() const
+    {
+        for (auto const& part: _deferred)
+            part->format_to(_buffer);
+        _deferred.clear();
+    }
 
   public:
     explicit message_builder(category const& cat, source_location loc = source_location::current());
+    message_builder(message_builder&& other) noexcept;
+    message_builder(message_builder const&) = delete;
+    message_builder& operator=(message_builder const&) = delete;
+    message_builder& operator=(message_builder&&) = delete;
 
     [[nodiscard]] category const& get_category() const noexcept { return *_category; }
     [[nodiscard]] source_location const& location() const noexcept { return _location; }
 
-    [[nodiscard]] std::string const& text() const noexcept { return _buffer; }
+    /// @returns the point in time the message was created at, which may be long before it is written.
+    [[nodiscard]] std::chrono::system_clock::time_point time() const { return detail::to_system_time(_time); }
+
+    /// @returns the message text, formatting any deferred parts of it first.
+    [[nodiscard]] std::string const& text() const
+    {
+        format_deferred();
+        return _buffer;
+    }
 
     message_builder& append(std::string_view msg)
     {
-        _buffer += msg;
+        if (!_admitted)
+            return *this;
+        if (_deferred.empty())
+            _buffer += msg;
+        else
+            _deferred.emplace_back(std::make_unique<detail::deferred_format<std::string_view>>("{}", msg));
         return *this;
     }
 
     template <typename... Ts>
     message_builder& append(std::string_view fmt, Ts const&... args)
     {
+        if (!_admitted)
+            return *this;
+        if constexpr ((detail::is_deferrable_arg<Ts> && ...))
+        {
+            if (_deferring)
+            {
+                _deferred.emplace_back(std::make_unique<detail::deferred_format<Ts...>>(fmt, args...));
+                return *this;
+            }
+        }
+        format_deferred();
         _buffer += std::vformat(fmt, std::make_format_args(args...));
         return *this;
     }
 
-    message_builder& operator()(std::string const& msg)
-    {
-        _buffer += msg;
-        return *this;
-    }
+    message_builder& operator()(std::string const& msg) { return append(std::string_view(msg)); }
 
     template <typename... Ts>
     message_builder& operator()(std::string_view fmt, Ts const&... args)
     {
-        _buffer += std::vformat(fmt, std::make_format_args(args...));
-        return *this;
+        return append(fmt, args...);
     }
 
     [[nodiscard]] std::string message() const;
 
+    /// Drops this message, such that it is not written when going out of scope.
+    void discard() noexcept { _admitted = false; }
+
     ~message_builder();
 };
 
@@ -152,6 +271,18 @@ class category
     [[nodiscard]] bool visible() const noexcept { return _visibility == visibility::Public; }
     void set_visible(bool visible) { _visibility = visible ? visibility::Public : visibility::Hidden; }
 
+    /// Keeps only every n-th message of this category, with 1 keeping all of them.
+    void set_sampling(unsigned n) noexcept { _sampling = std::max(n, 1u); }
+
+    /// Limits the number of messages of this category per second, with 0 meaning unlimited.
+    void set_rate_limit(unsigned messagesPerSecond) noexcept { _rateLimit = messagesPerSecond; }
+
+    /// @returns the number of messages discarded by sampling or rate limiting so far.
+    [[nodiscard]] uint64_t suppressed() const noexcept { return _suppressed.load(std::memory_order_relaxed); }
+
+    /// Decides whether a message to be built now is to be logged at all.
+    [[nodiscard]] bool admit() const noexcept;
+
     operator bool() const noexcept { return is_enabled(); }
 
     [[nodiscard]] formatter const& get_formatter() const { return _formatter; }
@@ -179,11 +310,23 @@ class category
     visibility _visibility;
     formatter _formatter;
     std::reference_wrapper<logstore::sink> _sink;
+
+    std::atomic<unsigned> _sampling = 1;
+    std::atomic<unsigned> _rateLimit = 0;
+    mutable std::atomic<uint64_t> _sampleCounter = 0;
+    mutable std::atomic<int64_t> _rateWindow = 0; // current rate limiting window, in seconds
+    mutable std::atomic<unsigned> _rateCount = 0; // messages admitted in the current window
+    mutable std::atomic<uint64_t> _suppressed = 0;
 };
 
 /// Logging sink API.
 ///
 /// Such as the console, a log file, or UDP endpoint.
+///
+/// An asynchronous sink only enqueues messages on the logging thread, along with copies of their
+/// format arguments (see is_deferrable), and leaves formatting and writing them to a background
+/// thread. Messages are dropped rather than blocking the logging thread if the background thread
+/// cannot keep up.
 class sink
 {
   public:
@@ -198,14 +341,24 @@ class sink
     /// Writes given built message to this sink.
     void write(message_builder const& message);
 
+    /// Writes given built message to this sink, or enqueues it if this sink is asynchronous.
+    void write(message_builder&& message);
+
+    /// Writes given already formatted text to this sink.
+    void write_raw(std::string_view text);
+
     void set_enabled(bool enabled) { _enabled = enabled; }
 
+    void set_async(bool async);
+    [[nodiscard]] bool is_async() const noexcept { return _async; }
+
     /// Retrieves reference to standard debug-logging sink.
     static sink& console();
     static sink& error_console(); // NOLINT(readability-identifier-naming)
 
   private:
     bool _enabled;
+    std::atomic<bool> _async = false;
     writer _writer;
 };
 
@@ -215,11 +368,21 @@ void set_sink(sink& sink);
 void set_formatter(category::formatter const& f);
 void enable(std::string_view categoryName, bool enabled = true);
 void disable(std::string_view categoryName);
+
+/// Enables the categories matching the comma separated list of category names or name prefixes
+/// ending with '*', disabling all others.
+///
+/// Each entry may carry options, separated by ':', such as "vt.trace:rate=1000" to log at most
+/// 1000 messages per second, or "pty.in:sample=16" to only log every 16th message.
 void configure(std::string_view filterString);
 
+/// Waits for all messages enqueued to asynchronous sinks so far to be written.
+void flush();
+
 // {{{ implementation
 inline std::string message_builder::message() const
 {
+    format_deferred();
     if (_category->get_formatter())
         return _category->get_formatter()(*this);
     else if (!_buffer.empty() && _buffer.back() == '\n')
@@ -268,6 +431,28 @@ inline void disable(std::string_view categoryName)
     enable(categoryName, false);
 }
 
+namespace detail
+{
+    inline void configure_options(category& cat, std::string_view options)
+    {
+        for (auto const option: crispy::split(options, ':'))
+        {
+            auto const separator = option.find('=');
+            auto const key = option.substr(0, separator);
+            if (separator == std::string_view::npos)
+                continue;
+            auto const value = option.substr(separator + 1);
+            auto number = 0u;
+            if (std::from_chars(value.data(), value.data() + value.size(), number).ec != std::errc {})
+                continue;
+            if (key == "sample")
+                cat.set_sampling(number);
+            else if (key == "rate")
+                cat.set_rate_limit(number);
+        }
+    }
+} // namespace detail
+
 inline void configure(std::string_view filterString)
 {
     if (filterString == "all")
@@ -280,26 +465,47 @@ inline void configure(std::string_view filterString)
         auto const filters = crispy::split(filterString, ',');
         for (auto& category: logstore::get())
         {
-            category.get().enable(crispy::any_of(filters, [&](std::string_view filterPattern) -> bool {
+            auto const filter = std::find_if(filters.begin(), filters.end(), [&](std::string_view entry) {
+                auto const filterPattern = entry.substr(0, entry.find(':'));
+                if (filterPattern.empty())
+                    return false;
                 if (filterPattern.back() != '*')
                     return category.get().name() == filterPattern;
                 // TODO: '*' excludes hidden categories
-                return std::equal(std::begin(filterPattern),
-                                  std::prev(end(filterPattern)),
-                                  std::begin(category.get().name()));
-            }));
+                return category.get().name().starts_with(filterPattern.substr(0, filterPattern.size() - 1));
+            });
+            category.get().enable(filter != filters.end());
+            if (filter != filters.end() && filter->find(':') != std::string_view::npos)
+                detail::configure_options(category.get(), filter->substr(filter->find(':') + 1));
         }
     }
 }
 
 inline message_builder::message_builder(logstore::category const& cat, source_location location):
-    _category { &cat }, _location { location }
+    _category { &cat },
+    _location { location },
+    _admitted { cat.admit() },
+    _deferring { _admitted && cat.sink().is_async() }
+{
+    if (_admitted)
+        _time = std::chrono::steady_clock::now();
+}
+
+inline message_builder::message_builder(message_builder&& other) noexcept:
+    _category { other._category },
+    _location { other._location },
+    _time { other._time },
+    _buffer { std::move(other._buffer) },
+    _deferred { std::move(other._deferred) },
+    _admitted { std::exchange(other._admitted, false) },
+    _deferring { other._deferring }
 {
 }
 
 inline message_builder::~message_builder()
 {
-    _category->sink().write(*this);
+    if (_admitted)
+        _category->sink().write(std::move(*this));
 }
 
 inline category::category(std::string_view name,
@@ -328,6 +534,36 @@ inline category::~category()
     }
 }
 
+inline bool category::admit() const noexcept
+{
+    if (!is_enabled())
+        return false;
+
+    if (auto const n = _sampling.load(std::memory_order_relaxed);
+        n > 1 && _sampleCounter.fetch_add(1, std::memory_order_relaxed) % n != 0)
+    {
+        _suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (auto const limit = _rateLimit.load(std::memory_order_relaxed); limit != 0)
+    {
+        auto const now = std::chrono::duration_cast<std::chrono::seconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count();
+        auto window = _rateWindow.load(std::memory_order_relaxed);
+        if (window != now && _rateWindow.compare_exchange_strong(window, now, std::memory_order_relaxed))
+            _rateCount.store(0, std::memory_order_relaxed);
+        if (_rateCount.fetch_add(1, std::memory_order_relaxed) >= limit)
+        {
+            _suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 inline std::string category::defaultFormatter(message_builder const& message)
 {
     return std::format("[{}:{}:{}]: {}\n",
@@ -343,6 +579,12 @@ inline void sink::write(message_builder const& message)
         _writer(message.message());
 }
 
+inline void sink::write_raw(std::string_view text)
+{
+    if (_enabled)
+        _writer(text);
+}
+
 inline void sink::set_writer(writer writer)
 {
     _writer = std::move(writer);
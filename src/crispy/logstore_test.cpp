@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/logstore.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <format>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct collecting_sink
+{
+    std::vector<std::string> lines;
+    logstore::sink sink { true, [this](std::string_view text) {
+                             for (auto const line: crispy::split(text, '\n'))
+                                 lines.emplace_back(line);
+                         } };
+};
+
+// Restores the enabled state of all categories, which logstore::configure() changes globally.
+class category_states_guard
+{
+  public:
+    category_states_guard()
+    {
+        for (auto const& category: logstore::get())
+            _states.emplace_back(&category.get(), category.get().is_enabled());
+    }
+
+    category_states_guard(category_states_guard const&) = delete;
+    category_states_guard& operator=(category_states_guard const&) = delete;
+
+    ~category_states_guard()
+    {
+        for (auto const& [category, enabled]: _states)
+            category->enable(enabled);
+    }
+
+  private:
+    std::vector<std::pair<logstore::category*, bool>> _states;
+};
+
+// Formats as "probe", recording the thread it got formatted on.
+struct thread_probe
+{
+};
+
+std::thread::id probeFormattingThread; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+} // namespace
+
+template <>
+struct logstore::is_deferrable<thread_probe>: std::true_type
+{
+};
+
+template <>
+struct std::formatter<thread_probe>: std::formatter<std::string_view>
+{
+    auto format(thread_probe, auto& ctx) const
+    {
+        probeFormattingThread = std::this_thread::get_id();
+        return formatter<std::string_view>::format("probe", ctx);
+    }
+};
+
+TEST_CASE("logstore.sampling")
+{
+    auto output = collecting_sink {};
+    auto category = logstore::category("test.sampling", "", logstore::category::state::Enabled);
+    category.set_sink(output.sink);
+    category.set_sampling(3);
+
+    for (int i = 0; i < 9; ++i)
+        category()("message {}", i);
+
+    CHECK(output.lines == std::vector<std::string> { "message 0", "message 3", "message 6" });
+    CHECK(category.suppressed() == 6);
+}
+
+TEST_CASE("logstore.rate_limit")
+{
+    auto output = collecting_sink {};
+    auto category = logstore::category("test.rate_limit", "", logstore::category::state::Enabled);
+    category.set_sink(output.sink);
+    category.set_rate_limit(5);
+
+    for (int i = 0; i < 100; ++i)
+        category()("message {}", i);
+
+    // At most two rate limiting windows may have been touched.
+    CHECK(output.lines.size() >= 5);
+    CHECK(output.lines.size() <= 10);
+    CHECK(category.suppressed() == 100 - output.lines.size());
+}
+
+TEST_CASE("logstore.configure_options")
+{
+    auto category = logstore::category("test.configure", "");
+    auto const restoreStates = category_states_guard {};
+    logstore::configure("test.other,test.conf*:sample=4:rate=100");
+    CHECK(category.is_enabled());
+
+    auto output = collecting_sink {};
+    category.set_sink(output.sink);
+    for (int i = 0; i < 8; ++i)
+        category()("message {}", i);
+    CHECK(output.lines.size() == 2);
+
+    logstore::configure("test.other");
+    CHECK_FALSE(category.is_enabled());
+}
+
+TEST_CASE("logstore.async")
+{
+    constexpr auto ThreadCount = 4;
+    constexpr auto MessageCount = 1000;
+
+    auto output = collecting_sink {};
+    output.sink.set_async(true);
+    auto category = logstore::category("test.async", "", logstore::category::state::Enabled);
+    category.set_sink(output.sink);
+
+    auto threads = std::vector<std::thread> {};
+    for (int t = 0; t < ThreadCount; ++t)
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < MessageCount; ++i)
+                category()("{} {}", t, i);
+        });
+    for (auto& thread: threads)
+        thread.join();
+
+    logstore::flush();
+    output.sink.set_async(false);
+
+    // Messages of each thread arrive in order, unless dropped due to a full queue.
+    auto next = std::vector<int>(ThreadCount, 0);
+    auto delivered = 0;
+    for (auto const& line: output.lines)
+    {
+        int t = 0;
+        int i = 0;
+        if (std::sscanf(line.c_str(), "%d %d", &t, &i) != 2)
+            continue; // drop notice
+        REQUIRE(t < ThreadCount);
+        CHECK(i >= next[t]);
+        next[t] = i + 1;
+        ++delivered;
+    }
+    CHECK(delivered > 0);
+    CHECK(delivered <= ThreadCount * MessageCount);
+}
+
+TEST_CASE("logstore.async.deferred_formatting")
+{
+    auto output = collecting_sink {};
+    output.sink.set_async(true);
+    auto category = logstore::category("test.async.deferred", "", logstore::category::state::Enabled);
+    category.set_sink(output.sink);
+
+    // Arguments are copied into the message, so changing them afterwards does not affect it.
+    auto text = std::string("before");
+    category()("{} {} {}", std::string_view(text), 42, thread_probe {});
+    text = "after!";
+
+    logstore::flush();
+    output.sink.set_async(false);
+
+    CHECK(output.lines == std::vector<std::string> { "before 42 probe" });
+    CHECK(probeFormattingThread != std::this_thread::get_id());
+}
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/trace.h>
+#include <crispy/utils.h>
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace std::string_view_literals;
+
+namespace crispy::trace
+{
+
+namespace
+{
+    // Maximum number of events recorded per thread. Events beyond that are counted as dropped.
+    constexpr size_t BufferCapacity = 64 * 1024;
+
+    enum class event_kind : uint8_t
+    {
+        Span,
+        Counter,
+    };
+
+    struct event
+    {
+        char const* name;
+        uint64_t start;
+        uint64_t duration;
+        int64_t value;
+        event_kind kind;
+    };
+
+    // Events of a single thread, only ever written to by that thread.
+    //
+    // Events are published by bumping the size, so that exporting can read all events
+    // below the size while the thread keeps appending.
+    struct thread_buffer
+    {
+        std::string threadName;
+        uint64_t id = 0;
+        std::unique_ptr<event[]> events = std::make_unique_for_overwrite<event[]>(BufferCapacity);
+        std::atomic<uint64_t> generation = 0;
+        std::atomic<size_t> size = 0;
+        std::atomic<size_t> dropped = 0;
+    };
+
+    struct registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<thread_buffer>> buffers;
+        std::atomic<uint64_t> generation = 1;
+        uint64_t epoch = 0;
+        uint64_t nextThreadId = 1;
+
+        static registry& get()
+        {
+            static auto instance = registry {};
+            return instance;
+        }
+    };
+
+    thread_buffer* localBuffer()
+    {
+        thread_local auto buffer = std::shared_ptr<thread_buffer> {};
+        if (!buffer)
+        {
+            try
+            {
+                auto newBuffer = std::make_shared<thread_buffer>();
+                newBuffer->threadName = crispy::threadName();
+                auto& reg = registry::get();
+                auto const _ = std::lock_guard { reg.mutex };
+                newBuffer->id = reg.nextThreadId++;
+                reg.buffers.emplace_back(newBuffer);
+                buffer = std::move(newBuffer);
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+        return buffer.get();
+    }
+
+    void append(event const& e) noexcept
+    {
+        auto* buffer = localBuffer();
+        if (!buffer)
+            return;
+
+        // Reset the buffer on the first event of a new recording. Only this thread writes to it.
+        auto const generation = registry::get().generation.load(std::memory_order_acquire);
+        if (buffer->generation.load(std::memory_order_relaxed) != generation)
+        {
+            buffer->size.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+            buffer->generation.store(generation, std::memory_order_release);
+        }
+
+        auto const size = buffer->size.load(std::memory_order_relaxed);
+        if (size == BufferCapacity)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->events[size] = e;
+        buffer->size.store(size + 1, std::memory_order_release);
+    }
+
+    std::string escapeJson(std::string_view text)
+    {
+        auto result = std::string {};
+        result.reserve(text.size());
+        for (char const ch: text)
+        {
+            if (ch == '"' || ch == '\\')
+                result += '\\';
+            if (static_cast<unsigned char>(ch) >= 0x20)
+                result += ch;
+        }
+        return result;
+    }
+
+    // Formats nanoseconds as microseconds, being the time unit of the trace event format.
+    std::string microseconds(uint64_t nanoseconds)
+    {
+        return std::format("{}.{:03}", nanoseconds / 1000, nanoseconds % 1000);
+    }
+} // namespace
+
+namespace detail
+{
+    void record_span(char const* name, uint64_t start, uint64_t end) noexcept
+    {
+        append(event { .name = name,
+                       .start = start,
+                       .duration = end - start,
+                       .value = 0,
+                       .kind = event_kind::Span });
+    }
+
+    void record_counter(char const* name, int64_t value) noexcept
+    {
+        append(event {
+            .name = name, .start = now(), .duration = 0, .value = value, .kind = event_kind::Counter });
+    }
+} // namespace detail
+
+void start()
+{
+    auto& reg = registry::get();
+    auto const _ = std::lock_guard { reg.mutex };
+
+    // Forget about threads that have exited.
+    std::erase_if(reg.buffers, [](auto const& buffer) { return buffer.use_count() == 1; });
+
+    reg.epoch = detail::now();
+    reg.generation.fetch_add(1, std::memory_order_release);
+    detail::recording.store(true, std::memory_order_relaxed);
+}
+
+void stop()
+{
+    detail::recording.store(false, std::memory_order_relaxed);
+}
+
+void write_chrome_trace(std::ostream& output)
+{
+    auto& reg = registry::get();
+    auto const _ = std::lock_guard { reg.mutex };
+    auto const generation = reg.generation.load(std::memory_order_relaxed);
+
+    auto separator = "\n"sv;
+    auto dropped = size_t { 0 };
+    output << "{\"traceEvents\":[";
+    for (auto const& buffer: reg.buffers)
+    {
+        if (buffer->generation.load(std::memory_order_acquire) != generation)
+            continue; // nothing recorded by this thread during the last recording
+
+        auto const size = buffer->size.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+        output << separator
+               << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                              buffer->id,
+                              escapeJson(buffer->threadName));
+        separator = ",\n"sv;
+
+        for (auto const& e: std::span(buffer->events.get(), size))
+        {
+            // Spans that began before the recording started are clipped to its start.
+            auto const begin = std::max(e.start, reg.epoch);
+            auto const timestamp = microseconds(begin - reg.epoch);
+            switch (e.kind)
+            {
+                case event_kind::Span: {
+                    auto const duration = e.duration - std::min(e.duration, begin - e.start);
+                    output << separator
+                           << std::format(R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{},"dur":{}}})",
+                                          e.name,
+                                          buffer->id,
+                                          timestamp,
+                                          microseconds(duration));
+                    break;
+                }
+                case event_kind::Counter:
+                    output << separator
+                           << std::format(R"({{"name":"{}","ph":"C","pid":1,"tid":{},"ts":{},)"
+                                          R"("args":{{"value":{}}}}})",
+                                          e.name,
+                                          buffer->id,
+                                          timestamp,
+                                          e.value);
+                    break;
+            }
+        }
+    }
+    output << std::format(R"(
+],"displayTimeUnit":"ms","otherData":{{"droppedEvents":{}}}}})",
+                          dropped)
+           << '\n';
+}
+
+bool save_chrome_trace(std::filesystem::path const& path)
+{
+    auto output = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+        return false;
+    write_chrome_trace(output);
+    return output.good();
+}
+
+} // namespace crispy::trace
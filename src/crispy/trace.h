@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+
+/// Performance timeline recording.
+///
+/// Scoped spans and counters placed in hot paths are recorded into per-thread buffers while
+/// recording is active, and can be exported in Chrome's trace event format, to be viewed with
+/// chrome://tracing or https://ui.perfetto.dev.
+///
+/// While not recording, a span costs a single relaxed atomic load.
+namespace crispy::trace
+{
+
+namespace detail
+{
+    inline std::atomic<bool> recording = false;
+
+    [[nodiscard]] inline uint64_t now() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    void record_span(char const* name, uint64_t start, uint64_t end) noexcept;
+    void record_counter(char const* name, int64_t value) noexcept;
+} // namespace detail
+
+[[nodiscard]] inline bool is_recording() noexcept
+{
+    return detail::recording.load(std::memory_order_relaxed);
+}
+
+/// Starts recording, discarding any previously recorded events.
+void start();
+
+/// Stops recording, keeping the recorded events for export.
+void stop();
+
+/// Writes the recorded events in Chrome's trace event format (JSON).
+void write_chrome_trace(std::ostream& output);
+
+/// Writes the recorded events in Chrome's trace event format into the given file.
+///
+/// @returns false if the file could not be written.
+bool save_chrome_trace(std::filesystem::path const& path);
+
+/// Records the duration of the enclosing scope on the timeline of the calling thread.
+///
+/// @p name must refer to a string of static storage duration, such as a string literal.
+class span
+{
+  public:
+    explicit span(char const* name) noexcept: _name { name }, _start { is_recording() ? detail::now() : 0 } {}
+
+    ~span()
+    {
+        if (_start)
+            detail::record_span(_name, _start, detail::now());
+    }
+
+    span(span const&) = delete;
+    span(span&&) = delete;
+    span& operator=(span const&) = delete;
+    span& operator=(span&&) = delete;
+
+  private:
+    char const* _name;
+    uint64_t _start;
+};
+
+/// Records the current value of a counter on the timeline.
+///
+/// @p name must refer to a string of static storage duration, such as a string literal.
+inline void counter(char const* name, int64_t value) noexcept
+{
+    if (is_recording())
+        detail::record_counter(name, value);
+}
+
+} // namespace crispy::trace
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/trace.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+size_t countOccurrences(std::string const& text, std::string_view pattern)
+{
+    auto count = size_t { 0 };
+    for (auto i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + pattern.size()))
+        ++count;
+    return count;
+}
+
+std::string exportTrace()
+{
+    auto output = std::ostringstream {};
+    crispy::trace::write_chrome_trace(output);
+    return output.str();
+}
+
+} // namespace
+
+TEST_CASE("trace.not_recording")
+{
+    crispy::trace::stop();
+    {
+        auto const traceSpan = crispy::trace::span { "test.ignored" };
+        crispy::trace::counter("test.ignored.counter", 1);
+    }
+    CHECK(exportTrace().find("test.ignored") == std::string::npos);
+}
+
+TEST_CASE("trace.spans_and_counters")
+{
+    crispy::trace::start();
+    auto worker = std::thread([]() {
+        for (int i = 0; i < 10; ++i)
+        {
+            auto const traceSpan = crispy::trace::span { "test.worker" };
+            crispy::trace::counter("test.counter", i);
+        }
+    });
+    {
+        auto const traceSpan = crispy::trace::span { "test.main" };
+    }
+    worker.join();
+    crispy::trace::stop();
+
+    auto const trace = exportTrace();
+    CHECK(trace.starts_with("{\"traceEvents\":["));
+    CHECK(countOccurrences(trace, R"("name":"test.worker","ph":"X")") == 10);
+    CHECK(countOccurrences(trace, R"("name":"test.counter","ph":"C")") == 10);
+    CHECK(countOccurrences(trace, R"("name":"test.main","ph":"X")") == 1);
+    CHECK(countOccurrences(trace, R"("name":"thread_name","ph":"M")") == 2);
+
+    // Starting a new recording discards the previous one.
+    crispy::trace::start();
+    crispy::trace::stop();
+    CHECK(exportTrace().find("test.worker") == std::string::npos);
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/CommandBlocks.h>
+
+#include <iterator>
+
+namespace vtbackend
+{
+
+CommandBlock& CommandBlocks::prompt(int64_t line)
+{
+    if (!_blocks.empty() && !_blocks.back().executed())
+        _blocks.back() = CommandBlock { .promptLine = line };
+    else
+        _blocks.emplace_back(CommandBlock { .promptLine = line });
+    return _blocks.back();
+}
+
+void CommandBlocks::evictAbove(int64_t line)
+{
+    while (!_blocks.empty() && _blocks.front().promptLine < line)
+    {
+        _blocks.pop_front();
+        ++_firstNumber;
+    }
+}
+
+void CommandBlocks::reanchor(Anchors const& anchors)
+{
+    auto prompt = anchors.prompts.rbegin();
+    auto outputStart = anchors.outputStarts.rbegin();
+    auto outputEnd = anchors.outputEnds.rbegin();
+
+    auto block = _blocks.rbegin();
+    for (; block != _blocks.rend(); ++block)
+    {
+        if (prompt == anchors.prompts.rend())
+            break;
+        if (block->executed() && outputStart == anchors.outputStarts.rend())
+            break;
+        if (block->finished() && outputEnd == anchors.outputEnds.rend())
+            break;
+
+        if (block->commandLine)
+            *block->commandLine += *prompt - block->promptLine;
+        block->promptLine = *prompt++;
+        if (block->executed())
+            block->outputStart = *outputStart++;
+        if (block->finished())
+            block->outputEnd = *outputEnd++;
+    }
+
+    // Drop the commands that could not be matched (along with all older ones).
+    auto const unmatched = static_cast<size_t>(std::distance(block, _blocks.rend()));
+    _blocks.erase(_blocks.begin(), std::next(_blocks.begin(), static_cast<std::ptrdiff_t>(unmatched)));
+    _firstNumber += unmatched;
+}
+
+void CommandBlocks::clear()
+{
+    _firstNumber += _blocks.size();
+    _blocks.clear();
+}
+
+} // namespace vtbackend
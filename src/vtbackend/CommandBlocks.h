@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// A shell command along with its output, as reported by the shell via semantic prompts (OSC 133).
+///
+/// Lines are referred to by their absolute line number (see Grid::lineNumberOf()),
+/// which remains stable while the grid is scrolling.
+struct CommandBlock
+{
+    /// Line of the prompt (OSC 133 ; A).
+    int64_t promptLine = 0;
+
+    /// Position where the command line starts, right after the prompt (OSC 133 ; B).
+    std::optional<int64_t> commandLine;
+    ColumnOffset commandColumn {};
+
+    /// The command line, as typed by the user.
+    std::string command;
+
+    /// First line of the command's output (OSC 133 ; C).
+    std::optional<int64_t> outputStart;
+
+    /// Line where the command has finished (OSC 133 ; D), and whether that line is part of the output.
+    std::optional<int64_t> outputEnd;
+    bool outputEndLineIncluded = false;
+
+    /// Exit code of the command, if reported by the shell.
+    std::optional<int> exitCode;
+
+    [[nodiscard]] bool executed() const noexcept { return outputStart.has_value(); }
+    [[nodiscard]] bool finished() const noexcept { return outputEnd.has_value(); }
+};
+
+/// Ordered index of the command blocks of a screen.
+///
+/// Commands are numbered sequentially in the order they were prompted for, so that any command,
+/// and in particular the most recent ones, can be accessed in constant time.
+class CommandBlocks
+{
+  public:
+    /// Line numbers of the lines flagged with the respective LineFlag, in ascending order.
+    struct Anchors
+    {
+        std::vector<int64_t> prompts;
+        std::vector<int64_t> outputStarts;
+        std::vector<int64_t> outputEnds;
+    };
+
+    [[nodiscard]] bool empty() const noexcept { return _blocks.empty(); }
+    [[nodiscard]] size_t size() const noexcept { return _blocks.size(); }
+
+    /// Number of the oldest command still being indexed.
+    [[nodiscard]] uint64_t firstNumber() const noexcept { return _firstNumber; }
+
+    /// Number the next prompted command will get.
+    [[nodiscard]] uint64_t nextNumber() const noexcept { return _firstNumber + _blocks.size(); }
+
+    /// @returns the command with the given number, if still indexed.
+    [[nodiscard]] CommandBlock const* find(uint64_t number) const noexcept
+    {
+        if (number < _firstNumber || number >= nextNumber())
+            return nullptr;
+        return &_blocks[number - _firstNumber];
+    }
+
+    /// @returns the @p n-th most recently executed command, with 0 being the most recent one.
+    ///
+    /// A command still waiting at its prompt is not counted.
+    [[nodiscard]] CommandBlock const* recent(size_t n) const noexcept
+    {
+        auto const executedCount =
+            _blocks.empty() || _blocks.back().executed() ? _blocks.size() : _blocks.size() - 1;
+        if (n >= executedCount)
+            return nullptr;
+        return &_blocks[executedCount - 1 - n];
+    }
+
+    /// @returns the most recent command, if any.
+    [[nodiscard]] CommandBlock* current() noexcept { return _blocks.empty() ? nullptr : &_blocks.back(); }
+
+    /// Starts a new command at the prompt on the given line.
+    ///
+    /// A command that was prompted for but never executed is replaced.
+    CommandBlock& prompt(int64_t line);
+
+    /// Drops all commands whose prompt line is above the given line.
+    void evictAbove(int64_t line);
+
+    /// Re-assigns line numbers after lines have been re-numbered, such as by reflow.
+    ///
+    /// Commands are matched from the most recent one upwards, as the oldest ones might
+    /// have been evicted. Commands that cannot be matched anymore are dropped.
+    void reanchor(Anchors const& anchors);
+
+    void clear();
+
+  private:
+    std::deque<CommandBlock> _blocks;
+    uint64_t _firstNumber = 0;
+};
+
+} // namespace vtbackend
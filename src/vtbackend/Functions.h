@@ -150,6 +150,7 @@ constexpr inline auto RCOLORHIGHLIGHTFG = FunctionDocumentation { .mnemonic = "R
 constexpr inline auto RCOLORMOUSEBG = FunctionDocumentation { .mnemonic = "RCOLORMOUSEBG", .comment = "Reset mouse background color." };
 constexpr inline auto RCOLORMOUSEFG = FunctionDocumentation { .mnemonic = "RCOLORMOUSEFG", .comment = "Reset mouse foreground color." };
 constexpr inline auto RCOLPAL = FunctionDocumentation { .mnemonic = "RCOLPAL", .comment = "Reset color full palette or entry" };
+constexpr inline auto SEMANTICPROMPT = FunctionDocumentation { .mnemonic = "SEMANTICPROMPT", .comment = "Shell integration semantic prompt marks" };
 constexpr inline auto SETCOLPAL = FunctionDocumentation { .mnemonic = "SETCOLPAL", .comment = "Set/Query color palette" };
 constexpr inline auto SETCWD = FunctionDocumentation { .mnemonic = "SETCWD", .comment = "Set current working directory" };
 constexpr inline auto SETFONT = FunctionDocumentation { .mnemonic = "SETFONT", .comment = "Get or set font." };
@@ -613,6 +614,7 @@ constexpr inline auto RCOLORHIGHLIGHTFG = detail::OSC(119, VTExtension::XTerm, d
 constexpr inline auto RCOLORMOUSEBG     = detail::OSC(114, VTExtension::XTerm, documentation::RCOLORMOUSEBG);
 constexpr inline auto RCOLORMOUSEFG     = detail::OSC(113, VTExtension::XTerm, documentation::RCOLORMOUSEFG);
 constexpr inline auto RCOLPAL           = detail::OSC(104, VTExtension::XTerm, documentation::RCOLPAL);
+constexpr inline auto SEMANTICPROMPT    = detail::OSC(133, VTExtension::Unknown, documentation::SEMANTICPROMPT);
 constexpr inline auto SETCOLPAL         = detail::OSC(4, VTExtension::XTerm, documentation::SETCOLPAL);
 constexpr inline auto SETCWD            = detail::OSC(7, VTExtension::XTerm, documentation::SETCWD);
 constexpr inline auto SETFONT           = detail::OSC(50, VTExtension::XTerm, documentation::SETFONT);
@@ -775,6 +777,7 @@ constexpr static auto allFunctionsArray() noexcept
         RCOLORHIGHLIGHTFG,
         RCOLORHIGHLIGHTBG,
         NOTIFY,
+        SEMANTICPROMPT,
         DUMPSTATE,
     };
     return funcs;
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <format>
 #include <iostream>
+#include <thread>
 
 using std::max;
 using std::min;
@@ -23,6 +24,35 @@ auto const inline gridLog = logstore::category(
 
 namespace detail
 {
+    // Minimum number of lines worth being reflowed by a thread of its own.
+    constexpr auto MinReflowSegmentLineCount = size_t { 1024 };
+
+    // Marks the columns of the given line that are empty or contain one of the given delimiters.
+    template <CellConcept Cell>
+    void markDelimitedColumns(Line<Cell> const& line, u32string_view delimiters, vector<bool>& output)
+    {
+        output.assign(unbox<size_t>(line.size()), true);
+
+        // US-ASCII text of a trivial line occupies one column per character, so the line need not be
+        // inflated.
+        if (line.isTrivialBuffer())
+        {
+            auto const text = line.trivialBuffer().text.view();
+            if (std::ranges::all_of(text, [](char ch) { return static_cast<unsigned char>(ch) < 0x80; }))
+            {
+                for (size_t column = 0; column < text.size() && column < output.size(); ++column)
+                    output[column] =
+                        delimiters.find(static_cast<char32_t>(text[column])) != u32string_view::npos;
+                return;
+            }
+        }
+
+        auto const cells = line.cells();
+        for (size_t column = 0; column < cells.size() && column < output.size(); ++column)
+            output[column] = CellUtil::empty(cells[column])
+                             || delimiters.find(cells[column].codepoint(0)) != u32string_view::npos;
+    }
+
     template <CellConcept Cell>
     gsl::span<Cell const> trimRight(gsl::span<Cell const> cells)
     {
@@ -127,6 +157,7 @@ void Grid<Cell>::setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount)
     _historyLimit = maxHistoryLineCount;
     _lines.resize(unbox<size_t>(_pageSize.lines + this->maxHistoryLineCount()));
     _linesUsed = min(_linesUsed, _pageSize.lines + this->maxHistoryLineCount());
+    pruneEvictedMarks();
     verifyState();
 }
 
@@ -134,6 +165,7 @@ template <CellConcept Cell>
 void Grid<Cell>::clearHistory()
 {
     _linesUsed = _pageSize.lines;
+    pruneEvictedMarks();
     verifyState();
 }
 
@@ -362,6 +394,12 @@ template <CellConcept Cell>
 LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes) noexcept
 {
     verifyState();
+
+    // Drop stale mark index entries of the lines about to scroll off into the history,
+    // so that they do not pile up there.
+    reindexMarks(LineOffset(0),
+                 boxed_cast<LineOffset>(std::min(linesCountToScrollUp, _pageSize.lines)) - LineOffset(1));
+
     // Number of lines in the ring buffer that are not yet
     // used by the grid system.
     auto const linesAvailable = LineCount::cast_from(_lines.size() - unbox<size_t>(_linesUsed));
@@ -381,12 +419,14 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
     {
         // TODO: ensure explicit test for this case
         rotateBuffersLeft(linesCountToScrollUp);
+        _pageTopLineNumber += *linesCountToScrollUp;
+        pruneEvictedMarks();
 
         // Initialize (/reset) new lines.
         for (auto y = boxed_cast<LineOffset>(_pageSize.lines - linesCountToScrollUp);
              y < boxed_cast<LineOffset>(_pageSize.lines);
              ++y)
-            lineAt(y).reset(defaultLineFlags(), defaultAttributes);
+            lineAt(y).reset(defaultLineFlags(), defaultAttributes, _pageSize.columns);
 
         return linesCountToScrollUp;
     }
@@ -407,17 +447,20 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
                                 TrivialLineBuffer { .displayWidth = _pageSize.columns,
                                                     .textAttributes = defaultAttributes } });
             rotateBuffersLeft(linesAppendCount);
+            _pageTopLineNumber += *linesAppendCount;
         }
         if (linesAppendCount < linesCountToScrollUp)
         {
             auto const incrementCount = linesCountToScrollUp - linesAppendCount;
             rotateBuffersLeft(incrementCount);
+            _pageTopLineNumber += *incrementCount;
+            pruneEvictedMarks();
 
             // Initialize (/reset) new lines.
             for (auto y = boxed_cast<LineOffset>(_pageSize.lines - linesCountToScrollUp);
                  y < boxed_cast<LineOffset>(_pageSize.lines);
                  ++y)
-                lineAt(y).reset(defaultLineFlags(), defaultAttributes);
+                lineAt(y).reset(defaultLineFlags(), defaultAttributes, _pageSize.columns);
         }
         return LineCount::cast_from(linesAppendCount);
     }
@@ -444,16 +487,14 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
         if (fullVertical) // full-screen scroll-up
             return scrollUp(n, defaultAttributes);
 
-        // scroll up only inside vertical margin with full horizontal extend
-        auto const marginHeight = LineCount(margin.vertical.length());
-        auto const n2 = std::min(n, marginHeight);
-        if (*n2 && n2 < marginHeight)
-        {
-            // rotate line attribs
-            for (auto topLineOffset = *margin.vertical.from; topLineOffset <= *margin.vertical.to - *n2;
-                 ++topLineOffset)
-                _lines[topLineOffset] = std::move(_lines[topLineOffset + *n2]);
-        }
+        // Scroll up only inside vertical margin with full horizontal extend.
+        //
+        // Lines are merely handles to their cell buffers, so this rotates the handles within the
+        // margin, without touching (or copying) any of the cells.
+        auto const n2 = std::min(n, LineCount(margin.vertical.length()));
+        auto const top = std::next(begin(_lines), *margin.vertical.from);
+        auto const bottom = std::next(begin(_lines), *margin.vertical.to + 1);
+        std::rotate(top, std::next(top, *n2), bottom);
 
         auto const topEmptyLineNr = *margin.vertical.to - *n2 + 1;
         auto const bottomLineNumber = *margin.vertical.to;
@@ -461,6 +502,7 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
         {
             _lines[lineNumber].reset(defaultLineFlags(), defaultAttributes, _pageSize.columns);
         }
+        reindexMarks(margin.vertical.from, margin.vertical.to);
     }
     else
     {
@@ -472,13 +514,14 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
         auto const bottomTargetLineOffset = margin.vertical.to - *n2;
         auto const columnsToMove = unbox<size_t>(margin.horizontal.length());
 
+        // Cells are moved rather than copied, so that their extras are handed over instead of cloned.
         for (LineOffset targetLineOffset = topTargetLineOffset; targetLineOffset <= bottomTargetLineOffset;
              ++targetLineOffset)
         {
             auto const sourceLineOffset = targetLineOffset + *n2;
             auto t = &useCellAt(targetLineOffset, margin.horizontal.from);
             auto s = &at(sourceLineOffset, margin.horizontal.from);
-            std::copy_n(s, columnsToMove, t);
+            std::move(s, s + columnsToMove, t);
         }
 
         for (LineOffset line = margin.vertical.to - *n2 + 1; line <= margin.vertical.to; ++line)
@@ -524,9 +567,19 @@ void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttri
         // bottom N lines are wiped out
 
         rotateBuffersRight(n);
+        _pageTopLineNumber -= *n;
 
+        // Lines pulled down from the history are wiped, hence need no reflow anymore.
+        _firstReflowedLineNumber = std::min(_firstReflowedLineNumber, _pageTopLineNumber);
         for (Line<Cell>& line: mainPage().subspan(0, unbox<size_t>(n)))
-            line.reset(defaultLineFlags(), defaultAttributes);
+            line.reset(defaultLineFlags(), defaultAttributes, _pageSize.columns);
+
+        // With all lines in use, the lines rotated off the page bottom wrapped around to the history top.
+        if (unbox<size_t>(_linesUsed) == _lines.size() && *historyLineCount() > 0)
+        {
+            auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+            reindexMarks(historyTop, std::min(historyTop + *n, LineOffset(0)) - 1);
+        }
         return;
     }
 
@@ -539,26 +592,28 @@ void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttri
         std::rotate(a, b, c);
         for (auto const i: ranges::views::iota(*margin.vertical.from, *margin.vertical.from + *n))
             _lines[i].reset(defaultLineFlags(), defaultAttributes);
+        reindexMarks(margin.vertical.from, margin.vertical.to);
     }
     else
     {
         // a full "inside" scroll-down
         if (n <= margin.vertical.length())
         {
-            for (LineOffset line = margin.vertical.to; line >= margin.vertical.to - *n; --line)
+            // Cells are moved rather than copied, so that their extras are handed over instead of cloned.
+            for (LineOffset line = margin.vertical.to; line >= margin.vertical.from + *n; --line)
             {
                 auto s = &at(line - *n, margin.horizontal.from);
                 auto t = &at(line, margin.horizontal.from);
-                std::copy_n(s, unbox<size_t>(margin.horizontal.length()), t);
+                std::move(s, s + unbox<size_t>(margin.horizontal.length()), t);
             }
 
             for (LineOffset line = margin.vertical.from; line < margin.vertical.from + *n; ++line)
             {
                 auto a = &at(line, margin.horizontal.from);
-                auto b = &at(line, margin.horizontal.to + 1);
+                auto b = a + unbox(margin.horizontal.length());
                 while (a != b)
                 {
-                    *a = Cell { defaultAttributes };
+                    a->reset(defaultAttributes);
                     a++;
                 }
             }
@@ -577,9 +632,22 @@ void Grid<Cell>::scrollLeft(GraphicsAttributes defaultAttributes, Margin margin)
         auto column2 = line.inflatedBuffer().begin() + *margin.horizontal.to + 1;
         std::rotate(column0, column1, column2);
 
-        auto const emptyCell = Cell { defaultAttributes };
-        auto const emptyCellsBegin = line.inflatedBuffer().begin() + *margin.horizontal.to;
-        std::fill_n(emptyCellsBegin, 1, emptyCell);
+        // The vacated cell is reset in-place, rather than assigned a copy of an empty cell.
+        std::prev(column2)->reset(defaultAttributes);
+    }
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::scrollRight(GraphicsAttributes defaultAttributes, Margin margin) noexcept
+{
+    for (LineOffset lineNo = margin.vertical.from; lineNo <= margin.vertical.to; ++lineNo)
+    {
+        auto& line = lineAt(lineNo);
+        auto column0 = line.inflatedBuffer().begin() + *margin.horizontal.from;
+        auto column1 = line.inflatedBuffer().begin() + *margin.horizontal.to;
+        auto column2 = line.inflatedBuffer().begin() + *margin.horizontal.to + 1;
+        std::rotate(column0, column1, column2);
+        column0->reset(defaultAttributes);
     }
 }
 
@@ -592,6 +660,7 @@ void Grid<Cell>::reset()
     _lines.rotate_right(_lines.zero_index());
     for (int i = 0; i < unbox(_pageSize.lines); ++i)
         _lines[i].reset(defaultLineFlags(), GraphicsAttributes {});
+    _markedLines.clear();
     verifyState();
 }
 
@@ -613,6 +682,7 @@ CellLocation Grid<Cell>::growLines(LineCount newHeight, CellLocation cursor)
         Require(totalLinesToExtend >= linesToTakeFromSavedLines);
         Require(*linesToTakeFromSavedLines >= 0);
         rotateBuffersRight(linesToTakeFromSavedLines);
+        _pageTopLineNumber -= *linesToTakeFromSavedLines;
         _pageSize.lines += linesToTakeFromSavedLines;
         cursorMove.line += boxed_cast<LineOffset>(linesToTakeFromSavedLines);
     }
@@ -699,6 +769,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             gridLog()(" -> numLinesToPushUp {}", numLinesToPushUp);
             Require(*cursor.line + 1 == *_pageSize.lines);
             rotateBuffersLeft(numLinesToPushUp);
+            _pageTopLineNumber += *numLinesToPushUp;
             _pageSize.lines -= numLinesToPushUp;
             clampHistory();
             verifyState();
@@ -939,19 +1010,82 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             return cursor; // TODO
         }
     };
+
+    auto const reflowColumnsLazily = [this, wrapPending](ColumnCount newColumnCount,
+                                                         CellLocation cursor) -> CellLocation {
+        // Only the lines of the main page (along with the logical line reaching into it) are reflowed
+        // right away. All lines above are left as they are, to be reflowed once they are needed.
+        auto const growing = newColumnCount > _pageSize.columns;
+        auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+        auto const pageBottom = boxed_cast<LineOffset>(_pageSize.lines);
+
+        auto begin = LineOffset(0);
+        while (begin > historyTop && lineAt(begin).wrapped())
+            --begin;
+
+        Lines<Cell> reflowedLines;
+        reflowLines(begin, pageBottom, newColumnCount, reflowedLines);
+        _pageSize.columns = newColumnCount;
+        auto missingLineCount = spliceReflowedLines(begin, pageBottom, std::move(reflowedLines));
+
+        // Fewer lines after reflow pull lines down from the history into the main page.
+        while (*unreflowedLineCount() != 0 && lineOffsetOf(_firstReflowedLineNumber) > LineOffset(0))
+            missingLineCount += reflowHistoryChunk(LineOffset(0));
+
+        verifyState();
+        if (growing)
+            cursor += CellLocation { .line = -boxed_cast<LineOffset>(missingLineCount),
+                                     .column = ColumnOffset(wrapPending ? 1 : 0) };
+        return cursor;
+    };
+
+    auto const reflowColumnsConcurrently = [this, wrapPending](ColumnCount newColumnCount,
+                                                               CellLocation cursor) -> CellLocation {
+        auto const growing = newColumnCount > _pageSize.columns;
+        auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+        auto const pageBottom = boxed_cast<LineOffset>(_pageSize.lines);
+
+        Lines<Cell> reflowedLines;
+        reflowLinesConcurrently(historyTop, pageBottom, newColumnCount, reflowedLines);
+        _pageSize.columns = newColumnCount;
+        auto const missingLineCount = spliceReflowedLines(historyTop, pageBottom, std::move(reflowedLines));
+
+        verifyState();
+        if (growing)
+            cursor += CellLocation { .line = -boxed_cast<LineOffset>(missingLineCount),
+                                     .column = ColumnOffset(wrapPending ? 1 : 0) };
+        return cursor;
+    };
     // }}}
 
     CellLocation cursor = currentCursorPos;
+    auto const reflowing = _reflowOnResize && newSize.columns != _pageSize.columns;
+    auto const reflowingLazily = reflowing && _lazyHistoryReflow;
+
+    // Any other way of resizing columns expects all lines to be laid out for the current page width.
+    if (newSize.columns != _pageSize.columns && !reflowingLazily)
+        reflowHistory();
 
     // grow/shrink columns
     using crispy::comparison;
-    switch (crispy::strongCompare(newSize.columns, _pageSize.columns))
+    if (reflowingLazily)
+        cursor = reflowColumnsLazily(newSize.columns, cursor);
+    else if (reflowing && _reflowThreadCount > 1)
+        cursor = reflowColumnsConcurrently(newSize.columns, cursor);
+    else
     {
-        case comparison::Greater: cursor += growColumns(newSize.columns); break;
-        case comparison::Less: cursor = shrinkColumns(newSize.columns, newSize.lines, cursor); break;
-        case comparison::Equal: break;
+        switch (crispy::strongCompare(newSize.columns, _pageSize.columns))
+        {
+            case comparison::Greater: cursor += growColumns(newSize.columns); break;
+            case comparison::Less: cursor = shrinkColumns(newSize.columns, newSize.lines, cursor); break;
+            case comparison::Equal: break;
+        }
     }
 
+    // Growing the page may pull lines down from the history, which must fit the page width.
+    if (newSize.lines > _pageSize.lines)
+        reflowHistoryUntil(-boxed_cast<LineOffset>(newSize.lines - _pageSize.lines));
+
     // grow/shrink lines
     switch (crispy::strongCompare(newSize.lines, _pageSize.lines))
     {
@@ -961,11 +1095,273 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
     }
 
     Ensures(_pageSize == newSize);
+
+    // Reflowing eagerly rebuilds all lines, whereas growing the page may uncover lines not indexed yet.
+    // Lazily reflowed lines have been re-indexed while being spliced in.
+    if (reflowing && !reflowingLazily)
+    {
+        _markedLines.clear();
+        reindexMarks(-boxed_cast<LineOffset>(historyLineCount()),
+                     boxed_cast<LineOffset>(_pageSize.lines) - 1);
+    }
+    else
+        reindexMarks(LineOffset(0), boxed_cast<LineOffset>(_pageSize.lines) - 1);
+    pruneEvictedMarks();
     verifyState();
 
     return cursor;
 }
 
+
+template <CellConcept Cell>
+LineCount Grid<Cell>::unreflowedLineCount() const noexcept
+{
+    auto const historyTop = lineNumberOf(-boxed_cast<LineOffset>(historyLineCount()));
+    if (_firstReflowedLineNumber <= historyTop)
+        return LineCount(0);
+    return LineCount::cast_from(std::min(_firstReflowedLineNumber, _pageTopLineNumber) - historyTop);
+}
+
+template <CellConcept Cell>
+bool Grid<Cell>::reflowHistoryUntil(LineOffset top)
+{
+    auto reflowed = false;
+    while (*unreflowedLineCount() != 0 && lineOffsetOf(_firstReflowedLineNumber) > top)
+    {
+        (void) reflowHistoryChunk(top);
+        reflowed = true;
+    }
+    return reflowed;
+}
+
+template <CellConcept Cell>
+LineCount Grid<Cell>::reflowHistoryChunk(LineOffset top)
+{
+    auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+    auto const end = lineOffsetOf(_firstReflowedLineNumber);
+    auto const reflowedLineCount = boxed_cast<LineOffset>(_pageSize.lines) - end;
+
+    // Only whole logical lines can be reflowed.
+    auto begin = std::max(historyTop, std::min(top, end - reflowedLineCount));
+    while (begin > historyTop && lineAt(begin).wrapped())
+        --begin;
+
+    gridLog()("reflow history lines {}..{} (of {})", begin, end - 1, historyLineCount());
+
+    Lines<Cell> reflowedLines;
+    reflowLinesConcurrently(begin, end, _pageSize.columns, reflowedLines);
+    auto const missingLineCount = spliceReflowedLines(begin, end, std::move(reflowedLines));
+    verifyState();
+    return missingLineCount;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::reflowLines(LineOffset begin,
+                             LineOffset end,
+                             ColumnCount newColumnCount,
+                             Lines<Cell>& output)
+{
+    using LineBuffer = typename Line<Cell>::InflatedBuffer;
+
+    auto first = begin;
+    while (first < end)
+    {
+        // All lines of a logical line have been laid out for the same column count.
+        auto last = first + 1;
+        while (last < end && lineAt(last).wrapped())
+            ++last;
+
+        auto const columnCount = lineAt(first).size();
+        if (columnCount == newColumnCount)
+        {
+            for (auto line = first; line < last; ++line)
+                output.emplace_back(std::move(lineAt(line)));
+        }
+        else if (columnCount < newColumnCount)
+        {
+            // Join the wrapped lines, like growColumns does.
+            auto& line = lineAt(first);
+            if (last == first + 1 && line.isTrivialBuffer())
+            {
+                line.trivialBuffer().displayWidth = newColumnCount;
+                output.emplace_back(std::move(line));
+            }
+            else
+            {
+                LineBuffer logicalLineBuffer;
+                for (auto const& cell: line.cells())
+                    logicalLineBuffer.push_back(cell);
+                for (auto wrapped = first + 1; wrapped < last; ++wrapped)
+                    for (auto const& cell: lineAt(wrapped).trim_blank_right())
+                        logicalLineBuffer.push_back(cell);
+                detail::addNewWrappedLines(output,
+                                           newColumnCount,
+                                           std::move(logicalLineBuffer),
+                                           line.flags().without(LineFlag::Wrapped),
+                                           true);
+            }
+        }
+        else
+        {
+            // Carry the overflowing columns over to the wrapped lines, like shrinkColumns does.
+            LineBuffer wrappedColumns;
+            LineFlags previousFlags = lineAt(first).inheritableFlags();
+            for (auto i = first; i < last; ++i)
+            {
+                auto& line = lineAt(i);
+                if (!wrappedColumns.empty())
+                {
+                    if (line.inheritableFlags() == previousFlags)
+                    {
+                        auto& editable = line.inflatedBuffer();
+                        editable.insert(editable.begin(), wrappedColumns.begin(), wrappedColumns.end());
+                    }
+                    else
+                    {
+                        detail::addNewWrappedLines(
+                            output, newColumnCount, std::move(wrappedColumns), previousFlags, false);
+                        previousFlags = line.inheritableFlags();
+                    }
+                }
+                else
+                {
+                    line.setWrappable(true);
+                    previousFlags = line.inheritableFlags();
+                }
+
+                wrappedColumns = line.reflow(newColumnCount);
+                output.emplace_back(std::move(line));
+            }
+            detail::addNewWrappedLines(
+                output, newColumnCount, std::move(wrappedColumns), previousFlags, false);
+        }
+
+        first = last;
+    }
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::reflowLinesConcurrently(LineOffset begin,
+                                         LineOffset end,
+                                         ColumnCount newColumnCount,
+                                         Lines<Cell>& output)
+{
+    auto const lineCount = unbox<size_t>(end - begin);
+    auto const segmentCount =
+        std::clamp(lineCount / detail::MinReflowSegmentLineCount, size_t { 1 }, _reflowThreadCount);
+    if (segmentCount == 1)
+    {
+        reflowLines(begin, end, newColumnCount, output);
+        return;
+    }
+
+    // Segments must not cut through a logical line, as its lines are reflowed together.
+    auto bounds = vector<LineOffset> { begin };
+    for (size_t i = 1; i < segmentCount; ++i)
+    {
+        auto bound = begin + LineOffset::cast_from(lineCount * i / segmentCount);
+        while (bound > bounds.back() && lineAt(bound).wrapped())
+            --bound;
+        if (bound > bounds.back())
+            bounds.push_back(bound);
+    }
+    bounds.push_back(end);
+
+    gridLog()("reflow lines {}..{} in {} segments", begin, end - 1, bounds.size() - 1);
+
+    // The first segment is reflowed by the calling thread.
+    auto segments = vector<Lines<Cell>>(bounds.size() - 1);
+    auto workers = vector<std::thread> {};
+    for (size_t i = 1; i < segments.size(); ++i)
+        workers.emplace_back([this, &bounds, &segments, newColumnCount, i]() {
+            reflowLines(bounds[i], bounds[i + 1], newColumnCount, segments[i]);
+        });
+    reflowLines(bounds[0], bounds[1], newColumnCount, segments[0]);
+    for (auto& worker: workers)
+        worker.join();
+
+    auto reflowedLineCount = output.size();
+    for (auto const& segment: segments)
+        reflowedLineCount += segment.size();
+    output.reserve(reflowedLineCount);
+    for (auto& segment: segments)
+        for (auto& line: segment.storage())
+            output.emplace_back(std::move(line));
+}
+
+template <CellConcept Cell>
+LineCount Grid<Cell>::spliceReflowedLines(LineOffset begin, LineOffset end, Lines<Cell>&& reflowedLines)
+{
+    auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+    auto const pageBottom = boxed_cast<LineOffset>(_pageSize.lines);
+    auto const linesAbove = unbox<size_t>(begin - historyTop);
+    auto const linesBelow = unbox<size_t>(pageBottom - end);
+    auto const capacity = std::holds_alternative<Infinite>(_historyLimit)
+                              ? std::max(_lines.size(), linesAbove + reflowedLines.size() + linesBelow)
+                              : std::max(unbox<size_t>(totalLineCount()), linesBelow);
+
+    // Lines exceeding the history limit are dropped from the top.
+    auto const keptReflowedLineCount = std::min(reflowedLines.size(), capacity - linesBelow);
+    auto const keptLineCountAbove = std::min(linesAbove, capacity - linesBelow - keptReflowedLineCount);
+
+    auto const beginNumber = lineNumberOf(begin);
+    auto const endNumber = lineNumberOf(end);
+
+    Lines<Cell> lines;
+    lines.reserve(capacity);
+    for (auto line = begin - LineOffset::cast_from(keptLineCountAbove); line < begin; ++line)
+        lines.emplace_back(std::move(lineAt(line)));
+    for (auto i = reflowedLines.size() - keptReflowedLineCount; i < reflowedLines.size(); ++i)
+        lines.emplace_back(std::move(reflowedLines.storage()[i]));
+    for (auto line = end; line < pageBottom; ++line)
+        lines.emplace_back(std::move(lineAt(line)));
+
+    auto const appendBlankLine = [&]() {
+        lines.emplace_back(defaultLineFlags(),
+                           TrivialLineBuffer { .displayWidth = _pageSize.columns,
+                                               .textAttributes = GraphicsAttributes {},
+                                               .fillAttributes = GraphicsAttributes {} });
+    };
+
+    // The reflowed lines might not fill the main page anymore, so fill the gap below.
+    auto const missingLineCount = LineCount::cast_from(lines.size()) < _pageSize.lines
+                                      ? _pageSize.lines - LineCount::cast_from(lines.size())
+                                      : LineCount(0);
+    for (auto i = 0; i < *missingLineCount; ++i)
+        appendBlankLine();
+
+    auto const linesUsed = LineCount::cast_from(lines.size());
+    while (lines.size() < capacity)
+        appendBlankLine();
+
+    lines.rotate_left(unbox<size_t>(linesUsed - _pageSize.lines));
+    _lines = std::move(lines);
+    _linesUsed = linesUsed;
+
+    // Line numbers of the main page remain, so the line numbers above change by as many lines as
+    // have been added (or removed) below them.
+    auto const shift =
+        static_cast<int64_t>(keptReflowedLineCount) - unbox<int64_t>(end - begin) + *missingLineCount;
+    auto markedLines = std::set<int64_t> {};
+    for (auto const lineNumber: _markedLines)
+    {
+        if (lineNumber < beginNumber)
+            markedLines.emplace_hint(markedLines.end(), lineNumber - shift);
+        else if (lineNumber >= endNumber)
+            markedLines.emplace_hint(markedLines.end(), lineNumber - *missingLineCount);
+    }
+    _markedLines = std::move(markedLines);
+
+    auto const reflowedTop = end - LineOffset::cast_from(keptReflowedLineCount)
+                             - boxed_cast<LineOffset>(missingLineCount);
+    reindexMarks(reflowedTop, reflowedTop + LineOffset::cast_from(keptReflowedLineCount) - 1);
+    pruneEvictedMarks();
+
+    _firstReflowedLineNumber = lineNumberOf(reflowedTop);
+    return missingLineCount;
+}
+
+
 template <CellConcept Cell>
 void Grid<Cell>::clampHistory()
 {
@@ -986,7 +1382,7 @@ void Grid<Cell>::appendNewLines(LineCount count, GraphicsAttributes attr)
         {
             auto line = std::move(_lines.front());
             _lines.pop_front();
-            line.reset(defaultLineFlags(), attr);
+            line.reset(defaultLineFlags(), attr, _pageSize.columns);
             _lines.emplace_back(std::move(line));
         }
         return;
@@ -1004,6 +1400,72 @@ void Grid<Cell>::appendNewLines(LineCount count, GraphicsAttributes attr)
     }
 }
 // }}}
+// {{{ Grid impl: line marks
+template <CellConcept Cell>
+void Grid<Cell>::enableLineFlags(LineOffset line, LineFlags flags, bool enable) noexcept
+{
+    lineAt(line).setFlag(flags, enable);
+
+    if (!flags.contains(LineFlag::Marked))
+        return;
+
+    if (enable)
+        _markedLines.insert(lineNumberOf(line));
+    else
+        _markedLines.erase(lineNumberOf(line));
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkerUpwards(LineOffset line) const noexcept
+{
+    auto const historyTop = lineNumberOf(-boxed_cast<LineOffset>(historyLineCount()));
+    auto i = _markedLines.lower_bound(lineNumberOf(line));
+    while (i != _markedLines.begin())
+    {
+        --i;
+        if (*i < historyTop)
+            return std::nullopt;
+        if (lineAt(lineOffsetOf(*i)).marked())
+            return lineOffsetOf(*i);
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkerDownwards(LineOffset line) const noexcept
+{
+    auto const historyTop = lineNumberOf(-boxed_cast<LineOffset>(historyLineCount()));
+    auto const pageBottom = lineNumberOf(boxed_cast<LineOffset>(_pageSize.lines) - 1);
+    auto i = _markedLines.lower_bound(std::max(lineNumberOf(line) + 1, historyTop));
+    while (i != _markedLines.end() && *i <= pageBottom)
+    {
+        if (lineAt(lineOffsetOf(*i)).marked())
+            return lineOffsetOf(*i);
+        ++i;
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::reindexMarks(LineOffset from, LineOffset to) noexcept
+{
+    if (to < from)
+        return;
+
+    auto hint = _markedLines.erase(_markedLines.lower_bound(lineNumberOf(from)),
+                                   _markedLines.upper_bound(lineNumberOf(to)));
+    for (auto line = from; line <= to; ++line)
+        if (lineAt(line).marked())
+            _markedLines.emplace_hint(hint, lineNumberOf(line));
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::pruneEvictedMarks() noexcept
+{
+    auto const historyTop = lineNumberOf(-boxed_cast<LineOffset>(historyLineCount()));
+    _markedLines.erase(_markedLines.begin(), _markedLines.lower_bound(historyTop));
+}
+// }}}
 // {{{ dumpGrid impl
 template <CellConcept Cell>
 std::ostream& dumpGrid(std::ostream& os, Grid<Cell> const& grid)
@@ -1039,11 +1501,50 @@ std::string dumpGrid(Grid<Cell> const& grid)
 }
 // }}}
 
+template <CellConcept Cell>
+GridSnapshot<Cell> Grid<Cell>::snapshot() const
+{
+    return snapshot(-boxed_cast<LineOffset>(historyLineCount()),
+                    boxed_cast<LineOffset>(_pageSize.lines) - LineOffset(1));
+}
+
+template <CellConcept Cell>
+GridSnapshot<Cell> Grid<Cell>::snapshot(LineOffset top, LineOffset bottom) const
+{
+    Require(-boxed_cast<LineOffset>(historyLineCount()) <= top);
+    Require(bottom < boxed_cast<LineOffset>(_pageSize.lines));
+
+    auto result = GridSnapshot<Cell> { .lines = {},
+                                       .pageSize = _pageSize,
+                                       .historyLineCount = historyLineCount(),
+                                       .topLine = top,
+                                       .topLineNumber = lineNumberOf(top) };
+    result.lines.reserve(static_cast<size_t>(std::max(unbox(bottom - top) + 1, 0)));
+    for (auto line = top; line <= bottom; ++line)
+        result.lines.emplace_back(lineAt(line));
+    return result;
+}
+
 template <CellConcept Cell>
 CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
                                                    u32string_view wordDelimiters) const noexcept
 {
-    auto const left = [this, wordDelimiters, position]() {
+    // The delimiters are looked up for a whole line at once, rather than cell by cell.
+    auto delimitedColumns = vector<bool> {};
+    auto delimitedLine = std::optional<LineOffset> {};
+    auto const delimited = [&](CellLocation location) {
+        if (delimitedLine != location.line)
+        {
+            detail::markDelimitedColumns(lineAt(location.line), wordDelimiters, delimitedColumns);
+            delimitedLine = location.line;
+        }
+        // Columns outside of the line delimit words just like delimiter characters do.
+        auto const column = unbox(location.column);
+        return column < 0 || static_cast<size_t>(column) >= delimitedColumns.size()
+               || delimitedColumns[static_cast<size_t>(column)];
+    };
+
+    auto const left = [this, &delimited, position]() {
         auto last = position;
         auto current = last;
 
@@ -1061,14 +1562,14 @@ CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
             else
                 break;
 
-            if (cellEmptyOrContainsOneOf(current, wordDelimiters))
+            if (delimited(current))
                 break;
             last = current;
         }
         return last;
     }();
 
-    auto const right = [this, wordDelimiters, position]() {
+    auto const right = [this, &delimited, position]() {
         auto last = position;
         auto current = last;
 
@@ -1097,7 +1598,7 @@ CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
             else
                 break;
 
-            if (cellEmptyOrContainsOneOf(current, wordDelimiters))
+            if (delimited(current))
                 break;
             last = current;
         }
@@ -21,8 +21,13 @@
 #include <gsl/span_ext>
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace vtbackend
 {
@@ -566,6 +571,39 @@ struct ReverseLogicalLines
     }
 };
 
+/// Lines of a grid, as they have been when the snapshot was taken.
+///
+/// Lines share their storage with the grid's lines until the grid modifies them (see Line),
+/// so taking a snapshot only copies line handles. A snapshot must be taken while holding
+/// the terminal lock, but can then be read, copied and destroyed on any thread while the grid
+/// keeps changing, as the shared storage is reference counted atomically and PTY buffers may be
+/// released into their pool from any thread.
+///
+/// The one exception are lines holding image fragments: dropping the last reference to an image
+/// reports its removal to the terminal, so a snapshot of such lines must be destroyed on the
+/// terminal thread, or while holding the terminal lock.
+template <CellConcept Cell>
+struct GridSnapshot
+{
+    /// The snapshotted lines, from top to bottom.
+    std::vector<Line<Cell>> lines;
+
+    PageSize pageSize;
+    LineCount historyLineCount;
+
+    /// Offset of the topmost snapshotted line, relative to the top of the main page.
+    LineOffset topLine;
+
+    /// Absolute line number of the topmost snapshotted line (see Grid::lineNumberOf()).
+    int64_t topLineNumber = 0;
+
+    /// @returns the line at the given offset relative to the top of the main page.
+    [[nodiscard]] Line<Cell> const& lineAt(LineOffset line) const noexcept
+    {
+        return lines[unbox<size_t>(line - topLine)];
+    }
+};
+
 /**
  * Manages the screen grid buffer (main screen + scrollback history).
  *
@@ -624,6 +662,22 @@ class Grid
     [[nodiscard]] bool reflowOnResize() const noexcept { return _reflowOnResize; }
     void setReflowOnResize(bool enabled) { _reflowOnResize = enabled; }
 
+    [[nodiscard]] bool lazyHistoryReflow() const noexcept { return _lazyHistoryReflow; }
+
+    /// Enables or disables deferring the reflow of the history lines upon resize.
+    ///
+    /// When enabled, resizing only reflows the lines of the main page right away, whereas the history
+    /// lines keep the page width they have last been reflowed for, until reflowHistoryUntil() is invoked.
+    void setLazyHistoryReflow(bool enabled) noexcept { _lazyHistoryReflow = enabled; }
+
+    [[nodiscard]] size_t reflowThreadCount() const noexcept { return _reflowThreadCount; }
+
+    /// Sets the number of threads the history lines may be reflowed with concurrently.
+    ///
+    /// The lines are cut into segments of whole logical lines, which do not depend on each other.
+    /// Reflowing only few lines remains serial, as it would not outweigh the cost of spawning threads.
+    void setReflowThreadCount(size_t count) noexcept { _reflowThreadCount = std::max(count, size_t { 1 }); }
+
     [[nodiscard]] PageSize pageSize() const noexcept { return _pageSize; }
 
     /// Resizes the main page area of the grid and adapts the scrollback area's width accordingly.
@@ -634,6 +688,23 @@ class Grid
     ///
     /// @returns updated cursor position.
     [[nodiscard]] CellLocation resize(PageSize newSize, CellLocation currentCursorPos, bool wrapPending);
+
+    /// @returns the number of lines at the top of the history that have not been reflowed
+    ///          for the current page width yet.
+    [[nodiscard]] LineCount unreflowedLineCount() const noexcept;
+
+    /// Reflows the history lines not reflowed yet, such that all lines from @p top down to the
+    /// bottom of the main page are laid out for the current page width.
+    ///
+    /// The lines that have been reflowed already keep their offsets, whereas the offsets
+    /// (and line numbers) of the lines above them change.
+    ///
+    /// @retval true   history lines have been reflowed.
+    /// @retval false  all lines from @p top on have been reflowed already.
+    bool reflowHistoryUntil(LineOffset top);
+
+    /// Reflows all history lines not reflowed yet.
+    bool reflowHistory() { return reflowHistoryUntil(-boxed_cast<LineOffset>(historyLineCount())); }
     // }}}
 
     // {{{ Line API
@@ -649,6 +720,14 @@ class Grid
 
     [[nodiscard]] std::string lineText(LineOffset line) const;
     [[nodiscard]] std::string lineTextTrimmed(LineOffset line) const;
+
+    /// @returns a snapshot of the history and main page lines, to be read while the grid keeps changing.
+    ///
+    /// History lines not reflowed yet (see unreflowedLineCount()) are snapshotted as they are.
+    [[nodiscard]] GridSnapshot<Cell> snapshot() const;
+
+    /// @returns a snapshot of the lines from @p top to @p bottom (inclusive).
+    [[nodiscard]] GridSnapshot<Cell> snapshot(LineOffset top, LineOffset bottom) const;
     [[nodiscard]] std::string lineText(Line<Cell> const& line) const;
 
     void setLineText(LineOffset line, std::string_view text);
@@ -663,6 +742,28 @@ class Grid
     [[nodiscard]] int computeLogicalLineNumberFromBottom(LineCount n) const noexcept;
 
     [[nodiscard]] size_t zero_index() const noexcept { return _lines.zero_index(); }
+
+    /// @returns the absolute number of the given line, which remains stable while the grid is scrolling.
+    ///
+    /// Line numbers are only re-assigned when reflowing lines on resize.
+    [[nodiscard]] int64_t lineNumberOf(LineOffset line) const noexcept { return _pageTopLineNumber + *line; }
+
+    /// @returns the line offset of the line with the given absolute line number.
+    [[nodiscard]] LineOffset lineOffsetOf(int64_t lineNumber) const noexcept
+    {
+        return LineOffset::cast_from(lineNumber - _pageTopLineNumber);
+    }
+    // }}}
+
+    // {{{ Line marks
+    /// Enables or disables the given flags on the given line, keeping the line mark index up to date.
+    void enableLineFlags(LineOffset line, LineFlags flags, bool enable) noexcept;
+
+    /// @returns the nearest marked line strictly above @p line, if any.
+    [[nodiscard]] std::optional<LineOffset> findMarkerUpwards(LineOffset line) const noexcept;
+
+    /// @returns the nearest marked line strictly below @p line within the main page, if any.
+    [[nodiscard]] std::optional<LineOffset> findMarkerDownwards(LineOffset line) const noexcept;
     // }}}
 
     /// Gets a reference to the cell relative to screen origin (top left, 0:0).
@@ -726,6 +827,9 @@ class Grid
 
     // Scrolls the data within the margins to the left filling the new space on the right with empty cells.
     void scrollLeft(GraphicsAttributes defaultAttributes, Margin margin) noexcept;
+
+    // Scrolls the data within the margins to the right filling the new space on the left with empty cells.
+    void scrollRight(GraphicsAttributes defaultAttributes, Margin margin) noexcept;
     // }}}
 
     // {{{ Rendering API
@@ -823,10 +927,50 @@ class Grid
     void rotateBuffersRight(LineCount count) noexcept { _lines.rotate_right(unbox<size_t>(count)); }
     // }}}
 
+    // {{{ line mark index helpers
+    /// Re-indexes the marks of all lines within the given (inclusive) range of lines.
+    void reindexMarks(LineOffset from, LineOffset to) noexcept;
+
+    /// Drops index entries of lines that have been evicted from the history.
+    void pruneEvictedMarks() noexcept;
+    // }}}
+
+    // {{{ reflow helpers
+    /// Appends the lines within [begin, end), reflowed for the given column count, to @p output.
+    ///
+    /// Each logical line is reflowed from the column count it has last been laid out for.
+    /// Only the lines within [begin, end) are touched, so disjoint ranges may be reflowed concurrently.
+    void reflowLines(LineOffset begin, LineOffset end, ColumnCount newColumnCount, Lines<Cell>& output);
+
+    /// Same as reflowLines(), but reflows segments of the lines on up to reflowThreadCount() threads.
+    void reflowLinesConcurrently(LineOffset begin,
+                                 LineOffset end,
+                                 ColumnCount newColumnCount,
+                                 Lines<Cell>& output);
+
+    /// Replaces the lines within [begin, end) with the given reflowed lines, which become
+    /// the topmost lines laid out for the current page width.
+    ///
+    /// The lines below keep their offsets, whereas the lines above are moved accordingly.
+    ///
+    /// @returns the number of blank lines appended, in case the lines do not fill the main page.
+    LineCount spliceReflowedLines(LineOffset begin, LineOffset end, Lines<Cell>&& reflowedLines);
+
+    /// Reflows the bottom-most history lines not reflowed yet, up to at least @p top.
+    ///
+    /// At least as many lines as have been reflowed already are reflowed at once, such that
+    /// reflowing all of the history on demand only takes a logarithmic number of passes.
+    ///
+    /// @returns the number of blank lines appended, in case the lines do not fill the main page.
+    LineCount reflowHistoryChunk(LineOffset top);
+    // }}}
+
     // private fields
     //
     PageSize _pageSize;
     bool _reflowOnResize = false;
+    bool _lazyHistoryReflow = false;
+    size_t _reflowThreadCount = 1;
     MaxHistoryLineCount _historyLimit;
 
     // Number of lines is at least the sum of _maxHistoryLineCount + _pageSize.lines,
@@ -836,6 +980,21 @@ class Grid
 
     // Number of lines used in the Lines buffer.
     LineCount _linesUsed;
+
+    // Absolute number of the top line of the main page, i.e. how many lines have been scrolled into
+    // the history so far. Line offsets relative to it yield line numbers that remain stable while
+    // the grid is scrolling.
+    int64_t _pageTopLineNumber = 0;
+
+    // Ordered absolute line numbers of marked lines.
+    //
+    // Each marked line is guaranteed to be indexed. Entries of lines that got unmarked by other means
+    // (such as a reset) are skipped upon lookup, and dropped when re-indexing the lines on scrolling.
+    std::set<int64_t> _markedLines;
+
+    // Absolute number of the topmost line laid out for the current page width.
+    // History lines above it are reflowed on demand only (see reflowHistoryUntil()).
+    int64_t _firstReflowedLineNumber = std::numeric_limits<int64_t>::min();
 };
 
 template <CellConcept Cell>
@@ -8,6 +8,8 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <format>
+#include <thread>
+#include <utility>
 
 using namespace vtbackend;
 using namespace std::string_literals;
@@ -311,6 +313,50 @@ TEST_CASE("LogicalLines.reverse_iterator", "[grid]")
     REQUIRE(lineIt == endIt);
 }
 
+TEST_CASE("scrollUp_within_vertical_margin", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(4), ColumnCount(3) }, false, LineCount(0));
+    grid.setLineText(LineOffset(0), "ABC");
+    grid.setLineText(LineOffset(1), "DEF");
+    grid.setLineText(LineOffset(2), "GHI");
+    grid.setLineText(LineOffset(3), "JKL");
+    auto const* const cellsOfGHI = &grid.useCellAt(LineOffset(2), ColumnOffset(0));
+
+    auto const margin =
+        Margin { .vertical = Margin::Vertical { .from = LineOffset(1), .to = LineOffset(2) },
+                 .horizontal = Margin::Horizontal { .from = ColumnOffset(0), .to = ColumnOffset(2) } };
+    grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin);
+
+    CHECK(grid.lineText(LineOffset(0)) == "ABC");
+    CHECK(grid.lineText(LineOffset(1)) == "GHI");
+    CHECK(grid.lineText(LineOffset(2)) == "   ");
+    CHECK(grid.lineText(LineOffset(3)) == "JKL");
+    CHECK(grid.historyLineCount() == LineCount(0));
+
+    // The line has been moved as a whole, not cell by cell.
+    CHECK(&grid.useCellAt(LineOffset(1), ColumnOffset(0)) == cellsOfGHI);
+}
+
+TEST_CASE("scrollUp_within_margins_moves_extras", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(3) }, false, LineCount(0));
+    grid.setLineText(LineOffset(0), "ABC");
+    grid.setLineText(LineOffset(1), "DEF");
+    grid.setLineText(LineOffset(2), "GHI");
+    grid.useCellAt(LineOffset(2), ColumnOffset(1)).appendCharacter(U'\u0301');
+
+    auto const margin =
+        Margin { .vertical = Margin::Vertical { .from = LineOffset(0), .to = LineOffset(2) },
+                 .horizontal = Margin::Horizontal { .from = ColumnOffset(1), .to = ColumnOffset(1) } };
+    grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin);
+
+    CHECK(grid.at(LineOffset(0), ColumnOffset(1)).codepoints() == U"E");
+    CHECK(grid.at(LineOffset(1), ColumnOffset(1)).codepoints() == U"H\u0301");
+    CHECK(grid.at(LineOffset(2), ColumnOffset(1)).empty());
+    CHECK(grid.lineText(LineOffset(0)) == "AEC");
+    CHECK(grid.lineText(LineOffset(2)) == "G I");
+}
+
 // {{{ Resize
 // TODO: test cases for resize: line grow
 //
@@ -326,6 +372,41 @@ TEST_CASE("LogicalLines.reverse_iterator", "[grid]")
 // - add test for handling scrollUp with overflow
 // - add test for handling scrollUp linesUsed = totalLineCount
 
+TEST_CASE("line_marks_follow_scrolling", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(3) }, false, LineCount(2));
+    grid.enableLineFlags(LineOffset(0), LineFlag::Marked, true);
+    grid.enableLineFlags(LineOffset(2), LineFlag::Marked, true);
+    CHECK(grid.findMarkerUpwards(LineOffset(2)) == LineOffset(0));
+    CHECK(grid.findMarkerDownwards(LineOffset(0)) == LineOffset(2));
+
+    // Marks keep pointing to their lines while these are scrolled into the history.
+    grid.scrollUp(LineCount(2));
+    CHECK(grid.findMarkerUpwards(LineOffset(0)) == LineOffset(-2));
+    CHECK(grid.findMarkerDownwards(LineOffset(-2)) == LineOffset(0));
+    CHECK_FALSE(grid.findMarkerDownwards(LineOffset(0)).has_value());
+
+    // Rotating lines within the margins moves their marks along.
+    auto const margin =
+        Margin { .vertical = Margin::Vertical { .from = LineOffset(0), .to = LineOffset(1) },
+                 .horizontal = Margin::Horizontal { .from = ColumnOffset(0), .to = ColumnOffset(2) } };
+    grid.scrollDown(LineCount(1), GraphicsAttributes {}, margin);
+    CHECK(grid.findMarkerDownwards(LineOffset(-1)) == LineOffset(1));
+
+    // Unmarked and evicted lines are not found anymore.
+    grid.enableLineFlags(LineOffset(1), LineFlag::Marked, false);
+    CHECK_FALSE(grid.findMarkerDownwards(LineOffset(-1)).has_value());
+    grid.scrollUp(LineCount(1));
+    CHECK_FALSE(grid.findMarkerUpwards(LineOffset(2)).has_value());
+
+    // Lines unmarked by other means are skipped, also once scrolled into the history.
+    grid.enableLineFlags(LineOffset(0), LineFlag::Marked, true);
+    grid.lineAt(LineOffset(0)).setFlag(LineFlag::Marked, false);
+    CHECK_FALSE(std::as_const(grid).findMarkerUpwards(LineOffset(2)).has_value());
+    grid.scrollUp(LineCount(1));
+    CHECK_FALSE(std::as_const(grid).findMarkerDownwards(LineOffset(-2)).has_value());
+}
+
 TEST_CASE("resize_lines_nr2_with_scrollback_moving_fully_into_page", "[grid]")
 {
     // If cursor is at the bottom and we grow in lines,
@@ -717,6 +798,156 @@ TEST_CASE("Grid.reflow.shrink_many_grow_many", "[grid]")
     }
 }
 
+TEST_CASE("Grid.reflow.lazy_history", "[grid]")
+{
+    auto const pageSize = PageSize { LineCount(2), ColumnCount(5) };
+    auto const init = { "ABCDE"sv, "abcde"sv, "FGHIJ"sv, "fghij"sv, "KLMNO"sv, "klmno"sv };
+    auto eager = setupGrid(pageSize, true, LineCount(20), init);
+    auto lazy = setupGrid(pageSize, true, LineCount(20), init);
+    lazy.setLazyHistoryReflow(true);
+    eager.enableLineFlags(LineOffset(-2), LineFlag::Marked, true);
+    lazy.enableLineFlags(LineOffset(-2), LineFlag::Marked, true);
+
+    (void) eager.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    (void) lazy.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    logGridText(lazy, "after lazy resize 2x2");
+
+    // Only the lines of the main page have been reflowed, leaving the history as it was.
+    REQUIRE(lazy.unreflowedLineCount() == LineCount(4));
+    CHECK(lazy.historyLineCount() == LineCount(8));
+    CHECK(lazy.lineText(LineOffset(-8)) == "ABCDE");
+    CHECK(lazy.lineText(LineOffset(-5)) == "fghij");
+    CHECK(lazy.lineText(LineOffset(-4)) == "KL");
+    CHECK(lazy.lineText(LineOffset(0)) == "mn");
+    CHECK(lazy.lineText(LineOffset(1)) == "o ");
+    CHECK(lazy.findMarkerUpwards(LineOffset(0)) == LineOffset(-6));
+
+    SECTION("reflow on demand")
+    {
+        CHECK(lazy.reflowHistoryUntil(LineOffset(-5)));
+        CHECK(lazy.unreflowedLineCount() == LineCount(0));
+        CHECK_FALSE(lazy.reflowHistory());
+
+        REQUIRE(lazy.historyLineCount() == eager.historyLineCount());
+        for (auto line = -boxed_cast<LineOffset>(eager.historyLineCount()); line < LineOffset(2); ++line)
+            CHECK(lazy.lineText(line) == eager.lineText(line));
+        CHECK(lazy.findMarkerUpwards(LineOffset(0)) == eager.findMarkerUpwards(LineOffset(0)));
+    }
+
+    SECTION("regrow")
+    {
+        (void) lazy.resize(pageSize, CellLocation {}, false);
+        logGridText(lazy, "after lazy resize 5x2");
+
+        CHECK(lazy.unreflowedLineCount() == LineCount(4));
+        CHECK(lazy.historyLineCount() == LineCount(4));
+        CHECK(lazy.lineText(LineOffset(0)) == "KLMNO");
+        CHECK(lazy.lineText(LineOffset(1)) == "klmno");
+
+        CHECK(lazy.reflowHistory());
+        CHECK(lazy.unreflowedLineCount() == LineCount(0));
+        CHECK(lazy.lineText(LineOffset(-4)) == "ABCDE");
+        CHECK(lazy.lineText(LineOffset(-1)) == "fghij");
+        CHECK(lazy.findMarkerUpwards(LineOffset(0)) == LineOffset(-2));
+    }
+}
+
+TEST_CASE("Grid.reflow.concurrent", "[grid]")
+{
+    // Enough lines to be cut into several segments, each reflowed by a thread of its own.
+    auto const pageSize = PageSize { LineCount(2), ColumnCount(10) };
+    auto serial = Grid<Cell>(pageSize, true, LineCount(20000));
+    auto concurrent = Grid<Cell>(pageSize, true, LineCount(20000));
+    concurrent.setReflowThreadCount(4);
+    for (auto* grid: { &serial, &concurrent })
+    {
+        for (auto i = 0; i < 4000; ++i)
+        {
+            grid->setLineText(LineOffset(1), std::format("{:010}", i));
+            grid->scrollUp(LineCount(1));
+        }
+        grid->enableLineFlags(LineOffset(-1000), LineFlag::Marked, true);
+    }
+
+    auto const checkEqual = [&]() {
+        REQUIRE(concurrent.historyLineCount() == serial.historyLineCount());
+        REQUIRE(concurrent.pageSize() == serial.pageSize());
+        for (auto line = -boxed_cast<LineOffset>(serial.historyLineCount()); line < LineOffset(2); ++line)
+        {
+            CHECK(concurrent.lineText(line) == serial.lineText(line));
+            CHECK(concurrent.lineAt(line).wrapped() == serial.lineAt(line).wrapped());
+        }
+        CHECK(concurrent.findMarkerUpwards(LineOffset(0)) == serial.findMarkerUpwards(LineOffset(0)));
+    };
+
+    auto const resize = [&](PageSize newSize) {
+        auto const cursor = serial.resize(newSize, CellLocation {}, false);
+        CHECK(concurrent.resize(newSize, CellLocation {}, false) == cursor);
+    };
+
+    resize(PageSize { LineCount(2), ColumnCount(4) });
+    CHECK(concurrent.historyLineCount() == LineCount(12000));
+    checkEqual();
+
+    resize(pageSize);
+    CHECK(concurrent.historyLineCount() == LineCount(4000));
+    checkEqual();
+}
+
+TEST_CASE("Grid.snapshot", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, true, LineCount(100));
+    for (auto i = 0; i < 50; ++i)
+    {
+        grid.setLineText(LineOffset(1), std::format("{:010}", i));
+        grid.scrollUp(LineCount(1));
+    }
+    grid.setLineText(LineOffset(1), "bottom");
+
+    auto const snapshot = grid.snapshot();
+    REQUIRE(snapshot.lines.size() == 52);
+    CHECK(snapshot.historyLineCount == LineCount(50));
+    CHECK(snapshot.topLineNumber == grid.lineNumberOf(LineOffset(-50)));
+    CHECK(snapshot.lineAt(LineOffset(-50)).sharesStorageWith(grid.lineAt(LineOffset(-50))));
+
+    // The snapshot is read on another thread, while the grid keeps changing.
+    auto snapshotText = std::vector<std::string> {};
+    auto reader = std::thread([&]() {
+        for (auto const& line: snapshot.lines)
+            snapshotText.emplace_back(line.toUtf8Trimmed());
+    });
+    for (auto i = 0; i < 50; ++i)
+    {
+        grid.setLineText(LineOffset(1), std::format("{:>10}", i));
+        grid.scrollUp(LineCount(1));
+    }
+    reader.join();
+
+    REQUIRE(snapshotText.size() == 52);
+    for (auto i = 0; i < 50; ++i)
+        CHECK(snapshotText[static_cast<size_t>(i)] == std::format("{:010}", i));
+    CHECK(snapshotText.back() == "bottom");
+    CHECK(grid.lineText(LineOffset(-49)) == "         0");
+}
+
+TEST_CASE("Grid.snapshot.range", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, true, LineCount(100));
+    for (auto i = 0; i < 10; ++i)
+    {
+        grid.setLineText(LineOffset(1), std::format("{:010}", i));
+        grid.scrollUp(LineCount(1));
+    }
+
+    auto const snapshot = grid.snapshot(LineOffset(-5), LineOffset(-3));
+    REQUIRE(snapshot.lines.size() == 3);
+    CHECK(snapshot.topLine == LineOffset(-5));
+    CHECK(snapshot.topLineNumber == grid.lineNumberOf(LineOffset(-5)));
+    CHECK(snapshot.lineAt(LineOffset(-5)).toUtf8() == "0000000005");
+    CHECK(snapshot.lineAt(LineOffset(-3)).toUtf8() == "0000000007");
+    CHECK(snapshot.lineAt(LineOffset(-4)).sharesStorageWith(grid.lineAt(LineOffset(-4))));
+}
+
 TEST_CASE("Grid.reflow.tripple", "[grid]")
 {
     // Tests reflowing text upon shrink/grow across more than two (e.g. three) wrapped lines.
@@ -4,7 +4,12 @@
 #include <crispy/StrongLRUHashtable.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <utility>
 
 using std::copy;
 using std::make_shared;
@@ -13,22 +18,308 @@ using std::move;
 using std::ostream;
 using std::shared_ptr;
 using std::string;
+using std::vector;
 
 namespace vtbackend
 {
 
+namespace
+{
+    std::atomic<uint64_t> imageUseCounter = 0;
+
+    constexpr size_t bytesPerPixel(ImageFormat format) noexcept
+    {
+        switch (format)
+        {
+            case ImageFormat::RGB: return 3;
+            case ImageFormat::RGBA: return 4;
+        }
+        return 4;
+    }
+
+    // Pixel data is run-length encoded as records of a run length (1..256, stored minus one),
+    // each followed by the pixel value repeated by that run.
+    constexpr size_t MaxRunLength = 256;
+
+    /// @returns the encoded pixels, or an empty buffer if they do not compress well.
+    Image::Data encodeRunLength(Image::Data const& pixels, size_t pixelSize)
+    {
+        if (pixels.empty() || pixels.size() % pixelSize != 0)
+            return {};
+
+        auto encoded = Image::Data {};
+        auto const* const end = pixels.data() + pixels.size();
+        for (auto const* run = pixels.data(); run != end;)
+        {
+            auto const* next = run + pixelSize;
+            auto length = size_t { 1 };
+            while (length < MaxRunLength && next != end && std::equal(run, run + pixelSize, next))
+            {
+                next += pixelSize;
+                ++length;
+            }
+
+            encoded.push_back(static_cast<uint8_t>(length - 1));
+            encoded.insert(encoded.end(), run, run + pixelSize);
+            if (encoded.size() >= pixels.size() / 2)
+                return {};
+
+            run = next;
+        }
+        return encoded;
+    }
+
+    void fillPixels(uint8_t* target, size_t count, RGBAColor color)
+    {
+        auto const pixel = std::array<uint8_t, 4> { color.red(), color.green(), color.blue(), color.alpha() };
+        for (size_t i = 0; i < count; ++i)
+            std::copy_n(pixel.data(), 4, target + (i * 4));
+    }
+
+    /// @returns the horizontal and vertical fraction of the free space to put before the image.
+    std::pair<double, double> alignmentFactors(ImageAlignment alignment) noexcept
+    {
+        switch (alignment)
+        {
+            case ImageAlignment::TopStart: return { 0.0, 0.0 };
+            case ImageAlignment::TopCenter: return { 0.5, 0.0 };
+            case ImageAlignment::TopEnd: return { 1.0, 0.0 };
+            case ImageAlignment::MiddleStart: return { 0.0, 0.5 };
+            case ImageAlignment::MiddleCenter: return { 0.5, 0.5 };
+            case ImageAlignment::MiddleEnd: return { 1.0, 0.5 };
+            case ImageAlignment::BottomStart: return { 0.0, 1.0 };
+            case ImageAlignment::BottomCenter: return { 0.5, 1.0 };
+            case ImageAlignment::BottomEnd: return { 1.0, 1.0 };
+        }
+        return { 0.0, 0.0 };
+    }
+
+    // Filter taps of a separable resampling filter along one axis.
+    //
+    // Downscaling uses a box filter, weighting each source pixel by its coverage of the target pixel,
+    // whereas upscaling interpolates linearly between the two nearest source pixels.
+    struct FilterTaps
+    {
+        std::vector<int> first;     // first source index contributing to each target index
+        std::vector<int> count;     // number of source indices contributing to each target index
+        std::vector<float> weights; // weights of the contributing source indices, per target index
+        size_t stride = 0;          // number of weights reserved per target index
+    };
+
+    FilterTaps computeFilterTaps(int sourceSize, int targetSize)
+    {
+        auto taps = FilterTaps {};
+        taps.first.resize(static_cast<size_t>(targetSize));
+        taps.count.resize(static_cast<size_t>(targetSize));
+
+        auto const scale = static_cast<double>(sourceSize) / static_cast<double>(targetSize);
+        if (scale > 1.0)
+        {
+            taps.stride = static_cast<size_t>(std::ceil(scale)) + 1;
+            taps.weights.resize(static_cast<size_t>(targetSize) * taps.stride);
+            for (int i = 0; i < targetSize; ++i)
+            {
+                auto const begin = i * scale;
+                auto const end = begin + scale;
+                auto const first = static_cast<int>(begin);
+                auto const last = std::min(static_cast<int>(std::ceil(end)), sourceSize);
+                auto* weights = &taps.weights[static_cast<size_t>(i) * taps.stride];
+                taps.first[static_cast<size_t>(i)] = first;
+                taps.count[static_cast<size_t>(i)] = last - first;
+                for (int k = first; k < last; ++k)
+                {
+                    auto const coverage = std::min(end, k + 1.0) - std::max(begin, static_cast<double>(k));
+                    weights[k - first] = static_cast<float>(coverage / scale);
+                }
+            }
+        }
+        else
+        {
+            taps.stride = 2;
+            taps.weights.resize(static_cast<size_t>(targetSize) * taps.stride);
+            for (int i = 0; i < targetSize; ++i)
+            {
+                auto const center = ((i + 0.5) * scale) - 0.5;
+                auto const left = std::clamp(static_cast<int>(std::floor(center)), 0, sourceSize - 1);
+                auto const fraction = static_cast<float>(std::clamp(center - left, 0.0, 1.0));
+                auto* weights = &taps.weights[static_cast<size_t>(i) * taps.stride];
+                taps.first[static_cast<size_t>(i)] = left;
+                taps.count[static_cast<size_t>(i)] = left + 1 < sourceSize ? 2 : 1;
+                weights[0] = left + 1 < sourceSize ? 1.0f - fraction : 1.0f;
+                weights[1] = fraction;
+            }
+        }
+        return taps;
+    }
+
+    /// Resamples the given RGBA pixels to the target size, in two separable passes.
+    ///
+    /// The inner loops run over contiguous channel values, so that the compiler can vectorize them.
+    Image::Data resample(Image::Data const& source, ImageSize sourceSize, ImageSize targetSize)
+    {
+        auto const sourceWidth = unbox<int>(sourceSize.width);
+        auto const sourceHeight = unbox<int>(sourceSize.height);
+        auto const targetWidth = unbox<int>(targetSize.width);
+        auto const targetHeight = unbox<int>(targetSize.height);
+        auto const horizontal = computeFilterTaps(sourceWidth, targetWidth);
+        auto const vertical = computeFilterTaps(sourceHeight, targetHeight);
+
+        // Horizontal pass, from sourceWidth x sourceHeight to targetWidth x sourceHeight.
+        auto const intermediatePitch = static_cast<size_t>(targetWidth) * 4;
+        auto intermediate = std::vector<float>(intermediatePitch * static_cast<size_t>(sourceHeight));
+        for (int y = 0; y < sourceHeight; ++y)
+        {
+            auto const* row = source.data() + (static_cast<size_t>(y) * static_cast<size_t>(sourceWidth) * 4);
+            auto* output = intermediate.data() + (static_cast<size_t>(y) * intermediatePitch);
+            for (size_t x = 0; x < static_cast<size_t>(targetWidth); ++x)
+            {
+                auto sum = std::array<float, 4> {};
+                auto const* weights = &horizontal.weights[x * horizontal.stride];
+                auto const* pixels = row + (static_cast<size_t>(horizontal.first[x]) * 4);
+                for (int k = 0; k < horizontal.count[x]; ++k)
+                    for (size_t c = 0; c < 4; ++c)
+                        sum[c] += weights[k] * static_cast<float>(pixels[(k * 4) + c]);
+                std::copy_n(sum.data(), 4, output + (x * 4));
+            }
+        }
+
+        // Vertical pass, from targetWidth x sourceHeight to targetWidth x targetHeight.
+        auto target = Image::Data(intermediatePitch * static_cast<size_t>(targetHeight));
+        auto accumulator = std::vector<float>(intermediatePitch);
+        for (size_t y = 0; y < static_cast<size_t>(targetHeight); ++y)
+        {
+            std::ranges::fill(accumulator, 0.0f);
+            for (int k = 0; k < vertical.count[y]; ++k)
+            {
+                auto const weight = vertical.weights[(y * vertical.stride) + static_cast<size_t>(k)];
+                auto const* row =
+                    intermediate.data() + (static_cast<size_t>(vertical.first[y] + k) * intermediatePitch);
+                for (size_t i = 0; i < intermediatePitch; ++i)
+                    accumulator[i] += weight * row[i];
+            }
+            auto* output = target.data() + (y * intermediatePitch);
+            for (size_t i = 0; i < intermediatePitch; ++i)
+                output[i] = static_cast<uint8_t>(std::clamp(accumulator[i] + 0.5f, 0.0f, 255.0f));
+        }
+        return target;
+    }
+
+    Image::Data decodeRunLength(Image::Data const& encoded, size_t pixelSize, size_t sizeHint)
+    {
+        auto decoded = Image::Data {};
+        decoded.reserve(sizeHint);
+        for (size_t i = 0; i + pixelSize < encoded.size(); i += 1 + pixelSize)
+        {
+            auto const length = static_cast<size_t>(encoded[i]) + 1;
+            auto const* const pixel = &encoded[i + 1];
+            for (size_t k = 0; k < length; ++k)
+                decoded.insert(decoded.end(), pixel, pixel + pixelSize);
+        }
+        return decoded;
+    }
+} // namespace
+
 ImageStats& ImageStats::get()
 {
     static ImageStats stats {};
     return stats;
 }
 
+Image::Image(ImageId id,
+             ImageFormat format,
+             Data data,
+             ImageSize pixelSize,
+             OnImageRemove remover,
+             shared_ptr<ImageMemoryUsage> memoryUsage):
+    _id { id },
+    _format { format },
+    _size { pixelSize },
+    _onImageRemove { std::move(remover) },
+    _memoryUsage { std::move(memoryUsage) },
+    _pixels { make_shared<Data const>(std::move(data)) }
+{
+    ++ImageStats::get().instances;
+    if (_memoryUsage)
+        _memoryUsage->bytes += _pixels->size();
+    markUsed();
+}
+
 Image::~Image()
 {
     --ImageStats::get().instances;
+    if (_memoryUsage)
+        _memoryUsage->bytes -= footprint();
     _onImageRemove(this);
 }
 
+shared_ptr<Image::Data const> Image::pixels() const
+{
+    markUsed();
+
+    auto pixels = shared_ptr<Data const> {};
+    {
+        auto const _ = std::lock_guard { _mutex };
+        if (_pixels)
+            return _pixels;
+
+        auto const pixelSize = bytesPerPixel(_format);
+        _pixels = make_shared<Data const>(
+            decodeRunLength(_compressedPixels, pixelSize, _size.area() * pixelSize));
+        if (_memoryUsage)
+            _memoryUsage->bytes += _pixels->size() - _compressedPixels.size();
+        _compressedPixels = Data {};
+        ++ImageStats::get().decompressions;
+        pixels = _pixels;
+    }
+
+    // Have the pool check its memory budget again.
+    if (_memoryUsage)
+    {
+        ++_memoryUsage->decompressions;
+        _memoryUsage->onDecompressed();
+    }
+    return pixels;
+}
+
+size_t Image::compress() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    if (!_pixels || _incompressible)
+        return 0;
+
+    auto encoded = encodeRunLength(*_pixels, bytesPerPixel(_format));
+    if (encoded.empty())
+    {
+        _incompressible = true;
+        return 0;
+    }
+
+    auto const saved = _pixels->size() - encoded.size();
+    _compressedPixels = std::move(encoded);
+    _pixels.reset();
+    if (_memoryUsage)
+        _memoryUsage->bytes -= saved;
+    ++ImageStats::get().compressions;
+    return saved;
+}
+
+bool Image::compressed() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    return !_pixels;
+}
+
+size_t Image::footprint() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    return _pixels ? _pixels->size() : _compressedPixels.size();
+}
+
+void Image::markUsed() const noexcept
+{
+    _lastUsed.store(imageUseCounter.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
 RasterizedImage::~RasterizedImage()
 {
     --ImageStats::get().rasterized;
@@ -39,30 +330,272 @@ ImageFragment::~ImageFragment()
     --ImageStats::get().fragments;
 }
 
-ImagePool::ImagePool(OnImageRemove onImageRemove, ImageId nextImageId):
+ImagePool::ImagePool(OnImageRemove onImageRemove,
+                     ImageId nextImageId,
+                     size_t memoryBudget,
+                     ImageRasterizer::OnCompleted onCompleted):
     _nextImageId { nextImageId },
     _imageNameToImageCache { crispy::strong_hashtable_size { 1024 },
                              crispy::lru_capacity { 100 },
                              "ImagePool name-to-image mappings" },
-    _onImageRemove { std::move(onImageRemove) }
+    _onImageRemove { std::move(onImageRemove) },
+    _memoryBudget { memoryBudget },
+    _memoryUsage { make_shared<ImageMemoryUsage>() },
+    _rasterizer { onCompleted }
 {
+    _memoryUsage->onDecompressed = std::move(onCompleted);
 }
 
-Image::Data RasterizedImage::fragment(CellLocation pos) const
+void ImagePool::rasterize(shared_ptr<RasterizedImage const> image)
+{
+    if (image->raster())
+        return;
+
+    _rasterizedImages.emplace_back(image);
+    _rasterizer.enqueue(std::move(image), _nextImageId++, _onImageRemove, _memoryUsage);
+}
+
+bool ImagePool::collectCompletedJobs()
+{
+    auto const rasterized = _rasterizer.collect();
+    auto const decompressions = _memoryUsage->decompressions.load();
+    if (rasterized || decompressions != _decompressionsSeen)
+    {
+        _decompressionsSeen = decompressions;
+        enforceMemoryBudget();
+    }
+    return rasterized;
+}
+
+// {{{ RasterizedImage
+shared_ptr<Image const> RasterizedImage::raster() const
+{
+    auto const _ = std::lock_guard { _rasterMutex };
+    return _raster;
+}
+
+void RasterizedImage::rasterize(ImageId rasterId,
+                                Image::OnImageRemove remover,
+                                shared_ptr<ImageMemoryUsage> memoryUsage) const
+{
+    if (raster())
+        return;
+
+    auto const rasterSize = this->rasterSize();
+    auto const imageSize = _image->size();
+    auto const scaledSize = [&]() -> ImageSize {
+        auto const widthRatio = unbox<double>(rasterSize.width) / unbox<double>(imageSize.width);
+        auto const heightRatio = unbox<double>(rasterSize.height) / unbox<double>(imageSize.height);
+        auto const scaledBy = [&](double ratio) {
+            auto const width = std::max(1.0, std::round(unbox<double>(imageSize.width) * ratio));
+            auto const height = std::max(1.0, std::round(unbox<double>(imageSize.height) * ratio));
+            return ImageSize { Width::cast_from(width), Height::cast_from(height) };
+        };
+        switch (_resizePolicy)
+        {
+            case ImageResize::NoResize: return imageSize;
+            case ImageResize::ResizeToFit: return scaledBy(std::min(widthRatio, heightRatio));
+            case ImageResize::ResizeToFill: return scaledBy(std::max(widthRatio, heightRatio));
+            case ImageResize::StretchToFill: return rasterSize;
+        }
+        return imageSize;
+    }();
+
+    auto scaled = _image->pixels();
+    if (scaledSize != imageSize)
+        scaled = make_shared<Image::Data const>(resample(*scaled, imageSize, scaledSize));
+
+    auto const rasterWidth = unbox<int>(rasterSize.width);
+    auto const rasterHeight = unbox<int>(rasterSize.height);
+    auto const scaledWidth = unbox<int>(scaledSize.width);
+    auto const scaledHeight = unbox<int>(scaledSize.height);
+
+    // Offset of the scaled image into the raster, which is negative when cropping.
+    auto const [horizontal, vertical] = alignmentFactors(_alignmentPolicy);
+    auto const offsetX = static_cast<int>(horizontal * (rasterWidth - scaledWidth));
+    auto const offsetY = static_cast<int>(vertical * (rasterHeight - scaledHeight));
+
+    auto data = Image::Data(rasterSize.area() * 4);
+    fillPixels(data.data(), rasterSize.area(), _defaultColor);
+
+    auto const firstX = std::max(0, offsetX);
+    auto const lastX = std::min(rasterWidth, offsetX + scaledWidth);
+    auto const firstY = std::max(0, offsetY);
+    auto const lastY = std::min(rasterHeight, offsetY + scaledHeight);
+    for (int y = firstY; firstX < lastX && y < lastY; ++y)
+    {
+        auto const sourceOffset = ((y - offsetY) * scaledWidth) + (firstX - offsetX);
+        auto const targetOffset = (y * rasterWidth) + firstX;
+        std::copy_n(scaled->data() + (static_cast<size_t>(sourceOffset) * 4),
+                    static_cast<size_t>(lastX - firstX) * 4,
+                    data.data() + (static_cast<size_t>(targetOffset) * 4));
+    }
+
+    auto image = make_shared<Image const>(
+        rasterId, ImageFormat::RGBA, std::move(data), rasterSize, std::move(remover), std::move(memoryUsage));
+
+    auto const _ = std::lock_guard { _rasterMutex };
+    if (!_raster)
+        _raster = std::move(image);
+}
+// }}}
+
+// {{{ ImageRasterizer
+ImageRasterizer::ImageRasterizer(OnCompleted onCompleted): _onCompleted { std::move(onCompleted) }
+{
+}
+
+ImageRasterizer::~ImageRasterizer()
+{
+    auto pendingJobs = std::deque<Job> {};
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _stopping = true;
+        pendingJobs.swap(_jobs);
+    }
+    _condition.notify_all();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void ImageRasterizer::enqueue(shared_ptr<RasterizedImage const> image,
+                              ImageId rasterId,
+                              Image::OnImageRemove remover,
+                              shared_ptr<ImageMemoryUsage> memoryUsage)
+{
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _jobs.emplace_back(Job { .image = image,
+                                 .rasterId = rasterId,
+                                 .remover = std::move(remover),
+                                 .memoryUsage = std::move(memoryUsage) });
+        if (!_thread.joinable())
+            _thread = std::thread { [this]() { run(); } };
+    }
+    _condition.notify_one();
+}
+
+void ImageRasterizer::compress(vector<std::weak_ptr<Image const>> images,
+                               size_t memoryBudget,
+                               shared_ptr<ImageMemoryUsage const> memoryUsage)
+{
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _compression = Compression { .images = std::move(images),
+                                     .memoryBudget = memoryBudget,
+                                     .memoryUsage = std::move(memoryUsage) };
+        if (!_thread.joinable())
+            _thread = std::thread { [this]() { run(); } };
+    }
+    _condition.notify_one();
+}
+
+void ImageRasterizer::run()
 {
-    // TODO: respect alignment hint
-    // TODO: respect resize hint
+    while (true)
+    {
+        auto job = std::optional<Job> {};
+        auto compression = std::optional<Compression> {};
+        {
+            auto lock = std::unique_lock { _mutex };
+            _condition.wait(lock, [this]() { return _stopping || !_jobs.empty() || _compression; });
+            if (_stopping)
+                return;
 
+            // Rasterizing takes precedence, as images are not displayed before.
+            if (!_jobs.empty())
+            {
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            else
+                compression = std::exchange(_compression, std::nullopt);
+        }
+
+        if (job)
+            process(*job);
+        else
+            process(*compression);
+    }
+}
+
+void ImageRasterizer::process(Job& job)
+{
+    // Skip images that are no longer referenced by any grid cell.
+    auto image = job.image.lock();
+    if (!image)
+        return;
+
+    image->rasterize(job.rasterId, std::move(job.remover), std::move(job.memoryUsage));
+
+    auto references = vector<shared_ptr<void const>> {};
+    references.emplace_back(std::move(image));
+    complete(std::move(references), true);
+}
+
+void ImageRasterizer::process(Compression const& compression)
+{
+    auto references = vector<shared_ptr<void const>> {};
+    for (auto const& weakImage: compression.images)
+    {
+        if (compression.memoryUsage->bytes <= compression.memoryBudget)
+            break;
+        if (auto image = weakImage.lock())
+        {
+            image->compress();
+            references.emplace_back(std::move(image));
+        }
+    }
+
+    if (!references.empty())
+        complete(std::move(references), false);
+}
+
+void ImageRasterizer::complete(vector<shared_ptr<void const>> references, bool rasterized)
+{
+    // The images may no longer be referenced by any grid cell either,
+    // so leave releasing them to the owning thread.
+    auto const _ = std::lock_guard { _mutex };
+    std::ranges::move(references, std::back_inserter(_released));
+    _rasterized = _rasterized || rasterized;
+    _completed = true;
+    if (!_stopping)
+        _onCompleted();
+}
+
+bool ImageRasterizer::collect()
+{
+    if (!_completed.exchange(false))
+        return false;
+
+    auto released = std::deque<shared_ptr<void const>> {};
+    auto rasterized = false;
+    {
+        auto const _ = std::lock_guard { _mutex };
+        released.swap(_released);
+        rasterized = std::exchange(_rasterized, false);
+    }
+    return rasterized;
+}
+// }}}
+
+Image::Data RasterizedImage::fragment(CellLocation pos) const
+{
     auto const xOffset = pos.column * unbox<int>(_cellSize.width);
     auto const yOffset = pos.line * unbox<int>(_cellSize.height);
     auto const pixelOffset = CellLocation { .line = yOffset, .column = xOffset };
 
+    // Until the image is rasterized, the fragment is filled with the default color only.
+    auto const image = raster();
+    auto const imageWidth = image ? unbox<int>(image->width()) : 0;
+    auto const imageHeight = image ? unbox<int>(image->height()) : 0;
+
     Image::Data fragData;
     fragData.resize(_cellSize.area() * 4); // RGBA
     auto const availableWidth =
-        min(unbox<int>(_image->width()) - unbox(pixelOffset.column), unbox<int>(_cellSize.width));
+        std::clamp(imageWidth - unbox(pixelOffset.column), 0, unbox<int>(_cellSize.width));
     auto const availableHeight =
-        min(unbox<int>(_image->height()) - unbox(pixelOffset.line), unbox<int>(_cellSize.height));
+        std::clamp(imageHeight - unbox(pixelOffset.line), 0, unbox<int>(_cellSize.height));
 
     // auto const availableSize = Size{availableWidth, availableHeight};
     // std::cout << std::format(
@@ -86,12 +619,13 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
     // TODO: if input format is (RGB | PNG), transform to RGBA
 
     auto* target = fragData.data();
+    auto const pixels = availableHeight ? image->pixels() : nullptr;
 
     for (int y = 0; y < availableHeight; ++y)
     {
-        auto const startOffset = static_cast<size_t>(
-            ((pixelOffset.line + y) * unbox<int>(_image->width()) + unbox(pixelOffset.column)) * 4);
-        const auto* const source = &_image->data()[startOffset];
+        auto const startOffset =
+            static_cast<size_t>(((pixelOffset.line + y) * imageWidth + unbox(pixelOffset.column)) * 4);
+        const auto* const source = &(*pixels)[startOffset];
         target = copy(source, source + (static_cast<ptrdiff_t>(availableWidth) * 4), target);
 
         // fill vertical gap on right
@@ -118,10 +652,96 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
 
 shared_ptr<Image const> ImagePool::create(ImageFormat format, ImageSize size, Image::Data&& data)
 {
-    // TODO: This operation should be idempotent, i.e. if that image has been created already, return a
-    // reference to that.
+    auto const contentHash = crispy::strong_hash::compute(data.data(), data.size());
+
+    // Stored images are compared by the hash of their content, without decompressing them.
+    auto [candidate, candidatesEnd] = _imagesByContent.equal_range(contentHash.d());
+    while (candidate != candidatesEnd)
+    {
+        auto const& entry = candidate->second;
+        auto image = entry.image.lock();
+        if (!image)
+        {
+            candidate = _imagesByContent.erase(candidate);
+            continue;
+        }
+        if (entry.hash == contentHash && entry.format == format && entry.size == size)
+        {
+            ++ImageStats::get().deduplicated;
+            return image;
+        }
+        ++candidate;
+    }
+
     auto const id = _nextImageId++;
-    return make_shared<Image>(id, format, std::move(data), size, _onImageRemove);
+    auto image = make_shared<Image>(id, format, std::move(data), size, _onImageRemove, _memoryUsage);
+    auto entry = ContentEntry { .hash = contentHash, .format = format, .size = size, .image = image };
+    _imagesByContent.emplace(contentHash.d(), std::move(entry));
+    if (memoryUsage() > _memoryBudget)
+        enforceMemoryBudget();
+    return image;
+}
+
+void ImagePool::setMemoryBudget(size_t bytes)
+{
+    _memoryBudget = bytes;
+    enforceMemoryBudget();
+}
+
+vector<shared_ptr<Image const>> ImagePool::liveImages()
+{
+    auto images = vector<shared_ptr<Image const>> {};
+    images.reserve(_imagesByContent.size());
+    for (auto i = _imagesByContent.begin(); i != _imagesByContent.end();)
+    {
+        if (auto image = i->second.image.lock())
+        {
+            images.emplace_back(std::move(image));
+            ++i;
+        }
+        else
+            i = _imagesByContent.erase(i);
+    }
+
+    // Rasters are images of their own, unless the image is displayed as it is.
+    std::erase_if(_rasterizedImages, [&](auto const& weakImage) {
+        auto const image = weakImage.lock();
+        if (!image)
+            return true;
+        if (auto raster = image->raster(); raster && raster != image->imagePointer())
+            images.emplace_back(std::move(raster));
+        return false;
+    });
+    return images;
+}
+
+void ImagePool::enforceMemoryBudget()
+{
+    if (memoryUsage() <= _memoryBudget)
+        return;
+
+    // Named images that are not referenced by any cell are only kept alive by the pool,
+    // so drop the least recently used of them first, which accounts them out of the memory usage.
+    auto const names = _imageNameToImageCache.keys(); // most recently used first
+    for (auto name = names.rbegin(); name != names.rend() && memoryUsage() > _memoryBudget; ++name)
+    {
+        auto const* image = _imageNameToImageCache.try_get(*name);
+        if (!image || image->use_count() != 1)
+            continue;
+        _imageNameToImageCache.remove(*name);
+        ++ImageStats::get().evictions;
+    }
+
+    if (memoryUsage() <= _memoryBudget)
+        return;
+
+    // Then have the images compressed that have not been rendered for the longest time,
+    // such as images that are only referenced from deep scrollback.
+    auto images = liveImages();
+    std::ranges::sort(images, std::ranges::less {}, [](auto const& image) { return image->lastUsed(); });
+    _rasterizer.compress(vector<std::weak_ptr<Image const>>(images.begin(), images.end()),
+                         _memoryBudget,
+                         _memoryUsage);
 }
 
 shared_ptr<RasterizedImage> rasterize(shared_ptr<Image const> image,
@@ -162,6 +782,7 @@ void ImagePool::inspect(ostream& os) const
 {
     os << "Image pool:\n";
     os << std::format("global image stats: {}\n", ImageStats::get());
+    os << std::format("memory usage: {} / {} bytes\n", memoryUsage(), _memoryBudget);
     _imageNameToImageCache.inspect(os);
 }
 
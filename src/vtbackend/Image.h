@@ -7,10 +7,17 @@
 #include <crispy/StrongHash.h>
 #include <crispy/StrongLRUCache.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <format>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace vtbackend
@@ -38,10 +45,26 @@ struct ImageStats
     uint32_t instances = 0;
     uint32_t rasterized = 0;
     uint32_t fragments = 0;
+    uint32_t deduplicated = 0;   // image creations served by an already existing image of equal content
+    uint32_t evictions = 0;      // named images dropped from the pool to stay within the memory budget
+    uint32_t compressions = 0;   // images compressed to stay within the memory budget
+    uint32_t decompressions = 0; // compressed images that had to be decompressed again
 
     static ImageStats& get();
 };
 
+/// Accounts the bytes occupied by the pixel data of the images of an ImagePool, shared with its images.
+struct ImageMemoryUsage
+{
+    std::atomic<size_t> bytes = 0;
+
+    /// Number of times an image's pixel data has grown again by being decompressed.
+    std::atomic<uint64_t> decompressions = 0;
+
+    /// Invoked, on any thread, after an image's pixel data has been decompressed.
+    std::function<void()> onDecompressed = []() {};
+};
+
 /**
  * Represents an image that can be displayed in the terminal by being placed into the grid cells
  */
@@ -52,38 +75,66 @@ class Image: public std::enable_shared_from_this<Image>
     using OnImageRemove = std::function<void(Image const*)>;
     /// Constructs an RGBA image.
     ///
-    /// @param data      RGBA buffer data
-    /// @param pixelSize image dimensionss in pixels
-    Image(ImageId id, ImageFormat format, Data data, ImageSize pixelSize, OnImageRemove remover) noexcept:
-        _id { id },
-        _format { format },
-        _data { std::move(data) },
-        _size { pixelSize },
-        _onImageRemove { std::move(remover) }
-    {
-        ++ImageStats::get().instances;
-    }
+    /// @param data        RGBA buffer data
+    /// @param pixelSize   image dimensionss in pixels
+    /// @param memoryUsage optional counter of bytes occupied by pixel data, to account this image in
+    Image(ImageId id,
+          ImageFormat format,
+          Data data,
+          ImageSize pixelSize,
+          OnImageRemove remover,
+          std::shared_ptr<ImageMemoryUsage> memoryUsage = {});
 
     ~Image();
 
     Image(Image const&) = delete;
     Image& operator=(Image const&) = delete;
-    Image(Image&&) noexcept = default;
-    Image& operator=(Image&&) noexcept = default;
+    Image(Image&&) = delete;
+    Image& operator=(Image&&) = delete;
 
     constexpr ImageId id() const noexcept { return _id; }
     constexpr ImageFormat format() const noexcept { return _format; }
-    Data const& data() const noexcept { return _data; }
     constexpr ImageSize size() const noexcept { return _size; }
     constexpr Width width() const noexcept { return _size.width; }
     constexpr Height height() const noexcept { return _size.height; }
 
+    /// @returns the raw pixel data, decompressing it first if needed.
+    ///
+    /// The returned buffer remains valid for as long as it is referenced,
+    /// even if the image gets compressed in the meantime.
+    [[nodiscard]] std::shared_ptr<Data const> pixels() const;
+
+    /// Run-length encodes the pixel data until it is accessed again via pixels().
+    ///
+    /// @returns the number of bytes saved, which is zero if the image is already compressed
+    ///          or does not compress well.
+    size_t compress() const;
+
+    [[nodiscard]] bool compressed() const;
+
+    /// @returns the number of bytes currently occupied by the pixel data.
+    [[nodiscard]] size_t footprint() const;
+
+    /// Marks the image as used (e.g. rendered), moving it to the back of the compression queue.
+    void markUsed() const noexcept;
+
+    /// @returns a monotonically increasing value indicating when the image was last used.
+    [[nodiscard]] uint64_t lastUsed() const noexcept { return _lastUsed.load(std::memory_order_relaxed); }
+
   private:
     ImageId _id;
     ImageFormat _format;
-    Data _data;
     ImageSize _size;
     OnImageRemove _onImageRemove;
+    std::shared_ptr<ImageMemoryUsage> _memoryUsage; // kept up to date with footprint(), if any
+
+    // The pixel data is accessed from the renderer as well as from the image pool,
+    // which may compress it behind the renderer's back.
+    mutable std::mutex _mutex;
+    mutable std::shared_ptr<Data const> _pixels; // nullptr while compressed
+    mutable Data _compressedPixels;              // run-length encoded pixels, empty while uncompressed
+    mutable bool _incompressible = false;        // compression has been attempted without any gain
+    mutable std::atomic<uint64_t> _lastUsed = 0;
 };
 
 /// Image resize hints are used to properly fit/fill the area to place the image onto.
@@ -113,6 +164,11 @@ enum class ImageAlignment : uint8_t
 /**
  * RasterizedImage wraps an Image into a fixed-size grid with some additional graphical properties for
  * rasterization.
+ *
+ * The image is resized and aligned according to its policies into a raster image spanning exactly
+ * the grid cells. Unless the image can be used as-is (ImageResize::NoResize at
+ * ImageAlignment::TopStart), that raster is produced by rasterize(), which is meant to be run
+ * off the terminal thread, see ImageRasterizer. Until then, the image renders nothing.
  */
 class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
 {
@@ -131,6 +187,8 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
         _cellSize { cellSize }
     {
         ++ImageStats::get().rasterized;
+        if (_resizePolicy == ImageResize::NoResize && _alignmentPolicy == ImageAlignment::TopStart)
+            _raster = _image;
     }
 
     ~RasterizedImage();
@@ -150,6 +208,27 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
     GridSize cellSpan() const noexcept { return _cellSpan; }
     ImageSize cellSize() const noexcept { return _cellSize; }
 
+    /// @returns the size in pixels of the grid area this image is rasterized into.
+    ImageSize rasterSize() const noexcept
+    {
+        return ImageSize { Width::cast_from(unbox(_cellSpan.columns) * unbox(_cellSize.width)),
+                           Height::cast_from(unbox(_cellSpan.lines) * unbox(_cellSize.height)) };
+    }
+
+    /// @returns the image to slice the grid cells from, or nullptr if it has not been rasterized yet.
+    [[nodiscard]] std::shared_ptr<Image const> raster() const;
+
+    /// Resizes and aligns the image into its raster, as given by the resize and alignment policies.
+    ///
+    /// This is thread-safe and does nothing if the raster is already available.
+    ///
+    /// @param rasterId    ID of the raster image to be created
+    /// @param remover     callback to be invoked when the raster image gets destroyed
+    /// @param memoryUsage optional accounting of the pool to account the raster image in
+    void rasterize(ImageId rasterId,
+                   Image::OnImageRemove remover,
+                   std::shared_ptr<ImageMemoryUsage> memoryUsage = {}) const;
+
     /// @returns an RGBA buffer for a grid cell at given coordinate @p pos of the rasterized image.
     Image::Data fragment(CellLocation pos) const;
 
@@ -160,6 +239,9 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
     RGBAColor _defaultColor;             //!< Default color to be applied at corners when needed.
     GridSize _cellSpan;                  //!< Number of grid cells to span the pixel image onto.
     ImageSize _cellSize;                 //!< number of pixels in X and Y dimension one grid cell has to fill.
+
+    mutable std::mutex _rasterMutex;
+    mutable std::shared_ptr<Image const> _raster; //!< resized and aligned image, once available
 };
 
 /// An ImageFragment holds a graphical image that ocupies one full grid cell.
@@ -220,19 +302,129 @@ inline bool operator<(ImageFragment const& a, ImageFragment const& b) noexcept
                && a.offset() < b.offset());
 }
 
+/// Rasterizes images on a worker thread, so that resizing large images does not block the terminal.
+/// For the same reason, images are compressed on that thread to stay within a memory budget.
+///
+/// The worker thread is started on demand. It never drops the last reference to an image,
+/// but hands the images it worked on back to the owning thread, which releases them via collect().
+class ImageRasterizer
+{
+  public:
+    using OnCompleted = std::function<void()>;
+
+    /// @param onCompleted callback to be invoked on the worker thread after a job has been completed,
+    ///                    meant to wake up the owning thread to call collect().
+    explicit ImageRasterizer(OnCompleted onCompleted);
+    ~ImageRasterizer();
+
+    ImageRasterizer(ImageRasterizer const&) = delete;
+    ImageRasterizer(ImageRasterizer&&) = delete;
+    ImageRasterizer& operator=(ImageRasterizer const&) = delete;
+    ImageRasterizer& operator=(ImageRasterizer&&) = delete;
+
+    void enqueue(std::shared_ptr<RasterizedImage const> image,
+                 ImageId rasterId,
+                 Image::OnImageRemove remover,
+                 std::shared_ptr<ImageMemoryUsage> memoryUsage);
+
+    /// Compresses the given images in order, until @p memoryUsage is within @p memoryBudget.
+    ///
+    /// This replaces any compression that has not been started yet.
+    void compress(std::vector<std::weak_ptr<Image const>> images,
+                  size_t memoryBudget,
+                  std::shared_ptr<ImageMemoryUsage const> memoryUsage);
+
+    /// @returns whether jobs have been completed since the last call to collect().
+    [[nodiscard]] bool hasCompleted() const noexcept { return _completed.load(); }
+
+    /// Releases the worker thread's references to the images of the jobs completed since the last call.
+    ///
+    /// This must be called on the thread owning the images, as releasing the last reference
+    /// to an image discards it.
+    ///
+    /// @returns whether any image has been rasterized since the last call.
+    bool collect();
+
+  private:
+    struct Job
+    {
+        std::weak_ptr<RasterizedImage const> image; // not keeping images alive that are no longer displayed
+        ImageId rasterId;
+        Image::OnImageRemove remover;
+        std::shared_ptr<ImageMemoryUsage> memoryUsage;
+    };
+
+    struct Compression
+    {
+        std::vector<std::weak_ptr<Image const>> images; // least recently used first
+        size_t memoryBudget;
+        std::shared_ptr<ImageMemoryUsage const> memoryUsage;
+    };
+
+    void run();
+    void process(Job& job);
+    void process(Compression const& compression);
+    void complete(std::vector<std::shared_ptr<void const>> references, bool rasterized);
+
+    OnCompleted _onCompleted;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Job> _jobs;
+    std::optional<Compression> _compression;
+    std::deque<std::shared_ptr<void const>> _released; // references to be released by collect()
+    bool _rasterized = false;                          // whether an image has been rasterized since collect()
+    std::atomic<bool> _completed = false;
+    bool _stopping = false;
+    std::thread _thread;
+};
+
 /// Highlevel Image Storage Pool.
 ///
 /// Stores RGBA images in host memory, also taking care of eviction.
+///
+/// Images of equal content share their storage. The pixel data of all live images is kept within
+/// a memory budget, by first dropping the least recently used named images (which are only kept
+/// alive by the pool itself), and then compressing the images that have not been rendered for the
+/// longest time, such as images only referenced from deep scrollback.
 class ImagePool
 {
   public:
     using OnImageRemove = std::function<void(Image const*)>;
 
-    ImagePool(OnImageRemove onImageRemove = [](auto) {}, ImageId nextImageId = ImageId(1));
+    static constexpr size_t DefaultMemoryBudget = 256 * 1024 * 1024;
+
+    ImagePool(OnImageRemove onImageRemove = [](auto) {},
+              ImageId nextImageId = ImageId(1),
+              size_t memoryBudget = DefaultMemoryBudget,
+              ImageRasterizer::OnCompleted onCompleted = []() {});
+
+    /// Ensures the given image gets rasterized, possibly asynchronously on a worker thread.
+    void rasterize(std::shared_ptr<RasterizedImage const> image);
+
+    /// @returns whether images have been rasterized, compressed or decompressed since the last
+    ///          collectCompletedJobs().
+    [[nodiscard]] bool hasCompletedJobs() const noexcept
+    {
+        return _rasterizer.hasCompleted() || _memoryUsage->decompressions.load() != _decompressionsSeen;
+    }
+
+    /// Takes the images rasterized or compressed on the worker thread back onto the calling
+    /// (terminal) thread, and enforces the memory budget if images have grown meanwhile
+    /// by being rasterized or decompressed.
+    ///
+    /// @returns whether any image has been rasterized since the last call.
+    bool collectCompletedJobs();
 
-    /// Creates an RGBA image of given size in pixels.
+    /// Creates an RGBA image of given size in pixels,
+    /// or returns an existing image of the very same content.
     std::shared_ptr<Image const> create(ImageFormat format, ImageSize pixelSize, Image::Data&& data);
 
+    void setMemoryBudget(size_t bytes);
+    [[nodiscard]] size_t memoryBudget() const noexcept { return _memoryBudget; }
+
+    /// @returns the number of bytes occupied by the pixel data of all live images.
+    [[nodiscard]] size_t memoryUsage() const noexcept { return _memoryUsage->bytes.load(); }
+
     // named image access
     //
     void link(std::string const& name, std::shared_ptr<Image const> imageRef);
@@ -246,13 +438,35 @@ class ImagePool
   private:
     void removeRasterizedImage(RasterizedImage* image); //!< Removes a rasterized image from pool.
 
+    /// Drops named images until the budget is met, and otherwise has the least recently used images
+    /// compressed on the worker thread.
+    void enforceMemoryBudget();
+
+    /// @returns all live images, including their rasters, pruning the indices from expired ones.
+    std::vector<std::shared_ptr<Image const>> liveImages();
+
     using NameToImageIdCache = crispy::strong_lru_cache<std::string, std::shared_ptr<Image const>>;
 
+    struct ContentEntry
+    {
+        crispy::strong_hash hash; //!< hash of the uncompressed pixel data
+        ImageFormat format;
+        ImageSize size;
+        std::weak_ptr<Image const> image;
+    };
+    using ContentIndex = std::unordered_multimap<uint32_t, ContentEntry>;
+
     // data members
     //
     ImageId _nextImageId;                      //!< ID for next image to be put into the pool
     NameToImageIdCache _imageNameToImageCache; //!< keeps mapping from name to raw image
     OnImageRemove _onImageRemove;              //!< Callback to be invoked when image gets removed from pool.
+    ContentIndex _imagesByContent;             //!< maps content hashes to (possibly expired) images
+    std::vector<std::weak_ptr<RasterizedImage const>> _rasterizedImages; //!< images with rasters of their own
+    size_t _memoryBudget;                      //!< upper bound of bytes occupied by live images' pixels
+    std::shared_ptr<ImageMemoryUsage> _memoryUsage; //!< bytes occupied by live images' pixels
+    uint64_t _decompressionsSeen = 0;               //!< decompressions as of the last collectCompletedJobs()
+    ImageRasterizer _rasterizer;               //!< resizes and compresses images off the terminal thread
 };
 
 } // namespace vtbackend
@@ -279,8 +493,15 @@ struct std::formatter<vtbackend::ImageStats>: formatter<std::string>
     auto format(vtbackend::ImageStats stats, auto& ctx) const
     {
         return formatter<std::string>::format(
-            std::format(
-                "{} instances, {} raster, {} fragments", stats.instances, stats.rasterized, stats.fragments),
+            std::format("{} instances, {} raster, {} fragments, {} deduplicated, {} evicted, "
+                        "{} compressed, {} decompressed",
+                        stats.instances,
+                        stats.rasterized,
+                        stats.fragments,
+                        stats.deduplicated,
+                        stats.evictions,
+                        stats.compressions,
+                        stats.decompressions),
             ctx);
     }
 };
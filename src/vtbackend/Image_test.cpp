@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Image.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace vtbackend;
+
+namespace
+{
+
+Image::Data solidImage(ImageSize size, uint8_t value)
+{
+    return Image::Data(size.area() * 4, value);
+}
+
+} // namespace
+
+TEST_CASE("ImagePool.deduplicate")
+{
+    auto pool = ImagePool {};
+    auto const size = ImageSize { Width(4), Height(4) };
+
+    auto const a = pool.create(ImageFormat::RGBA, size, solidImage(size, 0x10));
+    auto const b = pool.create(ImageFormat::RGBA, size, solidImage(size, 0x10));
+    auto const c = pool.create(ImageFormat::RGBA, size, solidImage(size, 0x20));
+
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(a->id() != c->id());
+    CHECK(pool.memoryUsage() == 2 * size.area() * 4);
+}
+
+TEST_CASE("Image.compress")
+{
+    auto const size = ImageSize { Width(64), Height(64) };
+    auto data = solidImage(size, 0xFF);
+    data[4] = 0x00; // break the first run
+    auto const image = Image(ImageId(1), ImageFormat::RGBA, data, size, [](auto) {});
+
+    CHECK(image.compress() > 0);
+    CHECK(image.compressed());
+    CHECK(image.footprint() < data.size());
+    CHECK(image.compress() == 0);
+
+    CHECK(*image.pixels() == data);
+    CHECK_FALSE(image.compressed());
+    CHECK(image.footprint() == data.size());
+}
+
+TEST_CASE("ImagePool.memory_budget")
+{
+    auto const size = ImageSize { Width(64), Height(64) };
+    auto const imageBytes = size.area() * 4;
+    auto mutex = std::mutex {};
+    auto condition = std::condition_variable {};
+    auto completed = false;
+    auto pool = ImagePool { [](auto) {}, ImageId(1), 2 * imageBytes, [&]() {
+                               auto const _ = std::lock_guard { mutex };
+                               completed = true;
+                               condition.notify_one();
+                           } };
+    auto const evictions = ImageStats::get().evictions;
+
+    auto const oldest = pool.create(ImageFormat::RGBA, size, solidImage(size, 1));
+    pool.link("named", pool.create(ImageFormat::RGBA, size, solidImage(size, 2)));
+    CHECK(pool.memoryUsage() == 2 * imageBytes);
+
+    // Exceeding the budget first drops named images that are only referenced by the pool.
+    auto const older = pool.create(ImageFormat::RGBA, size, solidImage(size, 3));
+    CHECK(pool.findImageByName("named") == nullptr);
+    CHECK(ImageStats::get().evictions == evictions + 1);
+    CHECK_FALSE(oldest->compressed());
+
+    // Then the least recently used images get compressed, on the worker thread.
+    auto const newest = pool.create(ImageFormat::RGBA, size, solidImage(size, 4));
+    auto lock = std::unique_lock { mutex };
+    REQUIRE(condition.wait_for(lock, std::chrono::seconds(10), [&]() { return completed; }));
+    lock.unlock();
+    CHECK_FALSE(pool.collectCompletedJobs());
+    CHECK(oldest->compressed());
+    CHECK_FALSE(newest->compressed());
+    CHECK(pool.memoryUsage() <= pool.memoryBudget());
+
+    // Decompressing an image grows it again, which has the budget enforced on the next collection.
+    CHECK(*oldest->pixels() == solidImage(size, 1));
+    CHECK(pool.memoryUsage() > pool.memoryBudget());
+    CHECK(pool.hasCompletedJobs());
+    lock.lock();
+    completed = false;
+    lock.unlock();
+    CHECK_FALSE(pool.collectCompletedJobs());
+    lock.lock();
+    REQUIRE(condition.wait_for(lock, std::chrono::seconds(10), [&]() { return completed; }));
+    lock.unlock();
+    CHECK(pool.memoryUsage() <= pool.memoryBudget());
+}
+
+TEST_CASE("RasterizedImage.resize_to_fit")
+{
+    auto const red = RGBAColor { 0xFF, 0x00, 0x00, 0xFF };
+    auto const imageSize = ImageSize { Width(4), Height(2) };
+    auto imageData = Image::Data {};
+    for (size_t i = 0; i < imageSize.area(); ++i)
+        imageData.insert(imageData.end(), { red.red(), red.green(), red.blue(), red.alpha() });
+    auto const image =
+        std::make_shared<Image>(ImageId(1), ImageFormat::RGBA, imageData, imageSize, [](auto) {});
+
+    // 2x2 cells of 2x2 pixels, i.e. a 4x4 raster with the image centered vertically.
+    auto const rasterizedImage = RasterizedImage(image,
+                                                 ImageAlignment::MiddleCenter,
+                                                 ImageResize::ResizeToFit,
+                                                 RGBAColor {},
+                                                 GridSize { LineCount(2), ColumnCount(2) },
+                                                 ImageSize { Width(2), Height(2) });
+    CHECK(rasterizedImage.raster() == nullptr);
+
+    rasterizedImage.rasterize(ImageId(2), [](auto) {});
+    auto const raster = rasterizedImage.raster();
+    REQUIRE(raster != nullptr);
+    CHECK(raster->id() == ImageId(2));
+    CHECK(raster->size() == ImageSize { Width(4), Height(4) });
+
+    auto const pixels = raster->pixels();
+    for (size_t y = 0; y < 4; ++y)
+    {
+        auto const expectedAlpha = (y == 1 || y == 2) ? 0xFF : 0x00;
+        for (size_t x = 0; x < 4; ++x)
+            CHECK((*pixels)[(((y * 4) + x) * 4) + 3] == expectedAlpha);
+    }
+}
+
+TEST_CASE("ImagePool.rasterize_async")
+{
+    auto mutex = std::mutex {};
+    auto condition = std::condition_variable {};
+    auto rasterized = false;
+    auto pool = ImagePool { [](auto) {}, ImageId(1), ImagePool::DefaultMemoryBudget, [&]() {
+                               auto const _ = std::lock_guard { mutex };
+                               rasterized = true;
+                               condition.notify_one();
+                           } };
+
+    auto const size = ImageSize { Width(64), Height(64) };
+    auto const image = pool.create(ImageFormat::RGBA, size, solidImage(size, 0x80));
+    auto const rasterizedImage = std::make_shared<RasterizedImage>(image,
+                                                                   ImageAlignment::TopStart,
+                                                                   ImageResize::StretchToFill,
+                                                                   RGBAColor {},
+                                                                   GridSize { LineCount(2), ColumnCount(4) },
+                                                                   ImageSize { Width(8), Height(16) });
+    pool.rasterize(rasterizedImage);
+
+    auto lock = std::unique_lock { mutex };
+    REQUIRE(condition.wait_for(lock, std::chrono::seconds(10), [&]() { return rasterized; }));
+    lock.unlock();
+
+    // The worker thread hands its reference to the rasterized image back to be released here.
+    CHECK(pool.hasCompletedJobs());
+    CHECK(pool.collectCompletedJobs());
+    CHECK_FALSE(pool.hasCompletedJobs());
+    CHECK(rasterizedImage.use_count() == 1);
+
+    auto const raster = rasterizedImage->raster();
+    REQUIRE(raster != nullptr);
+    CHECK(raster->size() == ImageSize { Width(32), Height(32) });
+    CHECK(*raster->pixels() == solidImage(raster->size(), 0x80));
+    CHECK(pool.memoryUsage() == (size.area() + raster->size().area()) * 4);
+}
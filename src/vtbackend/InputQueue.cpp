@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputQueue.h>
+
+namespace vtbackend
+{
+
+void InputQueue::push(std::string_view data)
+{
+    if (data.empty())
+        return;
+
+    auto const _ = std::lock_guard { _mutex };
+
+    if (!_segments.empty() && _segments.back().size() + data.size() <= MaxCoalescedSize)
+        _segments.back() += data;
+    else
+        _segments.emplace_back(data);
+
+    _size += data.size();
+}
+
+bool InputQueue::empty() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    return _size == 0;
+}
+
+size_t InputQueue::size() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    return _size;
+}
+
+std::string InputQueue::peek() const
+{
+    auto const _ = std::lock_guard { _mutex };
+
+    auto result = std::string {};
+    result.reserve(_size);
+    auto offset = _frontOffset;
+    for (auto const& segment: _segments)
+    {
+        result += std::string_view(segment).substr(offset);
+        offset = 0;
+    }
+    return result;
+}
+
+void InputQueue::clear()
+{
+    auto const _ = std::lock_guard { _mutex };
+    _segments.clear();
+    _frontOffset = 0;
+    _size = 0;
+}
+
+void InputQueue::consume(size_t n)
+{
+    _size -= n;
+    while (n > 0)
+    {
+        auto const available = _segments.front().size() - _frontOffset;
+        if (n < available)
+        {
+            _frontOffset += n;
+            return;
+        }
+        n -= available;
+        _segments.pop_front();
+        _frontOffset = 0;
+    }
+}
+
+} // namespace vtbackend
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace vtbackend
+{
+
+/**
+ * Thread-safe FIFO of bytes pending to be written to the PTY's stdin.
+ *
+ * User input (keyboard, mouse, paste) as well as replies to the application's requests
+ * (DA, DSR, XTGETTCAP, ...) are appended to the same queue, so that they reach the
+ * application in the order they were generated, regardless of the thread they originate from.
+ *
+ * Small appends are coalesced into the tail segment, and flush() hands out as many segments
+ * as fit into one bounded chunk to a single vectored write, keeping the number of write
+ * syscalls low under heavy mouse reporting or reply bursts.
+ */
+class InputQueue
+{
+  public:
+    /// Appends up to this many bytes to the tail segment instead of starting a new one.
+    static constexpr size_t MaxCoalescedSize = 4096;
+
+    /// Maximum number of bytes handed to the writer by a single flush().
+    ///
+    /// This bounds the time a single flush can take, e.g. for large pastes, and gives
+    /// the caller a chance to interleave other work (such as reading from the PTY)
+    /// before flushing the remainder.
+    static constexpr size_t MaxFlushSize = 64 * 1024;
+
+    /// Maximum number of segments handed to the writer by a single flush().
+    static constexpr size_t MaxFlushSegments = 64;
+
+    void push(std::string_view data);
+
+    [[nodiscard]] bool empty() const;
+
+    /// @returns the number of bytes pending.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns a copy of all pending bytes.
+    [[nodiscard]] std::string peek() const;
+
+    void clear();
+
+    /// Writes the pending bytes from the front of the queue, at most MaxFlushSize bytes.
+    ///
+    /// @param writer callable receiving a std::span<std::string_view const> of the
+    ///               segments to write, and returning the number of bytes written or -1 on error.
+    ///
+    /// @returns the writer's return value.
+    template <typename Writer>
+    int flush(Writer&& writer);
+
+  private:
+    void consume(size_t n);
+
+    mutable std::mutex _mutex;
+    std::deque<std::string> _segments;
+    size_t _frontOffset = 0; // number of bytes already written of the front segment
+    size_t _size = 0;
+};
+
+// {{{ implementation
+template <typename Writer>
+int InputQueue::flush(Writer&& writer)
+{
+    auto const _ = std::lock_guard { _mutex };
+
+    if (_size == 0)
+        return 0;
+
+    auto buffers = std::array<std::string_view, MaxFlushSegments> {};
+    auto count = size_t { 0 };
+    auto budget = MaxFlushSize;
+    auto offset = _frontOffset;
+    for (auto i = _segments.begin(); i != _segments.end() && count < buffers.size() && budget > 0; ++i)
+    {
+        auto const buffer = std::string_view(*i).substr(offset, budget);
+        buffers[count++] = buffer;
+        budget -= buffer.size();
+        offset = 0;
+    }
+
+    auto const rv = writer(std::span<std::string_view const>(buffers.data(), count));
+    if (rv > 0)
+        consume(static_cast<size_t>(rv));
+    return rv;
+}
+// }}}
+
+} // namespace vtbackend
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputQueue.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <string>
+#include <thread>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct MockWriter
+{
+    std::string written;
+    size_t calls = 0;
+    size_t buffers = 0;
+    size_t limit = std::string::npos; // maximum number of bytes accepted per call
+
+    int operator()(std::span<std::string_view const> input)
+    {
+        ++calls;
+        buffers += input.size();
+        auto accepted = size_t { 0 };
+        for (auto const buffer: input)
+        {
+            auto const n = std::min(buffer.size(), limit - accepted);
+            written += buffer.substr(0, n);
+            accepted += n;
+        }
+        return static_cast<int>(accepted);
+    }
+};
+
+} // namespace
+
+TEST_CASE("InputQueue.coalesce")
+{
+    auto queue = InputQueue {};
+    queue.push("\033[<35;1;1M"sv);
+    queue.push("\033[<35;2;1M"sv);
+    queue.push("\033[0n"sv);
+    CHECK(queue.size() == 24);
+    CHECK(queue.peek() == "\033[<35;1;1M\033[<35;2;1M\033[0n");
+
+    auto writer = MockWriter {};
+    CHECK(queue.flush(std::ref(writer)) == 24);
+    CHECK(writer.calls == 1);
+    CHECK(writer.buffers == 1);
+    CHECK(writer.written == "\033[<35;1;1M\033[<35;2;1M\033[0n");
+    CHECK(queue.empty());
+}
+
+TEST_CASE("InputQueue.partial_write")
+{
+    auto queue = InputQueue {};
+    queue.push("ABCDEF"sv);
+
+    auto writer = MockWriter {};
+    writer.limit = 4;
+    CHECK(queue.flush(std::ref(writer)) == 4);
+    CHECK(queue.peek() == "EF");
+
+    queue.push("GH"sv);
+    CHECK(queue.flush(std::ref(writer)) == 4);
+    CHECK(writer.written == "ABCDEFGH");
+    CHECK(queue.empty());
+}
+
+TEST_CASE("InputQueue.bounded_flush")
+{
+    auto const paste = std::string(InputQueue::MaxFlushSize * 2 + 10, 'x');
+
+    auto queue = InputQueue {};
+    queue.push(paste);
+    queue.push("\033[0n"sv);
+
+    auto writer = MockWriter {};
+    CHECK(queue.flush(std::ref(writer)) == static_cast<int>(InputQueue::MaxFlushSize));
+    CHECK(queue.flush(std::ref(writer)) == static_cast<int>(InputQueue::MaxFlushSize));
+    CHECK(queue.flush(std::ref(writer)) == 14);
+    CHECK(writer.calls == 3);
+    CHECK(writer.written == paste + "\033[0n");
+    CHECK(queue.flush(std::ref(writer)) == 0);
+    CHECK(writer.calls == 3);
+}
+
+TEST_CASE("InputQueue.concurrent_push")
+{
+    auto constexpr PushesPerThread = 1000;
+
+    auto queue = InputQueue {};
+    auto replies = std::thread { [&]() {
+        for (int i = 0; i < PushesPerThread; ++i)
+            queue.push("R"sv);
+    } };
+    for (int i = 0; i < PushesPerThread; ++i)
+        queue.push("I"sv);
+    replies.join();
+
+    auto writer = MockWriter {};
+    while (!queue.empty())
+        REQUIRE(queue.flush(std::ref(writer)) > 0);
+    CHECK(writer.written.size() == 2 * PushesPerThread);
+    CHECK(std::ranges::count(writer.written, 'R') == PushesPerThread);
+}
@@ -17,6 +17,8 @@
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <variant>
 #include <vector>
@@ -30,8 +32,11 @@ enum class LineFlag : uint8_t
     Wrappable = 0x0001,
     Wrapped = 0x0002,
     Marked = 0x0004,
-    // TODO: DoubleWidth  = 0x0010,
-    // TODO: DoubleHeight = 0x0020,
+    PromptStart = 0x0008, // OSC 133 ; A
+    OutputStart = 0x0010, // OSC 133 ; C
+    OutputEnd = 0x0020,   // OSC 133 ; D
+    // TODO: DoubleWidth  = 0x0040,
+    // TODO: DoubleHeight = 0x0080,
 };
 
 using LineFlags = crispy::flags<LineFlag>;
@@ -78,6 +83,9 @@ using LineStorage = std::variant<TrivialLineBuffer, InflatedLineBuffer<Cell>>;
 /**
  * Line<Cell> API.
  *
+ * Copies of a line share their storage until either of them gets modified (copy-on-write),
+ * such that lines can be snapshotted cheaply and read on another thread while the grid keeps changing.
+ *
  * TODO: Use custom allocator for ensuring cache locality of Cells to sibling lines.
  * TODO: Make the line optimization work.
  */
@@ -99,17 +107,23 @@ class Line
     using reverse_iterator = typename InflatedBuffer::reverse_iterator;
     using const_iterator = typename InflatedBuffer::const_iterator;
 
-    Line(LineFlags flags, TrivialBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
+    Line(LineFlags flags, TrivialBuffer buffer):
+        _storage { std::make_shared<Storage>(std::move(buffer)) }, _flags { flags }
+    {
+    }
 
-    Line(LineFlags flags, InflatedBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
+    Line(LineFlags flags, InflatedBuffer buffer):
+        _storage { std::make_shared<Storage>(std::move(buffer)) }, _flags { flags }
+    {
+    }
 
     void reset(LineFlags flags, GraphicsAttributes attributes) noexcept
     {
         _flags = flags;
-        if (isTrivialBuffer())
+        if (isTrivialBuffer() && !isStorageShared())
             trivialBuffer().reset(attributes);
         else
-            setBuffer(TrivialBuffer { ColumnCount::cast_from(inflatedBuffer().size()), attributes });
+            setBuffer(TrivialBuffer { size(), attributes });
     }
 
     void reset(LineFlags flags, GraphicsAttributes attributes, ColumnCount count) noexcept
@@ -284,19 +298,29 @@ class Line
     [[nodiscard]] InflatedBuffer& inflatedBuffer();
     [[nodiscard]] InflatedBuffer const& inflatedBuffer() const;
 
-    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept { return std::get<TrivialBuffer>(_storage); }
+    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept
+    {
+        return std::get<TrivialBuffer>(mutableStorage());
+    }
     [[nodiscard]] TrivialBuffer const& trivialBuffer() const noexcept
     {
-        return std::get<TrivialBuffer>(_storage);
+        return std::get<TrivialBuffer>(*_storage);
     }
 
     [[nodiscard]] bool isTrivialBuffer() const noexcept
     {
-        return std::holds_alternative<TrivialBuffer>(_storage);
+        return std::holds_alternative<TrivialBuffer>(*_storage);
     }
     [[nodiscard]] bool isInflatedBuffer() const noexcept { return !isTrivialBuffer(); }
 
-    void setBuffer(Storage buffer) noexcept { _storage = std::move(buffer); }
+    void setBuffer(Storage buffer) noexcept { replaceStorage(std::move(buffer)); }
+
+    /// Tests if this line still shares its storage with @p other, i.e. neither has been modified
+    /// since one has been copied from the other.
+    [[nodiscard]] bool sharesStorageWith(Line const& other) const noexcept
+    {
+        return _storage == other._storage;
+    }
 
     // Tests if the given text can be matched in this line at the exact given start column, in sensetive
     // or insensitive mode.
@@ -443,22 +467,60 @@ class Line
     }
 
   private:
-    Storage _storage;
+    static std::shared_ptr<Storage> const& sharedEmptyStorage()
+    {
+        static auto const storage = std::make_shared<Storage>();
+        return storage;
+    }
+
+    [[nodiscard]] bool isStorageShared() const noexcept
+    {
+        if (_storage.use_count() > 1)
+            return true;
+
+        // use_count() is a relaxed read. Before the storage gets modified in place, synchronize with
+        // the release of its last other owner, such as a snapshot destroyed on another thread.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return false;
+    }
+
+    // Returns this line's storage for modification, copying it first if it is shared with other lines.
+    Storage& mutableStorage()
+    {
+        if (isStorageShared())
+            _storage = std::make_shared<Storage>(*_storage);
+        return *_storage;
+    }
+
+    // Replaces this line's storage, reusing its memory unless it is shared with other lines.
+    void replaceStorage(Storage storage) const
+    {
+        if (isStorageShared())
+            _storage = std::make_shared<Storage>(std::move(storage));
+        else
+            *_storage = std::move(storage);
+    }
+
+    // Shared storage is never modified but replaced. Since only the owner of a line object
+    // replaces its storage, this is also done when inflating on const access, hence mutable.
+    mutable std::shared_ptr<Storage> _storage = sharedEmptyStorage();
     LineFlags _flags;
 };
 
 template <CellConcept Cell>
 inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedBuffer()
 {
-    if (auto trivialbuffer = std::get_if<TrivialBuffer>(&_storage))
-        _storage = inflate<Cell>(*trivialbuffer);
-    return std::get<InflatedBuffer>(_storage);
+    if (auto const* trivial = std::get_if<TrivialBuffer>(_storage.get()))
+        replaceStorage(inflate<Cell>(*trivial));
+    return std::get<InflatedBuffer>(mutableStorage());
 }
 
 template <CellConcept Cell>
 inline typename Line<Cell>::InflatedBuffer const& Line<Cell>::inflatedBuffer() const
 {
-    return const_cast<Line<Cell>*>(this)->inflatedBuffer();
+    if (auto const* trivial = std::get_if<TrivialBuffer>(_storage.get()))
+        replaceStorage(inflate<Cell>(*trivial));
+    return std::get<InflatedBuffer>(*_storage);
 }
 
 } // namespace vtbackend
@@ -468,10 +530,13 @@ struct std::formatter<vtbackend::LineFlags>: formatter<std::string>
 {
     auto format(const vtbackend::LineFlags flags, auto& ctx) const
     {
-        static const std::array<std::pair<vtbackend::LineFlags, std::string_view>, 3> nameMap = {
+        static const std::array<std::pair<vtbackend::LineFlags, std::string_view>, 6> nameMap = {
             std::pair { vtbackend::LineFlag::Wrappable, std::string_view("Wrappable") },
             std::pair { vtbackend::LineFlag::Wrapped, std::string_view("Wrapped") },
             std::pair { vtbackend::LineFlag::Marked, std::string_view("Marked") },
+            std::pair { vtbackend::LineFlag::PromptStart, std::string_view("PromptStart") },
+            std::pair { vtbackend::LineFlag::OutputStart, std::string_view("OutputStart") },
+            std::pair { vtbackend::LineFlag::OutputEnd, std::string_view("OutputEnd") },
         };
         std::string s;
         for (auto const& mapping: nameMap)
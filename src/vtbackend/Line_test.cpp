@@ -86,6 +86,48 @@ TEST_CASE("Line.reflow", "[Line]")
     CHECK(lineTrivial.isInflatedBuffer());
 }
 
+TEST_CASE("Line.copyOnWrite", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(4);
+    auto text = "abcd"sv;
+    auto pool = buffer_object_pool<char>(32);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(text);
+
+    auto const sgr = GraphicsAttributes {};
+    auto const trivial = TrivialLineBuffer { .displayWidth = DisplayWidth,
+                                             .textAttributes = sgr,
+                                             .fillAttributes = sgr,
+                                             .hyperlink = HyperlinkId {},
+                                             .usedColumns = DisplayWidth,
+                                             .text = bufferObject->ref(0, 4) };
+    auto line = Line<Cell>(LineFlag::None, trivial);
+    auto const snapshot = line;
+    CHECK(snapshot.sharesStorageWith(line));
+
+    // Reading the snapshot inflates its own copy only.
+    CHECK(snapshot.cells().size() == 4);
+    CHECK(snapshot.isInflatedBuffer());
+    CHECK(line.isTrivialBuffer());
+    CHECK_FALSE(snapshot.sharesStorageWith(line));
+
+    // Modifying the line leaves a snapshot of the inflated line untouched.
+    (void) line.inflatedBuffer();
+    auto const inflatedSnapshot = line;
+    CHECK(inflatedSnapshot.sharesStorageWith(line));
+    line.useCellAt(ColumnOffset(1)).write(sgr, U'X', 1);
+    CHECK_FALSE(inflatedSnapshot.sharesStorageWith(line));
+    CHECK(line.toUtf8() == "aXcd");
+    CHECK(inflatedSnapshot.toUtf8() == "abcd");
+    CHECK(snapshot.toUtf8() == "abcd");
+
+    // Resetting a shared line leaves the snapshot untouched, too.
+    auto const resetSnapshot = line;
+    line.reset(LineFlag::None, sgr);
+    CHECK(line.empty());
+    CHECK(resetSnapshot.toUtf8() == "aXcd");
+}
+
 TEST_CASE("Line.inflate", "[Line]")
 {
     auto constexpr TestText = "0123456789ABCDEF"sv;
@@ -86,9 +86,9 @@ class MockTerm: public Terminal::NullEvents
     std::string const& replyData() const noexcept { return mockPty().stdinBuffer(); }
     void resetReplyData() noexcept { mockPty().stdinBuffer().clear(); }
 
-    void requestCaptureBuffer(LineCount lines, bool logical) override
+    void requestCaptureBuffer(CaptureBufferMode mode, int count) override
     {
-        terminal.primaryScreen().captureBuffer(lines, logical);
+        terminal.primaryScreen().captureBuffer(mode, count);
     }
 };
 
@@ -1,12 +1,93 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/RenderBuffer.h>
 
+#include <crispy/FNV.h>
+
 #include <format>
 #include <mutex>
 
 namespace vtbackend
 {
 
+namespace
+{
+    /// Incremental 64-bit hash over word-sized values (FNV-1a with an additional
+    /// fold so that high bits of a value also affect the low bits of the result).
+    struct LineHasher
+    {
+        static constexpr auto Fnv =
+            crispy::fnv<uint64_t, uint64_t>(1099511628211llu, 14695981039346656037llu);
+
+        uint64_t state = Fnv.basis();
+
+        constexpr void add(uint64_t value) noexcept
+        {
+            state = Fnv(state, value);
+            state ^= state >> 32;
+        }
+
+        void add(RenderAttributes const& attributes) noexcept
+        {
+            add(attributes.foregroundColor.value());
+            add(attributes.backgroundColor.value());
+            add(attributes.decorationColor.value());
+            add(attributes.flags.value());
+        }
+    };
+} // namespace
+
+void RenderBuffer::updateLineHashes(LineCount lineCount)
+{
+    auto hashers = std::vector<LineHasher>(unbox<size_t>(lineCount));
+
+    auto const hasherAt = [&](LineOffset line) -> LineHasher* {
+        auto const index = unbox<size_t>(line);
+        return index < hashers.size() ? &hashers[index] : nullptr;
+    };
+
+    for (RenderCell const& cell: cells)
+    {
+        auto* hasher = hasherAt(cell.position.line);
+        if (!hasher)
+            continue;
+        hasher->add(unbox<uint64_t>(cell.position.column));
+        for (char32_t const codepoint: cell.codepoints)
+            hasher->add(codepoint);
+        hasher->add(cell.attributes);
+        hasher->add((uint64_t(cell.width) << 2) | (uint64_t(cell.groupStart) << 1) | uint64_t(cell.groupEnd));
+        if (cell.image)
+        {
+            auto const& rasterizedImage = cell.image->rasterizedImage();
+            hasher->add(unbox<uint64_t>(rasterizedImage.image().id()));
+            if (auto const raster = rasterizedImage.raster())
+                hasher->add(unbox<uint64_t>(raster->id()));
+            hasher->add((unbox<uint64_t>(cell.image->offset().line) << 32)
+                        | unbox<uint32_t>(cell.image->offset().column));
+            hasher->add((unbox<uint64_t>(rasterizedImage.cellSize().width) << 32)
+                        | unbox<uint32_t>(rasterizedImage.cellSize().height));
+        }
+    }
+
+    for (RenderLine const& line: lines)
+    {
+        auto* hasher = hasherAt(line.lineOffset);
+        if (!hasher)
+            continue;
+        // Distinguishes a line rendered as RenderLine from one rendered as (empty) cells.
+        hasher->add(~uint64_t(0));
+        for (char const ch: line.text)
+            hasher->add(static_cast<uint8_t>(ch));
+        hasher->add(unbox<uint64_t>(line.usedColumns));
+        hasher->add(unbox<uint64_t>(line.displayWidth));
+        hasher->add(line.textAttributes);
+        hasher->add(line.fillAttributes);
+    }
+
+    lineHashes.resize(hashers.size());
+    for (size_t i = 0; i < hashers.size(); ++i)
+        lineHashes[i] = hashers[i].state;
+}
+
 bool RenderDoubleBuffer::swapBuffers(std::chrono::steady_clock::time_point now) noexcept
 {
     // If the terminal thread (writer) cannot try_lock (w/o wait time)
@@ -71,12 +71,22 @@ struct RenderBuffer
     std::optional<RenderCursor> cursor {};
     uint64_t frameID {};
 
+    /// Content hash per screen line (including status lines), indexed by the line offset.
+    ///
+    /// Renderers use these to skip regenerating render commands for lines that
+    /// did not change since the previous frame.
+    std::vector<uint64_t> lineHashes {};
+
     void clear()
     {
         cells.clear();
         lines.clear();
         cursor.reset();
+        lineHashes.clear();
     }
+
+    /// Recomputes lineHashes for the first @p lineCount lines out of cells and lines.
+    void updateLineHashes(LineCount lineCount);
 };
 
 /// Lock-guarded handle to a read-only RenderBuffer object.
@@ -243,6 +243,145 @@ namespace // {{{ helper
         return v;
     }
 
+    // Serializes captured lines into consecutive PM replies (see docs/vt-extensions/buffer-capture.md).
+    //
+    // The text is encoded straight into the reply chunk being built, which is queued as soon as it is
+    // full. The queued replies are flushed to the PTY every now and then, so that the application
+    // can start consuming the capture while the remaining lines are still being serialized.
+    //
+    // Empty cells are captured as spaces, except for trailing ones, which are dropped at the end of
+    // each captured line.
+    class CaptureBufferWriter
+    {
+      public:
+        static constexpr size_t MaxChunkSize = 4096;
+
+        explicit CaptureBufferWriter(Terminal& terminal):
+            _terminal { terminal }, _prefix { std::format("\033^{};", CaptureBufferCode) }
+        {
+            _chunk.reserve(_prefix.size() + MaxChunkSize + 2);
+            _chunk = _prefix;
+        }
+
+        // Appends the text of the given line to the current captured line.
+        template <CellConcept Cell>
+        void append(Line<Cell> const& line)
+        {
+            if (line.isTrivialBuffer())
+            {
+                auto const& buffer = line.trivialBuffer();
+                appendText(buffer.text.view());
+                if (buffer.usedColumns < buffer.displayWidth)
+                    _pendingSpaces += unbox<size_t>(buffer.displayWidth - buffer.usedColumns);
+                return;
+            }
+
+            for (Cell const& cell: line.cells())
+            {
+                if (cell.isFlagEnabled(CellFlag::WideCharContinuation))
+                    continue;
+                if (cell.codepointCount() == 0 || (cell.codepointCount() == 1 && cell.codepoint(0) == ' '))
+                {
+                    ++_pendingSpaces;
+                    continue;
+                }
+                writePendingSpaces();
+                for (size_t i = 0; i < cell.codepointCount(); ++i)
+                    appendCodepoint(cell.codepoint(i));
+            }
+        }
+
+        // Terminates the current captured line, unless it is blank and @p keepBlank is false.
+        void endLine(bool keepBlank)
+        {
+            _pendingSpaces = 0;
+            if (_lineEmpty && !keepBlank)
+                return;
+            write("\n"sv);
+            _lineEmpty = true;
+        }
+
+        // Sends the remaining text, followed by the empty reply that marks the end of the capture.
+        void finish()
+        {
+            sendChunk();
+            _terminal.reply(std::format("{}\033\\", _prefix));
+        }
+
+      private:
+        void appendText(string_view text)
+        {
+            auto const contentEnd = text.find_last_not_of(' ');
+            if (contentEnd == string_view::npos)
+            {
+                _pendingSpaces += text.size();
+                return;
+            }
+            writePendingSpaces();
+            write(text.substr(0, contentEnd + 1));
+            _pendingSpaces = text.size() - contentEnd - 1;
+        }
+
+        void appendCodepoint(char32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                auto const ch = static_cast<char>(codepoint);
+                write(string_view(&ch, 1));
+            }
+            else
+                write(unicode::convert_to<char>(codepoint));
+        }
+
+        void writePendingSpaces()
+        {
+            _lineEmpty = false;
+            for (; _pendingSpaces > 0; --_pendingSpaces)
+                write(" "sv);
+        }
+
+        void write(string_view text)
+        {
+            while (!text.empty())
+            {
+                auto n = std::min(text.size(), MaxChunkSize - (_chunk.size() - _prefix.size()));
+                // Do not split UTF-8 sequences across chunks.
+                if (n < text.size())
+                    while (n > 0 && (static_cast<unsigned char>(text[n]) & 0xC0) == 0x80)
+                        --n;
+                _chunk.append(text.substr(0, n));
+                text.remove_prefix(n);
+                if (!text.empty())
+                    sendChunk();
+            }
+        }
+
+        void sendChunk()
+        {
+            if (_chunk.size() == _prefix.size())
+                return;
+
+            vtCaptureBufferLog()("Transferred chunk of {} bytes.", _chunk.size() - _prefix.size());
+            _chunk += "\033\\"; // ST
+            _terminal.reply(_chunk);
+            _unflushedSize += _chunk.size();
+            _chunk.resize(_prefix.size());
+
+            if (_unflushedSize >= InputQueue::MaxFlushSize)
+            {
+                _terminal.flushInput();
+                _unflushedSize = 0;
+            }
+        }
+
+        Terminal& _terminal;
+        std::string _prefix;
+        std::string _chunk;
+        size_t _pendingSpaces = 0;
+        size_t _unflushedSize = 0;
+        bool _lineEmpty = true;
+    };
+
     // optional<CharsetTable> getCharsetTableForCode(std::string const& intermediate)
     // {
     //     if (intermediate.size() != 1)
@@ -327,6 +466,7 @@ template <CellConcept Cell>
 void Screen<Cell>::hardReset()
 {
     _grid.reset();
+    _commandBlocks.clear();
     _cursor = {};
     _lastCursorPosition = {};
     updateCursorIterator();
@@ -336,11 +476,17 @@ template <CellConcept Cell>
 void Screen<Cell>::applyPageSizeToMainDisplay(PageSize mainDisplayPageSize)
 {
     auto cursorPosition = _cursor.position;
+    // Reflowing lines (including those left to be reflowed from a former resize) re-numbers them.
+    auto const renumbering = (_grid.reflowOnResize() && mainDisplayPageSize.columns != pageSize().columns)
+                             || _grid.unreflowedLineCount() != LineCount(0);
 
     // Ensure correct screen buffer size for the buffer we've just switched to.
     cursorPosition = _grid.resize(mainDisplayPageSize, cursorPosition, _cursor.wrapPending);
     cursorPosition = clampCoordinate(cursorPosition);
 
+    if (renumbering && !_commandBlocks.empty())
+        reanchorCommandBlocks();
+
     auto const margin = Margin {
         .vertical = Margin::Vertical { .from = {}, .to = mainDisplayPageSize.lines.as<LineOffset>() - 1 },
         .horizontal =
@@ -637,40 +783,29 @@ std::string Screen<Cell>::screenshot(function<string(LineOffset)> const& postLin
 }
 
 template <CellConcept Cell>
-optional<LineOffset> Screen<Cell>::findMarkerUpwards(LineOffset startLine) const
+bool Screen<Cell>::reflowHistoryUntil(LineOffset top)
 {
-    // XXX startLine is an absolute history line coordinate
-    if (historyLineCount() == 0)
-        return nullopt;
-    if (*startLine <= -*historyLineCount())
-        return nullopt;
-
-    startLine = std::min(startLine, boxed_cast<LineOffset>(pageSize().lines - 1));
+    if (!_grid.reflowHistoryUntil(top))
+        return false;
 
-    for (LineOffset i = startLine - 1; i >= -boxed_cast<LineOffset>(historyLineCount()); --i)
-        if (_grid.lineAt(i).marked())
-            return { i };
+    // Reflowing renumbers the lines above, which invalidates anything indexed by line number.
+    _terminal->markContentChanged();
+    if (!_commandBlocks.empty())
+        reanchorCommandBlocks();
+    return true;
+}
 
-    return nullopt;
+template <CellConcept Cell>
+optional<LineOffset> Screen<Cell>::findMarkerUpwards(LineOffset startLine) const
+{
+    // XXX startLine is an absolute history line coordinate
+    return _grid.findMarkerUpwards(std::min(startLine, boxed_cast<LineOffset>(pageSize().lines - 1)));
 }
 
 template <CellConcept Cell>
 optional<LineOffset> Screen<Cell>::findMarkerDownwards(LineOffset startLine) const
 {
-    if (historyLineCount() == 0)
-        return nullopt;
-
-    auto const top = std::clamp(startLine,
-                                -boxed_cast<LineOffset>(historyLineCount()),
-                                +boxed_cast<LineOffset>(pageSize().lines) - 1);
-
-    auto const bottom = LineOffset(0);
-
-    for (LineOffset i = top + 1; i <= bottom; ++i)
-        if (_grid.lineAt(i).marked())
-            return { i };
-
-    return nullopt;
+    return _grid.findMarkerDownwards(std::min(startLine, boxed_cast<LineOffset>(pageSize().lines - 1)));
 }
 
 // {{{ tabs related
@@ -1480,7 +1615,7 @@ void Screen<Cell>::moveCursorBackward(ColumnCount n)
     if (margin().horizontal.contains(_cursor.position.column))
         _cursor.position.column = margin().horizontal.clamp(_cursor.position.column - n.as<ColumnOffset>());
     else
-        _cursor.position.column = clampedColumn(_cursor.position.column + boxed_cast<ColumnOffset>(n));
+        _cursor.position.column = clampedColumn(_cursor.position.column - boxed_cast<ColumnOffset>(n));
     _cursor.wrapPending = false;
 }
 
@@ -1545,69 +1680,77 @@ void Screen<Cell>::notify(string const& title, string const& content)
 template <CellConcept Cell>
 void Screen<Cell>::captureBuffer(LineCount lineCount, bool logicalLines)
 {
-    // TODO: Unit test case! (for ensuring line numbering and limits are working as expected)
+    // TODO: when capturing lineCount < screenSize.lines, start at the lowest non-empty line.
+    auto const startLineToCapture = [&]() {
+        return logicalLines ? _grid.computeLogicalLineNumberFromBottom(LineCount::cast_from(lineCount))
+                            : unbox(pageSize().lines - lineCount);
+    };
+    auto relativeStartLine = startLineToCapture();
 
-    auto capturedBuffer = std::string();
+    // Lines are counted as laid out for the current page width.
+    if (reflowHistoryUntil(LineOffset::cast_from(relativeStartLine)))
+        relativeStartLine = startLineToCapture();
 
-    // TODO: when capturing lineCount < screenSize.lines, start at the lowest non-empty line.
-    auto const relativeStartLine =
-        logicalLines ? _grid.computeLogicalLineNumberFromBottom(LineCount::cast_from(lineCount))
-                     : unbox(pageSize().lines - lineCount);
     auto const startLine =
         LineOffset::cast_from(clamp(relativeStartLine, -unbox(historyLineCount()), unbox(pageSize().lines)));
 
     vtCaptureBufferLog()("Capture buffer: {} lines {}", lineCount, logicalLines ? "logical" : "actual");
+    vtCaptureBufferLog()("Capturing buffer. top: {}, bottom: {}", relativeStartLine, pageSize().lines - 1);
 
-    size_t constexpr MaxChunkSize = 4096;
-    size_t currentChunkSize = 0;
-    auto const pushContent = [&](auto const& data) -> void {
-        if (data.empty())
-            return;
-        if (currentChunkSize == 0) // initiate chunk
-            reply("\033^{};", CaptureBufferCode);
-        else if (currentChunkSize + data.size() >= MaxChunkSize)
+    // Logical lines are captured as one line each, with their wrapped lines joined.
+    // Blank lines are skipped either way.
+    auto writer = CaptureBufferWriter { *_terminal };
+    if (startLine < boxed_cast<LineOffset>(pageSize().lines))
+    {
+        for (LogicalLine<Cell> const& logicalLine: _grid.logicalLinesFrom(startLine))
         {
-            vtCaptureBufferLog()("Transferred chunk of {} bytes.", currentChunkSize);
-            reply("\033\\"); // ST
-            reply("\033^{};", CaptureBufferCode);
-            currentChunkSize = 0;
+            for (Line<Cell> const& line: logicalLine.lines)
+            {
+                writer.append(line);
+                if (!logicalLines)
+                    writer.endLine(false);
+            }
+            if (logicalLines)
+                writer.endLine(false);
         }
-        reply(data);
-        currentChunkSize += data.size();
-    };
-    LineOffset const bottomLine = boxed_cast<LineOffset>(pageSize().lines - 1);
-    vtCaptureBufferLog()("Capturing buffer. top: {}, bottom: {}", relativeStartLine, bottomLine);
+    }
+    writer.finish();
 
-    for (LineOffset line = startLine; line <= bottomLine; ++line)
+    vtCaptureBufferLog()("Capturing buffer finished.");
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::captureBuffer(CaptureBufferMode mode, int count)
+{
+    switch (mode)
     {
-        if (logicalLines && _grid.lineAt(line).wrapped() && !capturedBuffer.empty())
-            capturedBuffer.pop_back();
+        case CaptureBufferMode::PhysicalLines: captureBuffer(LineCount(count), false); break;
+        case CaptureBufferMode::LogicalLines: captureBuffer(LineCount(count), true); break;
+        case CaptureBufferMode::CommandOutputs: captureCommandOutputs(static_cast<size_t>(count)); break;
+    }
+}
 
-        auto const& lineBuffer = _grid.lineAt(line);
-        auto lineCellsTrimmed = lineBuffer.trim_blank_right();
-        if (lineCellsTrimmed.empty())
-        {
-            vtCaptureBufferLog()("Skipping blank line {}", line);
+template <CellConcept Cell>
+void Screen<Cell>::captureCommandOutputs(size_t count)
+{
+    vtCaptureBufferLog()("Capture command outputs: {} commands", count);
+
+    auto writer = CaptureBufferWriter { *_terminal };
+    for (auto n = std::min(count, _commandBlocks.size()); n > 0; --n)
+    {
+        auto const range = recentCommandOutputRange(n - 1);
+        if (!range)
             continue;
-        }
-        auto const tl = lineCellsTrimmed.size();
-        while (!lineCellsTrimmed.empty())
+        for (auto line = range->first.line; line <= range->second.line; ++line)
         {
-            auto const available = MaxChunkSize - currentChunkSize;
-            auto const n = std::min(available, lineCellsTrimmed.size());
-            for (auto const& cell: lineCellsTrimmed.subspan(0, n))
-                pushContent(cell.toUtf8());
-            lineCellsTrimmed = lineCellsTrimmed.subspan(n);
+            writer.append(_grid.lineAt(line));
+            if (line == range->second.line || !_grid.lineAt(line + 1).wrapped())
+                writer.endLine(true);
         }
-        vtCaptureBufferLog()("NL ({} len)", tl);
-        pushContent("\n"sv);
     }
+    writer.finish();
 
-    if (currentChunkSize != 0)
-        reply("\033\\"); // ST
-
-    vtCaptureBufferLog()("Capturing buffer finished.");
-    reply("\033^{};\033\\", CaptureBufferCode); // mark the end
+    vtCaptureBufferLog()("Capturing command outputs finished.");
 }
 
 template <CellConcept Cell>
@@ -1684,9 +1827,9 @@ template <CellConcept Cell>
 void Screen<Cell>::backIndex()
 {
     if (realCursorPosition().column == margin().horizontal.from)
-        ; // TODO: scrollRight(1);
+        _grid.scrollRight(GraphicsAttributes {}, margin());
     else
-        moveCursorForward(ColumnCount(1));
+        moveCursorBackward(ColumnCount(1));
 }
 
 template <CellConcept Cell>
@@ -1728,9 +1871,177 @@ void Screen<Cell>::setGraphicsRendition(GraphicsRendition rendition)
 template <CellConcept Cell>
 void Screen<Cell>::setMark()
 {
-    currentLine().setMarked(true);
+    _grid.enableLineFlags(_cursor.position.line, LineFlag::Marked, true);
+}
+
+// {{{ semantic prompts (OSC 133)
+template <CellConcept Cell>
+void Screen<Cell>::promptStart()
+{
+    setMark();
+
+    // A prompt that got redrawn (or abandoned) without executing anything is replaced.
+    if (auto const* block = _commandBlocks.current(); block && !block->executed())
+        if (auto const line = gridLineOffsetOf(block->promptLine))
+            _grid.enableLineFlags(*line, LineFlag::PromptStart, false);
+
+    _commandBlocks.evictAbove(_grid.lineNumberOf(-boxed_cast<LineOffset>(historyLineCount())));
+    _commandBlocks.prompt(_grid.lineNumberOf(_cursor.position.line));
+    _grid.enableLineFlags(_cursor.position.line, LineFlag::PromptStart, true);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::commandStart()
+{
+    auto* block = _commandBlocks.current();
+    if (!block || block->executed())
+        return;
+
+    block->commandLine = _grid.lineNumberOf(_cursor.position.line);
+    block->commandColumn = _cursor.position.column;
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::commandExecuted()
+{
+    auto* block = _commandBlocks.current();
+    if (!block || block->executed())
+        return;
+
+    if (block->commandLine)
+        if (auto const commandLine = gridLineOffsetOf(*block->commandLine);
+            commandLine && *commandLine <= _cursor.position.line)
+        {
+            auto const commandStart = CellLocation { .line = *commandLine, .column = block->commandColumn };
+            block->command = textBetween(commandStart, _cursor.position);
+        }
+
+    block->outputStart = _grid.lineNumberOf(_cursor.position.line);
+    _grid.enableLineFlags(_cursor.position.line, LineFlag::OutputStart, true);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::commandFinished(optional<int> exitCode)
+{
+    auto* block = _commandBlocks.current();
+    if (!block || !block->executed() || block->finished())
+        return;
+
+    block->outputEnd = _grid.lineNumberOf(_cursor.position.line);
+    block->outputEndLineIncluded = _cursor.position.column > ColumnOffset(0);
+    block->exitCode = exitCode;
+    _grid.enableLineFlags(_cursor.position.line, LineFlag::OutputEnd, true);
+}
+
+template <CellConcept Cell>
+optional<CellLocationRange> Screen<Cell>::recentCommandOutputRange(size_t n)
+{
+    auto const* block = _commandBlocks.recent(n);
+    if (!block)
+        return nullopt;
+
+    // Reflowing re-anchors the command blocks, so the range has to be looked up again.
+    auto range = commandOutputRange(*block);
+    if (range && reflowHistoryUntil(range->first.line))
+    {
+        block = _commandBlocks.recent(n);
+        range = block ? commandOutputRange(*block) : nullopt;
+    }
+    return range;
+}
+
+template <CellConcept Cell>
+optional<CellLocationRange> Screen<Cell>::commandOutputRange(CommandBlock const& block) const
+{
+    if (!block.executed())
+        return nullopt;
+
+    // The prompt line is gone when it has been evicted or overwritten (e.g. by a hard reset).
+    auto const promptLine = gridLineOffsetOf(block.promptLine);
+    if (!promptLine || !_grid.lineAt(*promptLine).isFlagEnabled(LineFlag::PromptStart))
+        return nullopt;
+
+    auto const first = gridLineOffsetOf(*block.outputStart);
+    if (!first)
+        return nullopt;
+
+    auto const [endLine, endLineIncluded] =
+        block.finished() ? pair { _grid.lineOffsetOf(*block.outputEnd), block.outputEndLineIncluded }
+                         : pair { _cursor.position.line, _cursor.position.column > ColumnOffset(0) };
+    auto const last = endLineIncluded ? endLine : endLine - 1;
+    if (last < *first)
+        return nullopt;
+
+    return CellLocationRange {
+        CellLocation { .line = *first, .column = ColumnOffset(0) },
+        CellLocation { .line = last, .column = boxed_cast<ColumnOffset>(pageSize().columns) - 1 },
+    };
+}
+
+template <CellConcept Cell>
+optional<LineOffset> Screen<Cell>::gridLineOffsetOf(int64_t lineNumber) const noexcept
+{
+    auto const line = _grid.lineOffsetOf(lineNumber);
+    if (line < -boxed_cast<LineOffset>(historyLineCount()))
+        return nullopt;
+    if (line >= boxed_cast<LineOffset>(pageSize().lines))
+        return nullopt;
+    return line;
 }
 
+template <CellConcept Cell>
+string Screen<Cell>::textBetween(CellLocation from, CellLocation to) const
+{
+    auto text = string {};
+    for (auto line = from.line; line <= to.line; ++line)
+    {
+        auto const& gridLine = _grid.lineAt(line);
+        if (line != from.line && !gridLine.wrapped())
+        {
+            while (!text.empty() && text.back() == ' ')
+                text.pop_back();
+            text += '\n';
+        }
+
+        auto const& cells = gridLine.inflatedBuffer();
+        auto const first = line == from.line ? from.column : ColumnOffset(0);
+        auto const last = line == to.line ? to.column : boxed_cast<ColumnOffset>(gridLine.size());
+        for (auto column = first; column < last; ++column)
+        {
+            auto const& cell = cells.at(unbox<size_t>(column));
+            if (cell.empty())
+                text += ' ';
+            else
+                text += cell.toUtf8();
+        }
+    }
+
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\n'))
+        text.pop_back();
+    return text;
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::reanchorCommandBlocks()
+{
+    auto anchors = CommandBlocks::Anchors {};
+    auto const bottomLine = boxed_cast<LineOffset>(pageSize().lines) - 1;
+    for (auto line = -boxed_cast<LineOffset>(historyLineCount()); line <= bottomLine; ++line)
+    {
+        auto const& gridLine = _grid.lineAt(line);
+        if (gridLine.wrapped())
+            continue;
+        if (gridLine.isFlagEnabled(LineFlag::PromptStart))
+            anchors.prompts.push_back(_grid.lineNumberOf(line));
+        if (gridLine.isFlagEnabled(LineFlag::OutputStart))
+            anchors.outputStarts.push_back(_grid.lineNumberOf(line));
+        if (gridLine.isFlagEnabled(LineFlag::OutputEnd))
+            anchors.outputEnds.push_back(_grid.lineNumberOf(line));
+    }
+    _commandBlocks.reanchor(anchors);
+}
+// }}}
+
 enum class ModeResponse : uint8_t
 { // TODO: respect response 0, 3, 4.
     NotRecognized = 0,
@@ -1879,6 +2190,7 @@ void Screen<Cell>::renderImage(shared_ptr<Image const> image,
     // TODO: make use of imageOffset and imageSize
     auto const rasterizedImage = make_shared<RasterizedImage>(
         std::move(image), alignmentPolicy, resizePolicy, gapColor, gridSize, _terminal->cellPixelSize());
+    _terminal->imagePool().rasterize(rasterizedImage);
     const auto lastSixelBand = unbox(imageSize.height) % 6;
     const LineOffset offset = [&]() {
         auto offset = LineOffset::cast_from(std::ceil((imageSize.height - lastSixelBand).as<double>()
@@ -2970,6 +3282,34 @@ namespace impl
                 return ApplyResult::Unsupported;
         }
 
+        template <CellConcept Cell>
+        ApplyResult SEMANTICPROMPT(Sequence const& seq, Screen<Cell>& screen)
+        {
+            // OSC 133 ; Kind [; Params] ST
+            //
+            // Kind: A = prompt start, B = command start, C = command executed, D = command finished
+            //
+            // Command finished may carry the command's exit code as first parameter.
+            auto const& value = seq.intermediateCharacters();
+            if (value.empty())
+                return ApplyResult::Invalid;
+
+            switch (value.front())
+            {
+                case 'A': screen.promptStart(); return ApplyResult::Ok;
+                case 'B': screen.commandStart(); return ApplyResult::Ok;
+                case 'C': screen.commandExecuted(); return ApplyResult::Ok;
+                case 'D': {
+                    auto const splits = crispy::split(value, ';');
+                    auto const exitCode =
+                        splits.size() > 1 ? crispy::to_integer<10, int>(splits[1]) : std::nullopt;
+                    screen.commandFinished(exitCode);
+                    return ApplyResult::Ok;
+                }
+                default: return ApplyResult::Unsupported;
+            }
+        }
+
         template <CellConcept Cell>
         ApplyResult SETCWD(Sequence const& seq, Screen<Cell>& screen)
         {
@@ -2984,17 +3324,22 @@ namespace impl
             //
             // Mode: 0 = physical lines
             //       1 = logical lines (unwrapped)
+            //       2 = outputs of the most recently executed commands (see OSC 133)
             //
             // Count: number of lines to capture from main page aera's bottom upwards
             //        If omitted or 0, the main page area's line count will be used.
+            //        In mode 2, the number of commands, defaulting to 1.
 
-            auto const logicalLines = seq.param_or(0, 0);
-            if (logicalLines != 0 && logicalLines != 1)
+            auto const mode = seq.param_or(0, 0);
+            if (mode > 2)
                 return ApplyResult::Invalid;
 
-            auto const lineCount = LineCount(seq.param_or(1, *terminal.pageSize().lines));
+            auto const captureMode = static_cast<CaptureBufferMode>(mode);
+            auto const defaultCount = captureMode == CaptureBufferMode::CommandOutputs
+                                          ? 1
+                                          : unbox<int>(terminal.pageSize().lines);
 
-            terminal.requestCaptureBuffer(lineCount, logicalLines);
+            terminal.requestCaptureBuffer(captureMode, seq.param_or(1, defaultCount));
 
             return ApplyResult::Ok;
         }
@@ -3751,6 +4096,7 @@ ApplyResult Screen<Cell>::apply(Function const& function, Sequence const& seq)
         case RCOLORHIGHLIGHTFG: resetDynamicColor(DynamicColorName::HighlightForegroundColor); break;
         case RCOLORHIGHLIGHTBG: resetDynamicColor(DynamicColorName::HighlightBackgroundColor); break;
         case NOTIFY: return impl::NOTIFY(seq, *this);
+        case SEMANTICPROMPT: return impl::SEMANTICPROMPT(seq, *this);
         case DUMPSTATE: inspect(); break;
 
         // hooks
@@ -5,6 +5,7 @@
 #include <vtbackend/CellUtil.h>
 #include <vtbackend/Charset.h>
 #include <vtbackend/Color.h>
+#include <vtbackend/CommandBlocks.h>
 #include <vtbackend/Grid.h>
 #include <vtbackend/Hyperlink.h>
 #include <vtbackend/Image.h>
@@ -275,6 +276,16 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void notify(std::string const& title, std::string const& content); // OSC 777
 
     void captureBuffer(LineCount lineCount, bool logicalLines);
+    void captureBuffer(CaptureBufferMode mode, int count);
+
+    /// Replies the output of the @p count most recently executed commands, oldest first,
+    /// using the same protocol as captureBuffer().
+    void captureCommandOutputs(size_t count);
+
+    void promptStart();                                // OSC 133 ; A
+    void commandStart();                               // OSC 133 ; B
+    void commandExecuted();                            // OSC 133 ; C
+    void commandFinished(std::optional<int> exitCode); // OSC 133 ; D
 
     void setForegroundColor(Color color);
     void setBackgroundColor(Color color);
@@ -481,11 +492,11 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     /// Finds the next marker right after the given line position.
     ///
-    /// @paramn startLine the line number of the current cursor (1..N) for screen area, or
-    ///                   (0..-N) for savedLines area
-    /// @return cursor position relative to screen origin (1, 1), that is, if line Number os >= 1, it's
-    ///         in the screen area, and in the savedLines area otherwise.
-    [[nodiscard]] std::optional<LineOffset> findMarkerDownwards(LineOffset startLine) const;
+    /// @paramn startLine the line number of the current cursor (0..N-1) for screen area, or
+    ///                   (-1..-N) for savedLines area
+    /// @return line offset of the nearest marked line below, if any, in the main page or
+    ///         savedLines area. This runs in logarithmic time with respect to the number of marks.
+    [[nodiscard]] std::optional<LineOffset> findMarkerDownwards(LineOffset startLine) const override;
 
     /// Finds the previous marker right next to the given line position.
     ///
@@ -493,7 +504,7 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     ///                   (0..-N) for savedLines area
     /// @return cursor position relative to screen origin (1, 1), that is, if line Number os >= 1, it's
     ///         in the screen area, and in the savedLines area otherwise.
-    [[nodiscard]] std::optional<LineOffset> findMarkerUpwards(LineOffset startLine) const;
+    [[nodiscard]] std::optional<LineOffset> findMarkerUpwards(LineOffset startLine) const override;
 
     void scrollUp(LineCount n) { scrollUp(n, margin()); }
     void scrollDown(LineCount n) { scrollDown(n, margin()); }
@@ -503,6 +514,26 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] Grid<Cell> const& grid() const noexcept { return _grid; }
     [[nodiscard]] Grid<Cell>& grid() noexcept { return _grid; }
 
+    /// Reflows the history lines not reflowed since the last resize yet, from @p top downwards.
+    ///
+    /// @see Grid::reflowHistoryUntil()
+    bool reflowHistoryUntil(LineOffset top);
+
+    /// Reflows all history lines not reflowed since the last resize yet.
+    bool reflowHistory() { return reflowHistoryUntil(-boxed_cast<LineOffset>(historyLineCount())); }
+
+    /// @returns the shell commands reported via semantic prompts (OSC 133).
+    [[nodiscard]] CommandBlocks const& commandBlocks() const noexcept { return _commandBlocks; }
+
+    /// @returns the range of full lines holding the output of the given command, if (still) available.
+    ///
+    /// The output of a command that is still running extends up to the cursor.
+    [[nodiscard]] std::optional<CellLocationRange> commandOutputRange(CommandBlock const& block) const;
+
+    /// @returns the output range of the @p n-th most recently executed command (see CommandBlocks::recent()),
+    ///          with the lines it spans being reflowed for the current page width.
+    [[nodiscard]] std::optional<CellLocationRange> recentCommandOutputRange(size_t n);
+
     /// @returns true iff given absolute line number is wrapped, false otherwise.
     [[nodiscard]] bool isLineWrapped(LineOffset lineNumber) const noexcept
     {
@@ -539,7 +570,7 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     void enableLineFlags(LineOffset lineOffset, LineFlags flags, bool enable) noexcept override
     {
-        _grid.lineAt(lineOffset).setFlag(flags, enable);
+        _grid.enableLineFlags(lineOffset, flags, enable);
     }
 
     [[nodiscard]] bool isLineFlagEnabledAt(LineOffset line, LineFlags flags) const noexcept override
@@ -614,6 +645,15 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] bool isContiguousToCurrentLine(std::string_view continuationChars) const noexcept;
     void advanceCursorAfterWrite(ColumnCount n) noexcept;
 
+    /// @returns the offset of the line with the given absolute line number, unless it has been evicted.
+    [[nodiscard]] std::optional<LineOffset> gridLineOffsetOf(int64_t lineNumber) const noexcept;
+
+    /// @returns the text between the two given positions (excluding @p to), joining wrapped lines.
+    [[nodiscard]] std::string textBetween(CellLocation from, CellLocation to) const;
+
+    /// Re-assigns the command blocks' line numbers after the lines have been reflowed.
+    void reanchorCommandBlocks();
+
     void clearAllTabs();
     void clearTabUnderCursor();
     void setTabUnderCursor();
@@ -642,6 +682,7 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     gsl::not_null<Settings*> _settings;
     gsl::not_null<Margin*> _margin;
     Grid<Cell> _grid;
+    CommandBlocks _commandBlocks;
 
     GraphicsAttributes _savedGraphicsRenditions {};
 
@@ -45,6 +45,8 @@ class ScreenBase: public SequenceHandler
     [[nodiscard]] virtual LineFlags lineFlagsAt(LineOffset line) const noexcept = 0;
     virtual void enableLineFlags(LineOffset lineOffset, LineFlags flags, bool enable) noexcept = 0;
     [[nodiscard]] virtual bool isLineFlagEnabledAt(LineOffset line, LineFlags flags) const noexcept = 0;
+    [[nodiscard]] virtual std::optional<LineOffset> findMarkerUpwards(LineOffset startLine) const = 0;
+    [[nodiscard]] virtual std::optional<LineOffset> findMarkerDownwards(LineOffset startLine) const = 0;
     [[nodiscard]] virtual std::string lineTextAt(LineOffset line,
                                                  bool stripLeadingSpaces = true,
                                                  bool stripTrailingSpaces = true) const noexcept = 0;
@@ -932,6 +932,39 @@ TEST_CASE("DECFI", "[screen]")
     REQUIRE("12345\n6   0\nA   E\nF   J\nKLMNO\n" == primaryScreen.renderMainPageText());
 }
 
+TEST_CASE("DECBI", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(5), ColumnCount(5) } };
+    auto& primaryScreen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen("12345\r\n67890\r\nABCDE\r\nFGHIJ\r\nKLMNO");
+    mock.writeToScreen(DECSM(69));     // Enable left right margin mode
+    mock.writeToScreen(DECSLRM(2, 4)); // Set left/right margin
+    mock.writeToScreen(DECSTBM(2, 4)); // Set top/bottom margin
+    mock.writeToScreen(CUP(1, 4));
+    REQUIRE(primaryScreen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(3) });
+
+    // from 0,3 to 0,2
+    mock.writeToScreen(DECBI());
+    CHECK(primaryScreen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(2) });
+    REQUIRE("12345\n67890\nABCDE\nFGHIJ\nKLMNO\n" == primaryScreen.renderMainPageText());
+
+    // from 0,2 to 0,1 (left border)
+    mock.writeToScreen(DECBI());
+    CHECK(primaryScreen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(1) });
+    REQUIRE("12345\n67890\nABCDE\nFGHIJ\nKLMNO\n" == primaryScreen.renderMainPageText());
+
+    // from 0,1 to 0,1, scrolling 1 right
+    mock.writeToScreen(DECBI());
+    CHECK(primaryScreen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(1) });
+    REQUIRE("12345\n6 780\nA BCE\nF GHJ\nKLMNO\n" == primaryScreen.renderMainPageText());
+
+    // from 0,1 to 0,1, scrolling 1 right
+    mock.writeToScreen(DECBI());
+    CHECK(primaryScreen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(1) });
+    REQUIRE("12345\n6  70\nA  BE\nF  GJ\nKLMNO\n" == primaryScreen.renderMainPageText());
+}
+
 TEST_CASE("InsertColumns", "[screen]")
 {
     // "DECIC has no effect outside the scrolling margins."
@@ -1716,30 +1749,38 @@ TEST_CASE("ScrollDown", "[screen]")
         mock.terminal.setTopBottomMargin(LineOffset { 1 }, LineOffset { 3 });
         mock.terminal.setMode(DECMode::Origin, true);
 
-        // SECTION("SD 1") {
-        //     screen.scrollDown(LineCount(1));
-        //     CHECK("12345\n6   0\nA789E\nFBCDJ\nKLMNO\n" == screen.renderMainPageText());
-        // }
-
-        // SECTION("SD 2") {
-        //     screen.scrollDown(LineCount(2));
-        //     CHECK(
-        //         "12345\n"
-        //         "6   0\n"
-        //         "A   E\n"
-        //         "F789J\n"
-        //         "KLMNO\n" == screen.renderMainPageText());
-        // }
-        //
-        // SECTION("SD 3") {
-        //     screen.scrollDown(LineCount(3));
-        //     CHECK(
-        //         "12345\n"
-        //         "6   0\n"
-        //         "A   E\n"
-        //         "F   J\n"
-        //         "KLMNO\n" == screen.renderMainPageText());
-        // }
+        SECTION("SD 1")
+        {
+            screen.scrollDown(LineCount(1));
+            CHECK("12345\n"
+                  "6   0\n"
+                  "A789E\n"
+                  "FBCDJ\n"
+                  "KLMNO\n"
+                  == screen.renderMainPageText());
+        }
+
+        SECTION("SD 2")
+        {
+            screen.scrollDown(LineCount(2));
+            CHECK("12345\n"
+                  "6   0\n"
+                  "A   E\n"
+                  "F789J\n"
+                  "KLMNO\n"
+                  == screen.renderMainPageText());
+        }
+
+        SECTION("SD 3")
+        {
+            screen.scrollDown(LineCount(3));
+            CHECK("12345\n"
+                  "6   0\n"
+                  "A   E\n"
+                  "F   J\n"
+                  "KLMNO\n"
+                  == screen.renderMainPageText());
+        }
     }
 
     SECTION("vertical margins")
@@ -1966,6 +2007,20 @@ TEST_CASE("MoveCursorBackward", "[screen]")
     REQUIRE(screen.logicalCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(0) });
 }
 
+TEST_CASE("MoveCursorBackward.outsideMargins", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen(DECSM(69));     // Enable left right margin mode
+    mock.writeToScreen(DECSLRM(2, 3)); // Set left/right margin
+    mock.writeToScreen(CUP(1, 5));
+    REQUIRE(screen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(4) });
+
+    // Right of the right margin, the cursor moves left into the margins, not right.
+    mock.writeToScreen(CUB(2));
+    CHECK(screen.realCursorPosition() == CellLocation { LineOffset(0), ColumnOffset(2) });
+}
+
 TEST_CASE("HorizontalPositionAbsolute", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(3) } };
@@ -2737,6 +2792,119 @@ TEST_CASE("captureBuffer", "[screen]")
     }
 }
 
+TEST_CASE("captureBuffer.logicalLines", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount { 5 } };
+    auto& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen("12345678\r\nabc");
+
+    SECTION("logical")
+    {
+        screen.captureBuffer(LineCount(2), true);
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;12345678\nabc\n\033\\\033^314;\033\\"));
+    }
+    SECTION("physical")
+    {
+        screen.captureBuffer(LineCount(2), false);
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;678\nabc\n\033\\\033^314;\033\\"));
+    }
+}
+
+TEST_CASE("captureBuffer.chunked", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(10) }, LineCount { 1000 } };
+    auto& screen = mock.terminal.primaryScreen();
+
+    auto expectedText = std::string();
+    for (int i = 0; i < 1000; ++i)
+    {
+        mock.writeToScreen(std::format("{:08}  \r\n", i));
+        expectedText += std::format("{:08}\n", i);
+    }
+
+    screen.captureBuffer(LineCount(1001), false);
+    mock.terminal.flushInput();
+    auto const reply = mock.replyData() + mock.terminal.peekInput();
+
+    // Each chunk is a PM sequence of its own, terminated by an empty one.
+    auto capturedText = std::string();
+    auto chunkCount = 0;
+    auto const prefix = "\033^314;"sv;
+    auto const st = "\033\\"sv;
+    auto input = string_view(reply);
+    while (!input.empty())
+    {
+        REQUIRE(input.starts_with(prefix));
+        input.remove_prefix(prefix.size());
+        auto const end = input.find(st);
+        REQUIRE(end != string_view::npos);
+        CHECK(end <= 4096);
+        capturedText += input.substr(0, end);
+        input.remove_prefix(end + st.size());
+        ++chunkCount;
+    }
+    CHECK(chunkCount > 2);
+    CHECK(capturedText == expectedText);
+}
+
+TEST_CASE("OSC.133.commandBlocks", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(5), ColumnCount(10) }, LineCount { 10 } };
+    auto& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen("\033]133;A\033\\$ \033]133;B\033\\ls -l\r\n\033]133;C\033\\one\r\ntwo\r\n");
+
+    SECTION("running")
+    {
+        auto const* block = screen.commandBlocks().recent(0);
+        REQUIRE(block != nullptr);
+        CHECK(block->command == "ls -l");
+        CHECK(!block->finished());
+
+        // The output of a running command extends up to the cursor.
+        mock.writeToScreen("thr");
+        auto const range = screen.commandOutputRange(*block);
+        REQUIRE(range.has_value());
+        CHECK(range->first == CellLocation { .line = LineOffset(1), .column = ColumnOffset(0) });
+        CHECK(range->second == CellLocation { .line = LineOffset(3), .column = ColumnOffset(9) });
+    }
+
+    SECTION("finished")
+    {
+        mock.writeToScreen("\033]133;D;2\033\\\033]133;A\033\\$ ");
+
+        REQUIRE(screen.commandBlocks().size() == 2);
+        CHECK(screen.commandBlocks().recent(1) == nullptr);
+        auto const* block = screen.commandBlocks().recent(0);
+        REQUIRE(block != nullptr);
+        CHECK(block->command == "ls -l");
+        CHECK(block->exitCode == 2);
+        CHECK(screen.isLineFlagEnabledAt(LineOffset(3), LineFlag::PromptStart));
+
+        auto const range = screen.commandOutputRange(*block);
+        REQUIRE(range.has_value());
+        CHECK(range->first == CellLocation { .line = LineOffset(1), .column = ColumnOffset(0) });
+        CHECK(range->second == CellLocation { .line = LineOffset(2), .column = ColumnOffset(9) });
+        CHECK(mock.terminal.extractCommandOutput(0) == "one\ntwo\n");
+
+        mock.writeToScreen("\033[>2;1t");
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;one\ntwo\n\033\\\033^314;\033\\"));
+    }
+
+    SECTION("evicted")
+    {
+        mock.writeToScreen("\033]133;D;0\033\\");
+        for (int i = 0; i < 20; ++i)
+            mock.writeToScreen("\r\n");
+        mock.writeToScreen("\033]133;A\033\\$ ");
+
+        CHECK(screen.commandBlocks().size() == 1);
+        CHECK(screen.commandBlocks().recent(0) == nullptr);
+        CHECK(mock.terminal.extractCommandOutput(0).empty());
+    }
+}
+
 TEST_CASE("render into history", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
@@ -40,6 +40,7 @@ struct Settings
 
     MaxHistoryLineCount maxHistoryLineCount;
     ImageSize maxImageSize { Width(800), Height(600) };
+    size_t maxImageMemory = 256 * 1024 * 1024; // budget in bytes for the pixel data of all live images
     unsigned maxImageRegisterCount = 256;
     StatusDisplayType statusDisplayType = StatusDisplayType::None;
     StatusDisplayPosition statusDisplayPosition = StatusDisplayPosition::Bottom;
@@ -85,6 +86,7 @@ struct Settings
     struct PrimaryScreen
     {
         bool allowReflowOnResize = true;
+        bool lazyHistoryReflow = true;
     };
     PrimaryScreen primaryScreen;
 
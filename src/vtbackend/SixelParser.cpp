@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstring>
 
 using std::clamp;
 using std::fill;
@@ -38,6 +40,29 @@ namespace
         return static_cast<int8_t>(static_cast<int>(value) - 63);
     }
 
+    /// Fills @p count RGBA pixels at @p target with the given color.
+    ///
+    /// The filled area is doubled with each copy, so that long runs are filled with
+    /// a few large (vectorized) memory copies rather than pixel by pixel.
+    void fillPixels(uint8_t* target, size_t count, RGBAColor color) noexcept
+    {
+        if (count == 0)
+            return;
+
+        target[0] = color.red();
+        target[1] = color.green();
+        target[2] = color.blue();
+        target[3] = color.alpha();
+
+        size_t filled = 1;
+        while (filled < count)
+        {
+            auto const n = min(filled, count - filled);
+            std::memcpy(target + (filled * 4), target, n * 4);
+            filled += n;
+        }
+    }
+
     constexpr RGBColor rgb(uint8_t r, uint8_t g, uint8_t b)
     {
         return RGBColor { r, g, b };
@@ -159,9 +184,7 @@ void SixelParser::parse(char value)
                 paramShiftAndAddDigit(toDigit(value));
             else if (isSixel(value))
             {
-                auto const sixel = toSixel(value);
-                for (unsigned i = 0; i < _params[0]; ++i)
-                    _events.render(sixel);
+                _events.renderRepeated(toSixel(value), _params[0]);
                 transitionTo(State::Ground);
             }
             else
@@ -356,8 +379,10 @@ SixelImageBuilder::SixelImageBuilder(ImageSize maxSize,
                                      std::shared_ptr<SixelColorPalette> colorPalette):
     _maxSize { maxSize },
     _colors { std::move(colorPalette) },
+    _backgroundColor { backgroundColor },
     _size { ImageSize { Width { 1 }, Height { 1 } } },
-    _buffer(_maxSize.area() * 4),
+    _buffer(_size.area() * 4),
+    _bufferSize { _size },
     _sixelCursor {},
     _aspectRatio(static_cast<unsigned int>(
         std::ceil(static_cast<float>(aspectVertical) / static_cast<float>(aspectHorizontal)))),
@@ -369,51 +394,69 @@ SixelImageBuilder::SixelImageBuilder(ImageSize maxSize,
 void SixelImageBuilder::clear(RGBAColor fillColor)
 {
     _sixelCursor = {};
-
-    auto* p = _buffer.data();
-    auto* const e = p + (_maxSize.area() * 4);
-    while (p != e)
-    {
-        *p++ = fillColor.red();
-        *p++ = fillColor.green();
-        *p++ = fillColor.blue();
-        *p++ = fillColor.alpha();
-    }
+    _backgroundColor = fillColor;
+    fillPixels(_buffer.data(), _buffer.size() / 4, fillColor);
 }
 
 RGBAColor SixelImageBuilder::at(CellLocation coord) const noexcept
 {
     auto const line = unbox(coord.line) % unbox(_size.height);
     auto const col = unbox(coord.column) % unbox(_size.width);
-    auto const base = (line * unbox(_size.width) * 4) + (col * 4);
+    auto const base = (line * unbox(_bufferSize.width) * 4) + (col * 4);
     const auto* const color = &_buffer[base];
     return RGBAColor { color[0], color[1], color[2], color[3] };
 }
 
-void SixelImageBuilder::write(CellLocation const& coord, RGBColor const& value) noexcept
+void SixelImageBuilder::resizeBuffer(ImageSize extents)
 {
-    if (unbox(coord.line) >= 0 && unbox(coord.line) < unbox<int>(_maxSize.height) && unbox(coord.column) >= 0
-        && unbox(coord.column) < unbox<int>(_maxSize.width))
+    if (extents.width == _bufferSize.width)
     {
-        if (!_explicitSize)
-        {
-            if (unbox(coord.line) >= unbox<int>(_size.height))
-                _size.height = Height::cast_from(coord.line.as<unsigned int>() + _aspectRatio);
-            if (unbox(coord.column) >= unbox<int>(_size.width))
-                _size.width = Width::cast_from(coord.column + 1);
-        }
+        // Same pitch, rows can be appended or dropped in place.
+        auto const oldByteCount = _buffer.size();
+        _buffer.resize(extents.area() * 4);
+        if (_buffer.size() > oldByteCount)
+            fillPixels(_buffer.data() + oldByteCount, (_buffer.size() - oldByteCount) / 4, _backgroundColor);
+        _bufferSize = extents;
+        return;
+    }
+
+    auto const newPitch = unbox<size_t>(extents.width);
+    auto const oldPitch = unbox<size_t>(_bufferSize.width);
+    auto const copyWidth = min(newPitch, oldPitch);
+    auto const copyHeight = min(unbox<size_t>(extents.height), unbox<size_t>(_bufferSize.height));
 
-        for (unsigned int i = 0; i < _aspectRatio; ++i)
+    auto buffer = Buffer(extents.area() * 4);
+    for (size_t line = 0; line < unbox<size_t>(extents.height); ++line)
+    {
+        auto* const target = buffer.data() + (line * newPitch * 4);
+        if (line < copyHeight)
         {
-            auto const base = ((coord.line.as<unsigned int>() + i)
-                               * unbox((_explicitSize ? _size.width : _maxSize.width)) * 4u)
-                              + (unbox<unsigned int>(coord.column) * 4u);
-            _buffer[base + 0] = value.red;
-            _buffer[base + 1] = value.green;
-            _buffer[base + 2] = value.blue;
-            _buffer[base + 3] = 0xFF;
+            std::memcpy(target, _buffer.data() + (line * oldPitch * 4), copyWidth * 4);
+            fillPixels(target + (copyWidth * 4), newPitch - copyWidth, _backgroundColor);
         }
+        else
+            fillPixels(target, newPitch, _backgroundColor);
     }
+
+    _buffer.swap(buffer);
+    _bufferSize = extents;
+}
+
+void SixelImageBuilder::reserveBuffer(unsigned columnEnd, unsigned lineEnd)
+{
+    auto extents = _bufferSize;
+
+    // The width is grown geometrically, as every change of the pitch implies moving all rows.
+    if (columnEnd > unbox(extents.width))
+        extents.width =
+            Width::cast_from(min(max(columnEnd, unbox(extents.width) * 2), unbox(_maxSize.width)));
+
+    // The height is grown band by band, with the buffer's capacity growth amortizing the reallocations.
+    if (lineEnd > unbox(extents.height))
+        extents.height = Height::cast_from(min(lineEnd, unbox(_maxSize.height)));
+
+    if (extents != _bufferSize)
+        resizeBuffer(extents);
 }
 
 void SixelImageBuilder::setColor(unsigned index, RGBColor const& color)
@@ -450,27 +493,56 @@ void SixelImageBuilder::setRaster(unsigned int pan, unsigned int pad, optional<I
         imageSize->height = Height::cast_from(imageSize->height.value * _aspectRatio);
         _size.width = clamp(imageSize->width, Width(0), _maxSize.width);
         _size.height = clamp(imageSize->height, Height(0), _maxSize.height);
-        _buffer.resize(_size.area() * 4);
+        resizeBuffer(_size);
         _explicitSize = true;
     }
 }
 
 void SixelImageBuilder::render(int8_t sixel)
+{
+    renderRepeated(sixel, 1);
+}
+
+void SixelImageBuilder::renderRepeated(int8_t sixel, unsigned count)
 {
     // TODO: respect aspect ratio!
-    auto const x = _sixelCursor.column;
-    if (unbox(x) < unbox<int>((_explicitSize ? _size.width : _maxSize.width)))
+    auto const limits = _explicitSize ? _size : _maxSize;
+    auto const column = unbox<unsigned>(_sixelCursor.column);
+    if (column >= unbox(limits.width))
+        return;
+
+    auto const run = min(count, unbox(limits.width) - column);
+    _sixelCursor.column = ColumnOffset::cast_from(column + run);
+
+    auto const pins = static_cast<unsigned>(sixel) & 0x3F;
+    if (!pins || !run)
+        return;
+
+    // Pixel rows [line, lineEnd) are covered by the pinned sixel bits, clipped to the image limits.
+    auto const line = unbox<unsigned>(_sixelCursor.line);
+    auto const lineEnd = min(line + (static_cast<unsigned>(std::bit_width(pins)) * _aspectRatio),
+                             unbox(limits.height));
+    if (line >= lineEnd)
+        return;
+
+    if (!_explicitSize)
     {
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-            auto const y = _sixelCursor.line + static_cast<int>(i * _aspectRatio);
-            auto const pos = CellLocation { .line = y, .column = x };
-            auto const pin = 1 << i;
-            auto const pinned = (sixel & pin) != 0;
-            if (pinned)
-                write(pos, currentColor());
-        }
-        _sixelCursor.column++;
+        reserveBuffer(column + run, line + _sixelBandHeight);
+        _size.width = max(_size.width, Width::cast_from(column + run));
+        _size.height = max(_size.height, Height::cast_from(lineEnd));
+    }
+
+    auto const color = RGBAColor { currentColor(), 0xFF };
+    auto const pitch = unbox<size_t>(_bufferSize.width);
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        if (!(pins & (1u << i)))
+            continue;
+
+        // Each sixel bit covers aspect-ratio many pixel rows.
+        auto const y0 = line + (i * _aspectRatio);
+        for (auto y = y0; y < min(y0 + _aspectRatio, lineEnd); ++y)
+            fillPixels(_buffer.data() + (((y * pitch) + column) * 4), run, color);
     }
 }
 
@@ -479,24 +551,13 @@ void SixelImageBuilder::finalize()
     if (unbox(_size.height) == 1)
     {
         _size.height = Height::cast_from(_sixelCursor.line.as<unsigned int>() * _aspectRatio);
-        _buffer.resize(_size.area() * 4);
+        resizeBuffer(_size);
         return;
     }
-    if (!_explicitSize)
-    {
-        Buffer tempBuffer(static_cast<size_t>(_size.height.value * _size.width.value) * 4);
-        for (auto i = 0u; i < unbox(_size.height); ++i)
-        {
-            for (auto j = 0u; j < unbox(_size.width); ++j)
-            {
-                std::copy_n(_buffer.begin() + i * unbox<long>(_maxSize.width) * 4,
-                            _size.width.value * 4,
-                            tempBuffer.begin() + i * unbox<long>(_size.width) * 4);
-            }
-        }
-        _buffer.swap(tempBuffer);
-        _explicitSize = false;
-    }
+
+    // Trims the storage to the image's actual size.
+    if (_bufferSize != _size)
+        resizeBuffer(_size);
 }
 
 } // namespace vtbackend
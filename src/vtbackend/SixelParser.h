@@ -65,6 +65,13 @@ class SixelParser: public ParserExtension
         /// renders a given sixel at the current sixel-cursor position.
         virtual void render(int8_t sixel) = 0;
 
+        /// Renders the given sixel @p count times, starting at the current sixel-cursor position.
+        virtual void renderRepeated(int8_t sixel, unsigned count)
+        {
+            for (unsigned i = 0; i < count; ++i)
+                render(sixel);
+        }
+
         /// Finalizes the image by optimizing the underlying storage to its minimal dimension in storage.
         virtual void finalize() = 0;
     };
@@ -135,6 +142,10 @@ class SixelColorPalette
 /// Sixel Image Builder API
 ///
 /// Implements the SixelParser::Events event listener to construct a Sixel image.
+///
+/// Unless the image size is given by the raster attributes, the underlying storage
+/// grows with the sixel bands being written, rather than being allocated for the
+/// maximum image size up front, and is trimmed to the image's size by finalize().
 class SixelImageBuilder: public SixelParser::Events
 {
   public:
@@ -164,18 +175,26 @@ class SixelImageBuilder: public SixelParser::Events
     void newline() override;
     void setRaster(unsigned int pan, unsigned int pad, std::optional<ImageSize> imageSize) override;
     void render(int8_t sixel) override;
+    void renderRepeated(int8_t sixel, unsigned count) override;
     void finalize() override;
 
     [[nodiscard]] CellLocation const& sixelCursor() const noexcept { return _sixelCursor; }
 
   private:
-    void write(CellLocation const& coord, RGBColor const& value) noexcept;
+    /// Resizes the underlying storage to the given extents, preserving the already written pixels.
+    void resizeBuffer(ImageSize extents);
+
+    /// Ensures the underlying storage covers the given (exclusive) column and line,
+    /// growing the storage if needed.
+    void reserveBuffer(unsigned columnEnd, unsigned lineEnd);
 
   private:
     ImageSize const _maxSize;
     std::shared_ptr<SixelColorPalette> _colors;
+    RGBAColor _backgroundColor;
     ImageSize _size;
-    Buffer _buffer; /// RGBA buffer
+    Buffer _buffer;         /// RGBA buffer
+    ImageSize _bufferSize;  /// Extents of _buffer in pixels, with its width being the buffer's pitch.
     CellLocation _sixelCursor {};
     unsigned _currentColor = 0;
     bool _explicitSize = false;
@@ -373,3 +373,30 @@ TEST_CASE("SixelParser.vertical_cursor_advance", "[sixel]")
     REQUIRE(ib.size() == vtbackend::ImageSize { Width(1), Height(24) });
     REQUIRE(ib.sixelCursor() == CellLocation { LineOffset(24), ColumnOffset { 0 } });
 }
+
+TEST_CASE("SixelParser.implicit_size_growth", "[sixel]")
+{
+    auto constexpr DefaultColor = RGBAColor { 0, 0, 0, 255 };
+    auto constexpr PinColor = RGBAColor { 255, 0, 0, 255 };
+    SixelImageBuilder ib(
+        { Width(640), Height(480) }, 1, 1, DefaultColor, std::make_shared<SixelColorPalette>(16, 256));
+    auto sp = SixelParser { ib };
+    sp.parseFragment("#1;2;100;0;0");
+    sp.parseFragment("!300~"); // full band of 300 sixels
+    sp.parseFragment("-");     // newline
+    sp.parseFragment("!5~");   // 5 sixels into the second band
+    sp.done();
+
+    REQUIRE(ib.size() == vtbackend::ImageSize { Width(300), Height(12) });
+    REQUIRE(ib.data().size() == 300u * 12u * 4u);
+
+    for (int y = 0; y < 12; ++y)
+    {
+        for (int x = 0; x < 300; ++x)
+        {
+            auto const expectedColor = y < 6 || x < 5 ? PinColor : DefaultColor;
+            auto const pos = CellLocation { .line = LineOffset(y), .column = ColumnOffset(x) };
+            CHECK(ib.at(pos) == expectedColor);
+        }
+    }
+}
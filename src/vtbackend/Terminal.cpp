@@ -15,6 +15,7 @@
 
 #include <crispy/assert.h>
 #include <crispy/escape.h>
+#include <crispy/trace.h>
 #include <crispy/utils.h>
 
 #include <libunicode/convert.h>
@@ -23,13 +24,16 @@
 
 #include <sys/types.h>
 
+#include <cerrno>
 #include <chrono>
 #include <cstdlib>
 #include <format>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <variant>
+#include <vector>
 
 using crispy::size;
 using std::nullopt;
@@ -157,9 +161,10 @@ Terminal::Terminal(Events& eventListener,
     _effectiveImageCanvasSize { _settings.maxImageSize },
     _sixelColorPalette { std::make_shared<SixelColorPalette>(_maxSixelColorRegisters,
                                                              _maxSixelColorRegisters) },
-    _imagePool { [this](Image const* image) {
-        discardImage(*image);
-    } },
+    _imagePool { [this](Image const* image) { discardImage(*image); },
+                 ImageId(1),
+                 _settings.maxImageMemory,
+                 [this]() { _pty->wakeupReader(); } },
     _hyperlinks { .cache = HyperlinkCache { 1024 } },
     _sequenceBuilder { ModeDependantSequenceHandler { *this }, TerminalInstructionCounter { *this } },
     _parser { std::ref(_sequenceBuilder) },
@@ -175,6 +180,8 @@ Terminal::Terminal(Events& eventListener,
     setMode(DECMode::Unicode, true);
     setMode(DECMode::VisibleCursor, true);
     setMode(DECMode::LeftRightMargin, false);
+    _primaryScreen.grid().setLazyHistoryReflow(_settings.primaryScreen.lazyHistoryReflow);
+    _primaryScreen.grid().setReflowThreadCount(std::thread::hardware_concurrency());
 
     for (auto const& [mode, frozen]: _settings.frozenModes)
         freezeMode(mode, frozen);
@@ -221,6 +228,7 @@ std::optional<vtpty::Pty::ReadResult> Terminal::readFromPty()
         _currentPtyBuffer = _ptyBufferPool.allocateBufferObject();
     }
 
+    auto const traceSpan = crispy::trace::span { "Terminal::readFromPty" };
     return _pty->read(*_currentPtyBuffer, timeout, _ptyReadBufferSize);
 }
 
@@ -266,6 +274,17 @@ bool Terminal::processInputOnce()
     }
     // clang-format on
 
+    if (_imagePool.hasCompletedJobs())
+    {
+        auto rasterized = false;
+        {
+            auto const _ = std::lock_guard { *this };
+            rasterized = _imagePool.collectCompletedJobs();
+        }
+        if (rasterized)
+            breakLoopAndRefreshRenderBuffer();
+    }
+
     auto const readResult = readFromPty();
 
     if (!readResult)
@@ -279,6 +298,7 @@ bool Terminal::processInputOnce()
     }
     string_view const buf = readResult->data;
     _usingStdoutFastPipe = readResult->fromStdoutFastPipe;
+    crispy::trace::counter("pty.read.bytes", static_cast<int64_t>(buf.size()));
 
     if (buf.empty())
     {
@@ -289,7 +309,9 @@ bool Terminal::processInputOnce()
 
     {
         auto const _ = std::lock_guard { *this };
+        auto const traceSpan = crispy::trace::span { "Parser::parseFragment" };
         _parser.parseFragment(buf);
+        markContentChanged();
     }
 
     if (!_modes.enabled(DECMode::BatchedRendering))
@@ -438,6 +460,8 @@ void Terminal::fillRenderBuffer(RenderBuffer& output, bool includeSelection)
 
 void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelection)
 {
+    auto const traceSpan = crispy::trace::span { "Terminal::fillRenderBufferInternal" };
+
     verifyState();
 
     output.clear();
@@ -461,6 +485,12 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
     auto const highlightSearchMatches =
         _search.pattern.empty() ? HighlightSearchMatches::No : HighlightSearchMatches::Yes;
 
+    // History lines not reflowed since the last resize are reflowed as they are scrolled into view.
+    auto const viewportTop = -boxed_cast<LineOffset>(_viewport.scrollOffset());
+    if (isPrimaryScreen() && _primaryScreen.reflowHistoryUntil(viewportTop)
+        && _viewport.scrollOffset() > boxed_cast<ScrollOffset>(_primaryScreen.historyLineCount()))
+        _viewport.scrollToTop();
+
     auto const theCursorPosition = [&]() -> std::optional<CellLocation> {
         if (inputHandler().mode() == ViMode::Insert)
         {
@@ -501,6 +531,8 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
         baseLine += pageSize().lines.as<LineOffset>();
         fillRenderBufferStatusLine(output, includeSelection, baseLine);
     }
+
+    output.updateLineHashes(pageSize().lines + statusLineHeight());
 }
 
 LineCount Terminal::fillRenderBufferStatusLine(RenderBuffer& output, bool includeSelection, LineOffset base)
@@ -633,7 +665,7 @@ Handled Terminal::sendKeyEvent(Key key, Modifiers modifiers, KeyboardEventType e
     bool const success = _inputGenerator.generate(key, modifiers, eventType);
     if (success)
     {
-        flushInput();
+        flushGeneratedInput();
         _viewport.scrollToBottom();
     }
     return Handled { success };
@@ -655,7 +687,7 @@ Handled Terminal::sendCharEvent(
     auto const success = _inputGenerator.generate(ch, physicalKey, modifiers, eventType);
     if (success)
     {
-        flushInput();
+        flushGeneratedInput();
         _viewport.scrollToBottom();
     }
     return Handled { success };
@@ -683,7 +715,7 @@ Handled Terminal::sendMousePressEvent(Modifiers modifiers,
 
     // TODO: Ctrl+(Left)Click's should still be catched by the terminal iff there's a hyperlink
     // under the current position
-    flushInput();
+    flushGeneratedInput();
     return Handled { eventHandledByApp && !isModeEnabled(DECMode::MousePassiveTracking) };
 }
 
@@ -887,7 +919,7 @@ void Terminal::sendMouseMoveEvent(Modifiers modifiers,
     {
         if (_inputGenerator.generateMouseMove(
                 modifiers, relativePos, pixelPosition, uiHandledHint || !selectionAvailable()))
-            flushInput();
+            flushGeneratedInput();
         if (!isModeEnabled(DECMode::MousePassiveTracking))
             return;
     }
@@ -945,7 +977,7 @@ Handled Terminal::sendMouseReleaseEvent(Modifiers modifiers,
         && _inputGenerator.generateMouseRelease(
             modifiers, button, _currentMousePosition, pixelPosition, uiHandledHint))
     {
-        flushInput();
+        flushGeneratedInput();
 
         if (!isModeEnabled(DECMode::MousePassiveTracking))
             return Handled { true };
@@ -961,7 +993,7 @@ bool Terminal::sendFocusInEvent()
 
     if (_inputGenerator.generateFocusInEvent())
     {
-        flushInput();
+        flushGeneratedInput();
         return true;
     }
 
@@ -975,7 +1007,7 @@ bool Terminal::sendFocusOutEvent()
 
     if (_inputGenerator.generateFocusOutEvent())
     {
-        flushInput();
+        flushGeneratedInput();
         return true;
     }
 
@@ -995,7 +1027,7 @@ void Terminal::sendPaste(string_view text)
     }
 
     _inputGenerator.generatePaste(text);
-    flushInput();
+    flushGeneratedInput();
 }
 
 void Terminal::sendRawInput(string_view text)
@@ -1013,24 +1045,47 @@ void Terminal::sendRawInput(string_view text)
 
     inputLog()("Sending raw input to stdin: {}", crispy::escape(text));
     _inputGenerator.generateRaw(text);
-    flushInput();
+    flushGeneratedInput();
 }
 
 bool Terminal::hasInput() const noexcept
 {
-    return !_inputGenerator.peek().empty();
+    return !_inputQueue.empty();
 }
 
-void Terminal::flushInput()
+std::string Terminal::peekInput() const
 {
-    if (_inputGenerator.peek().empty())
-        return;
+    return _inputQueue.peek();
+}
 
-    // XXX Should be the only location that does write to the PTY's stdin to avoid race conditions.
+void Terminal::flushGeneratedInput()
+{
+    // The input generator is only ever fed from the GUI thread, so moving its output
+    // into the (thread-safe) input queue needs no further synchronization.
     auto const input = _inputGenerator.peek();
-    auto const rv = _pty->write(input);
-    if (rv > 0)
-        _inputGenerator.consume(rv);
+    _inputQueue.push(input);
+    _inputGenerator.consume(static_cast<int>(input.size()));
+    flushInput();
+}
+
+bool Terminal::flushInput()
+{
+    // Writes at most one bounded chunk per call, leaving the rest for a later call,
+    // so that large pastes cannot starve the caller's event loop.
+    auto const rv = _inputQueue.flush(
+        [this](std::span<std::string_view const> buffers) { return _pty->writev(buffers); });
+    auto const error = errno;
+    if (rv > 0 || _inputQueue.empty())
+        return true;
+
+    if (rv == 0 || error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+        return false;
+
+    // Retrying would fail the same way, so do not keep the input around.
+    inputLog()(
+        "PTY write failed, dropping {} bytes of pending input. {}", _inputQueue.size(), strerror(error));
+    _inputQueue.clear();
+    return true;
 }
 
 void Terminal::writeToScreen(string_view vtStream)
@@ -1047,6 +1102,7 @@ void Terminal::writeToScreen(string_view vtStream)
             vtStream.remove_prefix(chunk.size());
             _parser.parseFragment(_currentPtyBuffer->writeAtEnd(chunk));
         }
+        markContentChanged();
     }
 
     if (!_modes.enabled(DECMode::BatchedRendering))
@@ -1138,6 +1194,7 @@ void Terminal::writeToScreenInternal(std::string_view vtStream)
         vtStream.remove_prefix(chunk.size());
         _parser.parseFragment(chunk);
     }
+    markContentChanged();
 }
 
 void Terminal::updateCursorVisibilityState() const noexcept
@@ -1239,6 +1296,7 @@ void Terminal::resizeScreen(PageSize totalPageSize, optional<ImageSize> pixels)
     _alternateScreen.margin() = _primaryScreen.margin();
 
     applyPageSizeToCurrentBuffer();
+    markContentChanged();
 
     _pty->resizeScreen(mainDisplayPageSize, pixels);
 
@@ -1312,44 +1370,113 @@ void Terminal::setExtendedWordDelimiters(string const& wordDelimiters)
 
 namespace
 {
+    // Selected text is extracted in chunks of about this size when done asynchronously.
+    constexpr size_t SelectionTextChunkSize = 1024 * 1024;
+
     template <CellConcept Cell>
-    struct SelectionRenderer
+    void appendCellsText(string& output, gsl::span<Cell const> cells)
     {
-        gsl::not_null<Terminal const*> term;
-        ColumnOffset rightPage {};
-        ColumnOffset lastColumn {};
-        string text {};
-        string currentLine {};
-
-        SelectionRenderer(Terminal const& term, ColumnOffset rightPage): term(&term), rightPage(rightPage) {}
-
-        void operator()(CellLocation pos, Cell const& cell)
+        for (Cell const& cell: cells)
         {
-            auto const isNewLine = pos.column < lastColumn || (pos.column == lastColumn && !text.empty());
-            if (isNewLine && (!term->isLineWrapped(pos.line)))
-            {
-                // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
-                trimSpaceRight(currentLine);
-                text += currentLine;
-                text += '\n';
-                currentLine.clear();
-            }
             if (cell.empty())
-                currentLine += ' ';
+                output += ' ';
             else
-                currentLine += cell.toUtf8();
-            lastColumn = pos.column;
+                output += cell.toUtf8();
+        }
+    }
+
+    // Appends the text of the given column range of the line.
+    //
+    // The text of trivial lines is copied in bulk, without visiting (or inflating) any cells.
+    template <CellConcept Cell>
+    void appendLineText(string& output, Line<Cell> const& line, ColumnOffset from, ColumnOffset to)
+    {
+        auto const end = std::min(to + 1, boxed_cast<ColumnOffset>(line.size()));
+        if (from >= end)
+            return;
+
+        if (!line.isTrivialBuffer())
+        {
+            appendCellsText(output, line.cells().subspan(unbox<size_t>(from), unbox<size_t>(end - from)));
+            return;
         }
 
-        std::string finish()
+        auto const& buffer = line.trivialBuffer();
+        auto const text = buffer.text.view();
+        if (text.size() != unbox<size_t>(buffer.usedColumns))
         {
-            trimSpaceRight(currentLine);
-            text += currentLine;
-            if (dynamic_cast<FullLineSelection const*>(term->selector()))
-                text += '\n';
-            return std::move(text);
+            // Not one byte per column, so leave decoding the text to the cells.
+            auto const cells = inflate<Cell>(buffer);
+            auto const span = gsl::span<Cell const>(cells);
+            appendCellsText(output, span.subspan(unbox<size_t>(from), unbox<size_t>(end - from)));
+            return;
         }
+
+        auto const used = std::min(end, boxed_cast<ColumnOffset>(buffer.usedColumns));
+        if (from < used)
+            output += text.substr(unbox<size_t>(from), unbox<size_t>(used - from));
+        output.append(unbox<size_t>(end - std::max(from, used)), ' ');
+    }
+
+    // Builds the selected text line by line, joining wrapped lines and trimming trailing spaces.
+    class SelectionTextBuilder
+    {
+      public:
+        explicit SelectionTextBuilder(bool fullLines): _fullLines { fullLines } {}
+
+        template <CellConcept Cell>
+        void append(Line<Cell> const& line, ColumnOffset from, ColumnOffset to)
+        {
+            beginLine(line.wrapped());
+            appendLineText(_currentLine, line, from, to);
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return _text.size(); }
+
+        // Takes the text of all lines that are complete so far.
+        [[nodiscard]] string takeCompleted() { return std::exchange(_text, string {}); }
+
+        [[nodiscard]] string finish()
+        {
+            trimSpaceRight(_currentLine);
+            _text += _currentLine;
+            if (_fullLines)
+                _text += '\n';
+            return std::move(_text);
+        }
+
+      private:
+        void beginLine(bool wrapped)
+        {
+            if (!_firstLine && !wrapped)
+            {
+                trimSpaceRight(_currentLine);
+                _text += _currentLine;
+                _text += '\n';
+                _currentLine.clear();
+            }
+            _firstLine = false;
+        }
+
+        bool _fullLines;
+        bool _firstLine = true;
+        string _text;
+        string _currentLine;
     };
+
+    bool isFullLineSelection(Selection const& selection) noexcept
+    {
+        return dynamic_cast<FullLineSelection const*>(&selection) != nullptr;
+    }
+
+    template <CellConcept Cell>
+    string extractSelectionTextFrom(Grid<Cell> const& grid, Selection const& selection)
+    {
+        auto builder = SelectionTextBuilder { isFullLineSelection(selection) };
+        for (Selection::Range const& range: selection.ranges())
+            builder.append(grid.lineAt(range.line), range.fromColumn, range.toColumn);
+        return builder.finish();
+    }
 } // namespace
 
 string Terminal::extractSelectionText() const
@@ -1358,20 +1485,56 @@ string Terminal::extractSelectionText() const
         return "";
 
     if (isPrimaryScreen())
-    {
-        auto se = SelectionRenderer<PrimaryScreenCell> { *this, pageSize().columns.as<ColumnOffset>() - 1 };
-        vtbackend::renderSelection(*_selection, [&](CellLocation pos) { se(pos, _primaryScreen.at(pos)); });
-        return se.finish();
-    }
+        return extractSelectionTextFrom(_primaryScreen.grid(), *_selection);
     else
-    {
-        auto se = SelectionRenderer<AlternateScreenCell> { *this, pageSize().columns.as<ColumnOffset>() - 1 };
-        vtbackend::renderSelection(*_selection, [&](CellLocation pos) { se(pos, _alternateScreen.at(pos)); });
-        return se.finish();
-    }
+        return extractSelectionTextFrom(_alternateScreen.grid(), *_selection);
+}
+
+std::shared_ptr<SelectionTextExtraction> Terminal::extractSelectionTextAsync(SelectionTextSink sink) const
+{
+    if (!_selection || _selection->state() == Selection::State::Waiting)
+        return nullptr;
+
+    auto ranges = _selection->ranges();
+    if (ranges.empty())
+        return nullptr;
+
+    // Only line handles are copied here. The text of the cells is extracted on the worker thread.
+    auto const spawn = [&]<CellConcept Cell>(Grid<Cell> const& grid) {
+        auto const snapshot = std::make_shared<GridSnapshot<Cell> const>(
+            grid.snapshot(ranges.front().line, ranges.back().line));
+        auto extraction = std::make_shared<SelectionTextExtraction>(ranges.size());
+        extraction->_snapshot = snapshot;
+
+        // The snapshot is only referenced by the extraction, so that it is never released on the worker.
+        auto worker = [extraction,
+                       lines = snapshot.get(),
+                       ranges = std::move(ranges),
+                       fullLines = isFullLineSelection(*_selection),
+                       sink = std::move(sink)]() {
+            auto builder = SelectionTextBuilder { fullLines };
+            for (size_t i = 0; i < ranges.size() && !extraction->cancelled(); ++i)
+            {
+                builder.append(lines->lineAt(ranges[i].line), ranges[i].fromColumn, ranges[i].toColumn);
+                extraction->advance(i + 1);
+                if (builder.size() >= SelectionTextChunkSize)
+                    sink(builder.takeCompleted(), false);
+            }
+            if (!extraction->cancelled())
+                sink(builder.finish(), true);
+            extraction->finish();
+        };
+        std::thread(std::move(worker)).detach();
+        return extraction;
+    };
+
+    if (isPrimaryScreen())
+        return spawn(_primaryScreen.grid());
+    else
+        return spawn(_alternateScreen.grid());
 }
 
-string Terminal::extractLastMarkRange() const
+string Terminal::extractLastMarkRange()
 {
     // -1 because we always want to start extracting one line above the cursor by default.
     auto const bottomLine =
@@ -1379,10 +1542,14 @@ string Terminal::extractLastMarkRange() const
 
     auto const marker1 = optional { bottomLine };
 
-    auto const marker0 = _primaryScreen.findMarkerUpwards(marker1.value());
+    auto marker0 = _primaryScreen.findMarkerUpwards(marker1.value());
     if (!marker0.has_value())
         return {};
 
+    // Reflowing the lines down from the mark moves the mark.
+    if (_primaryScreen.reflowHistoryUntil(*marker0))
+        marker0 = _primaryScreen.findMarkerUpwards(marker1.value());
+
     // +1 each for offset change from 0 to 1 and because we only want to start at the line *after* the mark.
     auto const firstLine = *marker0 + 1;
     auto const lastLine = *marker1;
@@ -1398,10 +1565,42 @@ string Terminal::extractLastMarkRange() const
     return text;
 }
 
+string Terminal::extractCommandOutput(size_t n)
+{
+    auto const range = _primaryScreen.recentCommandOutputRange(n);
+    if (!range)
+        return {};
+
+    auto builder = SelectionTextBuilder { true };
+    for (auto line = range->first.line; line <= range->second.line; ++line)
+        builder.append(_primaryScreen.grid().lineAt(line), ColumnOffset(0), range->second.column);
+    return builder.finish();
+}
+
+bool Terminal::selectCommandOutput(size_t n)
+{
+    if (!isPrimaryScreen())
+        return false;
+
+    auto const range = _primaryScreen.recentCommandOutputRange(n);
+    if (!range)
+        return false;
+
+    setSelector(
+        std::make_unique<FullLineSelection>(_selectionHelper, range->first, selectionUpdatedHelper()));
+    if (_selection->extend(range->second))
+        onSelectionUpdated();
+    _selection->complete();
+
+    _viewport.makeVisibleWithinSafeArea(range->first.line);
+    breakLoopAndRefreshRenderBuffer();
+    return true;
+}
+
 // {{{ screen events
-void Terminal::requestCaptureBuffer(LineCount lines, bool logical)
+void Terminal::requestCaptureBuffer(CaptureBufferMode mode, int count)
 {
-    _eventListener.requestCaptureBuffer(lines, logical);
+    _eventListener.requestCaptureBuffer(mode, count);
 }
 
 void Terminal::requestShowHostWritableStatusLine()
@@ -1492,9 +1691,8 @@ void Terminal::reply(string_view text)
 {
     // this is invoked from within the terminal thread.
     // most likely that's not the main thread, which will however write
-    // the actual input events.
-    // TODO: introduce new mutex to guard terminal writes.
-    _inputGenerator.generateRaw(text);
+    // the actual input events. Both are serialized by the input queue.
+    _inputQueue.push(text);
 
     auto const* syncReply = getenv("CONTOUR_SYNC_PTY_OUTPUT");
 
@@ -1810,6 +2008,7 @@ void Terminal::setLeftRightMargin(optional<ColumnOffset> left, optional<ColumnOf
 
 void Terminal::clearScreen()
 {
+    markContentChanged();
     if (isPrimaryScreen())
         _primaryScreen.clearScreen();
     else
@@ -1880,6 +2079,7 @@ void Terminal::setUnderlineColor(Color color)
 
 void Terminal::hardReset()
 {
+    markContentChanged();
     // TODO: make use of _factorySettings
     setScreen(ScreenType::Primary);
 
@@ -2205,6 +2405,9 @@ optional<CellLocation> Terminal::searchReverse(u32string text, CellLocation sear
 
 optional<CellLocation> Terminal::search(CellLocation searchPosition)
 {
+    if (isPrimaryScreen())
+        _primaryScreen.reflowHistory();
+
     auto const searchText = u32string_view(_search.pattern);
     auto const matchLocation = currentScreen().search(searchText, searchPosition);
 
@@ -2284,6 +2487,9 @@ std::tuple<std::u32string, CellLocationRange> Terminal::extractWordUnderCursor(
 
 optional<CellLocation> Terminal::searchReverse(CellLocation searchPosition)
 {
+    if (isPrimaryScreen())
+        _primaryScreen.reflowHistory();
+
     auto const searchText = u32string_view(_search.pattern);
     auto const matchLocation = currentScreen().searchReverse(searchText, searchPosition);
 
@@ -7,6 +7,7 @@
 #include <vtbackend/Hyperlink.h>
 #include <vtbackend/InputGenerator.h>
 #include <vtbackend/InputHandler.h>
+#include <vtbackend/InputQueue.h>
 #include <vtbackend/RenderBuffer.h>
 #include <vtbackend/Selector.h>
 #include <vtbackend/Sequence.h>
@@ -207,6 +208,61 @@ class TraceHandler: public SequenceHandler
     PendingSequenceQueue _pendingSequences = {};
 };
 
+/// Progress and cancellation of extracting the selected text on a worker thread.
+///
+/// @see Terminal::extractSelectionTextAsync()
+class SelectionTextExtraction
+{
+  public:
+    explicit SelectionTextExtraction(size_t totalLines) noexcept: _totalLines { totalLines } {}
+
+    [[nodiscard]] size_t totalLines() const noexcept { return _totalLines; }
+    [[nodiscard]] size_t linesDone() const noexcept { return _linesDone.load(std::memory_order_relaxed); }
+
+    /// @returns the fraction of lines extracted so far, between 0 and 1.
+    [[nodiscard]] float progress() const noexcept
+    {
+        return _totalLines ? static_cast<float>(linesDone()) / static_cast<float>(_totalLines) : 1.0f;
+    }
+
+    [[nodiscard]] bool finished() const noexcept { return _finished.load(std::memory_order_acquire); }
+    [[nodiscard]] bool cancelled() const noexcept { return _cancelled.load(std::memory_order_relaxed); }
+
+    /// Requests the extraction to stop. The sink is not invoked anymore after the chunk in flight.
+    void cancel() noexcept { _cancelled.store(true, std::memory_order_relaxed); }
+
+    /// Blocks until the extraction has either finished or given up after being cancelled.
+    void wait() const noexcept { _finished.wait(false, std::memory_order_acquire); }
+
+    /// Releases the lines snapshotted for the extraction.
+    ///
+    /// Must be called once the extraction has finished (see wait()) and while holding the terminal lock,
+    /// as the snapshotted lines may hold images, whose removal is reported to the terminal.
+    void releaseSnapshot() noexcept { _snapshot.reset(); }
+
+  private:
+    friend class Terminal;
+
+    void advance(size_t linesDone) noexcept { _linesDone.store(linesDone, std::memory_order_relaxed); }
+
+    void finish() noexcept
+    {
+        _finished.store(true, std::memory_order_release);
+        _finished.notify_all();
+    }
+
+    size_t _totalLines;
+    std::atomic<size_t> _linesDone = 0;
+    std::atomic<bool> _cancelled = false;
+    std::atomic<bool> _finished = false;
+    std::shared_ptr<void const> _snapshot; // GridSnapshot of the selected lines
+};
+
+/// Receives the text of an asynchronous selection extraction in consecutive chunks, on the worker thread.
+///
+/// The last chunk is passed with @p last set to true, unless the extraction got cancelled.
+using SelectionTextSink = std::function<void(std::string chunk, bool last)>;
+
 struct TabsInfo
 {
     size_t tabCount = 1;
@@ -228,7 +284,7 @@ class Terminal
       public:
         virtual ~Events() = default;
 
-        virtual void requestCaptureBuffer(LineCount /*lines*/, bool /*logical*/) {}
+        virtual void requestCaptureBuffer(CaptureBufferMode /*mode*/, int /*count*/) {}
         virtual void bell() {}
         virtual void bufferChanged(ScreenType) {}
         virtual void renderBufferUpdated() {}
@@ -258,7 +314,7 @@ class Terminal
     class NullEvents: public Events
     {
       public:
-        void requestCaptureBuffer(LineCount /*lines*/, bool /*logical*/) override {}
+        void requestCaptureBuffer(CaptureBufferMode /*mode*/, int /*count*/) override {}
         void bell() override {}
         void bufferChanged(ScreenType) override {}
         void renderBufferUpdated() override {}
@@ -447,9 +503,17 @@ class Terminal
     bool applicationKeypad() const noexcept { return _inputGenerator.applicationKeypad(); }
 
     bool hasInput() const noexcept;
-    void flushInput();
 
-    std::string_view peekInput() const noexcept { return _inputGenerator.peek(); }
+    /// Writes pending input and replies to the PTY, at most one bounded chunk at a time.
+    ///
+    /// Callers must call this again as long as hasInput() returns true. Pending input is dropped
+    /// if writing to the PTY fails for any other reason than the PTY not accepting input right now.
+    ///
+    /// @returns false if the PTY did not accept any input, in which case callers should wait
+    ///          for the PTY to become writable (see Pty::writeNotificationHandle()) before retrying.
+    bool flushInput();
+
+    [[nodiscard]] std::string peekInput() const;
     // }}}
 
     /// Writes a given VT-sequence to screen.
@@ -730,7 +794,26 @@ class Terminal
     // }}}
 
     [[nodiscard]] std::string extractSelectionText() const;
-    [[nodiscard]] std::string extractLastMarkRange() const;
+
+    /// Extracts the selected text on a worker thread, passing it on to @p sink in chunks.
+    ///
+    /// Only the selected lines are snapshotted on the calling thread (see Grid::snapshot()), so the
+    /// terminal may continue to change while their text is being extracted and passed on.
+    /// The snapshot is kept by the returned extraction until SelectionTextExtraction::releaseSnapshot().
+    ///
+    /// @returns the extraction's progress, or nullptr if nothing is selected.
+    [[nodiscard]] std::shared_ptr<SelectionTextExtraction> extractSelectionTextAsync(
+        SelectionTextSink sink) const;
+    [[nodiscard]] std::string extractLastMarkRange();
+
+    /// Extracts the output of the @p n-th most recently executed shell command (see OSC 133),
+    /// with 0 being the most recent one.
+    [[nodiscard]] std::string extractCommandOutput(size_t n);
+
+    /// Selects the output of the @p n-th most recently executed shell command and scrolls it into view.
+    ///
+    /// @retval false if the command's output is not available (anymore).
+    bool selectCommandOutput(size_t n);
 
     HyperlinkStorage& hyperlinks() noexcept { return _hyperlinks; }
     HyperlinkStorage const& hyperlinks() const noexcept { return _hyperlinks; }
@@ -757,11 +840,16 @@ class Terminal
 
     void markScreenDirty() noexcept { _screenDirty = true; }
 
+    /// @returns a number that changes whenever the contents or the layout of the screens might have changed,
+    ///          such that anything derived from the grid lines can tell whether it is still valid.
+    [[nodiscard]] uint64_t contentGeneration() const noexcept { return _contentGeneration; }
+    void markContentChanged() noexcept { ++_contentGeneration; }
+
     [[nodiscard]] uint64_t lastFrameID() const noexcept { return _lastFrameID.load(); }
 
     // Screen's EventListener implementation
     //
-    void requestCaptureBuffer(LineCount lines, bool logical);
+    void requestCaptureBuffer(CaptureBufferMode mode, int count);
     void requestShowHostWritableStatusLine();
     void bell();
     void bufferChanged(ScreenType);
@@ -975,6 +1063,7 @@ class Terminal
     void updateIndicatorStatusLine();
     void updateCursorVisibilityState() const noexcept;
     void updateHoveringHyperlinkState();
+    void flushGeneratedInput();
 
     struct TheSelectionHelper: public vtbackend::SelectionHelper
     {
@@ -1093,6 +1182,7 @@ class Terminal
     /// Boolean, indicating whether the terminal's screen buffer contains updates to be rendered.
     mutable std::atomic<uint64_t> _changes { 0 };
     bool _screenDirty = false; // TODO: just inc _changes and delete this instead.
+    uint64_t _contentGeneration = 0;
     RefreshInterval _refreshInterval;
     RenderDoubleBuffer _renderBuffer {};
     std::atomic<uint64_t> _lastFrameID = 0;
@@ -1202,6 +1292,7 @@ class Terminal
     uint64_t _instructionCounter = 0;
 
     InputGenerator _inputGenerator {};
+    InputQueue _inputQueue {};
 
     ViCommands _viCommands;
     ViInputHandler _inputHandler;
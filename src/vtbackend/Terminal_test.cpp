@@ -531,10 +531,60 @@ TEST_CASE("Terminal.TextSelection_wrapped_line", "[terminal]")
     mock.terminal.sendMouseReleaseEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
     CHECK(mock.terminal.extractSelectionText() == "aaaaaa");
 
+    // The same text is extracted asynchronously.
+    auto asyncText = std::string {};
+    auto lastChunkSeen = false;
+    auto const extraction = mock.terminal.extractSelectionTextAsync([&](std::string chunk, bool last) {
+        asyncText += chunk;
+        lastChunkSeen = last;
+    });
+    REQUIRE(extraction != nullptr);
+    extraction->wait();
+    CHECK(asyncText == "aaaaaa");
+    CHECK(lastChunkSeen);
+    CHECK(extraction->linesDone() == extraction->totalLines());
+    extraction->releaseSnapshot();
+
     mock.terminal.tick(1s);
     mock.terminal.sendMousePressEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
     mock.terminal.sendMouseReleaseEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
     CHECK(mock.terminal.extractSelectionText().empty());
+    CHECK(mock.terminal.extractSelectionTextAsync([](std::string, bool) {}) == nullptr);
+}
+
+TEST_CASE("Terminal.TextSelection_async_while_writing", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    mock.terminal.tick(chrono::steady_clock::time_point());
+    mock.writeToScreen(std::string(10, 'a'));
+
+    using namespace vtbackend;
+    auto constexpr UiHandledHint = false;
+    auto constexpr PixelCoordinate = vtbackend::PixelCoordinate {};
+
+    mock.terminal.tick(1s);
+    mock.terminal.sendMouseMoveEvent(
+        Modifier::None, 0_lineOffset + 1_columnOffset, PixelCoordinate, UiHandledHint);
+    mock.terminal.tick(1s);
+    mock.terminal.sendMousePressEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
+    mock.terminal.tick(1s);
+    mock.terminal.sendMouseMoveEvent(
+        Modifier::None, 1_lineOffset + 1_columnOffset, PixelCoordinate, UiHandledHint);
+    mock.terminal.tick(1s);
+    mock.terminal.sendMouseReleaseEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
+    REQUIRE(mock.terminal.extractSelectionText() == "aaaaaa");
+
+    // The selected lines are overwritten while the worker extracts the text of their snapshot.
+    auto asyncText = std::string {};
+    auto const extraction =
+        mock.terminal.extractSelectionTextAsync([&](std::string chunk, bool) { asyncText += chunk; });
+    REQUIRE(extraction != nullptr);
+    mock.writeToScreen("\033[H" + std::string(10, 'b'));
+    extraction->wait();
+
+    CHECK(asyncText == "aaaaaa");
+    CHECK(mock.terminal.extractSelectionText() == "bbbbbb");
+    extraction->releaseSnapshot();
 }
 
 // NOLINTEND(misc-const-correctness)
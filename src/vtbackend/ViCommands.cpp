@@ -5,9 +5,9 @@
 #include <vtbackend/logging.h>
 #include <vtbackend/primitives.h>
 
-#include <libunicode/ucd.h>
-
+#include <algorithm>
 #include <format>
+#include <iterator>
 #include <memory>
 
 namespace vtbackend
@@ -15,42 +15,6 @@ namespace vtbackend
 
 namespace
 {
-    constexpr bool isWord(char32_t codepoint) noexcept
-    {
-        // A word consists of a sequence of letters, digits and underscores, or a
-        // sequence of other non-blank characters, separated with white space (spaces,
-        // tabs, <EOL>).  This can be changed with the 'iskeyword' option.  An empty line
-        // is also considered to be a word.
-        return ('a' <= codepoint && codepoint <= 'z') || ('A' <= codepoint && codepoint <= 'Z')
-               || ('0' <= codepoint && codepoint <= '9') || codepoint == '_';
-    }
-
-    constexpr bool isKeyword(char32_t codepoint) noexcept
-    {
-        // vim default: (default: @,48-57,_,192-255)
-        //
-        // For '@' characters above 255 check the "word" character class
-        // (any character that is not white space or punctuation).
-        //
-        // TODO: The punctuation test is highly inefficient. Adapt libunicode to allow O(1) access to these.
-        return (codepoint > 255
-                && !(unicode::general_category::space_separator(codepoint)
-                     || unicode::general_category::initial_punctuation(codepoint)
-                     || unicode::general_category::final_punctuation(codepoint)
-                     || unicode::general_category::open_punctuation(codepoint)
-                     || unicode::general_category::close_punctuation(codepoint)
-                     || unicode::general_category::dash_punctuation(codepoint)))
-               || (192 <= codepoint && codepoint <= 255);
-    }
-
-    enum class WordSkipClass : uint8_t
-    {
-        Word,
-        Keyword,
-        Whitespace,
-        Other
-    };
-
     [[maybe_unused]] std::string_view str(WordSkipClass value)
     {
         switch (value)
@@ -63,29 +27,6 @@ namespace
         return "Wow";
     }
 
-    constexpr WordSkipClass wordSkipClass(char32_t codepoint) noexcept
-    {
-        if (isWord(codepoint))
-            return WordSkipClass::Word;
-        else if (isKeyword(codepoint))
-            return WordSkipClass::Keyword;
-        else if (codepoint == ' ' || codepoint == '\t' || codepoint == 0)
-            return WordSkipClass::Whitespace;
-        else
-            return WordSkipClass::Other;
-    }
-
-    WordSkipClass wordSkipClass(std::string text) noexcept
-    {
-        auto const s32 = unicode::convert_to<char32_t>(std::string_view(text.data(), text.size()));
-        switch (s32.size())
-        {
-            case 0: return WordSkipClass::Whitespace;
-            case 1: return wordSkipClass(s32[0]);
-            default: return WordSkipClass::Other;
-        }
-    }
-
     // constexpr bool shouldSkipForUntilWordBeginReverse(WordSkipClass current, WordSkipClass& initial)
     // noexcept
     // {
@@ -114,6 +55,17 @@ namespace
             return terminal.alternateScreen().grid().rightMostNonEmptyAt(lineOffset);
     }
 
+    // Brings the motion index up to date with the given grid.
+    template <CellConcept Cell>
+    ViMotionIndex& synchronizedIndex(ViMotionIndex& index, uint64_t contentGeneration, Grid<Cell> const& grid)
+    {
+        auto const historyTop = -boxed_cast<LineOffset>(grid.historyLineCount());
+        index.synchronize(contentGeneration,
+                          grid.lineNumberOf(historyTop),
+                          unbox<size_t>(grid.historyLineCount() + grid.pageSize().lines));
+        return index;
+    }
+
     constexpr std::optional<std::pair<char, bool>> matchingPairOfChar(char32_t input) noexcept
     {
         auto constexpr Pairs = std::array {
@@ -255,6 +207,10 @@ void ViCommands::modeChanged(ViMode mode)
 
             if (_lastMode == ViMode::Insert)
                 cursorPosition = _terminal->currentScreen().cursor().position;
+
+            // Motions may move the cursor anywhere into the history.
+            _terminal->primaryScreen().reflowHistory();
+
             if (_terminal->selectionAvailable())
                 _terminal->clearSelection();
             _terminal->pushStatusDisplay(StatusDisplayType::Indicator);
@@ -521,85 +477,104 @@ CellLocation ViCommands::next(CellLocation location) const noexcept
     return location;
 }
 
-CellLocation ViCommands::findMatchingPairFrom(CellLocation location) const noexcept
+CellLocation ViCommands::findMatchingPairFrom(CellLocation location) const
 {
-    auto const& cell = _terminal->primaryScreen().at(cursorPosition);
-    if (cell.codepointCount() != 1)
+    // Like in vim, the first bracket under or right of the cursor on its line is matched.
+    auto const& line = classifiedLine(location.line);
+    auto column = unbox<size_t>(location.column);
+    while (column < line.characters.size() && !matchingPairOfChar(line.characters[column]))
+        ++column;
+    if (column == line.characters.size())
         return location;
 
-    auto const a = cell.codepoint(0);
-    auto const matchResult = matchingPairOfChar(a);
-    if (!matchResult)
-        return location;
-    auto const [b, left] = *matchResult;
+    auto const a = static_cast<char32_t>(line.characters[column]);
+    auto const [b, left] = *matchingPairOfChar(a);
+    auto const start = CellLocation { .line = location.line, .column = ColumnOffset::cast_from(column) };
 
     if (left)
-        return findMatchingPairRight(a, b, 0);
+        return findMatchingPairRight(a, b, start, 0);
     else
-        return findMatchingPairLeft(b, a, 0);
+        return findMatchingPairLeft(b, a, start, 0);
 }
 
-CellLocation ViCommands::findMatchingPairLeft(char32_t left, char32_t right, int initialDepth) const noexcept
+CellLocation ViCommands::findMatchingPairLeft(char32_t left,
+                                              char32_t right,
+                                              CellLocation start,
+                                              int initialDepth) const
 {
-    auto a = cursorPosition;
+    auto const topLineOffset = _terminal->isPrimaryScreen()
+                                   ? -boxed_cast<LineOffset>(_terminal->primaryScreen().historyLineCount())
+                                   : LineOffset(0);
+    auto const pairSummary = LineSummary { lineSummaryFlagOf(left), lineSummaryFlagOf(right) };
     auto depth = initialDepth;
 
-    while (true)
+    for (auto lineOffset = start.line; lineOffset >= topLineOffset; --lineOffset)
     {
-        if (compareCellTextAt(a, right))
+        // Lines containing neither character of the pair are skipped as a whole.
+        if (lineOffset != start.line && !(lineSummary(lineOffset) & pairSummary))
+            continue;
+
+        auto const& line = classifiedLine(lineOffset);
+        auto column = lineOffset == start.line
+                          ? std::min(unbox<size_t>(start.column) + 1, line.characters.size())
+                          : line.characters.size();
+        while (column > 0)
         {
-            ++depth;
-            if (depth == 0)
-                break;
-        }
-        else if (compareCellTextAt(a, left))
-        {
-            --depth;
+            --column;
+            auto const ch = static_cast<char32_t>(line.characters[column]);
+            if (ch == right)
+                ++depth;
+            else if (ch == left)
+                --depth;
+            else
+                continue;
             if (depth == 0)
-                break;
+                return { .line = lineOffset, .column = ColumnOffset::cast_from(column) };
         }
-
-        if (auto const prevA = prev(a); prevA != a)
-            a = prevA;
-        else
-            break;
     }
-    return a;
+
+    return { .line = topLineOffset, .column = ColumnOffset(0) };
 }
 
-CellLocation ViCommands::findMatchingPairRight(char32_t left, char32_t right, int initialDepth) const noexcept
+CellLocation ViCommands::findMatchingPairRight(char32_t left,
+                                               char32_t right,
+                                               CellLocation start,
+                                               int initialDepth) const
 {
+    auto const pageBottom = _terminal->pageSize().lines.as<LineOffset>() - 1;
+    auto const pairSummary = LineSummary { lineSummaryFlagOf(left), lineSummaryFlagOf(right) };
     auto depth = initialDepth;
-    auto b = cursorPosition;
 
-    while (true)
+    for (auto lineOffset = start.line; lineOffset <= pageBottom; ++lineOffset)
     {
-        if (compareCellTextAt(b, left))
-        {
-            ++depth;
-            if (depth == 0)
-                break;
-        }
-        else if (compareCellTextAt(b, right))
+        // Lines containing neither character of the pair are skipped as a whole.
+        if (lineOffset != start.line && !(lineSummary(lineOffset) & pairSummary))
+            continue;
+
+        auto const& line = classifiedLine(lineOffset);
+        for (auto column = lineOffset == start.line ? unbox<size_t>(start.column) : 0;
+             column < line.characters.size();
+             ++column)
         {
-            --depth;
+            auto const ch = static_cast<char32_t>(line.characters[column]);
+            if (ch == left)
+                ++depth;
+            else if (ch == right)
+                --depth;
+            else
+                continue;
             if (depth == 0)
-                break;
+                return { .line = lineOffset, .column = ColumnOffset::cast_from(column) };
         }
-
-        if (auto const nextB = next(b); nextB != b)
-            b = nextB;
-        else
-            break;
     }
 
-    return b;
+    return { .line = pageBottom, .column = _terminal->pageSize().columns.as<ColumnOffset>() - 1 };
 }
 
-CellLocationRange ViCommands::expandMatchingPair(TextObjectScope scope, char left, char right) const noexcept
+CellLocationRange ViCommands::expandMatchingPair(TextObjectScope scope, char left, char right) const
 {
-    auto a = findMatchingPairLeft(left, right, left != right ? 1 : -1);
-    auto b = findMatchingPairRight(left, right, left != right ? 1 : -1);
+    auto a = findMatchingPairLeft(left, right, cursorPosition, left != right ? 1 : -1);
+    auto b = findMatchingPairRight(left, right, cursorPosition, left != right ? 1 : -1);
 
     if (scope == TextObjectScope::Inner)
     {
@@ -626,27 +601,27 @@ CellLocationRange ViCommands::translateToCellRange(TextObjectScope scope,
         case TextObject::BackQuotes: return expandMatchingPair(scope, '`', '`');
         case TextObject::CurlyBrackets: return expandMatchingPair(scope, '{', '}');
         case TextObject::DoubleQuotes: return expandMatchingPair(scope, '"', '"');
-        case TextObject::LineMark:
-            // Walk the line upwards until we find a marked line.
-            while (a.line > gridTop
-                   && !(_terminal->currentScreen().lineFlagsAt(a.line).contains(LineFlag::Marked)))
-                --a.line;
+        case TextObject::LineMark: {
+            auto const& screen = _terminal->currentScreen();
+            // Find the nearest marked line upwards.
+            if (!screen.isLineFlagEnabledAt(a.line, LineFlag::Marked))
+                a.line = screen.findMarkerUpwards(a.line).value_or(gridTop);
             if (scope == TextObjectScope::Inner && a != cursorPosition)
                 ++a.line;
-            // Walk the line downwards until we find a marked line.
-            while (b.line < gridBottom
-                   && !(_terminal->currentScreen().lineFlagsAt(b.line).contains(LineFlag::Marked)))
-                ++b.line;
+            // Find the nearest marked line downwards.
+            if (!screen.isLineFlagEnabledAt(b.line, LineFlag::Marked))
+                b.line = screen.findMarkerDownwards(b.line).value_or(gridBottom);
             if (scope == TextObjectScope::Inner && b != cursorPosition)
                 --b.line;
             // Span the range from left most column to right most column.
             a.column = ColumnOffset(0);
             b.column = rightMargin;
             break;
+        }
         case TextObject::Paragraph:
-            while (a.line > gridTop && !_terminal->currentScreen().isLineEmpty(a.line - 1))
+            while (a.line > gridTop && !isLineBlank(a.line - 1))
                 --a.line;
-            while (b.line < gridBottom && !_terminal->currentScreen().isLineEmpty(b.line))
+            while (b.line < gridBottom && !isLineBlank(b.line))
                 ++b.line;
             break;
         case TextObject::RoundBrackets: return expandMatchingPair(scope, '(', ')');
@@ -658,9 +633,9 @@ CellLocationRange ViCommands::translateToCellRange(TextObjectScope scope,
             break;
         }
         case TextObject::BigWord: {
-            while (a.column.value > 0 && !_terminal->currentScreen().isCellEmpty(prev(a)))
+            while (a.column.value > 0 && !isBlankAt(prev(a)))
                 a = prev(a);
-            while (b.column < rightMargin && !_terminal->currentScreen().isCellEmpty(next(b)))
+            while (b.column < rightMargin && !isBlankAt(next(b)))
                 b = next(b);
             break;
         }
@@ -690,15 +665,14 @@ CellLocation ViCommands::findBeginOfWordAt(CellLocation location, JumpOver jumpO
 
     auto current = location;
     auto leftLocation = prev(current);
-    auto leftClass = wordSkipClass(_terminal->currentScreen().cellTextAt(leftLocation));
-    auto continuationClass =
-        jumpOver == JumpOver::Yes ? leftClass : wordSkipClass(_terminal->currentScreen().cellTextAt(current));
+    auto leftClass = wordSkipClassAt(leftLocation);
+    auto continuationClass = jumpOver == JumpOver::Yes ? leftClass : wordSkipClassAt(current);
 
     while (current != firstAddressableLocation && leftClass == continuationClass)
     {
         current = leftLocation;
         leftLocation = prev(current);
-        leftClass = wordSkipClass(_terminal->currentScreen().cellTextAt(leftLocation));
+        leftClass = wordSkipClassAt(leftLocation);
         if (continuationClass == WordSkipClass::Whitespace && leftClass != WordSkipClass::Whitespace)
             continuationClass = leftClass;
     }
@@ -738,6 +712,54 @@ CellLocation ViCommands::snapToCellRight(CellLocation location) const noexcept
     return location;
 }
 
+ClassifiedLine const& ViCommands::classifiedLine(LineOffset line) const
+{
+    auto const contentGeneration = _terminal->contentGeneration();
+    if (_terminal->isPrimaryScreen())
+    {
+        auto const& grid = _terminal->primaryScreen().grid();
+        return synchronizedIndex(_motionIndex, contentGeneration, grid)
+            .classified(grid.lineNumberOf(line), grid.lineAt(line));
+    }
+    auto const& grid = _terminal->alternateScreen().grid();
+    return synchronizedIndex(_motionIndex, contentGeneration, grid)
+        .classified(grid.lineNumberOf(line), grid.lineAt(line));
+}
+
+LineSummary ViCommands::lineSummary(LineOffset line) const
+{
+    auto const contentGeneration = _terminal->contentGeneration();
+    if (_terminal->isPrimaryScreen())
+    {
+        auto const& grid = _terminal->primaryScreen().grid();
+        return synchronizedIndex(_motionIndex, contentGeneration, grid)
+            .summary(grid.lineNumberOf(line), grid.lineAt(line));
+    }
+    auto const& grid = _terminal->alternateScreen().grid();
+    return synchronizedIndex(_motionIndex, contentGeneration, grid)
+        .summary(grid.lineNumberOf(line), grid.lineAt(line));
+}
+
+WordSkipClass ViCommands::wordSkipClassAt(CellLocation location) const
+{
+    auto const& line = classifiedLine(location.line);
+    auto const column = unbox<size_t>(location.column);
+    return column < line.classes.size() ? line.classes[column] : WordSkipClass::Whitespace;
+}
+
+bool ViCommands::isLineOf(LineOffset line, char ch) const
+{
+    // Lines without the character are told apart by their summary, without inspecting their cells.
+    if (!lineSummary(line).test(lineSummaryFlagOf(static_cast<char32_t>(ch))))
+        return false;
+
+    auto const& classified = classifiedLine(line);
+    return !classified.characters.empty() && classified.characters.front() == ch
+           && std::all_of(std::next(classified.classes.begin()), classified.classes.end(), [](auto value) {
+                  return value == WordSkipClass::Whitespace;
+              });
+}
+
 bool ViCommands::compareCellTextAt(CellLocation position, char32_t codepoint) const noexcept
 {
     return _terminal->currentScreen().compareCellTextAt(position, codepoint);
@@ -751,13 +773,8 @@ CellLocation ViCommands::globalCharUp(CellLocation location, char ch, unsigned c
     {
         if (location.column == ColumnOffset(0) && result.line > pageTop)
             --result.line;
-        while (result.line > pageTop)
-        {
-            auto const& line = _terminal->currentScreen().lineTextAt(result.line, false, true);
-            if (line.size() == 1 && line[0] == ch)
-                break;
+        while (result.line > pageTop && !isLineOf(result.line, ch))
             --result.line;
-        }
         --count;
     }
     return result;
@@ -771,13 +788,8 @@ CellLocation ViCommands::globalCharDown(CellLocation location, char ch, unsigned
     {
         if (location.column == ColumnOffset(0) && result.line < pageBottom)
             ++result.line;
-        while (result.line < pageBottom)
-        {
-            auto const& line = _terminal->currentScreen().lineTextAt(result.line, false, true);
-            if (line.size() == 1 && line[0] == ch)
-                break;
+        while (result.line < pageBottom && !isLineOf(result.line, ch))
             ++result.line;
-        }
         --count;
     }
     return result;
@@ -838,8 +850,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
         case ViMotion::LineTextBegin: // ^
         {
             auto result = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
-            while (result.column < _terminal->pageSize().columns.as<ColumnOffset>() - 1
-                   && _terminal->currentScreen().isCellEmpty(result))
+            while (result.column < _terminal->pageSize().columns.as<ColumnOffset>() - 1 && isBlankAt(result))
                 ++result.column;
             return result;
         }
@@ -874,9 +885,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             if (prev.line.value > 0)
                 prev.line--;
             auto current = prev;
-            while (current.line > pageTop
-                   && (!_terminal->currentScreen().isLineEmpty(current.line)
-                       || _terminal->currentScreen().isLineEmpty(prev.line)))
+            while (current.line > pageTop && (!isLineBlank(current.line) || isLineBlank(prev.line)))
             {
                 prev.line = current.line;
                 current.line--;
@@ -895,33 +904,20 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
         {
             auto const gridTop = -_terminal->currentScreen().historyLineCount().as<LineOffset>();
             auto result = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
-            while (count > 0)
-            {
-                if (result.line > gridTop
-                    && _terminal->currentScreen().isLineFlagEnabledAt(result.line, LineFlag::Marked))
-                    --result.line;
-                while (result.line > gridTop
-                       && !_terminal->currentScreen().isLineFlagEnabledAt(result.line, LineFlag::Marked))
-                    --result.line;
-                --count;
-            }
+            for (; count > 0; --count)
+                result.line = _terminal->currentScreen().findMarkerUpwards(result.line).value_or(gridTop);
             return addJumpHistory(result);
         }
         case ViMotion::LineMarkDown: // ]m
         {
             auto const pageBottom = _terminal->pageSize().lines.as<LineOffset>() - 1;
             auto result = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
-            while (count > 0)
+            for (; count > 0; --count)
             {
-                if (cursorPosition.column == ColumnOffset(0) && result.line < pageBottom)
-                    ++result.line;
-                while (result.line < pageBottom)
-                {
-                    if (_terminal->currentScreen().lineFlagsAt(result.line).contains(LineFlag::Marked))
-                        break;
-                    ++result.line;
-                }
-                --count;
+                // Unless at the line start, the current line is a candidate itself.
+                auto const startLine =
+                    cursorPosition.column == ColumnOffset(0) ? result.line : result.line - 1;
+                result.line = _terminal->currentScreen().findMarkerDownwards(startLine).value_or(pageBottom);
             }
             return addJumpHistory(result);
         }
@@ -932,17 +928,15 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             if (prev.line < pageBottom)
                 prev.line++;
             auto current = prev;
-            while (current.line < pageBottom
-                   && (!_terminal->currentScreen().isLineEmpty(current.line)
-                       || _terminal->currentScreen().isLineEmpty(prev.line)))
+            while (current.line < pageBottom && (!isLineBlank(current.line) || isLineBlank(prev.line)))
             {
                 prev.line = current.line;
                 current.line++;
             }
             return addJumpHistory(snapToCell(current));
         }
-        case ViMotion::ParenthesisMatching: // % TODO
-            return findMatchingPairFrom(cursorPosition);
+        case ViMotion::ParenthesisMatching: // %
+            return addJumpHistory(findMatchingPairFrom(cursorPosition));
         case ViMotion::SearchResultBackward: // N TODO
         {
             auto startPosition = cursorPosition;
@@ -992,9 +986,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             if (prev.column + 1 < rightMargin)
                 prev.column++;
             auto current = prev;
-            while (current.column + 1 < rightMargin
-                   && (_terminal->currentScreen().isCellEmpty(current)
-                       || !_terminal->currentScreen().isCellEmpty(prev)))
+            while (current.column + 1 < rightMargin && (isBlankAt(current) || !isBlankAt(prev)))
             {
                 prev = current;
                 current.column++;
@@ -1009,9 +1001,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             if (prev.column + 1 < rightMargin)
                 prev.column++;
             auto current = prev;
-            while (current.column + 1 < rightMargin
-                   && (!_terminal->currentScreen().isCellEmpty(current)
-                       || _terminal->currentScreen().isCellEmpty(prev)))
+            while (current.column + 1 < rightMargin && (!isBlankAt(current) || isBlankAt(prev)))
             {
                 prev.column = current.column;
                 current.column++;
@@ -1025,9 +1015,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
                 prev.column--;
             auto current = prev;
 
-            while (current.column.value > 0
-                   && (!_terminal->currentScreen().isCellEmpty(current)
-                       || _terminal->currentScreen().isCellEmpty(prev)))
+            while (current.column.value > 0 && (!isBlankAt(current) || isBlankAt(prev)))
             {
                 prev.column = current.column;
                 current.column--;
@@ -1045,11 +1033,10 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             auto result = cursorPosition;
             while (count > 0)
             {
-                auto initialClass = wordSkipClass(_terminal->currentScreen().cellTextAt(result));
+                auto initialClass = wordSkipClassAt(result);
                 result = next(result);
                 while (result != lastAddressableLocation
-                       && shouldSkipForUntilWordBegin(
-                           wordSkipClass(_terminal->currentScreen().cellTextAt(result)), initialClass))
+                       && shouldSkipForUntilWordBegin(wordSkipClassAt(result), initialClass))
                     result = next(result);
                 --count;
             }
@@ -3,6 +3,7 @@
 
 #include <vtbackend/JumpHistory.h>
 #include <vtbackend/ViInputHandler.h>
+#include <vtbackend/ViMotionIndex.h>
 #include <vtbackend/primitives.h>
 
 #include <gsl/pointers>
@@ -57,16 +58,16 @@ class ViCommands: public ViInputHandler::Executor
                                                          TextObject textObject) const noexcept;
     [[nodiscard]] CellLocation prev(CellLocation location) const noexcept;
     [[nodiscard]] CellLocation next(CellLocation location) const noexcept;
-    [[nodiscard]] CellLocation findMatchingPairFrom(CellLocation location) const noexcept;
+    [[nodiscard]] CellLocation findMatchingPairFrom(CellLocation location) const;
     [[nodiscard]] CellLocation findMatchingPairLeft(char32_t left,
                                                     char32_t right,
-                                                    int initialDepth) const noexcept;
+                                                    CellLocation start,
+                                                    int initialDepth) const;
     [[nodiscard]] CellLocation findMatchingPairRight(char32_t left,
                                                      char32_t right,
-                                                     int initialDepth) const noexcept;
-    [[nodiscard]] CellLocationRange expandMatchingPair(TextObjectScope scope,
-                                                       char left,
-                                                       char right) const noexcept;
+                                                     CellLocation start,
+                                                     int initialDepth) const;
+    [[nodiscard]] CellLocationRange expandMatchingPair(TextObjectScope scope, char left, char right) const;
     [[nodiscard]] CellLocation findBeginOfWordAt(CellLocation location, JumpOver jumpOver) const noexcept;
     [[nodiscard]] CellLocation findEndOfWordAt(CellLocation location, JumpOver jumpOver) const noexcept;
     [[nodiscard]] CellLocation globalCharUp(CellLocation location, char ch, unsigned count) const noexcept;
@@ -91,6 +92,23 @@ class ViCommands: public ViInputHandler::Executor
     [[nodiscard]] CellLocation snapToCellRight(CellLocation location) const noexcept;
 
     [[nodiscard]] bool compareCellTextAt(CellLocation position, char32_t codepoint) const noexcept;
+
+    /// @returns the cells of the given line, classified for word motions.
+    [[nodiscard]] ClassifiedLine const& classifiedLine(LineOffset line) const;
+    [[nodiscard]] LineSummary lineSummary(LineOffset line) const;
+    [[nodiscard]] WordSkipClass wordSkipClassAt(CellLocation location) const;
+    [[nodiscard]] bool isBlankAt(CellLocation location) const
+    {
+        return wordSkipClassAt(location) == WordSkipClass::Whitespace;
+    }
+    [[nodiscard]] bool isLineBlank(LineOffset line) const
+    {
+        return lineSummary(line).test(LineSummaryFlag::Blank);
+    }
+
+    /// Tests whether the given line consists of nothing but the given character in its first column.
+    [[nodiscard]] bool isLineOf(LineOffset line, char ch) const;
+
     void addLineOffsetToJumpHistory(LineOffset offset) { _jumpHistory.addOffset(offset); }
     // Cursor offset into the grid.
     CellLocation cursorPosition {};
@@ -103,6 +121,7 @@ class ViCommands: public ViInputHandler::Executor
     std::optional<ViMotion> _lastCharMotion = std::nullopt;
     bool _lastCursorVisible = true;
     JumpHistory _jumpHistory;
+    mutable ViMotionIndex _motionIndex;
 };
 
 } // namespace vtbackend
@@ -25,7 +25,7 @@
 // - [ ] $
 // - [ ] G
 // - [ ] gg
-// - [ ] %
+// - [x] %
 // - [ ] i{TextObject}
 // - [ ] a{TextObject}
 
@@ -195,6 +195,24 @@ TEST_CASE("vi.motion: b", "[vi]")
     REQUIRE(mock.terminal.normalModeCursorPosition() == 0_lineOffset + 0_columnOffset);
 }
 
+TEST_CASE("vi.motion: %", "[vi]")
+{
+    auto mock =
+        setupMockTerminal("auto pi_times(unsigned factor) {\r\n"
+                          "    return (3.14 * factor);\r\n"
+                          "}",
+                          vtbackend::PageSize { vtbackend::LineCount(10), vtbackend::ColumnCount(40) });
+    mock.sendCharSequence("%"); // jump from the first bracket right of the cursor to its match.
+    REQUIRE(mock.terminal.normalModeCursorPosition() == 0_lineOffset + 29_columnOffset);
+    mock.sendCharSequence("%"); // and back.
+    REQUIRE(mock.terminal.normalModeCursorPosition() == 0_lineOffset + 13_columnOffset);
+
+    mock.sendCharSequence("$%"); // jump across lines, skipping the nested brackets.
+    REQUIRE(mock.terminal.normalModeCursorPosition() == 2_lineOffset + 0_columnOffset);
+    mock.sendCharSequence("%");
+    REQUIRE(mock.terminal.normalModeCursorPosition() == 0_lineOffset + 31_columnOffset);
+}
+
 TEST_CASE("ViCommands:modeChanged", "[vi]")
 {
     auto mock = setupMockTerminal(
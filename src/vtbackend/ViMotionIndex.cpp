@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/ViMotionIndex.h>
+
+#include <libunicode/ucd.h>
+
+#include <algorithm>
+
+namespace vtbackend
+{
+
+namespace
+{
+    constexpr bool isWord(char32_t codepoint) noexcept
+    {
+        // A word consists of a sequence of letters, digits and underscores, or a
+        // sequence of other non-blank characters, separated with white space (spaces,
+        // tabs, <EOL>).  This can be changed with the 'iskeyword' option.  An empty line
+        // is also considered to be a word.
+        return ('a' <= codepoint && codepoint <= 'z') || ('A' <= codepoint && codepoint <= 'Z')
+               || ('0' <= codepoint && codepoint <= '9') || codepoint == '_';
+    }
+
+    constexpr bool isKeyword(char32_t codepoint) noexcept
+    {
+        // vim default: (default: @,48-57,_,192-255)
+        //
+        // For '@' characters above 255 check the "word" character class
+        // (any character that is not white space or punctuation).
+        //
+        // TODO: The punctuation test is highly inefficient. Adapt libunicode to allow O(1) access to these.
+        return (codepoint > 255
+                && !(unicode::general_category::space_separator(codepoint)
+                     || unicode::general_category::initial_punctuation(codepoint)
+                     || unicode::general_category::final_punctuation(codepoint)
+                     || unicode::general_category::open_punctuation(codepoint)
+                     || unicode::general_category::close_punctuation(codepoint)
+                     || unicode::general_category::dash_punctuation(codepoint)))
+               || (192 <= codepoint && codepoint <= 255);
+    }
+
+    constexpr WordSkipClass wordSkipClass(char32_t codepoint) noexcept
+    {
+        if (isWord(codepoint))
+            return WordSkipClass::Word;
+        else if (isKeyword(codepoint))
+            return WordSkipClass::Keyword;
+        else if (codepoint == ' ' || codepoint == '\t' || codepoint == 0)
+            return WordSkipClass::Whitespace;
+        else
+            return WordSkipClass::Other;
+    }
+
+    constexpr bool isAscii(char ch) noexcept
+    {
+        return static_cast<unsigned char>(ch) < 0x80;
+    }
+} // namespace
+
+template <CellConcept Cell>
+void classifyLine(Line<Cell> const& line, ClassifiedLine& output)
+{
+    auto const columnCount = unbox<size_t>(line.size());
+    output.classes.assign(columnCount, WordSkipClass::Whitespace);
+    output.characters.assign(columnCount, '\0');
+
+    // US-ASCII text of a trivial line occupies one column per character, so it is classified
+    // without inflating the line.
+    if (line.isTrivialBuffer())
+    {
+        auto const text = line.trivialBuffer().text.view();
+        if (std::ranges::all_of(text, isAscii))
+        {
+            auto const usedColumnCount = std::min(text.size(), columnCount);
+            for (size_t column = 0; column < usedColumnCount; ++column)
+            {
+                output.classes[column] = wordSkipClass(static_cast<char32_t>(text[column]));
+                output.characters[column] = text[column];
+            }
+            return;
+        }
+    }
+
+    auto const cells = line.cells();
+    for (size_t column = 0; column < cells.size() && column < columnCount; ++column)
+    {
+        auto const& cell = cells[column];
+        switch (cell.codepointCount())
+        {
+            case 0: break;
+            case 1: {
+                auto const codepoint = cell.codepoint(0);
+                output.classes[column] = wordSkipClass(codepoint);
+                if (codepoint < 0x80)
+                    output.characters[column] = static_cast<char>(codepoint);
+                break;
+            }
+            default: output.classes[column] = WordSkipClass::Other; break;
+        }
+    }
+}
+
+template <CellConcept Cell>
+LineSummary summarizeLine(Line<Cell> const& line)
+{
+    auto summary = LineSummary { LineSummaryFlag::Summarized };
+
+    if (line.isTrivialBuffer())
+    {
+        auto const text = line.trivialBuffer().text.view();
+        if (text.empty())
+            summary.enable(LineSummaryFlag::Blank);
+        for (char const ch: text)
+            summary.enable(lineSummaryFlagOf(static_cast<char32_t>(ch)));
+        return summary;
+    }
+
+    auto blank = true;
+    for (auto const& cell: line.cells())
+    {
+        if (cell.empty())
+            continue;
+        blank = false;
+        if (cell.codepointCount() == 1)
+            summary.enable(lineSummaryFlagOf(cell.codepoint(0)));
+    }
+    if (blank)
+        summary.enable(LineSummaryFlag::Blank);
+    return summary;
+}
+
+void ViMotionIndex::synchronize(uint64_t contentGeneration, int64_t topLineNumber, size_t lineCount)
+{
+    if (contentGeneration == _contentGeneration && topLineNumber == _topLineNumber
+        && lineCount == _summaries.size())
+        return;
+
+    _contentGeneration = contentGeneration;
+    _topLineNumber = topLineNumber;
+    _summaries.assign(lineCount, LineSummary {});
+    for (auto& entry: _classifiedLines)
+        entry.valid = false;
+}
+
+} // namespace vtbackend
+
+#include <vtbackend/cell/CompactCell.h>
+template void vtbackend::classifyLine<vtbackend::CompactCell>(vtbackend::Line<vtbackend::CompactCell> const&,
+                                                              vtbackend::ClassifiedLine&);
+template vtbackend::LineSummary vtbackend::summarizeLine<vtbackend::CompactCell>(
+    vtbackend::Line<vtbackend::CompactCell> const&);
+
+#include <vtbackend/cell/SimpleCell.h>
+template void vtbackend::classifyLine<vtbackend::SimpleCell>(vtbackend::Line<vtbackend::SimpleCell> const&,
+                                                             vtbackend::ClassifiedLine&);
+template vtbackend::LineSummary vtbackend::summarizeLine<vtbackend::SimpleCell>(
+    vtbackend::Line<vtbackend::SimpleCell> const&);
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Line.h>
+#include <vtbackend/cell/CellConcept.h>
+#include <vtbackend/primitives.h>
+
+#include <crispy/flags.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// Class of a cell's character, as far as vi word motions are concerned.
+enum class WordSkipClass : uint8_t
+{
+    Word,
+    Keyword,
+    Whitespace,
+    Other
+};
+
+/// Summary of a line's contents, letting motions skip lines without inspecting their cells.
+enum class LineSummaryFlag : uint16_t
+{
+    None = 0x0000,
+    Blank = 0x0001, // No cell contains any character.
+    RoundOpen = 0x0002,
+    RoundClose = 0x0004,
+    SquareOpen = 0x0008,
+    SquareClose = 0x0010,
+    CurlyOpen = 0x0020,
+    CurlyClose = 0x0040,
+    AngleOpen = 0x0080,
+    AngleClose = 0x0100,
+    SingleQuote = 0x0200,
+    DoubleQuote = 0x0400,
+    BackQuote = 0x0800,
+    Summarized = 0x8000, // The line has been summarized already.
+};
+
+using LineSummary = crispy::flags<LineSummaryFlag>;
+
+/// @returns the summary flag of lines containing the given character, if any.
+constexpr LineSummaryFlag lineSummaryFlagOf(char32_t codepoint) noexcept
+{
+    switch (codepoint)
+    {
+        case '(': return LineSummaryFlag::RoundOpen;
+        case ')': return LineSummaryFlag::RoundClose;
+        case '[': return LineSummaryFlag::SquareOpen;
+        case ']': return LineSummaryFlag::SquareClose;
+        case '{': return LineSummaryFlag::CurlyOpen;
+        case '}': return LineSummaryFlag::CurlyClose;
+        case '<': return LineSummaryFlag::AngleOpen;
+        case '>': return LineSummaryFlag::AngleClose;
+        case '\'': return LineSummaryFlag::SingleQuote;
+        case '"': return LineSummaryFlag::DoubleQuote;
+        case '`': return LineSummaryFlag::BackQuote;
+        default: return LineSummaryFlag::None;
+    }
+}
+
+/// The cells of a line, classified for vi motions.
+struct ClassifiedLine
+{
+    /// Word skip class of each column.
+    std::vector<WordSkipClass> classes;
+
+    /// US-ASCII character of each column, or 0 for empty cells and cells of any other character.
+    std::string characters;
+};
+
+/// Classifies all cells of the given line at once.
+template <CellConcept Cell>
+void classifyLine(Line<Cell> const& line, ClassifiedLine& output);
+
+/// @returns the summary of the given line.
+template <CellConcept Cell>
+[[nodiscard]] LineSummary summarizeLine(Line<Cell> const& line);
+
+/// Index of the grid lines for vi motions.
+///
+/// Lines are referred to by their absolute line number (see Grid::lineNumberOf()).
+/// The summaries of all lines are kept, as motions like paragraph jumps sweep across the whole history,
+/// whereas the classified cells are kept for the most recently visited lines only.
+class ViMotionIndex
+{
+  public:
+    /// Number of lines whose classified cells are kept.
+    ///
+    /// Each line number maps to a fixed slot, so that up to this many consecutive lines,
+    /// such as the ones of the main page, do not evict each other.
+    static constexpr size_t ClassifiedLineCapacity = 256;
+
+    /// Drops everything indexed, unless the grid is still the same as on the previous call.
+    ///
+    /// @param contentGeneration  see Terminal::contentGeneration()
+    /// @param topLineNumber      absolute line number of the topmost line of the grid
+    /// @param lineCount          number of lines of the grid, including the history
+    void synchronize(uint64_t contentGeneration, int64_t topLineNumber, size_t lineCount);
+
+    /// @returns the classified cells of the given line, which remain valid until the next call.
+    template <CellConcept Cell>
+    [[nodiscard]] ClassifiedLine const& classified(int64_t lineNumber, Line<Cell> const& line)
+    {
+        if (_classifiedLines.empty())
+            _classifiedLines.resize(ClassifiedLineCapacity);
+
+        auto& entry = _classifiedLines[static_cast<uint64_t>(lineNumber) % ClassifiedLineCapacity];
+        if (!entry.valid || entry.lineNumber != lineNumber)
+        {
+            classifyLine(line, entry.line);
+            entry.lineNumber = lineNumber;
+            entry.valid = true;
+        }
+        return entry.line;
+    }
+
+    /// @returns the summary of the given line.
+    template <CellConcept Cell>
+    [[nodiscard]] LineSummary summary(int64_t lineNumber, Line<Cell> const& line)
+    {
+        auto const index = static_cast<size_t>(lineNumber - _topLineNumber);
+        if (index >= _summaries.size())
+            return summarizeLine(line);
+
+        auto& summary = _summaries[index];
+        if (!summary.test(LineSummaryFlag::Summarized))
+            summary = summarizeLine(line);
+        return summary;
+    }
+
+  private:
+    struct ClassifiedLineEntry
+    {
+        int64_t lineNumber = 0;
+        bool valid = false;
+        ClassifiedLine line;
+    };
+
+    uint64_t _contentGeneration = 0;
+    int64_t _topLineNumber = 0;
+    std::vector<LineSummary> _summaries;
+    std::vector<ClassifiedLineEntry> _classifiedLines;
+};
+
+} // namespace vtbackend
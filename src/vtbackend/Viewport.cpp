@@ -118,8 +118,14 @@ bool Viewport::scrollMarkUp()
     if (scrollingDisabled())
         return false;
 
-    auto const newScrollOffset =
-        _terminal->primaryScreen().findMarkerUpwards(-boxed_cast<LineOffset>(_scrollOffset));
+    auto& screen = _terminal->primaryScreen();
+    auto const top = -boxed_cast<LineOffset>(_scrollOffset);
+    auto newScrollOffset = screen.findMarkerUpwards(top);
+
+    // Reflowing the lines down from the mark moves the mark.
+    if (newScrollOffset.has_value() && screen.reflowHistoryUntil(*newScrollOffset))
+        newScrollOffset = screen.findMarkerUpwards(top);
+
     if (newScrollOffset.has_value())
         return scrollTo(boxed_cast<ScrollOffset>(-*newScrollOffset));
 
@@ -134,7 +140,7 @@ bool Viewport::scrollMarkDown()
 
     auto const newScrollOffset =
         _terminal->primaryScreen().findMarkerDownwards(-boxed_cast<LineOffset>(_scrollOffset));
-    if (newScrollOffset)
+    if (newScrollOffset && *newScrollOffset <= LineOffset(0))
         return scrollTo(boxed_cast<ScrollOffset>(-*newScrollOffset));
     else
         return forceScrollToBottom();
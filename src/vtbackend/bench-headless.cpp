@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Grid.h>
 #include <vtbackend/MockTerm.h>
+#include <vtbackend/SixelParser.h>
 #include <vtbackend/Terminal.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/logging.h>
@@ -7,12 +9,19 @@
 #include <vtparser/ParserEvents.h>
 
 #include <vtpty/MockViewPty.h>
+#if defined(VTPTY_LIBSSH2)
+    #include <vtpty/SshSession.h>
+#endif
+
+#include <vtrasterizer/TextureAtlas.h>
 
 #include <crispy/App.h>
 #include <crispy/BufferObject.h>
 #include <crispy/CLI.h>
 #include <crispy/utils.h>
 
+#include <cerrno>
+#include <chrono>
 #include <format>
 #include <iostream>
 #include <optional>
@@ -37,6 +46,125 @@ std::string createText(size_t bytes)
     return text;
 }
 
+// Creates a sixel stream (without introducer and ST) of the given dimension, that resembles
+// the output of plotting tools: every band is painted color by color with mostly long repeat runs.
+std::string createSixelStream(unsigned width, unsigned height, unsigned colors)
+{
+    std::string stream;
+    for (unsigned color = 0; color < colors; ++color)
+        stream += std::format("#{};2;{};{};{}", color, rand() % 101, rand() % 101, rand() % 101);
+
+    for (unsigned band = 0; band < (height + 5) / 6; ++band)
+    {
+        for (unsigned color = 0; color < colors; ++color)
+        {
+            stream += std::format("#{}", color);
+            for (unsigned column = 0; column < width;)
+            {
+                auto const run = std::min(1u + static_cast<unsigned>(rand() % 64), width - column);
+                auto const sixel = (rand() % 4) != 0 ? char(63 + (rand() % 64)) : '?';
+                if (run > 3)
+                    stream += std::format("!{}{}", run, sixel);
+                else
+                    stream += std::string(run, sixel);
+                column += run;
+            }
+            stream += '$';
+        }
+        stream += '-';
+    }
+    return stream;
+}
+
+// Feeds @p setup followed by @p chunk repeatedly, until @p testSize bytes of chunks have been processed,
+// into a fresh terminal and reports the throughput of the latter.
+void benchStream(
+    vtbackend::PageSize pageSize, size_t testSize, string_view title, string_view setup, string_view chunk)
+{
+    using std::chrono::steady_clock;
+
+    auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, vtbackend::LineCount(1000), 1'000'000);
+    auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
+    vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+    auto const feed = [&](string_view data) {
+        pty->setReadData(data);
+        do
+            vt.terminal.processInputOnce();
+        while (!pty->isClosed() && !pty->stdoutBuffer().empty());
+    };
+
+    feed(setup);
+    auto stream = std::string {};
+    while (stream.size() < 1024 * 1024)
+        stream += chunk;
+
+    auto bytesProcessed = size_t { 0 };
+    auto const startTime = steady_clock::now();
+    while (bytesProcessed < testSize)
+    {
+        feed(stream);
+        bytesProcessed += stream.size();
+    }
+    auto const elapsed = std::chrono::duration<double>(steady_clock::now() - startTime);
+    auto const seconds = std::max(elapsed.count(), 1e-6);
+    std::cout << std::format("{:<22} : {:.3f} s, {:.2f} MB/s\n",
+                             title,
+                             seconds,
+                             static_cast<double>(bytesProcessed) / seconds / (1024.0 * 1024.0));
+}
+
+// Headless texture atlas backend, that does not touch any GPU but merely records
+// what would have been sent to it, in the same form the OpenGL backend does.
+class HeadlessAtlasBackend final: public vtrasterizer::atlas::AtlasBackend
+{
+  public:
+    explicit HeadlessAtlasBackend(vtbackend::ImageSize atlasSize): _atlasSize { atlasSize } {}
+
+    [[nodiscard]] vtbackend::ImageSize atlasSize() const noexcept override { return _atlasSize; }
+    void configureAtlas(vtrasterizer::atlas::ConfigureAtlas atlas) override { _atlasSize = atlas.size; }
+    void uploadTile(vtrasterizer::atlas::UploadTile /*tile*/) override {}
+
+    // Expands the tile into 6 vertices of (3 + 4 + 4) floats, as OpenGLRenderer does for unencodable tiles.
+    void renderTile(vtrasterizer::atlas::RenderTile tile) override
+    {
+        auto const x = static_cast<float>(tile.x.value);
+        auto const y = static_cast<float>(tile.y.value);
+        auto const r = unbox<float>(tile.bitmapSize.width);
+        auto const s = unbox<float>(tile.bitmapSize.height);
+        auto const& n = tile.normalizedLocation;
+        auto const u = static_cast<float>(tile.fragmentShaderSelector);
+        auto const [cr, cg, cb, ca] = tile.color;
+        // clang-format off
+        float const vertices[6 * 11] = {
+            x,     y + s, 0, n.x,           n.y + n.height, 0, u, cr, cg, cb, ca,
+            x,     y,     0, n.x,           n.y,            0, u, cr, cg, cb, ca,
+            x + r, y,     0, n.x + n.width, n.y,            0, u, cr, cg, cb, ca,
+            x,     y + s, 0, n.x,           n.y + n.height, 0, u, cr, cg, cb, ca,
+            x + r, y,     0, n.x + n.width, n.y,            0, u, cr, cg, cb, ca,
+            x + r, y + s, 0, n.x + n.width, n.y + n.height, 0, u, cr, cg, cb, ca,
+        };
+        // clang-format on
+        vertexBuffer.insert(vertexBuffer.end(), std::begin(vertices), std::end(vertices));
+    }
+
+    void renderTileInstance(vtrasterizer::atlas::RenderTileInstance const& instance) override
+    {
+        instanceBuffer.emplace_back(instance);
+    }
+
+    void clear()
+    {
+        vertexBuffer.clear();
+        instanceBuffer.clear();
+    }
+
+    std::vector<float> vertexBuffer;
+    std::vector<vtrasterizer::atlas::RenderTileInstance> instanceBuffer;
+
+  private:
+    vtbackend::ImageSize _atlasSize;
+};
+
 } // namespace
 
 struct BenchOptions
@@ -115,7 +243,15 @@ class ContourHeadlessBench: public crispy::app
             Project { "fmt", "MIT", "https://github.com/fmtlib/fmt" });
         link("bench-headless.parser", bind(&ContourHeadlessBench::benchParserOnly, this));
         link("bench-headless.grid", bind(&ContourHeadlessBench::benchGrid, this));
-        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY));
+        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY, this));
+#if defined(VTPTY_LIBSSH2)
+        link("bench-headless.ssh", bind(&ContourHeadlessBench::benchSSH, this));
+#endif
+        link("bench-headless.atlas", bind(&ContourHeadlessBench::benchAtlas, this));
+        link("bench-headless.sixel", bind(&ContourHeadlessBench::benchSixel, this));
+        link("bench-headless.margins", bind(&ContourHeadlessBench::benchMargins, this));
+        link("bench-headless.editing", bind(&ContourHeadlessBench::benchEditing, this));
+        link("bench-headless.reflow", bind(&ContourHeadlessBench::benchReflow, this));
         link("bench-headless.meta", bind(&ContourHeadlessBench::showMetaInfo));
 
         char const* logFilterString = getenv("LOG");
@@ -154,7 +290,77 @@ class ContourHeadlessBench: public crispy::app
                     "parser", "Performs performance tests utilizing the VT parser only.", perfOptions },
                 CLI::command {
                     "pty",
-                    "Performs performance tests utilizing the underlying operating system's PTY only." },
+                    "Performs performance tests utilizing the underlying operating system's PTY only.",
+                    CLI::option_list {
+                        CLI::option { "write-size", CLI::value { 4096u }, "Bytes per PTY write.", "BYTES" },
+                        CLI::option {
+                            "read-size", CLI::value { 4096u }, "Maximum bytes per PTY read.", "BYTES" },
+                        CLI::option { "writes", CLI::value { 1u }, "Number of writes per loop.", "COUNT" },
+                        CLI::option { "time", CLI::value { 10u }, "Test duration.", "SECONDS" },
+                    } },
+#if defined(VTPTY_LIBSSH2)
+                CLI::command {
+                    "ssh",
+                    "Measures the output throughput of the builtin SSH client. Requires agent based "
+                    "authentication.",
+                    CLI::option_list {
+                        CLI::option {
+                            "host", CLI::value { "localhost"s }, "SSH server to connect to.", "HOST" },
+                        CLI::option { "port", CLI::value { 22u }, "SSH server port.", "PORT" },
+                        CLI::option { "user", CLI::value { ""s }, "User name (defaults to $USER).", "NAME" },
+                        CLI::option { "size", CLI::value { 256u }, "Number of megabyte to transfer.", "MB" },
+                        CLI::option {
+                            "read-size", CLI::value { 65536u }, "Maximum bytes per read.", "BYTES" },
+                        CLI::option { "compression", CLI::value { false }, "Enable SSH compression." },
+                    } },
+#endif
+                CLI::command {
+                    "atlas",
+                    "Compares the CPU-side cost of encoding render tiles as vertices vs. compact instances.",
+                    CLI::option_list {
+                        CLI::option { "columns", CLI::value { 300u }, "Number of grid columns.", "COUNT" },
+                        CLI::option { "lines", CLI::value { 100u }, "Number of grid lines.", "COUNT" },
+                        CLI::option { "frames", CLI::value { 1000u }, "Number of frames to encode.", "COUNT" },
+                    } },
+                CLI::command {
+                    "sixel",
+                    "Measures the throughput of decoding sixel streams into images.",
+                    CLI::option_list {
+                        CLI::option { "width", CLI::value { 1920u }, "Image width in pixels.", "PIXELS" },
+                        CLI::option { "height", CLI::value { 1080u }, "Image height in pixels.", "PIXELS" },
+                        CLI::option { "colors", CLI::value { 16u }, "Number of colors per band.", "COUNT" },
+                        CLI::option { "images", CLI::value { 20u }, "Number of images to decode.", "COUNT" },
+                    } },
+                CLI::command {
+                    "margins",
+                    "Measures scrolling within DECSTBM and DECSLRM margins, as exercised by test/DECSTBM.sh "
+                    "and test/DECSLRM.sh.",
+                    CLI::option_list {
+                        CLI::option {
+                            "size", CLI::value { 32u }, "Number of megabyte to process per test.", "MB" },
+                        CLI::option { "columns", CLI::value { 80u }, "Number of grid columns.", "COUNT" },
+                        CLI::option { "lines", CLI::value { 25u }, "Number of grid lines.", "COUNT" },
+                    } },
+                CLI::command {
+                    "editing",
+                    "Measures inserting (ICH) and deleting (DCH) characters on fully attributed lines.",
+                    CLI::option_list {
+                        CLI::option {
+                            "size", CLI::value { 32u }, "Number of megabyte to process per test.", "MB" },
+                        CLI::option { "columns", CLI::value { 300u }, "Number of grid columns.", "COUNT" },
+                        CLI::option { "lines", CLI::value { 25u }, "Number of grid lines.", "COUNT" },
+                    } },
+                CLI::command {
+                    "reflow",
+                    "Measures reflowing the history upon resize with 1, 4 and 16 threads.",
+                    CLI::option_list {
+                        CLI::option {
+                            "lines", CLI::value { 1'000'000u }, "Number of history lines.", "COUNT" },
+                        CLI::option {
+                            "from", CLI::value { 200u }, "Number of columns before resize.", "COUNT" },
+                        CLI::option {
+                            "to", CLI::value { 80u }, "Number of columns after resize.", "COUNT" },
+                    } },
             }
         };
     }
@@ -210,7 +416,7 @@ class ContourHeadlessBench: public crispy::app
         return rv;
     }
 
-    static int benchPTY()
+    int benchPTY()
     {
         using std::chrono::steady_clock;
         using vtpty::ColumnCount;
@@ -220,14 +426,13 @@ class ContourHeadlessBench: public crispy::app
         using vtpty::Pty;
 
         // Benchmark configuration
-        // TODO make these values CLI configurable.
-        auto constexpr WritesPerLoop = 1;
-        auto constexpr PtyWriteSize = 4096;
-        auto constexpr PtyReadSize = 4096;
-        auto const benchTime = chrono::seconds(10);
+        auto const writesPerLoop = parameters().uint("bench-headless.pty.writes");
+        auto const ptyWriteSize = std::max(parameters().uint("bench-headless.pty.write-size"), 1u);
+        auto const ptyReadSize = std::max(parameters().uint("bench-headless.pty.read-size"), 1u);
+        auto const benchTime = chrono::seconds(std::max(parameters().uint("bench-headless.pty.time"), 1u));
 
         // Setup benchmark
-        std::string const text = createText(PtyWriteSize);
+        std::string const text = createText(ptyWriteSize);
         unique_ptr<Pty> ptyObject = createPty(PageSize { LineCount(25), ColumnCount(80) }, std::nullopt);
         auto& pty = *ptyObject;
         auto& ptySlave = pty.slave();
@@ -241,7 +446,7 @@ class ContourHeadlessBench: public crispy::app
         auto ptyStdoutReaderThread = std::thread { [&]() {
             while (!pty.isClosed())
             {
-                auto const readResult = pty.read(*bufferObject, std::chrono::seconds(2), PtyReadSize);
+                auto const readResult = pty.read(*bufferObject, std::chrono::seconds(2), ptyReadSize);
                 if (!readResult)
                     break;
                 auto const dataChunk = readResult.value().data;
@@ -262,7 +467,7 @@ class ContourHeadlessBench: public crispy::app
         auto stopTime = startTime;
         while (stopTime - startTime < benchTime)
         {
-            for (int i = 0; i < WritesPerLoop; ++i)
+            for (unsigned i = 0; i < writesPerLoop; ++i)
                 (void) ptySlave.write(text);
             stopTime = steady_clock::now();
         }
@@ -279,9 +484,9 @@ class ContourHeadlessBench: public crispy::app
         std::cout << std::format("\n");
         std::cout << std::format("PTY stdout throughput bandwidth test\n");
         std::cout << std::format("====================================\n\n");
-        std::cout << std::format("Writes per loop        : {}\n", WritesPerLoop);
-        std::cout << std::format("PTY write size         : {}\n", PtyWriteSize);
-        std::cout << std::format("PTY read size          : {}\n", PtyReadSize);
+        std::cout << std::format("Writes per loop        : {}\n", writesPerLoop);
+        std::cout << std::format("PTY write size         : {}\n", ptyWriteSize);
+        std::cout << std::format("PTY read size          : {}\n", ptyReadSize);
         std::cout << std::format(
             "Test time              : {}.{:03} seconds\n", msecs.count() / 1000, msecs.count() % 1000);
         std::cout << std::format("Data transferred       : {}\n",
@@ -297,6 +502,317 @@ class ContourHeadlessBench: public crispy::app
         return EXIT_SUCCESS;
     }
 
+#if defined(VTPTY_LIBSSH2)
+    int benchSSH()
+    {
+        using std::chrono::steady_clock;
+
+        auto config = vtpty::SshHostConfig {};
+        config.hostname = parameters().str("bench-headless.ssh.host");
+        config.port = static_cast<int>(parameters().uint("bench-headless.ssh.port"));
+        config.username = parameters().str("bench-headless.ssh.user");
+        config.compression = parameters().boolean("bench-headless.ssh.compression");
+        if (config.username.empty())
+            if (auto const* user = getenv("USER"); user)
+                config.username = user;
+
+        auto const bytesToTransfer = uint64_t { parameters().uint("bench-headless.ssh.size") } * 1024 * 1024;
+        auto const readSize = std::max(parameters().uint("bench-headless.ssh.read-size"), 1u);
+
+        auto session = vtpty::SshSession { config };
+        session.start();
+        if (!session.isOperational())
+        {
+            std::cerr << "Failed to establish SSH session.\n";
+            return EXIT_FAILURE;
+        }
+
+        // Have the remote side produce the payload and then close the session.
+        (void) session.write(std::format("head -c {} /dev/zero | tr '\\0' x; exit\r", bytesToTransfer));
+
+        auto bufferObjectPool = crispy::buffer_object_pool<char>(4llu * 1024 * 1024);
+        auto bufferObject = bufferObjectPool.allocateBufferObject();
+
+        std::cout << std::format("Running SSH benchmark ...\n");
+        auto bytesTransferred = uint64_t { 0 };
+        auto loopIterations = uint64_t { 0 };
+        auto idleReads = 0;
+        auto const startTime = steady_clock::now();
+        while (bytesTransferred < bytesToTransfer && !session.isClosed() && idleReads < 5)
+        {
+            auto const readResult = session.read(*bufferObject, std::chrono::seconds(2), readSize);
+            if (!readResult)
+            {
+                if (errno != EAGAIN)
+                    break;
+                ++idleReads;
+                continue;
+            }
+            if (readResult->data.empty())
+                break;
+            idleReads = 0;
+            bytesTransferred += readResult->data.size();
+            loopIterations++;
+        }
+        auto const elapsedTime = steady_clock::now() - startTime;
+        session.close();
+
+        auto const msecs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime);
+        auto const seconds = std::max(std::chrono::duration<double>(elapsedTime).count(), 1e-6);
+
+        std::cout << std::format("\n");
+        std::cout << std::format("SSH output throughput bandwidth test\n");
+        std::cout << std::format("====================================\n\n");
+        std::cout << std::format("Compression            : {}\n", config.compression ? "yes" : "no");
+        std::cout << std::format("Read size              : {}\n", readSize);
+        std::cout << std::format(
+            "Test time              : {}.{:03} seconds\n", msecs.count() / 1000, msecs.count() % 1000);
+        std::cout << std::format("Data transferred       : {}\n",
+                                 crispy::humanReadableBytes(bytesTransferred));
+        std::cout << std::format("Reader loop iterations : {}\n", loopIterations);
+        std::cout << std::format("Transfer speed         : {} per second\n",
+                                 crispy::humanReadableBytes(static_cast<uint64_t>(
+                                     static_cast<double>(bytesTransferred) / seconds)));
+
+        return bytesTransferred >= bytesToTransfer ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+#endif
+
+    int benchAtlas()
+    {
+        using std::chrono::steady_clock;
+        namespace atlas = vtrasterizer::atlas;
+
+        auto const columns = parameters().uint("bench-headless.atlas.columns");
+        auto const lines = parameters().uint("bench-headless.atlas.lines");
+        auto const frames = parameters().uint("bench-headless.atlas.frames");
+
+        auto const cellSize = vtbackend::ImageSize { vtbackend::Width(10), vtbackend::Height(20) };
+        auto backend = HeadlessAtlasBackend { vtbackend::ImageSize { vtbackend::Width(2048),
+                                                                     vtbackend::Height(2048) } };
+
+        // Build one frame worth of render tiles, one per grid cell.
+        auto tiles = std::vector<atlas::RenderTile> {};
+        tiles.reserve(static_cast<size_t>(columns) * lines);
+        for (unsigned line = 0; line < lines; ++line)
+        {
+            for (unsigned column = 0; column < columns; ++column)
+            {
+                auto const tileIndex = static_cast<uint16_t>(rand() % 4096);
+                auto tile = atlas::RenderTile {};
+                tile.x = atlas::RenderTile::X { static_cast<int>(column * unbox(cellSize.width)) };
+                tile.y = atlas::RenderTile::Y { static_cast<int>(line * unbox(cellSize.height)) };
+                tile.bitmapSize = cellSize;
+                tile.color = atlas::normalize(vtbackend::RGBAColor { 0xC0, 0xC0, 0xC0, 0xFF });
+                tile.tileLocation = atlas::TileLocation {
+                    atlas::TileLocation::X { static_cast<uint16_t>((tileIndex % 64) * 10) },
+                    atlas::TileLocation::Y { static_cast<uint16_t>((tileIndex / 64) * 20) },
+                };
+                tile.normalizedLocation.x = static_cast<float>(tile.tileLocation.x.value) / 2048.f;
+                tile.normalizedLocation.y = static_cast<float>(tile.tileLocation.y.value) / 2048.f;
+                tile.normalizedLocation.width = 10.f / 2048.f;
+                tile.normalizedLocation.height = 20.f / 2048.f;
+                tiles.emplace_back(tile);
+            }
+        }
+
+        auto const measure = [&](auto&& submit) {
+            auto const startTime = steady_clock::now();
+            for (unsigned frame = 0; frame < frames; ++frame)
+            {
+                backend.clear();
+                for (auto const& tile: tiles)
+                    submit(tile);
+            }
+            return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - startTime);
+        };
+
+        auto const vertexTime = measure([&](atlas::RenderTile const& tile) { backend.renderTile(tile); });
+        auto const vertexBytes = backend.vertexBuffer.size() * sizeof(float);
+
+        auto const instanceTime = measure([&](atlas::RenderTile const& tile) {
+            if (auto const instance = atlas::encodeRenderTile(tile))
+                backend.renderTileInstance(*instance);
+            else
+                backend.renderTile(tile);
+        });
+        auto const instanceBytes = backend.instanceBuffer.size() * sizeof(atlas::RenderTileInstance);
+
+        auto const perFrame = [&](std::chrono::microseconds total) {
+            return static_cast<double>(total.count()) / static_cast<double>(std::max(frames, 1u));
+        };
+
+        std::cout << std::format("Render tile encoding test ({}x{} grid, {} frames)\n", columns, lines, frames);
+        std::cout << std::format("=============================================\n\n");
+        std::cout << std::format("Vertex expansion       : {:.2f} us per frame, {} per frame\n",
+                                 perFrame(vertexTime),
+                                 crispy::humanReadableBytes(vertexBytes));
+        std::cout << std::format("Instance encoding      : {:.2f} us per frame, {} per frame\n",
+                                 perFrame(instanceTime),
+                                 crispy::humanReadableBytes(instanceBytes));
+        return EXIT_SUCCESS;
+    }
+
+    int benchSixel()
+    {
+        using std::chrono::steady_clock;
+
+        auto const width = parameters().uint("bench-headless.sixel.width");
+        auto const height = parameters().uint("bench-headless.sixel.height");
+        auto const colors = std::max(parameters().uint("bench-headless.sixel.colors"), 1u);
+        auto const images = parameters().uint("bench-headless.sixel.images");
+
+        auto const stream = createSixelStream(width, height, colors);
+        auto const maxImageSize = vtbackend::ImageSize { vtbackend::Width(4096), vtbackend::Height(4096) };
+        auto const palette = std::make_shared<vtbackend::SixelColorPalette>(colors, 256);
+
+        auto pixelCount = size_t { 0 };
+        auto const startTime = steady_clock::now();
+        for (unsigned i = 0; i < images; ++i)
+        {
+            auto const backgroundColor = vtbackend::RGBAColor { 0, 0, 0, 0 };
+            auto builder = vtbackend::SixelImageBuilder(maxImageSize, 1, 1, backgroundColor, palette);
+            vtbackend::SixelParser::parse(stream, builder);
+            pixelCount += builder.size().area();
+        }
+        auto const elapsed = std::chrono::duration<double>(steady_clock::now() - startTime);
+        auto const seconds = std::max(elapsed.count(), 1e-6);
+
+        std::cout << std::format("Sixel decoding test ({}x{} pixels, {} colors, {} images)\n",
+                                 width,
+                                 height,
+                                 colors,
+                                 images);
+        std::cout << std::format("=============================================\n\n");
+        std::cout << std::format("Stream size            : {} per image\n",
+                                 crispy::humanReadableBytes(stream.size()));
+        std::cout << std::format("Total time             : {:.3f} s\n", seconds);
+        std::cout << std::format("Throughput             : {:.2f} MB/s, {:.2f} megapixels/s\n",
+                                 static_cast<double>(stream.size()) * images / seconds / (1024.0 * 1024.0),
+                                 static_cast<double>(pixelCount) / seconds / 1'000'000.0);
+        return EXIT_SUCCESS;
+    }
+
+    int benchMargins()
+    {
+        auto const testSize = size_t { parameters().uint("bench-headless.margins.size") } * 1024 * 1024;
+        auto const columns = std::max(parameters().uint("bench-headless.margins.columns"), 10u);
+        auto const lines = std::max(parameters().uint("bench-headless.margins.lines"), 10u);
+        auto const pageSize = vtbackend::PageSize { vtbackend::LineCount::cast_from(lines),
+                                                    vtbackend::ColumnCount::cast_from(columns) };
+        auto const run = [&](string_view title, string_view setup, string_view chunk) {
+            benchStream(pageSize, testSize, title, setup, chunk);
+        };
+
+        std::cout << std::format("Margin scrolling test ({}x{} page)\n", columns, lines);
+        std::cout << std::format("=====================================\n\n");
+
+        // test/DECSTBM.sh: line feeds at the bottom of a top/bottom margin, like a pager or an
+        // editor above a status line, with the margin spanning all but the first and last page line.
+        auto const topBottom = std::format("\033[2J\033[H\033[2;{}r\033[{};1H", lines - 1, lines - 1);
+        run("DECSTBM", topBottom, "1: Hello, World\r\n");
+        run("DECSTBM (underlined)", topBottom, "\033[4:3;58:2::255:0:0m1: Hello, World\033[m\r\n");
+
+        // test/DECSLRM.sh: text wrapping within a left/right plus top/bottom margin, scrolling the
+        // margin's rectangle up on every wrap at its bottom.
+        auto const leftRight = std::format("\033[2J\033[H\033[?69h\033[2;{}s\033[2;{}r\033[2;2H",
+                                           columns - 1,
+                                           lines - 1);
+        run("DECSLRM", leftRight, "123456789");
+        run("DECSLRM (underlined)", leftRight, "\033[4:3;58:2::255:0:0m123456789\033[m");
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchEditing()
+    {
+        auto const testSize = size_t { parameters().uint("bench-headless.editing.size") } * 1024 * 1024;
+        auto const columns = std::max(parameters().uint("bench-headless.editing.columns"), 20u);
+        auto const lines = std::max(parameters().uint("bench-headless.editing.lines"), 1u);
+        auto const pageSize = vtbackend::PageSize { vtbackend::LineCount::cast_from(lines),
+                                                    vtbackend::ColumnCount::cast_from(columns) };
+
+        std::cout << std::format("Character insertion and deletion test ({}x{} page)\n", columns, lines);
+        std::cout << std::format("====================================================\n\n");
+
+        // Fills every line of the page with text in the given rendition, which is kept active,
+        // so that also the blanks inserted by ICH and DCH carry it.
+        auto const fill = [&](string_view sgr) {
+            auto setup = std::format("\033[2J\033[H{}", sgr);
+            for (unsigned line = 1; line <= lines; ++line)
+            {
+                setup += std::format("\033[{};1H", line);
+                for (unsigned column = 0; column < columns; ++column)
+                    setup += char('A' + ((line + column) % 26));
+            }
+            return setup;
+        };
+
+        // Edits at a few spots of every line, like an editor redrawing a changed line would.
+        auto const edits = [&](string_view function) {
+            auto chunk = std::string {};
+            for (unsigned line = 1; line <= lines; ++line)
+                for (unsigned column = 1; column < columns; column += columns / 4)
+                    chunk += std::format("\033[{};{}H\033[8{}", line, column, function);
+            return chunk;
+        };
+
+        auto const plain = fill("\033[m");
+        auto const attributed = fill("\033[1;3;4:3;38:2::200:100:50;48:5:17;58:2::255:0:0m");
+        benchStream(pageSize, testSize, "ICH", plain, edits("@"));
+        benchStream(pageSize, testSize, "ICH (attributed)", attributed, edits("@"));
+        benchStream(pageSize, testSize, "DCH", plain, edits("P"));
+        benchStream(pageSize, testSize, "DCH (attributed)", attributed, edits("P"));
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchReflow()
+    {
+        using std::chrono::steady_clock;
+
+        auto const historyLineCount = parameters().uint("bench-headless.reflow.lines");
+        auto const fromColumns = std::max(parameters().uint("bench-headless.reflow.from"), 1u);
+        auto const toColumns = std::max(parameters().uint("bench-headless.reflow.to"), 1u);
+        auto const pageLineCount = vtbackend::LineCount(25);
+
+        std::cout << std::format(
+            "History reflow test ({} lines, {} -> {} columns)\n", historyLineCount, fromColumns, toColumns);
+        std::cout << std::format("====================================================\n\n");
+
+        for (auto const threadCount: { 1u, 4u, 16u })
+        {
+            auto grid = vtbackend::Grid<vtbackend::PrimaryScreenCell>(
+                vtbackend::PageSize { pageLineCount, vtbackend::ColumnCount::cast_from(fromColumns) },
+                true,
+                vtbackend::LineCount::cast_from(historyLineCount));
+            grid.setReflowThreadCount(threadCount);
+
+            // Fills the history with lines of varying length, like the output of a build log.
+            auto const bottomLine = boxed_cast<vtbackend::LineOffset>(pageLineCount) - 1;
+            auto text = std::string {};
+            for (unsigned i = 0; i < historyLineCount + unbox<unsigned>(pageLineCount); ++i)
+            {
+                text.assign(1 + ((i * 37) % fromColumns), char('A' + (i % 26)));
+                grid.lineAt(bottomLine).fill(vtbackend::ColumnOffset(0), {}, text);
+                grid.scrollUp(vtbackend::LineCount(1));
+            }
+
+            auto const newSize =
+                vtbackend::PageSize { pageLineCount, vtbackend::ColumnCount::cast_from(toColumns) };
+            auto const startTime = steady_clock::now();
+            (void) grid.resize(newSize, vtbackend::CellLocation {}, false);
+            auto const elapsed = std::chrono::duration<double>(steady_clock::now() - startTime);
+
+            std::cout << std::format("{:>2} thread(s)           : {:.3f} s, {} lines\n",
+                                     threadCount,
+                                     elapsed.count(),
+                                     grid.historyLineCount());
+        }
+
+        return EXIT_SUCCESS;
+    }
+
     int benchParserOnly()
     {
         auto po = vtparser::NullParserEvents {};
@@ -193,10 +193,17 @@ inline CompactCell::CompactCell(CompactCell const& v) noexcept:
 
 inline CompactCell& CompactCell::operator=(CompactCell const& v) noexcept
 {
+    if (this == &v)
+        return *this;
+
     _codepoint = v._codepoint;
     _foregroundColor = v._foregroundColor;
     _backgroundColor = v._backgroundColor;
-    if (v._extra)
+    if (!v._extra)
+        _extra.reset();
+    else if (_extra)
+        *_extra = *v._extra; // reuse the existing allocation
+    else
         createExtra(*v._extra);
     return *this;
 }
@@ -212,14 +219,7 @@ inline void CompactCell::reset() noexcept
 
 inline void CompactCell::reset(GraphicsAttributes const& attributes) noexcept
 {
-    _codepoint = 0;
-    _foregroundColor = attributes.foregroundColor;
-    _backgroundColor = attributes.backgroundColor;
-    _extra.reset();
-    if (attributes.flags != CellFlag::None)
-        extra().flags = attributes.flags;
-    if (attributes.underlineColor != DefaultColor())
-        extra().underlineColor = attributes.underlineColor;
+    reset(attributes, HyperlinkId {});
 }
 
 inline void CompactCell::write(GraphicsAttributes const& attributes, char32_t ch, uint8_t width) noexcept
@@ -282,13 +282,21 @@ inline void CompactCell::reset(GraphicsAttributes const& attributes, HyperlinkId
     _foregroundColor = attributes.foregroundColor;
     _backgroundColor = attributes.backgroundColor;
 
-    _extra.reset();
-    if (attributes.underlineColor != DefaultColor())
-        extra().underlineColor = attributes.underlineColor;
-    if (attributes.flags != CellFlag::None)
-        extra().flags = attributes.flags;
-    if (hyperlink != HyperlinkId())
-        extra().hyperlink = hyperlink;
+    if (attributes.underlineColor == DefaultColor() && attributes.flags == CellFlag::None
+        && hyperlink == HyperlinkId())
+    {
+        _extra.reset();
+        return;
+    }
+
+    // Reset the extra in-place, if present, so that bulk resets of attributed cells do not allocate.
+    if (_extra)
+        *_extra = CellExtra {};
+    else
+        createExtra();
+    _extra->underlineColor = attributes.underlineColor;
+    _extra->flags = attributes.flags;
+    _extra->hyperlink = hyperlink;
 }
 // }}}
 // {{{ impl: character
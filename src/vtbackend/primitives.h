@@ -463,6 +463,14 @@ enum class ScreenType : uint8_t
     Alternate = 1,
 };
 
+/// What is being captured by XTCAPTURE (see docs/vt-extensions/buffer-capture.md).
+enum class CaptureBufferMode : uint8_t
+{
+    PhysicalLines = 0,  // count lines from the main page area's bottom upwards
+    LogicalLines = 1,   // count unwrapped lines from the main page area's bottom upwards
+    CommandOutputs = 2, // the outputs of the count most recently executed shell commands
+};
+
 // TODO: Maybe make boxed.h into its own C++ github repo?
 // TODO: Differentiate Line/Column types for DECOM enabled/disabled coordinates?
 //
@@ -23,4 +23,19 @@ unique_ptr<Pty> createPty(PageSize pageSize, optional<ImageSize> viewSize)
 #endif
 }
 
+int Pty::writev(std::span<std::string_view const> buffers)
+{
+    auto total = 0;
+    for (auto const buffer: buffers)
+    {
+        auto const rv = write(buffer);
+        if (rv < 0)
+            return total > 0 ? total : rv;
+        total += rv;
+        if (static_cast<size_t>(rv) < buffer.size())
+            break;
+    }
+    return total;
+}
+
 } // namespace vtpty
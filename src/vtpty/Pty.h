@@ -9,6 +9,7 @@
 
 #include <chrono>
 #include <optional>
+#include <span>
 #include <string_view>
 
 #include <boxed-cpp/boxed.hpp>
@@ -105,6 +106,23 @@ class Pty
     /// @returns Number of bytes written or -1 on error.
     [[nodiscard]] virtual int write(std::string_view buf) = 0;
 
+    /// Writes the given buffers in order to the PTY device, as if they were one contiguous buffer.
+    ///
+    /// Unlike write(), this call never blocks on a partially written buffer. The caller is expected
+    /// to retry with the remaining bytes later on.
+    ///
+    /// The default implementation falls back to one write() per buffer.
+    ///
+    /// @returns Number of bytes written or -1 on error.
+    [[nodiscard]] virtual int writev(std::span<std::string_view const> buffers);
+
+    /// @returns the handle to watch for the PTY to become writable again after a write() or writev()
+    ///          could not write anything, or std::nullopt if there is no such handle to watch.
+    [[nodiscard]] virtual std::optional<PtyHandle> writeNotificationHandle() const noexcept
+    {
+        return std::nullopt;
+    }
+
     /// @returns current underlying window size in characters width and height.
     [[nodiscard]] virtual PageSize pageSize() const noexcept = 0;
 
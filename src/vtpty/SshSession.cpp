@@ -18,23 +18,32 @@
 #include <vtpty/Process.h>
 #include <vtpty/Pty.h>
 #include <vtpty/SshSession.h>
+#if !defined(_WIN32)
+    #include <vtpty/UnixUtils.h>
+#endif
 
 #include <crispy/escape.h>
 #include <crispy/utils.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include <libssh2.h>
 #include <libssh2_publickey.h>
 
 #if not defined(_WIN32)
     #include <sys/ioctl.h>
-    #include <sys/select.h>
     #include <sys/socket.h>
     #include <sys/types.h>
 
     #include <fcntl.h>
     #include <netdb.h>
+    #include <poll.h>
     #include <termios.h>
     #include <unistd.h>
 
@@ -56,9 +65,6 @@
     #define LIBSSH2_HANDSHAKE_FUNCTION libssh2_session_startup
 #endif
 
-// It would be nice to move to NB IO mode, but I didn't have the time to debug it.
-// #define SSH_SESSION_NB_IO /* BUGGY EZ */
-
 using crispy::file_descriptor;
 
 using namespace std::string_literals;
@@ -82,6 +88,18 @@ namespace
 {
     constexpr auto MaxPasswordTries = 3;
 
+    // Receive window of the SSH channel. Larger than libssh2's default, so that bulk output
+    // over high-latency links is not throttled by waiting for window adjustments.
+    constexpr auto ChannelWindowSize = 4u * 1024 * 1024;
+
+    // Maximum number of bytes accepted by write() but not yet sent. Beyond that,
+    // write() pushes back on the caller.
+    constexpr auto MaxOutboundSize = size_t { 1024 * 1024 };
+
+    // Maximum number of bytes read from or written to one channel at a time while the connection
+    // is shared, so that a session with bulk output does not starve the other sessions on it.
+    constexpr auto ChannelQuantum = size_t { 64 * 1024 };
+
     template <typename T>
     std::string_view libssl2ErrorString(T rc)
     {
@@ -174,6 +192,96 @@ using socket_handle = crispy::native_handle<SOCKET, INVALID_SOCKET>;
 using socket_handle = crispy::native_handle<int, -1>;
 #endif
 
+// {{{ SshTransport
+/// Authenticated SSH connection, shared by all sessions to the same host, port and user.
+struct SshTransport
+{
+    LIBSSH2_SESSION* sshSession = libssh2_session_init();
+    LIBSSH2_AGENT* sshAgent = nullptr;
+
+    socket_handle sshSocket;
+
+    // Guards all libssh2 calls on this connection, as it is driven by the reading
+    // and writing threads of every session on it.
+    std::mutex mutex;
+
+    // Sessions with a running shell on this connection. Guarded by mutex.
+    std::vector<SshSession*> sessions;
+
+    // Whether new sessions may open their channel on this connection.
+    std::atomic<bool> reusable = false;
+
+    SshTransport() = default;
+    SshTransport(SshTransport const&) = delete;
+    SshTransport(SshTransport&&) = delete;
+    SshTransport& operator=(SshTransport const&) = delete;
+    SshTransport& operator=(SshTransport&&) = delete;
+
+    ~SshTransport()
+    {
+        if (sshAgent)
+        {
+            libssh2_agent_disconnect(sshAgent);
+            libssh2_agent_free(sshAgent);
+        }
+
+        if (sshSession)
+        {
+            libssh2_session_set_blocking(sshSession, 1);
+            libssh2_session_disconnect(sshSession, "Normal shutdown");
+            libssh2_session_free(sshSession);
+        }
+
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+    }
+
+    // Blocking mode is used while no shell is running on the connection yet, and otherwise only
+    // for the duration of setting up or tearing down a channel, with the mutex held.
+    // Must be called with the mutex held.
+    void updateBlockingMode() { libssh2_session_set_blocking(sshSession, sessions.empty() ? 1 : 0); }
+
+    // Limits the number of bytes transferred on one channel at a time, see ChannelQuantum.
+    [[nodiscard]] size_t quantum(size_t size) const noexcept
+    {
+        return sessions.size() > 1 ? std::min(size, ChannelQuantum) : size;
+    }
+};
+
+namespace
+{
+    std::mutex transportsMutex;
+    std::map<std::string, std::weak_ptr<SshTransport>> transports;
+
+    std::string transportKey(SshHostConfig const& config)
+    {
+        return std::format("{}@{}:{}{}",
+                           config.username,
+                           config.hostname,
+                           config.port,
+                           config.compression ? " (compressed)" : "");
+    }
+
+    std::shared_ptr<SshTransport> findTransport(std::string const& key)
+    {
+        auto const _ = std::lock_guard { transportsMutex };
+        if (auto const i = transports.find(key); i != transports.end())
+            if (auto transport = i->second.lock(); transport && transport->reusable)
+                return transport;
+        return nullptr;
+    }
+
+    void registerTransport(std::string const& key, std::shared_ptr<SshTransport> const& transport)
+    {
+        auto const _ = std::lock_guard { transportsMutex };
+        std::erase_if(transports, [](auto const& entry) { return entry.second.expired(); });
+        transports[key] = transport;
+        transport->reusable = true;
+    }
+} // namespace
+// }}}
+
 std::string SshHostConfig::toString() const
 {
     auto result = ""s;
@@ -212,6 +320,7 @@ std::string SshHostConfig::toString() const
         add(std::format("known hosts: {}", knownHostsFile.string()));
 
     add(std::format("ForwardAgent: {}", forwardAgent ? "Yes" : "No"));
+    add(std::format("Compression: {}", compression ? "Yes" : "No"));
 
     return result;
 }
@@ -235,6 +344,8 @@ std::string SshHostConfig::toConfigString(std::string const& host) const
     if (!knownHostsFile.empty())
         result += std::format("{}KnownHostsFile {}\n", prefix, knownHostsFile.string());
     result += std::format("{}ForwardAgent {}\n", prefix, forwardAgent);
+    if (compression)
+        result += std::format("{}Compression yes\n", prefix);
     result += std::format("\n");
     return result;
 }
@@ -294,6 +405,8 @@ crispy::result<SshHostConfigMap> loadSshConfig(std::filesystem::path const& conf
                 config.privateKeyFile = value;
             else if (key == "ForwardAgent")
                 config.forwardAgent = (value == "yes");
+            else if (key == "Compression")
+                config.compression = (value == "yes");
             else
                 errorLog()("Unknown SSH config key: {}", key);
             // Add additional options here as needed
@@ -311,12 +424,16 @@ crispy::result<SshHostConfigMap> loadSshConfig()
 
 struct SshSession::Private
 {
-    LIBSSH2_SESSION* sshSession = nullptr;
+    std::shared_ptr<SshTransport> transport;
     LIBSSH2_CHANNEL* sshChannel = nullptr;
-    LIBSSH2_AGENT* sshAgent = nullptr;
-    bool wantsWaitForSocket = false;
 
-    socket_handle sshSocket;
+#if !defined(_WIN32)
+    // Used to interrupt waitForSocket().
+    UnixPipe wakeupPipe { O_NONBLOCK | O_CLOEXEC };
+#endif
+
+    // Bytes accepted by write() but not yet accepted by the SSH channel.
+    std::string outbound;
 };
 
 SshSession::SshSession(SshHostConfig config):
@@ -328,43 +445,23 @@ SshSession::SshSession(SshHostConfig config):
 {
     libssh2_init(0); // TODO: call only once?
 
-#if defined(SSH_SESSION_NB_IO)
-    libssh2_session_set_blocking(_p->sshSession, 0);
-#endif
-
     std::atexit([]() { libssh2_exit(); });
-
-    _p->sshSession = libssh2_session_init();
 }
 
 SshSession::~SshSession()
 {
     close();
 
-    if (_p->sshAgent)
-    {
-        libssh2_agent_disconnect(_p->sshAgent);
-        libssh2_agent_free(_p->sshAgent);
-        _p->sshAgent = nullptr;
-    }
-
     if (_p->sshChannel)
     {
-        libssh2_channel_send_eof(_p->sshChannel);
-        libssh2_channel_close(_p->sshChannel);
+        auto const _ = std::lock_guard { _p->transport->mutex };
+        libssh2_session_set_blocking(_p->transport->sshSession, 1);
+        libssh2_channel_free(_p->sshChannel);
         _p->sshChannel = nullptr;
+        _p->transport->updateBlockingMode();
     }
 
-    if (_p->sshSession)
-    {
-        libssh2_session_disconnect(_p->sshSession, "Normal shutdown");
-        libssh2_session_free(_p->sshSession);
-        _p->sshSession = nullptr;
-    }
-
-#if defined(_WIN32)
-    WSACleanup();
-#endif
+    // The connection is shut down along with the last session using it.
 }
 
 void SshSession::setState(State nextState)
@@ -398,10 +495,7 @@ bool SshSession::requestPty()
                                                    _pixels.has_value() ? _pixels->width.as<int>() : 0,
                                                    _pixels.has_value() ? _pixels->height.as<int>() : 0);
     if (rc == LIBSSH2_ERROR_EAGAIN)
-    {
-        _p->wantsWaitForSocket = true;
         return false;
-    }
     if (rc != LIBSSH2_ERROR_NONE)
     {
         logError("Failed to request PTY. {}", libssl2ErrorString(rc));
@@ -432,8 +526,7 @@ bool SshSession::setEnv()
             libssh2_channel_setenv_ex(_p->sshChannel, name.data(), name.size(), value.data(), value.size());
         if (rc == LIBSSH2_ERROR_EAGAIN)
         {
-            _walkIndex = i;                // remember where we left off
-            _p->wantsWaitForSocket = true; // and wait for socket to become writable
+            _walkIndex = i; // remember where we left off
             return false;
         }
         if (rc != LIBSSH2_ERROR_NONE)
@@ -454,10 +547,7 @@ void SshSession::resizeScreen()
                                             _pixels.has_value() ? unbox<int>(_pixels->width) : 0,
                                             _pixels.has_value() ? unbox<int>(_pixels->height) : 0);
     if (rc == LIBSSH2_ERROR_EAGAIN)
-    {
-        _p->wantsWaitForSocket = true;
         return;
-    }
     if (rc != LIBSSH2_ERROR_NONE)
     {
         logError("Failed to request PTY resize. {}", libssl2ErrorString(rc));
@@ -468,7 +558,6 @@ void SshSession::resizeScreen()
 
 void SshSession::processState()
 {
-    waitForSocket();
     while (true)
     {
         switch (_state)
@@ -486,12 +575,12 @@ void SshSession::processState()
                 setState(State::Handshake);
                 [[fallthrough]];
             case State::Handshake: {
-                int const rc = LIBSSH2_HANDSHAKE_FUNCTION(_p->sshSession, _p->sshSocket);
+                if (_config.compression)
+                    libssh2_session_flag(_p->transport->sshSession, LIBSSH2_FLAG_COMPRESS, 1);
+                int const rc =
+                    LIBSSH2_HANDSHAKE_FUNCTION(_p->transport->sshSession, _p->transport->sshSocket);
                 if (rc == LIBSSH2_ERROR_EAGAIN)
-                {
-                    _p->wantsWaitForSocket = true;
                     return;
-                }
                 if (rc != LIBSSH2_ERROR_NONE)
                 {
                     logError("Failed to establish SSH session. {}", libssl2ErrorString(rc));
@@ -545,11 +634,22 @@ void SshSession::processState()
                 break;
             }
             case State::OpenChannel: {
-                _p->sshChannel = libssh2_channel_open_session(_p->sshSession);
-                auto const rc = libssh2_session_last_errno(_p->sshSession);
+                if (!_p->transport->reusable)
+                    registerTransport(transportKey(_config), _p->transport);
+
+                // The channel is set up in blocking mode, also when other sessions are already
+                // running on this connection, as they are held off by the mutex meanwhile.
+                libssh2_session_set_blocking(_p->transport->sshSession, 1);
+                _p->sshChannel = libssh2_channel_open_ex(_p->transport->sshSession,
+                                                         "session",
+                                                         sizeof("session") - 1,
+                                                         ChannelWindowSize,
+                                                         LIBSSH2_CHANNEL_PACKET_DEFAULT,
+                                                         nullptr,
+                                                         0);
+                auto const rc = libssh2_session_last_errno(_p->transport->sshSession);
                 if (rc == LIBSSH2_ERROR_EAGAIN)
                 {
-                    _p->wantsWaitForSocket = true;
                     errno = EAGAIN;
                     return;
                 }
@@ -571,10 +671,7 @@ void SshSession::processState()
                     //       docs/profiles.md
                     int const rc = libssh2_channel_request_auth_agent(_p->sshChannel);
                     if (rc == LIBSSH2_ERROR_EAGAIN)
-                    {
-                        _p->wantsWaitForSocket = true;
                         return;
-                    }
 
                     if (rc != LIBSSH2_ERROR_NONE)
                         logError("Failed to request auth agent forwarding. {}", libssl2ErrorString(rc));
@@ -606,6 +703,9 @@ void SshSession::processState()
                     setState(State::Failure);
                     return;
                 }
+                // From now on, reads and writes are multiplexed over the socket without blocking.
+                _p->transport->sessions.push_back(this);
+                _p->transport->updateBlockingMode();
                 auto const _ = std::lock_guard { _injectMutex };
                 setState(State::Operational);
                 _injectCV.notify_all();
@@ -635,9 +735,23 @@ void SshSession::start()
             "Starting SSH session to host: {}@{}:{}", _config.username, _config.hostname, _config.port);
 
     assert(_state == State::Initial);
-    // auto const _ = std::lock_guard { _mutex };
-    setState(State::Started);
+
+    if (auto transport = findTransport(transportKey(_config)))
+    {
+        logInfoWithInject("Reusing existing SSH connection to {}.", transportKey(_config));
+        _p->transport = std::move(transport);
+        setState(State::OpenChannel);
+    }
+    else
+    {
+        _p->transport = std::make_shared<SshTransport>();
+        setState(State::Started);
+    }
+
+    auto const _ = std::lock_guard { _p->transport->mutex };
     processState();
+    _p->transport->updateBlockingMode();
+    wakeupSiblings();
 
     /*
         if (!_p->sshClient.connect(_host, _port))
@@ -683,21 +797,26 @@ PtySlave& SshSession::slave() noexcept
 void SshSession::close()
 {
     setState(State::Closed);
+    wakeupReader();
 
-    if (_p->sshChannel)
-    {
-        libssh2_channel_send_eof(_p->sshChannel);
-        libssh2_channel_close(_p->sshChannel);
-        libssh2_channel_wait_closed(_p->sshChannel);
-    }
+    if (!_p->sshChannel)
+        return;
 
-    if (_p->sshSocket.is_open())
-        _p->sshSocket.close();
+    // Only this session's channel is closed, as the connection may still be used by other sessions.
+    auto const _ = std::lock_guard { _p->transport->mutex };
+    std::erase(_p->transport->sessions, this);
+    libssh2_session_set_blocking(_p->transport->sshSession, 1);
+    libssh2_channel_send_eof(_p->sshChannel);
+    libssh2_channel_close(_p->sshChannel);
+    libssh2_channel_wait_closed(_p->sshChannel);
+    _p->transport->updateBlockingMode();
+    wakeupSiblings();
 }
 
 bool SshSession::isClosed() const noexcept
 {
-    return _p->sshSocket.is_closed() || _state == State::Closed || _state == State::Failure;
+    return !_p->transport || _p->transport->sshSocket.is_closed() || _state == State::Closed
+           || _state == State::Failure;
 }
 
 void SshSession::waitForClosed()
@@ -711,7 +830,9 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
                                                        size_t size)
 {
     auto injectLock = std::unique_lock { _injectMutex };
-    _injectCV.wait(injectLock, [this]() { return _state == State::Operational || !_injectedRead.empty(); });
+    _injectCV.wait(injectLock, [this]() {
+        return _state == State::Operational || _state == State::ResizeScreen || !_injectedRead.empty();
+    });
 
     if (!_injectedRead.empty())
     {
@@ -721,6 +842,7 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
         return ReadResult { .data = std::string_view { storage.hotEnd(), nread },
                             .fromStdoutFastPipe = false };
     }
+    injectLock.unlock();
 
     if (_state == State::AuthenticatePasswordWaitForInput)
     {
@@ -729,23 +851,40 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
     }
 
     // Below is for state: Operational
+    if (auto result = readChannel(storage, size); result || errno != EAGAIN)
+        return result;
+
+    waitForSocket(timeout);
+    return readChannel(storage, size);
+}
+
+std::optional<SshSession::ReadResult> SshSession::readChannel(crispy::buffer_object<char>& storage,
+                                                              size_t size)
+{
+    auto const _ = std::lock_guard { _p->transport->mutex };
+    auto const wakeup = crispy::finally([this]() { wakeupSiblings(); });
+
+    // Continue a pending screen resize request, if any.
     processState();
 
-    if (_state != State::Operational && !isClosed())
+    if (_state != State::Operational)
     {
-        errno = EAGAIN;
-        _p->wantsWaitForSocket = true;
+        errno = isClosed() ? EIO : EAGAIN;
         return std::nullopt;
     }
 
-    waitForSocket(timeout);
-    // auto _ = std::unique_lock { _mutex };
-    auto const rc =
-        libssh2_channel_read(_p->sshChannel, storage.hotEnd(), std::min(storage.bytesAvailable(), size));
+    flushOutbound();
+    if (_state == State::Failure)
+    {
+        errno = EIO;
+        return std::nullopt;
+    }
+
+    auto const rc = libssh2_channel_read(
+        _p->sshChannel, storage.hotEnd(), _p->transport->quantum(std::min(storage.bytesAvailable(), size)));
 
     if (rc == LIBSSH2_ERROR_EAGAIN)
     {
-        _p->wantsWaitForSocket = true;
         errno = EAGAIN;
         return std::nullopt;
     }
@@ -753,6 +892,8 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
     if (rc < 0)
     {
         logError("Failed to read from SSH channel. {}", libssl2ErrorString(rc));
+        if (rc != LIBSSH2_ERROR_CHANNEL_CLOSED)
+            _p->transport->reusable = false;
         errno = EIO;
         return std::nullopt;
     }
@@ -766,13 +907,23 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
     return ReadResult { .data = target, .fromStdoutFastPipe = isStdFastPipe };
 }
 
+void SshSession::wakeupSiblings()
+{
+    for (auto* session: _p->transport->sessions)
+        if (session != this && libssh2_poll_channel_read(session->_p->sshChannel, 0))
+            session->wakeupReader();
+}
+
 void SshSession::wakeupReader()
 {
+#if !defined(_WIN32)
+    if (_p->wakeupPipe.good())
+        (void) ::write(_p->wakeupPipe.writer(), "x", 1);
+#else
     // TODO: implement
     //
-    // wakeupReader() is invoked in TerminalSession's destructor (we could as well just call forceClose()
-    // there, which would first wake-up a potential read()-call, if necessary.
-    // And it's called in Terminal twice, where I am currently not sure that we even still need these calls.
+    // On Windows, a blocking read() is only interrupted by its timeout or incoming data.
+#endif
 }
 
 void SshSession::handlePreAuthenticationPasswordInput(std::string_view buf, State next)
@@ -788,8 +939,11 @@ void SshSession::handlePreAuthenticationPasswordInput(std::string_view buf, Stat
     }
     else if (buf == "\r" || buf == "\n") // enter
     {
+        auto const _ = std::lock_guard { _p->transport->mutex };
         setState(next);
         processState();
+        _p->transport->updateBlockingMode();
+        wakeupSiblings();
     }
     else
     {
@@ -799,10 +953,9 @@ void SshSession::handlePreAuthenticationPasswordInput(std::string_view buf, Stat
 
 int SshSession::write(std::string_view buf)
 {
-    // auto const _ = std::lock_guard { _mutex };
     if (isClosed())
     {
-        errno = EPIPE;
+        errno = _state == State::Failure ? EIO : EPIPE;
         return -1;
     }
 
@@ -816,41 +969,77 @@ int SshSession::write(std::string_view buf)
         handlePreAuthenticationPasswordInput(buf, State::AuthenticatePrivateKey);
         return static_cast<int>(buf.size()); // Make the caller believe that we have written all bytes.
     }
-    else if (_state != State::Operational)
+    else if (_state != State::Operational && _state != State::ResizeScreen)
     {
         sshLog()("Ignoring write() call in state: {}", _state);
         return static_cast<int>(buf.size()); // Make the caller believe that we have written all bytes.
     }
 
-    waitForSocket();
-    auto const rv = libssh2_channel_write(_p->sshChannel, buf.data(), buf.size());
+    // Writes are queued and sent without waiting for the socket, so that subsequent writes are
+    // pipelined with each other and with reads, rather than each one waiting for the previous.
+    auto const _ = std::lock_guard { _p->transport->mutex };
+    auto const wakeup = crispy::finally([this]() { wakeupSiblings(); });
 
-    if (rv == LIBSSH2_ERROR_EAGAIN)
+    auto const available = MaxOutboundSize - std::min(_p->outbound.size(), MaxOutboundSize);
+    auto const accepted = std::min(buf.size(), available);
+    if (accepted == 0)
     {
-        _p->wantsWaitForSocket = true;
         errno = EAGAIN;
         return -1;
     }
 
-    if (rv < 0)
+    _p->outbound += buf.substr(0, accepted);
+    flushOutbound();
+    if (_state == State::Failure)
     {
-        logError("Failed to write to SSH channel. {}", libssl2ErrorString(rv));
         errno = EIO;
         return -1;
     }
 
-    if (ptyOutLog)
+    // Writing may pull this channel's inbound data off the socket, which the reader is then not
+    // notified about by the socket anymore. Also have the reader wait for the socket to become
+    // writable, to send the remainder.
+    if (!_p->outbound.empty() || libssh2_poll_channel_read(_p->sshChannel, 0))
+        wakeupReader();
+
+    return static_cast<int>(accepted);
+}
+
+void SshSession::flushOutbound()
+{
+    if (_state != State::Operational)
+        return;
+
+    auto budget = _p->transport->quantum(_p->outbound.size());
+    while (!_p->outbound.empty() && budget > 0)
     {
-        if (rv >= 0)
-            ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf.data(), buf.data() + rv));
+        // libssh2 requires to be called with the same data again after LIBSSH2_ERROR_EAGAIN,
+        // which is guaranteed by only removing the bytes that have been accepted.
+        auto const rv =
+            libssh2_channel_write(_p->sshChannel, _p->outbound.data(), std::min(_p->outbound.size(), budget));
 
-        if (0 <= rv && static_cast<size_t>(rv) < buf.size())
-            ptyOutLog()("Partial write. {} bytes written and {} bytes left.",
-                        rv,
-                        buf.size() - static_cast<size_t>(rv));
-    }
+        if (rv == LIBSSH2_ERROR_EAGAIN)
+            return;
+
+        if (rv < 0)
+        {
+            // The queued bytes cannot be delivered anymore, so fail rather than silently dropping them.
+            logError("Failed to write to SSH channel. {}", libssl2ErrorString(rv));
+            if (rv != LIBSSH2_ERROR_CHANNEL_CLOSED)
+                _p->transport->reusable = false;
+            _p->outbound.clear();
+            setState(State::Failure);
+            wakeupReader();
+            return;
+        }
+
+        if (ptyOutLog)
+            ptyOutLog()("Sending bytes: \"{}\"",
+                        crispy::escape(std::string_view(_p->outbound).substr(0, static_cast<size_t>(rv))));
 
-    return static_cast<int>(rv);
+        _p->outbound.erase(0, static_cast<size_t>(rv));
+        budget -= std::min(budget, static_cast<size_t>(rv));
+    }
 }
 
 PageSize SshSession::pageSize() const noexcept
@@ -860,8 +1049,6 @@ PageSize SshSession::pageSize() const noexcept
 
 void SshSession::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
 {
-    // auto const _ = std::lock_guard { _mutex };
-
     _pageSize = cells;
     _pixels = pixels;
 
@@ -869,8 +1056,10 @@ void SshSession::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
 
     if (isOperational())
     {
+        auto const _ = std::lock_guard { _p->transport->mutex };
         setState(State::ResizeScreen);
         processState();
+        wakeupSiblings();
     }
 }
 
@@ -990,11 +1179,19 @@ bool SshSession::connect(std::string_view host, int port)
                     break;
             }
 
-            _p->sshSocket = socket_handle::from_native(
+            _p->transport->sshSocket = socket_handle::from_native(
                 socket(addrEntry->ai_family, addrEntry->ai_socktype, addrEntry->ai_protocol));
 
-            if (::connect(_p->sshSocket, addrEntry->ai_addr, addrEntry->ai_addrlen) == 0)
+            if (::connect(_p->transport->sshSocket, addrEntry->ai_addr, addrEntry->ai_addrlen) == 0)
             {
+                // Do not delay small writes (such as key presses) until previous ones are acknowledged.
+                auto const noDelay = 1;
+                setsockopt(_p->transport->sshSocket,
+                           IPPROTO_TCP,
+                           TCP_NODELAY,
+                           reinterpret_cast<char const*>(&noDelay),
+                           sizeof(noDelay));
+
                 auto const addrAndPort =
                     port == 22 ? std::string(addrStr) : std::format("{}:{}", addrStr, port);
                 if (host != addrStr)
@@ -1015,7 +1212,7 @@ bool SshSession::connect(std::string_view host, int port)
     }
 
     logError("Failed to connect to {}:{}", host, port);
-    _p->sshSocket.close(); // Explicitly close socket, to indicate that we're not connected
+    _p->transport->sshSocket.close(); // Explicitly close socket, to indicate that we're not connected
     return false;
 }
 
@@ -1027,7 +1224,7 @@ bool SshSession::verifyHostKey()
         return true;
     }
 
-    LIBSSH2_KNOWNHOSTS* knownHosts = libssh2_knownhost_init(_p->sshSession);
+    LIBSSH2_KNOWNHOSTS* knownHosts = libssh2_knownhost_init(_p->transport->sshSession);
     if (!knownHosts)
     {
         logError("Failed to initialize known_hosts file.");
@@ -1047,7 +1244,7 @@ bool SshSession::verifyHostKey()
 
     int hostkeyType = 0;
     size_t hostkeyLength = 0;
-    char const* hostkeyRaw = libssh2_session_hostkey(_p->sshSession, &hostkeyLength, &hostkeyType);
+    char const* hostkeyRaw = libssh2_session_hostkey(_p->transport->sshSession, &hostkeyLength, &hostkeyType);
     int knownhostType = LIBSSH2_KNOWNHOST_KEY_UNKNOWN;
     switch (hostkeyType)
     {
@@ -1127,7 +1324,7 @@ void SshSession::logErrorWithDetails(int libssl2ErrorCode, std::string_view mess
 {
     char* errorMessageBuffer = nullptr;
     int errorMessageLength = 0;
-    libssh2_session_last_error(_p->sshSession, &errorMessageBuffer, &errorMessageLength, 0);
+    libssh2_session_last_error(_p->transport->sshSession, &errorMessageBuffer, &errorMessageLength, 0);
     auto libssl2Message = std::string_view { errorMessageBuffer, static_cast<size_t>(errorMessageLength) };
 
     logError("{}: {}", message, libssl2ErrorString(libssl2ErrorCode));
@@ -1136,65 +1333,47 @@ void SshSession::logErrorWithDetails(int libssl2ErrorCode, std::string_view mess
 
 int SshSession::waitForSocket(std::optional<std::chrono::milliseconds> timeout)
 {
-    if (!_p->wantsWaitForSocket)
-        return 0;
-
-    _p->wantsWaitForSocket = false;
-
-#if defined(SSH_SESSION_NB_IO)
-    fd_set fd;
-    fd_set* writefd = nullptr;
-    fd_set* readfd = nullptr;
-
-    auto tv = timeval {};
-    if (timeout)
-    {
-        tv.tv_sec = timeout->count() / 1000;
-        tv.tv_usec = (timeout->count() % 1000) * 1000;
-    }
-
-    // TODO: also watch for break signal, so we can abort waiting for socket
-
-    FD_ZERO(&fd);
-    FD_SET(_p->sshSocket, &fd);
+    auto const directions = [&]() {
+        auto const _ = std::lock_guard { _p->transport->mutex };
+        auto directions = libssh2_session_block_directions(_p->transport->sshSession);
+        if (!_p->outbound.empty())
+            directions |= LIBSSH2_SESSION_BLOCK_OUTBOUND;
+        return directions;
+    }();
+
+    // The socket is always watched for inbound data, as that is what the reader is waiting for.
+    auto fds = std::array<pollfd, 2> {};
+    auto fdCount = 1;
+    fds[0].fd = _p->transport->sshSocket;
+    fds[0].events =
+        static_cast<short>((directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) ? (POLLIN | POLLOUT) : POLLIN);
 
-    assert(_p->sshSession);
-
-    auto const dir =
-        libssh2_session_block_directions(_p->sshSession); // now make sure we wait in the correct direction
+#if defined(_WIN32)
+    auto const rc = WSAPoll(fds.data(), fdCount, timeout ? static_cast<int>(timeout->count()) : -1);
+#else
+    fds[1].fd = _p->wakeupPipe.reader();
+    fds[1].events = POLLIN;
+    ++fdCount;
 
-    if (dir & LIBSSH2_SESSION_BLOCK_INBOUND)
-    {
-        readfd = &fd;
-        std::cout << std::format("({}) SshSession: waiting for socket to become readable\n",
-                                 crispy::threadName());
-    }
+    auto const rc = ::poll(fds.data(), fdCount, timeout ? static_cast<int>(timeout->count()) : -1);
 
-    if (dir & LIBSSH2_SESSION_BLOCK_OUTBOUND)
+    if (rc > 0 && (fds[1].revents & POLLIN))
     {
-        writefd = &fd;
-        std::cout << std::format("({}) SshSession: waiting for socket to become readable\n",
-                                 crispy::threadName());
+        // Drain the pipe.
+        char buf[256];
+        while (::read(_p->wakeupPipe.reader(), buf, sizeof(buf)) > 0)
+            ;
     }
+#endif
 
-    auto const rc = ::select((int) (_p->sshSocket + 1), readfd, writefd, nullptr, timeout ? &tv : nullptr);
-    std::cout << std::format("({}) SshSession: select() returned {}{}{}\n",
-                             crispy::threadName(),
-                             rc,
-                             readfd && FD_ISSET(_p->sshSocket, readfd) ? " [readable]" : "",
-                             writefd && FD_ISSET(_p->sshSocket, writefd) ? " [writable]" : "");
     return rc;
-#else
-    crispy::ignore_unused(timeout);
-    return 0;
-#endif
 }
 
 void SshSession::authenticateWithPrivateKey()
 {
     auto const password = _injectedWrite;
     auto const rc = libssh2_userauth_publickey_fromfile_ex(
-        _p->sshSession,
+        _p->transport->sshSession,
         _config.username.data(),
         _config.username.size(),
         _config.publicKeyFile.empty() ? nullptr : _config.publicKeyFile.string().data(),
@@ -1202,10 +1381,7 @@ void SshSession::authenticateWithPrivateKey()
         password.data());
 
     if (rc == LIBSSH2_ERROR_EAGAIN)
-    {
-        _p->wantsWaitForSocket = true;
         return;
-    }
 
     injectRead("\r\n");
     _injectedWrite.clear();
@@ -1238,7 +1414,7 @@ void SshSession::authenticateWithPassword()
     auto const password = std::move(_injectedWrite);
     _injectedWrite = {};
 
-    int const rc = libssh2_userauth_password_ex(_p->sshSession,
+    int const rc = libssh2_userauth_password_ex(_p->transport->sshSession,
                                                 _config.username.data(),
                                                 _config.username.size(),
                                                 password.data(),
@@ -1246,10 +1422,7 @@ void SshSession::authenticateWithPassword()
                                                 nullptr);
 
     if (rc == LIBSSH2_ERROR_EAGAIN)
-    {
-        _p->wantsWaitForSocket = true;
         return;
-    }
 
     injectRead("\r\n");
 
@@ -1273,23 +1446,23 @@ void SshSession::authenticateWithPassword()
 
 bool SshSession::authenticateWithAgent()
 {
-    if (!_p->sshAgent)
+    if (!_p->transport->sshAgent)
     {
-        _p->sshAgent = libssh2_agent_init(_p->sshSession);
-        if (!_p->sshAgent)
+        _p->transport->sshAgent = libssh2_agent_init(_p->transport->sshSession);
+        if (!_p->transport->sshAgent)
         {
             logError("Failed to initialize SSH agent.");
             return false;
         }
 
-        int rc = libssh2_agent_connect(_p->sshAgent);
+        int rc = libssh2_agent_connect(_p->transport->sshAgent);
         if (rc != LIBSSH2_ERROR_NONE)
         {
             logError("Failed to connect to SSH agent. {}", libssl2ErrorString(rc));
             return false;
         }
 
-        rc = libssh2_agent_list_identities(_p->sshAgent);
+        rc = libssh2_agent_list_identities(_p->transport->sshAgent);
         if (rc != LIBSSH2_ERROR_NONE)
         {
             logError("Failed to list SSH identities. {}", libssl2ErrorString(rc));
@@ -1303,7 +1476,7 @@ bool SshSession::authenticateWithAgent()
     libssh2_agent_publickey* prevIdentity = nullptr;
     int rc = 0;
     int i = 0;
-    while ((rc = libssh2_agent_get_identity(_p->sshAgent, &identity, prevIdentity)) == 0)
+    while ((rc = libssh2_agent_get_identity(_p->transport->sshAgent, &identity, prevIdentity)) == 0)
     {
         prevIdentity = identity;
         if (i < _walkIndex)
@@ -1312,10 +1485,9 @@ bool SshSession::authenticateWithAgent()
             continue;
         }
 
-        rc = libssh2_agent_userauth(_p->sshAgent, _config.username.data(), identity);
+        rc = libssh2_agent_userauth(_p->transport->sshAgent, _config.username.data(), identity);
         if (rc == LIBSSH2_ERROR_EAGAIN)
         {
-            _p->wantsWaitForSocket = true;
             _walkIndex = i;
             return false;
         }
@@ -28,6 +28,7 @@ struct SshHostConfig
     std::filesystem::path publicKeyFile;
     std::filesystem::path knownHostsFile;
     bool forwardAgent = false;
+    bool compression = false;
     Environment env;
 
     [[nodiscard]] std::string toString() const;
@@ -40,6 +41,10 @@ crispy::result<SshHostConfigMap> loadSshConfig(std::filesystem::path const& conf
 crispy::result<SshHostConfigMap> loadSshConfig();
 
 /// SSH Login session.
+///
+/// Sessions to the same host, port and user share one authenticated SSH connection,
+/// each running its shell on a separate channel. Only the first session to a host pays for
+/// connecting, the key exchange, host key verification and authentication.
 class SshSession final: public Pty
 {
   public:
@@ -97,7 +102,8 @@ class SshSession final: public Pty
         Closed,                             // connection closed by peer or us
     };
 
-    // Wait for the socket to become readable and/or writable.
+    /// Waits for the socket to become readable, or writable if libssh2 or pending writes require so,
+    /// or for wakeupReader() to be invoked.
     int waitForSocket(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
 
   private:
@@ -113,6 +119,19 @@ class SshSession final: public Pty
     void injectRead(std::string_view buf);
     void injectWrite(std::string_view buf);
 
+    // Reads from the SSH channel without blocking, after flushing pending writes.
+    std::optional<ReadResult> readChannel(crispy::buffer_object<char>& storage, size_t size);
+
+    // Any libssh2 call on the shared connection may pull data for other sessions' channels off
+    // the socket, which their readers are then not notified about by the socket anymore.
+    // Must therefore be called after libssh2 calls, with the connection's mutex still held.
+    void wakeupSiblings();
+
+    // Writes as much of the outbound queue to the SSH channel as possible without blocking.
+    // On a write error, the session fails, making subsequent writes fail with EIO.
+    // Must be called with the connection's mutex held.
+    void flushOutbound();
+
     // Handles each individual states.
     void processState();
 
@@ -152,7 +171,6 @@ class SshSession final: public Pty
     PageSize _pageSize { .lines = LineCount(24), .columns = ColumnCount(80) };
     std::optional<ImageSize> _pixels = std::nullopt;
     std::unique_ptr<PtySlave> _ptySlave;
-    std::mutex _mutex;
 
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> _p;
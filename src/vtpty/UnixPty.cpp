@@ -8,6 +8,8 @@
 #include <crispy/escape.h>
 #include <crispy/logstore.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <csignal>
 #include <cstddef>
@@ -33,6 +35,7 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 
 #include <pwd.h>
@@ -57,6 +60,11 @@ namespace vtpty
 
 namespace
 {
+#if defined(__linux__)
+    // Size of the stdout fastpipe's kernel buffer, which equals the default pipe-max-size on Linux.
+    constexpr int StdoutFastPipeSize = 1024 * 1024;
+#endif
+
     UnixPty::PtyHandles createUnixPty(PageSize const& windowSize, optional<ImageSize> pixels)
     {
         // See https://code.woboq.org/userspace/glibc/login/forkpty.c.html
@@ -221,6 +229,13 @@ void UnixPty::start()
     util::setFileFlags(_stdoutFastPipe.reader(), O_NONBLOCK);
     ptyLog()("stdout fastpipe: reader {}, writer {}", _stdoutFastPipe.reader(), _stdoutFastPipe.writer());
 
+#if defined(__linux__)
+    // Let bulk writers to the stdout fastpipe block less often. This may fail for unprivileged
+    // processes if exceeding /proc/sys/fs/pipe-max-size, in which case the default size is kept.
+    if (fcntl(_stdoutFastPipe.writer(), F_SETPIPE_SZ, StdoutFastPipeSize) < 0)
+        ptyLog()("Failed to resize stdout fastpipe to {} bytes. {}", StdoutFastPipeSize, strerror(errno));
+#endif
+
     _readSelector.want_read(_masterFd);
     _readSelector.want_read(_stdoutFastPipe.reader());
 
@@ -288,6 +303,8 @@ optional<string_view> UnixPty::readSome(int fd, char* target, size_t n) noexcept
     if (rv == 0 && fd == _stdoutFastPipe.reader())
     {
         ptyInLog()("Closing stdout-fastpipe.");
+        if (_drainingFd == fd)
+            _drainingFd = nullopt;
         _readSelector.cancel_read(fd);
         _stdoutFastPipe.closeReader();
         errno = EAGAIN;
@@ -303,11 +320,35 @@ std::optional<Pty::ReadResult> UnixPty::read(crispy::buffer_object<char>& storag
 {
     assert(_readSelector.size() > 0);
 
+    auto const l = scoped_lock { storage };
+    auto const n = std::min(size, storage.bytesAvailable());
+
+    // While bulk data is flowing, keep reading from the same file descriptor until it would block,
+    // instead of waiting for it to become readable on every call.
+    if (_drainingFd && _drainingReads < MaxDrainingReads)
+    {
+        auto const fd = *_drainingFd;
+        ++_drainingReads;
+        if (auto x = readSome(fd, storage.hotEnd(), n))
+        {
+            if (x->size() < n)
+                _drainingFd = nullopt;
+            return ReadResult { .data = x.value(), .fromStdoutFastPipe = fd == _stdoutFastPipe.reader() };
+        }
+        if (errno != EAGAIN && errno != EINTR)
+            return std::nullopt;
+    }
+    _drainingFd = nullopt;
+    _drainingReads = 0;
+
     if (auto const fd = _readSelector.wait_one(timeout); fd.has_value())
     {
-        auto const l = scoped_lock { storage };
-        if (auto x = readSome(*fd, storage.hotEnd(), std::min(size, storage.bytesAvailable())))
+        if (auto x = readSome(*fd, storage.hotEnd(), n))
+        {
+            if (!x->empty() && x->size() == n)
+                _drainingFd = *fd;
             return ReadResult { .data = x.value(), .fromStdoutFastPipe = *fd == _stdoutFastPipe.reader() };
+        }
     }
     else
         errno = EAGAIN;
@@ -349,9 +390,45 @@ int UnixPty::write(std::string_view data)
         }
     }
 
+    errno = savedErrno;
+    return static_cast<int>(rv);
+}
+
+int UnixPty::writev(std::span<std::string_view const> buffers)
+{
+    auto iov = std::array<iovec, 64> {};
+    auto const count = std::min(buffers.size(), iov.size());
+    for (size_t i = 0; i < count; ++i)
+        iov[i] = iovec { .iov_base = const_cast<char*>(buffers[i].data()), .iov_len = buffers[i].size() };
+
+    ssize_t const rv = ::writev(_masterFd, iov.data(), static_cast<int>(count));
+    auto const savedErrno = errno; // for the caller to tell whether to retry
+    if (ptyOutLog)
+    {
+        if (rv < 0)
+            ptyOutLog()("PTY write of {} buffers failed. {}\n", count, strerror(errno));
+        else
+        {
+            auto remaining = static_cast<size_t>(rv);
+            for (size_t i = 0; i < count && remaining > 0; ++i)
+            {
+                auto const n = std::min(remaining, buffers[i].size());
+                ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(buffers[i].substr(0, n)));
+                remaining -= n;
+            }
+        }
+    }
+
     return static_cast<int>(rv);
 }
 
+std::optional<PtyHandle> UnixPty::writeNotificationHandle() const noexcept
+{
+    if (!started())
+        return std::nullopt;
+    return static_cast<PtyHandle>(_masterFd.get());
+}
+
 PageSize UnixPty::pageSize() const noexcept
 {
     return _pageSize;
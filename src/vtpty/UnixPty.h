@@ -63,6 +63,8 @@ class UnixPty final: public Pty
                                                  std::optional<std::chrono::milliseconds> timeout,
                                                  size_t size) override;
     int write(std::string_view data) override;
+    int writev(std::span<std::string_view const> buffers) override;
+    [[nodiscard]] std::optional<PtyHandle> writeNotificationHandle() const noexcept override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
     void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
 
@@ -80,6 +82,13 @@ class UnixPty final: public Pty
     std::optional<ImageSize> _pixels;
     std::unique_ptr<Slave> _slave;
     std::mutex _mutex;
+
+    // File descriptor whose previous read filled the caller's buffer completely, and thus most
+    // likely has more data pending. It is read from directly, bypassing the read selector,
+    // at most MaxDrainingReads times in a row, to not starve the other file descriptors.
+    static constexpr int MaxDrainingReads = 16;
+    std::optional<int> _drainingFd;
+    int _drainingReads = 0;
 };
 
 } // namespace vtpty
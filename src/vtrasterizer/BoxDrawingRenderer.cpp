@@ -9,9 +9,15 @@
 #include <range/v3/view/iota.hpp>
 #include <range/v3/view/zip.hpp>
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
 #include <cstdint>
 #include <format>
+#include <limits>
+#include <ostream>
+#include <utility>
 
 using namespace std::string_view_literals;
 
@@ -49,14 +55,182 @@ namespace
         auto const pitch = cellSize.width.as<size_t>();
         auto const height = cellSize.height.as<size_t>();
 
-        for (size_t i = 0; i < cellSize.height.as<size_t>(); ++i)
+        for (size_t i = 0; i < height; ++i)
+            std::copy_n(image.begin() + static_cast<ptrdiff_t>((height - i - 1u) * pitch),
+                        pitch,
+                        dest.begin() + static_cast<ptrdiff_t>(i * pitch));
+        return dest;
+    }
+
+    // Fills the rectangle of the given row-major image with full intensity, one row span at a time.
+    void fillRows(
+        atlas::Buffer& image, unsigned pitch, unsigned x0, unsigned y0, unsigned width, unsigned height)
+    {
+        for (auto y = y0; y < y0 + height; ++y)
+            std::fill_n(image.begin() + static_cast<ptrdiff_t>((y * pitch) + x0), width, 0xFF);
+    }
+
+    struct CodepointRange
+    {
+        char32_t first;
+        char32_t last;
+    };
+
+    // The codepoints that are rendered by the BoxDrawingRenderer, in ascending order.
+    // clang-format off
+    constexpr auto Repertoire = std::array {
+        CodepointRange { 0x23A1, 0x23A6 },   // mathematical square brackets
+        CodepointRange { 0x2500, 0x2590 },   // box drawing, block elements
+        CodepointRange { 0x2594, 0x259F },   // Terminal graphic characters
+        CodepointRange { 0x2800, 0x28FF },   // Braille patterns
+        CodepointRange { 0xE0B0, 0xE0B0 },   // 
+        CodepointRange { 0xE0B2, 0xE0B2 },   // 
+        CodepointRange { 0xE0B4, 0xE0B4 },   // 
+        CodepointRange { 0xE0B6, 0xE0B6 },   // 
+        CodepointRange { 0xE0BA, 0xE0BA },   // 
+        CodepointRange { 0xE0BC, 0xE0BC },   // 
+        CodepointRange { 0xE0BE, 0xE0BE },   // 
+        CodepointRange { 0xEE00, 0xEE05 },   // progress bar (Fira Code)
+        CodepointRange { 0x1FB00, 0x1FBAF }, // more block sextants
+        CodepointRange { 0x1FBF0, 0x1FBF9 }, // digits
+    };
+    // clang-format on
+
+    constexpr uint32_t computeRepertoireSize() noexcept
+    {
+        uint32_t count = 0;
+        for (CodepointRange const range: Repertoire)
+            count += static_cast<uint32_t>(range.last - range.first + 1);
+        return count;
+    }
+
+    constexpr auto RepertoireSize = computeRepertoireSize();
+    static_assert(RepertoireSize == 618);
+    static_assert(Repertoire.front().first == BoxDrawingRenderer::FirstRenderableCodepoint);
+
+    // {{{ compile-time repertoire index
+    // The repertoire is indexed in blocks of 256 codepoints. Each block that contains
+    // renderable codepoints carries a bitmap of them, along with the number of
+    // renderable codepoints preceding each bitmap word, so that a codepoint's
+    // direct mapping index is computed from its offset to the block base.
+    constexpr auto BlockShift = 8;
+    constexpr char32_t BlockMask = (1 << BlockShift) - 1;
+    constexpr char32_t RepertoireEnd = 0x20000; // exclusive upper bound of the repertoire's codepoints
+    constexpr uint8_t NoBlock = 0xFF;
+
+    static_assert(Repertoire.back().last < RepertoireEnd);
+
+    struct RepertoireBlock
+    {
+        std::array<uint64_t, 4> bits {};
+        std::array<uint16_t, 4> rank {}; // number of renderable codepoints in the preceding words
+        uint32_t directMappingBase = 0;
+    };
+
+    constexpr size_t countRepertoireBlocks() noexcept
+    {
+        size_t count = 0;
+        auto lastBlock = std::optional<char32_t> {};
+        for (CodepointRange const range: Repertoire)
         {
-            for (size_t j = 0; j < cellSize.width.as<size_t>(); ++j)
+            for (auto block = range.first >> BlockShift; block <= range.last >> BlockShift; ++block)
             {
-                dest[(i * pitch) + j] = image[((height - i - 1u) * pitch) + j];
+                if (lastBlock != block)
+                    ++count;
+                lastBlock = block;
             }
         }
-        return dest;
+        return count;
+    }
+
+    struct RepertoireIndex
+    {
+        std::array<uint8_t, (RepertoireEnd >> BlockShift)> blockOf {}; // block index or NoBlock
+        std::array<RepertoireBlock, countRepertoireBlocks()> blocks {};
+    };
+
+    constexpr RepertoireIndex buildRepertoireIndex() noexcept
+    {
+        auto index = RepertoireIndex {};
+        for (auto& blockIndex: index.blockOf)
+            blockIndex = NoBlock;
+
+        // Repertoire is sorted, hence blocks are created in ascending order.
+        uint8_t blockCount = 0;
+        for (CodepointRange const range: Repertoire)
+        {
+            for (auto codepoint = range.first; codepoint <= range.last; ++codepoint)
+            {
+                auto& blockIndex = index.blockOf[codepoint >> BlockShift];
+                if (blockIndex == NoBlock)
+                    blockIndex = blockCount++;
+                auto const offset = codepoint & BlockMask;
+                index.blocks[blockIndex].bits[offset / 64] |= uint64_t(1) << (offset % 64);
+            }
+        }
+
+        uint32_t directMappingBase = 0;
+        for (RepertoireBlock& block: index.blocks)
+        {
+            block.directMappingBase = directMappingBase;
+            uint16_t rank = 0;
+            for (size_t word = 0; word < block.bits.size(); ++word)
+            {
+                block.rank[word] = rank;
+                rank += static_cast<uint16_t>(std::popcount(block.bits[word]));
+            }
+            directMappingBase += rank;
+        }
+
+        return index;
+    }
+
+    constexpr auto RepertoireLookup = buildRepertoireIndex();
+
+    // Maps a codepoint of the repertoire to its index within the repertoire.
+    constexpr optional<uint32_t> toDirectMappingIndex(char32_t codepoint) noexcept
+    {
+        if (codepoint >= RepertoireEnd)
+            return nullopt;
+
+        auto const blockIndex = RepertoireLookup.blockOf[codepoint >> BlockShift];
+        if (blockIndex == NoBlock)
+            return nullopt;
+
+        RepertoireBlock const& block = RepertoireLookup.blocks[blockIndex];
+        auto const offset = codepoint & BlockMask;
+        auto const word = block.bits[offset / 64];
+        auto const bit = uint64_t(1) << (offset % 64);
+        if (!(word & bit))
+            return nullopt;
+
+        return block.directMappingBase + block.rank[offset / 64]
+               + static_cast<uint32_t>(std::popcount(word & (bit - 1)));
+    }
+
+    static_assert(toDirectMappingIndex(0x23A1) == 0);
+    static_assert(toDirectMappingIndex(0x2500) == 6);
+    static_assert(toDirectMappingIndex(0x2594) == 6 + 145);
+    static_assert(toDirectMappingIndex(0x1FBF9) == RepertoireSize - 1);
+    static_assert(!toDirectMappingIndex(U'A'));
+    static_assert(!toDirectMappingIndex(0x2591));
+    static_assert(!toDirectMappingIndex(0xE0B1));
+    static_assert(!toDirectMappingIndex(0x10FFFF));
+    // }}}
+
+    int supersamplingFactor()
+    {
+        static int const factor = []() {
+            auto constexpr EnvName = "SSA_FACTOR";
+            auto* const envValue = getenv(EnvName);
+            if (!envValue)
+                return 2;
+            auto const val = atoi(envValue);
+            if (!(val >= 1 && val <= 8))
+                return 1;
+            return val;
+        }();
+        return factor;
     }
 } // namespace
 
@@ -121,10 +295,14 @@ namespace detail
             // The element-array for each y-coordinate represent the x-coordinates that
             // have been written to at that line.
             //
-            // This is needed in order to fill the gaps.
-            using GapFills = std::vector<std::vector<unsigned>>;
-            GapFills gaps;
-            gaps.resize(unbox<size_t>(imageSize.height));
+            // This is needed in order to fill the gaps. Only the outermost written
+            // x-coordinates of each scanline are of interest.
+            struct GapFill
+            {
+                unsigned front = std::numeric_limits<unsigned>::max();
+                unsigned back = 0;
+            };
+            auto gaps = std::vector<GapFill>(unbox<size_t>(imageSize.height));
 
             auto const w = unbox(imageSize.width);
             auto const h = unbox(imageSize.height);
@@ -134,7 +312,8 @@ namespace detail
                 auto const fy = clamp((unsigned) y, 0u, h - 1);
                 auto const fx = clamp((unsigned) x, 0u, w - 1);
                 buffer[(fy * w) + fx] = alpha;
-                gaps[fy].push_back(fx);
+                gaps[fy].front = min(gaps[fy].front, fx);
+                gaps[fy].back = max(gaps[fy].back, fx);
             };
 
             // inner circle
@@ -162,14 +341,8 @@ namespace detail
 
             // fill gap
             for (size_t y = 0; y < gaps.size(); ++y)
-            {
-                if (auto& gap = gaps[y]; !gap.empty())
-                {
-                    std::ranges::sort(gap);
-                    for (auto const xi: iota(gap.front(), gap.back()))
-                        buffer.at((y * unbox<size_t>(imageSize.width)) + xi) = 0xFF;
-                }
-            }
+                if (auto const& gap = gaps[y]; gap.front < gap.back)
+                    fillRows(buffer, w, gap.front, unsigned(y), gap.back - gap.front, 1);
         }
 
         struct ProgressBar
@@ -750,7 +923,7 @@ namespace detail
             for (auto const y: ranges::views::iota(0u, pixmap.size.height.as<unsigned>()))
                 for (auto const x: ranges::views::iota(0u, pixmap.size.width.as<unsigned>()))
                     if (condition(int(x), int(y)))
-                        pixmap.buffer.at((w * (h - y)) + x) = 0xFF;
+                        pixmap.buffer[(w * (h - y)) + x] = 0xFF;
         }
 
         inline atlas::Buffer upperDiagonalMosaic(ImageSize size, Ratio ra, Ratio rb)
@@ -834,6 +1007,30 @@ namespace detail
             return std::move(image);
         }
 
+        // Braille patterns are 2x4 dots, with the pattern's bits 0..7 denoting the dots 1..8.
+        inline atlas::Buffer braille(ImageSize size, char32_t codepoint)
+        {
+            // (column, row) of dots 1..8.
+            constexpr auto DotPositions = std::array<pair<int, int>, 8> {
+                pair { 0, 0 }, pair { 0, 1 }, pair { 0, 2 }, pair { 1, 0 },
+                pair { 1, 1 }, pair { 1, 2 }, pair { 0, 3 }, pair { 1, 3 },
+            };
+
+            auto pixmap = blockElement(size);
+            auto const pattern = static_cast<unsigned>(codepoint - 0x2800);
+            for (size_t dot = 0; dot < DotPositions.size(); ++dot)
+            {
+                if (!(pattern & (1u << dot)))
+                    continue;
+                auto const [column, row] = DotPositions[dot];
+                auto const from = Ratio { .x = (column * (1 / 2_th)) + (1 / 8_th),
+                                          .y = (row * (1 / 4_th)) + (1 / 16_th) };
+                auto const to = Ratio { .x = from.x + (1 / 4_th), .y = from.y + (1 / 8_th) };
+                fillBlock(pixmap.buffer, pixmap.size, from, to, pixmap.filler);
+            }
+            return pixmap.take();
+        }
+
         // }}}
         // {{{ block sextant construction
         template <typename Container, typename T>
@@ -905,24 +1102,76 @@ void BoxDrawingRenderer::setRenderTarget(RenderTarget& renderTarget,
                                          DirectMappingAllocator& directMappingAllocator)
 {
     Renderable::setRenderTarget(renderTarget, directMappingAllocator);
+
+    // The whole repertoire is always direct-mapped, regardless of whether or not
+    // direct mapping is enabled for regular text.
+    auto const directMappingEnabled = std::exchange(directMappingAllocator.enabled, true);
+    _directMapping = directMappingAllocator.allocate(RepertoireSize);
+    directMappingAllocator.enabled = directMappingEnabled;
+
     clearCache();
 }
 
+void BoxDrawingRenderer::setTextureAtlas(TextureAtlas& atlas)
+{
+    Renderable::setTextureAtlas(atlas);
+    initializeDirectMapping();
+}
+
 void BoxDrawingRenderer::clearCache()
 {
     // As we're reusing the upper layer's texture atlas, we do not need
     // to clear here anything. It's done for us already.
 }
 
+void BoxDrawingRenderer::initializeDirectMapping()
+{
+    Require(_textureAtlas);
+    Require(_directMapping.count == RepertoireSize);
+
+    // Rasterizes the whole repertoire up front, as this is invoked only when the
+    // texture atlas is (re)configured, e.g. due to font metric changes.
+    auto const start = std::chrono::steady_clock::now();
+
+    _tileAvailable.assign(RepertoireSize, false);
+    uint32_t directMappingIndex = 0;
+    for (CodepointRange const range: Repertoire)
+    {
+        for (auto codepoint = range.first; codepoint <= range.last; ++codepoint, ++directMappingIndex)
+        {
+            auto const tileIndex = _directMapping.toTileIndex(directMappingIndex);
+            auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
+            if (auto tileData = createTileData(codepoint, tileLocation))
+            {
+                _textureAtlas->setDirectMapping(tileIndex, std::move(*tileData));
+                _tileAvailable[directMappingIndex] = true;
+            }
+        }
+    }
+
+    _initializationTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    boxDrawingLog()("Rasterized {} of {} tiles of size {} in {} us.",
+                    std::ranges::count(_tileAvailable, true),
+                    RepertoireSize,
+                    _gridMetrics.cellSize,
+                    _initializationTime.count());
+}
+
 bool BoxDrawingRenderer::render(vtbackend::LineOffset line,
                                 vtbackend::ColumnOffset column,
                                 char32_t codepoint,
                                 vtbackend::RGBColor color)
 {
-    Renderable::AtlasTileAttributes const* data = getOrCreateCachedTileAttributes(codepoint);
-    if (!data)
+    auto const directMappingIndex = toDirectMappingIndex(codepoint);
+    if (!directMappingIndex || *directMappingIndex >= _tileAvailable.size()
+        || !_tileAvailable[*directMappingIndex])
         return false;
 
+    AtlasTileAttributes const* data =
+        &_textureAtlas->directMapped(_directMapping.toTileIndex(*directMappingIndex));
+
     auto const pos = _gridMetrics.map(line, column);
     auto const x = pos.x;
     auto const y = pos.y;
@@ -966,17 +1215,7 @@ auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation
     atlas::Buffer pixels;
     if (antialiasing)
     {
-        auto const supersamplingFactor = []() {
-            auto constexpr EnvName = "SSA_FACTOR";
-            auto* const envValue = getenv(EnvName);
-            if (!envValue)
-                return 2;
-            auto const val = atoi(envValue);
-            if (!(val >= 1 && val <= 8))
-                return 1;
-            return val;
-        }();
-        auto const supersamplingSize = _gridMetrics.cellSize * supersamplingFactor;
+        auto const supersamplingSize = _gridMetrics.cellSize * supersamplingFactor();
         auto const supersamplingLineThickness = _gridMetrics.underline.thickness * 2;
         auto tmp = buildBoxElements(codepoint, supersamplingSize, supersamplingLineThickness);
         if (!tmp)
@@ -1004,35 +1243,14 @@ auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation
                             FRAGMENT_SELECTOR_GLYPH_ALPHA) };
 }
 
-Renderable::AtlasTileAttributes const* BoxDrawingRenderer::getOrCreateCachedTileAttributes(char32_t codepoint)
+bool BoxDrawingRenderer::inRepertoire(char32_t codepoint) noexcept
 {
-    return textureAtlas().get_or_try_emplace(
-        crispy::strong_hash { 31, 13, 8, static_cast<uint32_t>(codepoint) },
-        [this, codepoint](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
-            return createTileData(codepoint, tileLocation);
-        });
+    return toDirectMappingIndex(codepoint).has_value();
 }
 
-bool BoxDrawingRenderer::renderable(char32_t codepoint) noexcept
+atlas::Buffer BoxDrawingRenderer::buildBraille(char32_t codepoint, ImageSize size)
 {
-    auto const ascending = [codepoint](char32_t a, char32_t b) noexcept -> bool {
-        return a <= codepoint && codepoint <= b;
-    };
-
-    return ascending(0x23A1, 0x23A6)      // mathematical square brackets
-           || ascending(0x2500, 0x2590)   // box drawing, block elements
-           || ascending(0x2594, 0x259F)   // Terminal graphic characters
-           || ascending(0x1FB00, 0x1FBAF) // more block sextants
-           || ascending(0x1FBF0, 0x1FBF9) // digits
-           || ascending(0xEE00, 0xEE05)   // progress bar (Fira Code)
-           || codepoint == 0xE0B0         // 
-           || codepoint == 0xE0B2         // 
-           || codepoint == 0xE0B4         // 
-           || codepoint == 0xE0B6         // 
-           || codepoint == 0xE0BA         // 
-           || codepoint == 0xE0BC         // 
-           || codepoint == 0xE0BE         // 
-        ;
+    return detail::braille(size, codepoint);
 }
 
 optional<atlas::Buffer> BoxDrawingRenderer::buildElements(char32_t codepoint)
@@ -1062,6 +1280,9 @@ optional<atlas::Buffer> BoxDrawingRenderer::buildElements(char32_t codepoint)
             .baseline(_gridMetrics.baseline * AntiAliasingSamplingFactor);
     };
 
+    if (isBraille(codepoint))
+        return buildBraille(codepoint, size);
+
     // TODO: just check notcurses-info to get an idea what may be missing
     // clang-format off
     switch (codepoint)
@@ -1537,10 +1758,8 @@ auto boxDashedHorizontal(auto& dashed, ImageSize size, int lineThickness){
         auto x0 = round(p / 2.0);
         for ([[maybe_unused]] auto const _: iota(0u, dashCount))
         {
-            auto const x0l = static_cast<int>(round(x0));
-            for (auto const y: iota(y0, y0 + w))
-                for (auto const x: iota(x0l, x0l + static_cast<int>(p)))
-                    image[(y * unbox(width)) + unsigned(x)] = 0xFF;
+            auto const x0l = static_cast<unsigned>(round(x0));
+            fillRows(image, unbox(width), x0l, y0, static_cast<unsigned>(p), w);
             x0 += unbox<double>(width) / static_cast<double>(dashCount);
         }
 
@@ -1567,9 +1786,7 @@ auto boxDashedVertical(auto& dashed, ImageSize size, int lineThickness)
     for ([[maybe_unused]] auto const i: iota(0u, dashCount))
     {
         auto const y0l = static_cast<unsigned>(round(y0));
-        for (auto const y: iota(y0l, y0l + static_cast<unsigned>(p)))
-            for (auto const x: iota(x0, x0 + w))
-                image[(y * unbox(width)) + unsigned(x)] = 0xFF;
+        fillRows(image, unbox(width), x0, y0l, w, static_cast<unsigned>(p));
         y0 += unbox<double>(height) / static_cast<double>(dashCount);
     }
 
@@ -1615,10 +1832,8 @@ optional<atlas::Buffer> BoxDrawingRenderer::buildBoxElements(char32_t codepoint,
         auto const right = tuple { box.rightval, *width / 2, *width, false };
         auto const offset = horizontalOffset;
 
-        auto fillImage = [&](auto ymax, auto xmax, auto x0, auto y0){
-            for (auto const yi: iota(0u, ymax))
-                for (auto const xi: iota(0u, xmax))
-                    image[((y0 + yi) * unbox(width)) + x0 + xi] = 0xFF;
+        auto fillImage = [&](unsigned ymax, unsigned xmax, unsigned x0, unsigned y0) {
+            fillRows(image, unbox(width), x0, y0, xmax, ymax);
         };
         for (auto const& pq: { left, right })
         {
@@ -1674,10 +1889,8 @@ optional<atlas::Buffer> BoxDrawingRenderer::buildBoxElements(char32_t codepoint,
         auto const up = tuple { box.downval, 0u, *height / 2, true };
         auto const down = tuple { box.upval, *height / 2, *height, false };
         auto const offset = verticalOffset;
-        auto fillImage = [&](auto ymax, auto xmax, auto x0, auto y0){
-            for (auto const yi: iota(0u, ymax))
-                for (auto const xi: iota(0u, xmax))
-                    image[((y0 + yi) * unbox(width)) + x0 + xi] = 0xFF;
+        auto fillImage = [&](unsigned ymax, unsigned xmax, unsigned x0, unsigned y0) {
+            fillRows(image, unbox(width), x0, y0, xmax, ymax);
         };
         for (auto const& pq: { up, down })
         {
@@ -1749,8 +1962,15 @@ optional<atlas::Buffer> BoxDrawingRenderer::buildBoxElements(char32_t codepoint,
     return image;
 }
 
-void BoxDrawingRenderer::inspect(std::ostream& /*output*/) const
+void BoxDrawingRenderer::inspect(std::ostream& output) const
 {
+    auto const tileCount = std::ranges::count(_tileAvailable, true);
+
+    output << "BoxDrawingRenderer\n";
+    output << "------------------------\n";
+    output << std::format("direct-mapped tiles : {}/{}\n", tileCount, RepertoireSize);
+    output << std::format("rasterization time  : {} us\n", _initializationTime.count());
+    output << '\n';
 }
 
 } // namespace vtrasterizer
@@ -9,6 +9,9 @@
 
 #include <crispy/point.h>
 
+#include <chrono>
+#include <vector>
+
 namespace vtrasterizer
 {
 
@@ -27,9 +30,28 @@ class BoxDrawingRenderer: public Renderable
     explicit BoxDrawingRenderer(GridMetrics const& gridMetrics): Renderable { gridMetrics } {}
 
     void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator) override;
+    void setTextureAtlas(TextureAtlas& atlas) override;
     void clearCache() override;
 
-    [[nodiscard]] static bool renderable(char32_t codepoint) noexcept;
+    /// The lowest codepoint that is rendered by the BoxDrawingRenderer.
+    static constexpr char32_t FirstRenderableCodepoint = 0x23A1;
+
+    /// Tests whether the given codepoint is rendered by the BoxDrawingRenderer.
+    ///
+    /// This is a constant-time lookup, with the bulk of all text being rejected inline.
+    [[nodiscard]] static bool renderable(char32_t codepoint) noexcept
+    {
+        return codepoint >= FirstRenderableCodepoint && inRepertoire(codepoint);
+    }
+
+    /// Tests whether the given codepoint is a Braille pattern (U+2800..U+28FF).
+    [[nodiscard]] static constexpr bool isBraille(char32_t codepoint) noexcept
+    {
+        return 0x2800 <= codepoint && codepoint <= 0x28FF;
+    }
+
+    /// Rasterizes the given Braille pattern into a bottom-up alpha bitmap of the given size.
+    [[nodiscard]] static atlas::Buffer buildBraille(char32_t codepoint, ImageSize size);
 
     /// Renders boxdrawing character.
     ///
@@ -42,7 +64,10 @@ class BoxDrawingRenderer: public Renderable
     void inspect(std::ostream& output) const override;
 
   private:
-    AtlasTileAttributes const* getOrCreateCachedTileAttributes(char32_t codepoint);
+    [[nodiscard]] static bool inRepertoire(char32_t codepoint) noexcept;
+
+    /// Rasterizes all renderable codepoints into the direct-mapped tiles of the texture atlas.
+    void initializeDirectMapping();
 
     using Renderable::createTileData;
     [[nodiscard]] std::optional<TextureAtlas::TileCreateData> createTileData(
@@ -52,6 +77,10 @@ class BoxDrawingRenderer: public Renderable
                                                                        ImageSize size,
                                                                        int lineThickness);
     [[nodiscard]] std::optional<atlas::Buffer> buildElements(char32_t codepoint);
+
+    DirectMapping _directMapping {};
+    std::vector<bool> _tileAvailable; // indexed by direct mapping index
+    std::chrono::microseconds _initializationTime {};
 };
 
 } // namespace vtrasterizer
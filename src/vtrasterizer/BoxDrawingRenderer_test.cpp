@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/BoxDrawingRenderer.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+using namespace vtrasterizer;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::Width;
+
+namespace
+{
+
+auto const CellSize = ImageSize { Width(8), Height(16) };
+
+// Returns the pixel at the given top-down coordinate of a bottom-up alpha bitmap.
+uint8_t pixelAt(atlas::Buffer const& buffer, int x, int y)
+{
+    auto const w = unbox<int>(CellSize.width);
+    auto const h = unbox<int>(CellSize.height) - 1;
+    return buffer[static_cast<size_t>(((h - y) * w) + x)];
+}
+
+size_t filledPixels(atlas::Buffer const& buffer)
+{
+    return static_cast<size_t>(std::ranges::count(buffer, uint8_t { 0xFF }));
+}
+
+} // namespace
+
+TEST_CASE("BoxDrawingRenderer.isBraille")
+{
+    CHECK(!BoxDrawingRenderer::isBraille(0x27FF));
+    CHECK(BoxDrawingRenderer::isBraille(0x2800));
+    CHECK(BoxDrawingRenderer::isBraille(0x28FF));
+    CHECK(!BoxDrawingRenderer::isBraille(0x2900));
+    CHECK(BoxDrawingRenderer::renderable(0x2801));
+}
+
+TEST_CASE("BoxDrawingRenderer.buildBraille.blank")
+{
+    auto const buffer = BoxDrawingRenderer::buildBraille(0x2800, CellSize);
+
+    REQUIRE(buffer.size() == 8 * 16);
+    CHECK(filledPixels(buffer) == 0);
+}
+
+TEST_CASE("BoxDrawingRenderer.buildBraille.dot1")
+{
+    // U+2801 BRAILLE PATTERN DOTS-1: only the top left dot, spanning x=1..2 and y=1..2.
+    auto const buffer = BoxDrawingRenderer::buildBraille(0x2801, CellSize);
+
+    REQUIRE(buffer.size() == 8 * 16);
+    for (int y = 0; y < 16; ++y)
+    {
+        for (int x = 0; x < 8; ++x)
+        {
+            auto const inside = 1 <= x && x <= 2 && 1 <= y && y <= 2;
+            INFO("x=" << x << ", y=" << y);
+            CHECK(pixelAt(buffer, x, y) == (inside ? 0xFF : 0x00));
+        }
+    }
+}
+
+TEST_CASE("BoxDrawingRenderer.buildBraille.allDots")
+{
+    // U+28FF BRAILLE PATTERN DOTS-12345678: all eight dots, 2x2 pixels each.
+    auto const buffer = BoxDrawingRenderer::buildBraille(0x28FF, CellSize);
+
+    REQUIRE(buffer.size() == 8 * 16);
+    CHECK(filledPixels(buffer) == 8 * 4);
+    CHECK(pixelAt(buffer, 1, 1) == 0xFF);  // dot 1
+    CHECK(pixelAt(buffer, 5, 9) == 0xFF);  // dot 6
+    CHECK(pixelAt(buffer, 1, 13) == 0xFF); // dot 7
+    CHECK(pixelAt(buffer, 6, 14) == 0xFF); // dot 8
+    CHECK(pixelAt(buffer, 3, 1) == 0x00);  // gap between the columns
+    CHECK(pixelAt(buffer, 1, 15) == 0x00); // below the last row
+}
@@ -5,7 +5,11 @@
 #include <crispy/algorithm.h>
 #include <crispy/times.h>
 
+#include <algorithm>
 #include <array>
+#include <format>
+#include <memory>
+#include <ostream>
 
 using crispy::times;
 
@@ -38,7 +42,20 @@ void ImageRenderer::renderImage(crispy::point pos, vtbackend::ImageFragment cons
 {
     // std::cout << std::format("ImageRenderer.renderImage: {}\n", fragment);
 
-    AtlasTileAttributes const* tileAttributes = getOrCreateCachedTileAttributes(fragment);
+    // The image is rendered from its raster, which may still be in the making.
+    auto const raster = fragment.rasterizedImage().raster();
+    if (!raster)
+        return;
+
+    raster->markUsed();
+
+    if (textureScheduler().supportsImageTextures())
+    {
+        renderImageTexture(pos, fragment, *raster);
+        return;
+    }
+
+    AtlasTileAttributes const* tileAttributes = getOrCreateCachedTileAttributes(fragment, *raster);
     if (!tileAttributes)
         return;
 
@@ -49,6 +66,50 @@ void ImageRenderer::renderImage(crispy::point pos, vtbackend::ImageFragment cons
     // clang-format on
 }
 
+void ImageRenderer::renderImageTexture(crispy::point pos,
+                                       vtbackend::ImageFragment const& fragment,
+                                       vtbackend::Image const& image)
+{
+    auto const& rasterizedImage = fragment.rasterizedImage();
+    auto const imageId = unbox(image.id());
+
+    if (_uploadedImages.insert(imageId).second)
+    {
+        // Share the image's pixels with the backend rather than copying them.
+        textureScheduler().uploadImage(atlas::UploadImage {
+            .imageId = imageId,
+            .pixels = image.pixels(),
+            .size = image.size(),
+        });
+    }
+
+    // Clip the cell's sub-rectangle to the image, leaving the area beyond the image's
+    // right and bottom edges untouched rather than filling it with the default color.
+    auto const cellWidth = unbox<int>(rasterizedImage.cellSize().width);
+    auto const cellHeight = unbox<int>(rasterizedImage.cellSize().height);
+    auto const imageWidth = unbox<int>(image.width());
+    auto const imageHeight = unbox<int>(image.height());
+    auto const pixelX = unbox<int>(fragment.offset().column) * cellWidth;
+    auto const pixelY = unbox<int>(fragment.offset().line) * cellHeight;
+    auto const availableWidth = std::min(imageWidth - pixelX, cellWidth);
+    auto const availableHeight = std::min(imageHeight - pixelY, cellHeight);
+    if (availableWidth <= 0 || availableHeight <= 0)
+        return;
+
+    auto command = atlas::RenderImage {};
+    command.imageId = imageId;
+    command.x = atlas::RenderTile::X { pos.x };
+    command.y = atlas::RenderTile::Y { pos.y };
+    command.targetSize =
+        ImageSize { Width::cast_from(availableWidth * unbox<int>(_cellSize.width) / cellWidth),
+                    Height::cast_from(availableHeight * unbox<int>(_cellSize.height) / cellHeight) };
+    command.source.x = static_cast<float>(pixelX) / static_cast<float>(imageWidth);
+    command.source.y = static_cast<float>(pixelY) / static_cast<float>(imageHeight);
+    command.source.width = static_cast<float>(availableWidth) / static_cast<float>(imageWidth);
+    command.source.height = static_cast<float>(availableHeight) / static_cast<float>(imageHeight);
+    _pendingRenderImagesAboveText.emplace_back(command);
+}
+
 void ImageRenderer::onBeforeRenderingText()
 {
     // We could render here the images that should go below text.
@@ -57,45 +118,48 @@ void ImageRenderer::onBeforeRenderingText()
 void ImageRenderer::onAfterRenderingText()
 {
     // We render here the images that should go above text.
-
-    for (auto const& tile: _pendingRenderTilesAboveText)
-        textureScheduler().renderTile(tile);
-
-    _pendingRenderTilesAboveText.clear();
+    flushPendingRenderTiles();
 }
 
 void ImageRenderer::beginFrame()
 {
     assert(_pendingRenderTilesAboveText.empty());
+    assert(_pendingRenderImagesAboveText.empty());
 }
 
 void ImageRenderer::endFrame()
 {
-    if (!_pendingRenderTilesAboveText.empty())
-    {
-        // In case some image tiles are still pending but no text had to be rendered.
+    // In case some image tiles are still pending but no text had to be rendered.
+    flushPendingRenderTiles();
+}
 
-        for (auto& tile: _pendingRenderTilesAboveText)
-            textureScheduler().renderTile(tile);
-        _pendingRenderTilesAboveText.clear();
-    }
+void ImageRenderer::flushPendingRenderTiles()
+{
+    for (auto const& tile: _pendingRenderTilesAboveText)
+        textureScheduler().renderTile(tile);
+    _pendingRenderTilesAboveText.clear();
+
+    for (auto const& image: _pendingRenderImagesAboveText)
+        textureScheduler().renderImage(image);
+    _pendingRenderImagesAboveText.clear();
 }
 
 Renderable::AtlasTileAttributes const* ImageRenderer::getOrCreateCachedTileAttributes(
-    vtbackend::ImageFragment const& fragment)
+    vtbackend::ImageFragment const& fragment, vtbackend::Image const& raster)
 {
     // using crispy::StrongHash;
     // auto const hash = StrongHash::compute(fragment.rasterizedImage().image().id().value)
     //                   * fragment.offset().column.value * fragment.offset().line.value
     //                   * fragment.rasterizedImage().cellSize().width.value
     //                   * fragment.rasterizedImage().cellSize().height.value;
-    auto const key = ImageFragmentKey { .imageId = fragment.rasterizedImage().image().id(),
+    auto const key = ImageFragmentKey { .imageId = raster.id(),
                                         .offset = fragment.offset(),
                                         .size = fragment.rasterizedImage().cellSize() };
     auto const hash = crispy::strong_hash::compute(key);
 
     return textureAtlas().get_or_try_emplace(
-        hash, [&](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
+        hash,
+        [&](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
             return createTileData(tileLocation,
                                   fragment.data(),
                                   atlas::Format::RGBA,
@@ -104,23 +168,32 @@ Renderable::AtlasTileAttributes const* ImageRenderer::getOrCreateCachedTileAttri
                                   RenderTileAttributes::X { 0 },
                                   RenderTileAttributes::Y { 0 },
                                   FRAGMENT_SELECTOR_IMAGE_BGRA);
-        });
+        },
+        atlas::TileSizeClass::Wide);
 }
 
-void ImageRenderer::discardImage(vtbackend::ImageId /*imageId*/)
+void ImageRenderer::discardImage(vtbackend::ImageId imageId)
 {
-    // We currently don't really discard.
-    // Because the GPU texture atlas is resource-guarded by an LRU hashtable.
+    // Image textures are released right away, whereas atlas tiles of image fragments
+    // are resource-guarded by the atlas' LRU hashtable.
+    if (_uploadedImages.erase(unbox(imageId)))
+        textureScheduler().releaseImage(unbox(imageId));
 }
 
 void ImageRenderer::clearCache()
 {
-    // We currently don't really clean up anything.
-    // Because the GPU texture atlas is resource-guarded by an LRU hashtable.
+    if (renderTargetAvailable())
+        for (auto const imageId: _uploadedImages)
+            textureScheduler().releaseImage(imageId);
+    _uploadedImages.clear();
 }
 
-void ImageRenderer::inspect(std::ostream& /*output*/) const
+void ImageRenderer::inspect(std::ostream& output) const
 {
+    output << "ImageRenderer\n";
+    output << "------------------------\n";
+    output << std::format("image textures : {}\n", _uploadedImages.size());
+    output << '\n';
 }
 
 } // namespace vtrasterizer
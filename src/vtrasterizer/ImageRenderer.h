@@ -10,6 +10,7 @@
 #include <crispy/point.h>
 #include <crispy/size.h>
 
+#include <unordered_set>
 #include <vector>
 
 namespace vtrasterizer
@@ -38,6 +39,10 @@ struct ImageFragmentKey
 /// Image Rendering API.
 ///
 /// Can render any arbitrary RGBA image (for example Sixel Graphics images).
+///
+/// If the backend supports image textures, each image is uploaded once as a whole and its
+/// grid cells are rendered as sub-rectangles of that texture. Otherwise each grid cell's
+/// fragment is sliced out of the image and uploaded into a texture atlas tile.
 class ImageRenderer: public Renderable, public TextRendererEvents
 {
   public:
@@ -64,8 +69,18 @@ class ImageRenderer: public Renderable, public TextRendererEvents
     void onAfterRenderingText() override;
 
   private:
-    AtlasTileAttributes const* getOrCreateCachedTileAttributes(vtbackend::ImageFragment const& fragment);
+    void renderImageTexture(crispy::point pos,
+                            vtbackend::ImageFragment const& fragment,
+                            vtbackend::Image const& image);
+    AtlasTileAttributes const* getOrCreateCachedTileAttributes(vtbackend::ImageFragment const& fragment,
+                                                               vtbackend::Image const& raster);
+    void flushPendingRenderTiles();
+
     std::vector<atlas::RenderTile> _pendingRenderTilesAboveText;
+    std::vector<atlas::RenderImage> _pendingRenderImagesAboveText;
+
+    // IDs of the images that have been uploaded into textures of their own.
+    std::unordered_set<uint32_t> _uploadedImages;
 
     // private data
     //
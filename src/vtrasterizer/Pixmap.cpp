@@ -30,13 +30,11 @@ namespace
         {
             case Orientation::Horizontal:
                 for (auto const y: ranges::views::iota(base.value - 1, base.value + 1))
-                    for (auto const x: ranges::views::iota(from.value, to.value))
-                        pixmap.paint(x, y);
+                    pixmap.paintSpan(y, from.value, to.value);
                 break;
             case Orientation::Vertical:
                 for (auto const y: ranges::views::iota(from.value, to.value))
-                    for (auto const x: ranges::views::iota(base.value - 1, base.value + 1))
-                        pixmap.paint(x, y);
+                    pixmap.paintSpan(y, base.value - 1, base.value + 1);
                 break;
         }
         return pixmap;
@@ -82,8 +80,7 @@ Pixmap& Pixmap::halfFilledCircleLeft()
     auto const putpixel = [&](int x, int y) {
         auto const xf = clamp(x, 0, w - 1);
         auto const yf = clamp(y, 0, h - 1);
-        for (int xi = xf; xi < w; ++xi)
-            paint(xi, yf, 0xFF);
+        paintSpan(yf, xf, w, 0xFF);
     };
     auto const putAbove = [&](int x, int y) {
         putpixel(x, y - (h / 2));
@@ -102,9 +99,7 @@ Pixmap& Pixmap::halfFilledCircleRight()
     auto const w = unbox<int>(size.width);
     auto const h = unbox<int>(size.height);
     auto const putpixel = [&](int x, int y) {
-        auto const fx = min(w - 1, x);
-        for (int x = 0; x < fx; ++x)
-            paint(x, y, 0xFF);
+        paintSpan(y, 0, min(w - 1, x), 0xFF);
     };
     auto const putAbove = [&](int x, int y) {
         putpixel(x, y - (h / 2));
@@ -208,8 +208,7 @@ struct Pixmap
         auto const right = int(bottomRight.x * unbox<double>(size.width));
 
         for (int y = top; y < bottom; ++y)
-            for (int x = left; x < right; ++x)
-                paint(x, y, 0xFF);
+            paintSpan(y, left, right, 0xFF);
 
         return *this;
     }
@@ -223,6 +222,7 @@ struct Pixmap
     Pixmap& fill(F const& filler);
 
     void paint(int x, int y, uint8_t value = 0xFF);
+    void paintSpan(int y, int fromX, int toX, uint8_t value = 0xFF);
     void paintOver(int x, int y, uint8_t intensity);
     void paintOverThick(int x, int y, uint8_t intensity, int sx, int sy);
 
@@ -260,6 +260,20 @@ inline void Pixmap::paint(int x, int y, uint8_t value)
     buffer.at(static_cast<unsigned>((h - y) * w + x)) = value;
 }
 
+/// Paints the horizontal pixel span [fromX, toX) of row y, clipped to the pixmap's bounds.
+inline void Pixmap::paintSpan(int y, int fromX, int toX, uint8_t value)
+{
+    auto const w = unbox<int>(size.width);
+    auto const h = unbox<int>(size.height) - 1;
+    if (!(0 <= y && y <= h))
+        return;
+    fromX = std::max(fromX, 0);
+    toX = std::min(toX, w);
+    if (fromX >= toX)
+        return;
+    std::fill_n(buffer.begin() + ((h - y) * w) + fromX, toX - fromX, value);
+}
+
 inline void Pixmap::paintOver(int x, int y, uint8_t intensity)
 {
     auto const w = unbox<int>(size.width);
@@ -282,9 +296,15 @@ inline void Pixmap::paintOverThick(int x, int y, uint8_t intensity, int sx, int
 template <typename F>
 Pixmap& Pixmap::fill(F const& filler)
 {
-    for (auto const y: ::ranges::views::iota(0, unbox<int>(size.height)))
-        for (auto const x: ::ranges::views::iota(0, unbox<int>(size.width)))
-            paint(x, y, static_cast<uint8_t>(filler(x, y)));
+    auto const w = unbox<int>(size.width);
+    auto const h = unbox<int>(size.height);
+    for (auto const y: ::ranges::views::iota(0, h))
+    {
+        // Write the row directly, as the coordinates are known to be within bounds.
+        auto* const row = buffer.data() + (static_cast<size_t>(h - 1 - y) * static_cast<size_t>(w));
+        for (auto const x: ::ranges::views::iota(0, w))
+            row[x] = static_cast<uint8_t>(filler(x, y));
+    }
     return *this;
 }
 
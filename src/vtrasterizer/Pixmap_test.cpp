@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/Pixmap.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+using namespace vtrasterizer;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::Width;
+
+namespace
+{
+
+// Returns the pixel at the given bottom-up coordinate, as painted by Pixmap::paint().
+uint8_t pixelAt(Pixmap const& pixmap, int x, int y)
+{
+    auto const w = unbox<int>(pixmap.size.width);
+    auto const h = unbox<int>(pixmap.size.height) - 1;
+    return pixmap.buffer[static_cast<size_t>(((h - y) * w) + x)];
+}
+
+} // namespace
+
+TEST_CASE("Pixmap.paintSpan.clipped")
+{
+    auto pixmap = blockElement(ImageSize { Width(8), Height(4) });
+
+    pixmap.paintSpan(1, -3, 3);
+    pixmap.paintSpan(2, 6, 20);
+    pixmap.paintSpan(-1, 0, 8); // out of bounds
+    pixmap.paintSpan(4, 0, 8);  // out of bounds
+
+    for (int x = 0; x < 8; ++x)
+    {
+        CHECK(pixelAt(pixmap, x, 1) == (x < 3 ? 0xFF : 0x00));
+        CHECK(pixelAt(pixmap, x, 2) == (x >= 6 ? 0xFF : 0x00));
+    }
+    CHECK(std::count(pixmap.buffer.begin(), pixmap.buffer.end(), 0xFF) == 5);
+}
+
+TEST_CASE("Pixmap.rect_matches_paint")
+{
+    auto const size = ImageSize { Width(10), Height(10) };
+
+    auto expected = blockElement(size);
+    for (int y = 0; y < 5; ++y)
+        for (int x = 5; x < 10; ++x)
+            expected.paint(x, y);
+
+    auto actual = blockElement(size);
+    actual.rect({ .x = 0.5, .y = 0 }, { .x = 1, .y = 0.5 });
+
+    CHECK(actual.buffer == expected.buffer);
+}
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/RenderCommandCache.h>
+#include <vtrasterizer/utils.h>
+
+#include <crispy/overloaded.h>
+
+#include <algorithm>
+#include <format>
+#include <ostream>
+
+using std::nullopt;
+using std::optional;
+using std::vector;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    constexpr uint32_t packTileLocation(uint16_t x, uint16_t y) noexcept
+    {
+        return (uint32_t(x) << 16) | y;
+    }
+
+    constexpr uint32_t packTileLocation(RenderCommandCache::Command const& command) noexcept
+    {
+        if (auto const* tile = std::get_if<atlas::RenderTile>(&command))
+            return packTileLocation(tile->tileLocation.x.value, tile->tileLocation.y.value);
+        if (auto const* instance = std::get_if<atlas::RenderTileInstance>(&command))
+            return packTileLocation(instance->tileX, instance->tileY);
+        return 0;
+    }
+} // namespace
+
+void RenderCommandCache::setRenderTarget(RenderTarget& target)
+{
+    _target = &target;
+    _backend = &target.textureScheduler();
+    invalidate();
+}
+
+void RenderCommandCache::invalidate() noexcept
+{
+    for (LineCommands& line: _lines)
+    {
+        line.commands.clear();
+        line.valid = false;
+    }
+}
+
+void RenderCommandCache::beginFrame(size_t lineCount, uint64_t frameKey)
+{
+    if (_lines.size() != lineCount || _frameKey != frameKey)
+    {
+        _lines.clear();
+        _lines.resize(lineCount);
+        _frameKey = frameKey;
+    }
+
+    _damaged.assign(lineCount, false);
+    _volatileCommands.clear();
+    _uploadedTiles.clear();
+    _currentLine = nullopt;
+    ++_stats.frames;
+}
+
+bool RenderCommandCache::beginLine(size_t line, optional<uint64_t> hash)
+{
+    Require(line < _lines.size());
+
+    LineCommands& lineCommands = _lines[line];
+    if (hash && lineCommands.valid && lineCommands.hash == *hash)
+    {
+        ++_stats.linesReplayed;
+        return false;
+    }
+
+    lineCommands.commands.clear();
+    lineCommands.hash = hash.value_or(0);
+    lineCommands.valid = hash.has_value();
+    _damaged[line] = true;
+    _currentLine = line;
+    ++_stats.linesRendered;
+    return true;
+}
+
+void RenderCommandCache::endLine() noexcept
+{
+    if (_currentLine)
+        _lines[*_currentLine].recordedAt = _uploadSequence;
+    _currentLine = nullopt;
+}
+
+bool RenderCommandCache::referencesUploadedTile(LineCommands const& line) const
+{
+    for (Command const& command: line.commands)
+    {
+        if (std::holds_alternative<RectangleCommand>(command)
+            || std::holds_alternative<atlas::RenderImage>(command))
+            continue;
+        auto const upload = _uploadedTiles.find(packTileLocation(command));
+        if (upload != _uploadedTiles.end() && upload->second > line.recordedAt)
+            return true;
+    }
+    return false;
+}
+
+vector<size_t> RenderCommandCache::takeStaleLines()
+{
+    auto staleLines = vector<size_t> {};
+    if (_uploadedTiles.empty())
+        return staleLines;
+
+    for (size_t line = 0; line < _lines.size(); ++line)
+    {
+        if (_lines[line].valid && referencesUploadedTile(_lines[line]))
+        {
+            _lines[line].valid = false;
+            staleLines.push_back(line);
+        }
+    }
+
+    _stats.linesStale += staleLines.size();
+    return staleLines;
+}
+
+void RenderCommandCache::markDamaged(size_t line)
+{
+    if (line < _damaged.size())
+        _damaged[line] = true;
+}
+
+void RenderCommandCache::record(Command command)
+{
+    if (_currentLine)
+        _lines[*_currentLine].commands.emplace_back(std::move(command));
+    else
+        _volatileCommands.emplace_back(std::move(command));
+}
+
+// {{{ RenderTarget overrides
+void RenderCommandCache::setRenderSize(ImageSize size)
+{
+    _target->setRenderSize(size);
+}
+
+void RenderCommandCache::setMargin(PageMargin margin)
+{
+    _target->setMargin(margin);
+}
+
+void RenderCommandCache::renderRectangle(int x, int y, Width width, Height height, RGBAColor color)
+{
+    record(RectangleCommand { .x = x, .y = y, .width = width, .height = height, .color = color });
+}
+
+void RenderCommandCache::scheduleScreenshot(ScreenshotCallback callback)
+{
+    _target->scheduleScreenshot(std::move(callback));
+}
+
+void RenderCommandCache::setDamage(std::vector<RenderDamage> const& damage)
+{
+    _target->setDamage(damage);
+}
+
+void RenderCommandCache::execute(std::chrono::steady_clock::time_point now)
+{
+    auto const replay = overloaded {
+        [&](RectangleCommand const& rectangle) {
+            _target->renderRectangle(
+                rectangle.x, rectangle.y, rectangle.width, rectangle.height, rectangle.color);
+        },
+        [&](atlas::RenderTile const& tile) { _backend->renderTile(tile); },
+        [&](atlas::RenderTileInstance const& instance) { _backend->renderTileInstance(instance); },
+        [&](atlas::RenderImage const& image) { _backend->renderImage(image); },
+    };
+
+    for (LineCommands const& line: _lines)
+        for (Command const& command: line.commands)
+            std::visit(replay, command);
+
+    for (Command const& command: _volatileCommands)
+        std::visit(replay, command);
+
+    _target->execute(now);
+}
+
+void RenderCommandCache::clearCache()
+{
+    invalidate();
+    _target->clearCache();
+}
+
+optional<AtlasTextureScreenshot> RenderCommandCache::readAtlas()
+{
+    return _target->readAtlas();
+}
+
+void RenderCommandCache::inspect(std::ostream& output) const
+{
+    auto const validLines = std::count_if(
+        _lines.begin(), _lines.end(), [](LineCommands const& line) { return line.valid; });
+
+    output << "RenderCommandCache\n";
+    output << "------------------------\n";
+    output << std::format("lines cached   : {}/{}\n", validLines, _lines.size());
+    output << std::format("frames         : {}\n", _stats.frames);
+    output << std::format("lines rendered : {}\n", _stats.linesRendered);
+    output << std::format("lines replayed : {}\n", _stats.linesReplayed);
+    output << std::format("lines stale    : {}\n", _stats.linesStale);
+    output << '\n';
+}
+// }}}
+
+// {{{ AtlasBackend overrides
+ImageSize RenderCommandCache::atlasSize() const noexcept
+{
+    return _backend->atlasSize();
+}
+
+void RenderCommandCache::configureAtlas(atlas::ConfigureAtlas atlas)
+{
+    invalidate();
+    _backend->configureAtlas(atlas);
+}
+
+void RenderCommandCache::uploadTile(atlas::UploadTile tile)
+{
+    _uploadedTiles[packTileLocation(tile.location.x.value, tile.location.y.value)] = ++_uploadSequence;
+    _backend->uploadTile(std::move(tile));
+}
+
+void RenderCommandCache::renderTile(atlas::RenderTile tile)
+{
+    record(tile);
+}
+
+void RenderCommandCache::renderTileInstance(atlas::RenderTileInstance const& instance)
+{
+    record(instance);
+}
+
+bool RenderCommandCache::supportsImageTextures() const noexcept
+{
+    return _backend && _backend->supportsImageTextures();
+}
+
+void RenderCommandCache::uploadImage(atlas::UploadImage image)
+{
+    _backend->uploadImage(std::move(image));
+}
+
+void RenderCommandCache::renderImage(atlas::RenderImage const& image)
+{
+    record(image);
+}
+
+void RenderCommandCache::releaseImage(uint32_t imageId)
+{
+    _backend->releaseImage(imageId);
+}
+// }}}
+
+} // namespace vtrasterizer
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtrasterizer/RenderTarget.h>
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * Records the render commands of each screen line, so that lines that did not
+ * change since the previous frame can be replayed instead of being regenerated.
+ *
+ * The cache is put in between the render subsystems and the actual render target.
+ * Atlas configuration, tile and image uploads are forwarded immediately, whereas
+ * rectangle, tile and image render commands are recorded into the bucket of the line
+ * currently being rendered (or into a per-frame bucket if no line is active)
+ * and are only forwarded to the render target by execute().
+ *
+ * A line's recorded commands are keyed by the line's content hash, as computed
+ * by vtbackend::RenderBuffer::updateLineHashes().
+ */
+class RenderCommandCache final: public RenderTarget, public atlas::AtlasBackend
+{
+  public:
+    struct RectangleCommand
+    {
+        int x;
+        int y;
+        Width width;
+        Height height;
+        RGBAColor color;
+    };
+
+    using Command =
+        std::variant<RectangleCommand, atlas::RenderTile, atlas::RenderTileInstance, atlas::RenderImage>;
+
+    void setRenderTarget(RenderTarget& target);
+    [[nodiscard]] bool hasRenderTarget() const noexcept { return _target != nullptr; }
+
+    /// Discards all recorded line commands, forcing every line to be re-rendered next frame.
+    void invalidate() noexcept;
+
+    /// Starts a new frame for the given number of screen lines.
+    ///
+    /// Changing @p frameKey (e.g. due to color or grid metric changes) invalidates all lines.
+    void beginFrame(size_t lineCount, uint64_t frameKey);
+
+    /// Tests whether the given line must be re-rendered.
+    ///
+    /// If so, the line's previously recorded commands are discarded and all subsequent
+    /// render commands are recorded into that line until endLine() is invoked.
+    /// Lines without a @p hash are always re-rendered.
+    [[nodiscard]] bool beginLine(size_t line, std::optional<uint64_t> hash);
+    void endLine() noexcept;
+
+    /// Returns the lines that were replayed from the cache but reference atlas tiles
+    /// that have been overwritten by uploads during this frame.
+    ///
+    /// The returned lines are invalidated and must be rendered again.
+    [[nodiscard]] std::vector<size_t> takeStaleLines();
+
+    /// Marks the given line as damaged without touching its recorded commands.
+    void markDamaged(size_t line);
+
+    [[nodiscard]] std::vector<bool> const& damagedLines() const noexcept { return _damaged; }
+
+    // RenderTarget overrides
+    void setRenderSize(ImageSize size) override;
+    void setMargin(PageMargin margin) override;
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int x, int y, Width width, Height height, RGBAColor color) override;
+    void scheduleScreenshot(ScreenshotCallback callback) override;
+    void setDamage(std::vector<RenderDamage> const& damage) override;
+    void execute(std::chrono::steady_clock::time_point now) override;
+    void clearCache() override;
+    std::optional<AtlasTextureScreenshot> readAtlas() override;
+    void inspect(std::ostream& output) const override;
+
+    // AtlasBackend overrides
+    [[nodiscard]] ImageSize atlasSize() const noexcept override;
+    void configureAtlas(atlas::ConfigureAtlas atlas) override;
+    void uploadTile(atlas::UploadTile tile) override;
+    void renderTile(atlas::RenderTile tile) override;
+    void renderTileInstance(atlas::RenderTileInstance const& instance) override;
+    [[nodiscard]] bool supportsImageTextures() const noexcept override;
+    void uploadImage(atlas::UploadImage image) override;
+    void renderImage(atlas::RenderImage const& image) override;
+    void releaseImage(uint32_t imageId) override;
+
+  private:
+    struct LineCommands
+    {
+        std::vector<Command> commands;
+        uint64_t hash = 0;
+        uint64_t recordedAt = 0; // upload sequence number at the time the commands were recorded
+        bool valid = false;
+    };
+
+    void record(Command command);
+    [[nodiscard]] bool referencesUploadedTile(LineCommands const& line) const;
+
+    RenderTarget* _target = nullptr;
+    atlas::AtlasBackend* _backend = nullptr;
+
+    std::vector<LineCommands> _lines;
+    std::vector<Command> _volatileCommands;
+    std::vector<bool> _damaged;
+    std::optional<size_t> _currentLine;
+    uint64_t _frameKey = 0;
+
+    // Maps packed atlas tile locations that have been uploaded to during the current frame
+    // to the upload sequence number of their most recent upload.
+    std::unordered_map<uint32_t, uint64_t> _uploadedTiles;
+    uint64_t _uploadSequence = 0;
+
+    struct
+    {
+        uint64_t frames = 0;
+        uint64_t linesRendered = 0;
+        uint64_t linesReplayed = 0;
+        uint64_t linesStale = 0;
+    } _stats;
+};
+
+} // namespace vtrasterizer
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/RenderCommandCache.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtrasterizer;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::Width;
+
+namespace
+{
+
+class MockRenderTarget final: public RenderTarget, public atlas::AtlasBackend
+{
+  public:
+    size_t rectangles = 0;
+    size_t tiles = 0;
+    size_t images = 0;
+    size_t imageUploads = 0;
+    size_t executions = 0;
+    std::vector<RenderDamage> damage;
+
+    void setRenderSize(ImageSize) override {}
+    void setMargin(PageMargin) override {}
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int, int, Width, Height, RGBAColor) override { ++rectangles; }
+    void scheduleScreenshot(ScreenshotCallback) override {}
+    void setDamage(std::vector<RenderDamage> const& value) override { damage = value; }
+    void execute(std::chrono::steady_clock::time_point) override { ++executions; }
+    void clearCache() override {}
+    std::optional<AtlasTextureScreenshot> readAtlas() override { return std::nullopt; }
+    void inspect(std::ostream&) const override {}
+
+    [[nodiscard]] ImageSize atlasSize() const noexcept override
+    {
+        return ImageSize { Width(1024), Height(1024) };
+    }
+    void configureAtlas(atlas::ConfigureAtlas) override {}
+    void uploadTile(atlas::UploadTile) override {}
+    void renderTile(atlas::RenderTile) override { ++tiles; }
+    [[nodiscard]] bool supportsImageTextures() const noexcept override { return true; }
+    void uploadImage(atlas::UploadImage) override { ++imageUploads; }
+    void renderImage(atlas::RenderImage const&) override { ++images; }
+};
+
+atlas::RenderTile makeRenderTile(uint16_t tileX, uint16_t tileY)
+{
+    auto tile = atlas::RenderTile {};
+    tile.tileLocation =
+        atlas::TileLocation { atlas::TileLocation::X { tileX }, atlas::TileLocation::Y { tileY } };
+    return tile;
+}
+
+atlas::UploadTile makeUploadTile(uint16_t tileX, uint16_t tileY)
+{
+    auto tile = atlas::UploadTile {};
+    tile.location =
+        atlas::TileLocation { atlas::TileLocation::X { tileX }, atlas::TileLocation::Y { tileY } };
+    return tile;
+}
+
+} // namespace
+
+TEST_CASE("RenderCommandCache.replay_unchanged_lines")
+{
+    auto target = MockRenderTarget {};
+    auto cache = RenderCommandCache {};
+    cache.setRenderTarget(target);
+
+    cache.beginFrame(2, 0);
+    REQUIRE(cache.beginLine(0, 100));
+    cache.renderRectangle(0, 0, Width(10), Height(10), RenderTarget::RGBAColor::White);
+    cache.renderTile(makeRenderTile(10, 0));
+    cache.endLine();
+    REQUIRE(cache.beginLine(1, 200));
+    cache.renderTile(makeRenderTile(20, 0));
+    cache.endLine();
+    cache.execute({});
+    CHECK(target.rectangles == 1);
+    CHECK(target.tiles == 2);
+
+    // Second frame: line 0 unchanged, line 1 changed.
+    cache.beginFrame(2, 0);
+    CHECK_FALSE(cache.beginLine(0, 100));
+    REQUIRE(cache.beginLine(1, 201));
+    cache.endLine();
+    CHECK(cache.damagedLines() == std::vector<bool> { false, true });
+    cache.execute({});
+    CHECK(target.rectangles == 2);
+    CHECK(target.tiles == 3);
+}
+
+TEST_CASE("RenderCommandCache.frame_key_invalidates")
+{
+    auto target = MockRenderTarget {};
+    auto cache = RenderCommandCache {};
+    cache.setRenderTarget(target);
+
+    cache.beginFrame(1, 1);
+    REQUIRE(cache.beginLine(0, 100));
+    cache.endLine();
+
+    cache.beginFrame(1, 2);
+    CHECK(cache.beginLine(0, 100));
+    cache.endLine();
+}
+
+TEST_CASE("RenderCommandCache.stale_after_upload")
+{
+    auto target = MockRenderTarget {};
+    auto cache = RenderCommandCache {};
+    cache.setRenderTarget(target);
+
+    cache.beginFrame(2, 0);
+    REQUIRE(cache.beginLine(0, 100));
+    cache.renderTile(makeRenderTile(10, 0));
+    cache.endLine();
+    REQUIRE(cache.beginLine(1, 200));
+    cache.renderTile(makeRenderTile(20, 0));
+    cache.endLine();
+    CHECK(cache.takeStaleLines().empty());
+
+    // Line 1 changes and its rendering overwrites the atlas tile still referenced by line 0.
+    cache.beginFrame(2, 0);
+    CHECK_FALSE(cache.beginLine(0, 100));
+    REQUIRE(cache.beginLine(1, 201));
+    cache.uploadTile(makeUploadTile(10, 0));
+    cache.renderTile(makeRenderTile(10, 0));
+    cache.endLine();
+
+    auto const staleLines = cache.takeStaleLines();
+    REQUIRE(staleLines == std::vector<size_t> { 0 });
+    CHECK(cache.beginLine(0, 100));
+    cache.endLine();
+    CHECK(cache.takeStaleLines().empty());
+}
+
+TEST_CASE("RenderCommandCache.replay_images")
+{
+    auto target = MockRenderTarget {};
+    auto cache = RenderCommandCache {};
+    cache.setRenderTarget(target);
+    CHECK(cache.supportsImageTextures());
+
+    cache.beginFrame(1, 0);
+    REQUIRE(cache.beginLine(0, 100));
+    cache.uploadImage(atlas::UploadImage { .imageId = 1 });
+    cache.renderImage(atlas::RenderImage { .imageId = 1 });
+    cache.endLine();
+    CHECK(target.imageUploads == 1);
+    CHECK(target.images == 0);
+    cache.execute({});
+    CHECK(target.images == 1);
+
+    // The image is referenced by its own texture, so replaying the line does not need a re-upload.
+    cache.beginFrame(1, 0);
+    CHECK_FALSE(cache.beginLine(0, 100));
+    CHECK(cache.takeStaleLines().empty());
+    cache.execute({});
+    CHECK(target.imageUploads == 1);
+    CHECK(target.images == 2);
+}
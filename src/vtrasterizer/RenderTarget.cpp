@@ -100,5 +100,9 @@ void Renderable::renderTile(atlas::RenderTile::X x,
                             RGBAColor color,
                             Renderable::AtlasTileAttributes const& attributes)
 {
-    textureScheduler().renderTile(createRenderTile(x, y, color, attributes));
+    auto const tile = createRenderTile(x, y, color, attributes);
+    if (auto const instance = atlas::encodeRenderTile(tile))
+        textureScheduler().renderTileInstance(*instance);
+    else
+        textureScheduler().renderTile(tile);
 }
@@ -79,6 +79,18 @@ struct RenderTileAttributes
     ImageSize targetSize {};
 };
 
+/**
+ * Describes a rectangular area of the render target in pixels whose contents
+ * changed since the previously rendered frame.
+ */
+struct RenderDamage
+{
+    int x;
+    int y;
+    vtbackend::Width width;
+    vtbackend::Height height;
+};
+
 /**
  * Terminal render target interface, for example OpenGL, DirectX, or software-rasterization.
  *
@@ -111,6 +123,12 @@ class RenderTarget
     /// Schedules taking a screenshot of the current scene and forwards it to the given callback.
     virtual void scheduleScreenshot(ScreenshotCallback callback) = 0;
 
+    /// Informs the render target about the areas that changed since the previous frame.
+    ///
+    /// This is invoked right before execute(). Render targets that preserve the previous
+    /// frame's contents may use it to limit redrawing to the damaged areas.
+    virtual void setDamage(std::vector<RenderDamage> const& damage) { (void) damage; }
+
     /// Executes all previously scheduled render commands.
     virtual void execute(std::chrono::steady_clock::time_point now) = 0;
 
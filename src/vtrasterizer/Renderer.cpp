@@ -6,7 +6,9 @@
 #include <text_shaper/font_locator.h>
 #include <text_shaper/open_shaper.h>
 
+#include <crispy/FNV.h>
 #include <crispy/StrongLRUHashtable.h>
+#include <crispy/trace.h>
 
 #if defined(_WIN32)
     #include <text_shaper/directwrite_shaper.h>
@@ -34,6 +36,11 @@ namespace vtrasterizer
 
 namespace
 {
+    // Number of pages the texture atlas is partitioned into (see atlas::TileSizeClass).
+    constexpr uint32_t AtlasPageCount = 4;
+
+    // Number of frames between two attempts to compact the texture atlas.
+    constexpr uint32_t AtlasCompactionInterval = 256;
 
     void loadGridMetricsFromFont(text::font_key font, GridMetrics& gm, text::shaper& textShaper)
     {
@@ -155,6 +162,7 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
 void Renderer::setRenderTarget(RenderTarget& renderTarget)
 {
     _renderTarget = &renderTarget;
+    _renderCommandCache.setRenderTarget(renderTarget);
 
     // Reset DirectMappingAllocator (also skipping zero-tile).
     _directMappingAllocator =
@@ -165,9 +173,9 @@ void Renderer::setRenderTarget(RenderTarget& renderTarget)
     _directMappingAllocator.enabled = true;
     for (Renderable* renderable: initializer_list<Renderable*> {
              &_backgroundRenderer, &_cursorRenderer, &_decorationRenderer, &_imageRenderer })
-        renderable->setRenderTarget(renderTarget, _directMappingAllocator);
+        renderable->setRenderTarget(_renderCommandCache, _directMappingAllocator);
     _directMappingAllocator.enabled = _atlasDirectMapping;
-    _textRenderer.setRenderTarget(renderTarget, _directMappingAllocator);
+    _textRenderer.setRenderTarget(_renderCommandCache, _directMappingAllocator);
 
     configureTextureAtlas();
 }
@@ -182,11 +190,12 @@ void Renderer::configureTextureAtlas()
                                  .tileSize = atlasCellSize,
                                  .hashCount = _atlasHashtableSlotCount,
                                  .tileCount = _atlasTileCount,
-                                 .directMappingCount = _directMappingAllocator.currentlyAllocatedCount };
+                                 .directMappingCount = _directMappingAllocator.currentlyAllocatedCount,
+                                 .pageCount = AtlasPageCount };
 
     Require(atlasProperties.tileCount.value > 0);
 
-    _textureAtlas = make_unique<Renderable::TextureAtlas>(_renderTarget->textureScheduler(), atlasProperties);
+    _textureAtlas = make_unique<Renderable::TextureAtlas>(_renderCommandCache, atlasProperties);
 
     // clang-format off
     rendererLog()("Configuring texture atlas.\n", atlasProperties);
@@ -194,6 +203,7 @@ void Renderer::configureTextureAtlas()
     rendererLog()("- Atlas texture size   : {} pixels\n", _textureAtlas->atlasSize());
     rendererLog()("- Atlas hashtable      : {} slots\n", _atlasHashtableSlotCount.value);
     rendererLog()("- Atlas tile count     : {} = {}x * {}y\n", _textureAtlas->capacity(), _textureAtlas->tilesInX(), _textureAtlas->tilesInY());
+    rendererLog()("- Atlas pages          : {}\n", _textureAtlas->pageCount());
     rendererLog()("- Atlas direct mapping : {} (for text rendering)", _atlasDirectMapping ? "enabled" : "disabled");
     // clang-format on
 
@@ -216,6 +226,9 @@ void Renderer::executeImageDiscards()
     for (auto const imageId: _discardImageQueue)
         _imageRenderer.discardImage(imageId);
 
+    if (!_discardImageQueue.empty())
+        _renderCommandCache.invalidate();
+
     _discardImageQueue.clear();
 }
 
@@ -224,7 +237,7 @@ void Renderer::clearCache()
     if (!_renderTarget)
         return;
 
-    _renderTarget->clearCache();
+    _renderCommandCache.clearCache();
 
     // TODO(?): below functions are actually doing the same again and again and again. delete them (and their
     // functions for that) either that, or only the render target is allowed to clear the actual atlas caches.
@@ -283,6 +296,8 @@ void Renderer::updateFontMetrics()
 
 void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
 {
+    auto const traceSpan = crispy::trace::span { "Renderer::render" };
+
     auto const statusLineHeight = terminal.statusLineHeight();
     _gridMetrics.pageSize = terminal.pageSize() + statusLineHeight;
 
@@ -295,18 +310,27 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
     terminal.refreshRenderBuffer();
 #endif // }}}
 
+    pressure = pressure && terminal.isPrimaryScreen();
+
     optional<vtbackend::RenderCursor> cursorOpt;
-    _imageRenderer.beginFrame();
-    _textRenderer.beginFrame();
-    _textRenderer.setPressure(pressure && terminal.isPrimaryScreen());
+    _textRenderer.setPressure(pressure);
+    _renderCommandCache.beginFrame(unbox<size_t>(_gridMetrics.pageSize.lines), frameKey(pressure));
     {
         vtbackend::RenderBufferRef const renderBuffer = terminal.renderBuffer();
         cursorOpt = renderBuffer.get().cursor;
-        renderCells(renderBuffer.get().cells);
-        renderLines(renderBuffer.get().lines);
+        renderScreen(renderBuffer.get());
+    }
+
+    // The cursor's line(s) are always reported as damaged, as non-block cursors are rendered
+    // on top of the cached line contents on every frame.
+    if (_lastCursorLine)
+        _renderCommandCache.markDamaged(*_lastCursorLine);
+    _lastCursorLine = nullopt;
+    if (cursorOpt && cursorOpt.value().position.line >= vtbackend::LineOffset(0))
+    {
+        _lastCursorLine = unbox<size_t>(cursorOpt.value().position.line);
+        _renderCommandCache.markDamaged(*_lastCursorLine);
     }
-    _textRenderer.endFrame();
-    _imageRenderer.endFrame();
 
     if (cursorOpt && cursorOpt.value().shape != vtbackend::CursorShape::Block)
     {
@@ -324,34 +348,165 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
         _cursorRenderer.render(_gridMetrics.map(cursor.position), cursor.width, cursorColor);
     }
 
-    _renderTarget->execute(terminal.currentTime());
+    _renderCommandCache.setDamage(collectDamage());
+    _renderCommandCache.execute(terminal.currentTime());
+
+    if (++_framesSinceAtlasCompaction >= AtlasCompactionInterval)
+    {
+        _framesSinceAtlasCompaction = 0;
+        if (auto const releasedPages = _textureAtlas->compact(); releasedPages != 0)
+            rendererLog()("Released {} sparsely used texture atlas page(s).", releasedPages);
+    }
+}
+
+uint64_t Renderer::frameKey(bool pressure) const noexcept
+{
+    // Everything that influences the render commands of a line, but is not part of the line's hash.
+    auto const fnv = crispy::fnv<uint64_t, uint64_t>(1099511628211llu, 14695981039346656037llu);
+    return fnv(fnv.basis(),
+               uint64_t(_colorPalette.defaultBackground.value()),
+               uint64_t(pressure),
+               unbox<uint64_t>(_gridMetrics.pageSize.columns),
+               unbox<uint64_t>(_gridMetrics.cellSize.width),
+               unbox<uint64_t>(_gridMetrics.cellSize.height),
+               uint64_t(uint32_t(_gridMetrics.pageMargin.left)),
+               uint64_t(uint32_t(_gridMetrics.pageMargin.top)),
+               uint64_t(uint32_t(_gridMetrics.pageMargin.bottom)));
+}
+
+void Renderer::renderScreen(vtbackend::RenderBuffer const& renderBuffer)
+{
+    auto const lineCount = unbox<size_t>(_gridMetrics.pageSize.lines);
+    auto const& cells = renderBuffer.cells;
+
+    // Index the render buffer by screen line. Cells of a line are emitted consecutively.
+    _lineRenderables.assign(lineCount, LineRenderables {});
+    auto strayCells = vector<size_t> {};
+    for (size_t i = 0; i < cells.size();)
+    {
+        auto const line = unbox<int>(cells[i].position.line);
+        auto j = i + 1;
+        while (j < cells.size() && cells[j].position.line == cells[i].position.line)
+            ++j;
+        if (0 <= line && static_cast<size_t>(line) < lineCount)
+            _lineRenderables[static_cast<size_t>(line)] = LineRenderables { .cellBegin = i, .cellEnd = j };
+        else
+            for (auto k = i; k < j; ++k)
+                strayCells.push_back(k);
+        i = j;
+    }
+    for (vtbackend::RenderLine const& line: renderBuffer.lines)
+        if (unbox<size_t>(line.lineOffset) < lineCount)
+            _lineRenderables[unbox<size_t>(line.lineOffset)].line = &line;
+
+    auto const hashOf = [&](size_t line) -> optional<uint64_t> {
+        if (line < renderBuffer.lineHashes.size())
+            return renderBuffer.lineHashes[line];
+        return nullopt;
+    };
+
+    for (size_t line = 0; line < lineCount; ++line)
+    {
+        if (!_renderCommandCache.beginLine(line, hashOf(line)))
+            continue;
+        renderLine(cells, _lineRenderables[line]);
+        _renderCommandCache.endLine();
+    }
+
+    // Tile uploads for changed lines may have evicted atlas tiles still referenced by
+    // lines replayed from the cache. Those lines must be rendered again.
+    for (auto attempt = 0; attempt < 3; ++attempt)
+    {
+        auto const staleLines = _renderCommandCache.takeStaleLines();
+        if (staleLines.empty())
+            break;
+        for (auto const line: staleLines)
+        {
+            [[maybe_unused]] auto const rendering = _renderCommandCache.beginLine(line, hashOf(line));
+            renderLine(cells, _lineRenderables[line]);
+            _renderCommandCache.endLine();
+        }
+    }
+
+    if (!strayCells.empty())
+    {
+        _textRenderer.beginFrame();
+        _imageRenderer.beginFrame();
+        for (auto const i: strayCells)
+            renderCell(cells[i]);
+        _textRenderer.endFrame();
+        _imageRenderer.endFrame();
+    }
 }
 
-void Renderer::renderCells(vector<vtbackend::RenderCell> const& renderableCells)
+void Renderer::renderLine(vector<vtbackend::RenderCell> const& renderableCells,
+                          LineRenderables const& renderables)
 {
-    for (vtbackend::RenderCell const& cell: renderableCells)
+    // Each line is rendered as a frame of its own, so that its render commands
+    // do not depend on any neighbouring lines and can be cached independently.
+    _textRenderer.beginFrame();
+    _imageRenderer.beginFrame();
+
+    for (auto i = renderables.cellBegin; i < renderables.cellEnd; ++i)
+        renderCell(renderableCells[i]);
+
+    if (renderables.line)
     {
-        _backgroundRenderer.renderCell(cell);
-        _decorationRenderer.renderCell(cell);
-        _textRenderer.renderCell(cell);
-        if (cell.image)
-            _imageRenderer.renderImage(_gridMetrics.map(cell.position), *cell.image);
+        _backgroundRenderer.renderLine(*renderables.line);
+        _decorationRenderer.renderLine(*renderables.line);
+        _textRenderer.renderLine(*renderables.line);
     }
+
+    _textRenderer.endFrame();
+    _imageRenderer.endFrame();
+}
+
+void Renderer::renderCell(vtbackend::RenderCell const& cell)
+{
+    _backgroundRenderer.renderCell(cell);
+    _decorationRenderer.renderCell(cell);
+    _textRenderer.renderCell(cell);
+    if (cell.image)
+        _imageRenderer.renderImage(_gridMetrics.map(cell.position), *cell.image);
 }
 
-void Renderer::renderLines(vector<vtbackend::RenderLine> const& renderableLines)
+vector<RenderDamage> Renderer::collectDamage() const
 {
-    for (vtbackend::RenderLine const& line: renderableLines)
+    auto damage = vector<RenderDamage> {};
+    auto const& damagedLines = _renderCommandCache.damagedLines();
+    auto const width =
+        _gridMetrics.cellSize.width * boxed_cast<vtbackend::Width>(_gridMetrics.pageSize.columns);
+
+    // Coalesce consecutive damaged lines into one full-width rectangle.
+    for (size_t line = 0; line < damagedLines.size();)
     {
-        _backgroundRenderer.renderLine(line);
-        _decorationRenderer.renderLine(line);
-        _textRenderer.renderLine(line);
+        if (!damagedLines[line])
+        {
+            ++line;
+            continue;
+        }
+        auto end = line + 1;
+        while (end < damagedLines.size() && damagedLines[end])
+            ++end;
+        auto const topLeft =
+            _gridMetrics.map(vtbackend::LineOffset::cast_from(line), vtbackend::ColumnOffset(0));
+        damage.emplace_back(RenderDamage { .x = topLeft.x,
+                                           .y = topLeft.y,
+                                           .width = width,
+                                           .height = _gridMetrics.cellSize.height
+                                                     * vtbackend::Height::cast_from(end - line) });
+        line = end;
     }
+
+    return damage;
 }
 
 void Renderer::inspect(std::ostream& textOutput) const
 {
     _textureAtlas->inspect(textOutput);
+    _renderCommandCache.inspect(textOutput);
+    if (_renderTarget)
+        _renderTarget->inspect(textOutput);
     for (auto const& renderable: renderables())
         renderable->inspect(textOutput);
 }
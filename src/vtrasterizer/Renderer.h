@@ -11,6 +11,7 @@
 #include <vtrasterizer/Decorator.h>
 #include <vtrasterizer/GridMetrics.h>
 #include <vtrasterizer/ImageRenderer.h>
+#include <vtrasterizer/RenderCommandCache.h>
 #include <vtrasterizer/RenderTarget.h>
 #include <vtrasterizer/TextRenderer.h>
 
@@ -21,6 +22,7 @@
 
 #include <format>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace vtrasterizer
@@ -80,6 +82,7 @@ class Renderer
     void setHyperlinkDecoration(Decorator normal, Decorator hover)
     {
         _decorationRenderer.setHyperlinkDecoration(normal, hover);
+        _renderCommandCache.invalidate();
     }
 
     void setPageSize(vtbackend::PageSize screenSize) noexcept { _gridMetrics.pageSize = screenSize; }
@@ -125,9 +128,21 @@ class Renderer
     }
 
   private:
+    /// Range of render cells and the optional render line making up a single screen line.
+    struct LineRenderables
+    {
+        size_t cellBegin = 0;
+        size_t cellEnd = 0;
+        vtbackend::RenderLine const* line = nullptr;
+    };
+
     void configureTextureAtlas();
-    void renderCells(std::vector<vtbackend::RenderCell> const& renderableCells);
-    void renderLines(std::vector<vtbackend::RenderLine> const& renderableLines);
+    [[nodiscard]] uint64_t frameKey(bool pressure) const noexcept;
+    void renderScreen(vtbackend::RenderBuffer const& renderBuffer);
+    void renderLine(std::vector<vtbackend::RenderCell> const& renderableCells,
+                    LineRenderables const& renderables);
+    void renderCell(vtbackend::RenderCell const& cell);
+    [[nodiscard]] std::vector<RenderDamage> collectDamage() const;
     void executeImageDiscards();
 
     crispy::strong_hashtable_size _atlasHashtableSlotCount;
@@ -136,8 +151,15 @@ class Renderer
 
     RenderTarget* _renderTarget = nullptr;
 
+    // Sits in between the render subsystems and _renderTarget, to skip
+    // regenerating render commands for lines that did not change.
+    RenderCommandCache _renderCommandCache;
+    std::vector<LineRenderables> _lineRenderables;
+    std::optional<size_t> _lastCursorLine;
+
     Renderable::DirectMappingAllocator _directMappingAllocator;
     std::unique_ptr<Renderable::TextureAtlas> _textureAtlas;
+    uint32_t _framesSinceAtlasCompaction = 0;
 
     FontDescriptions _fontDescriptions;
     std::unique_ptr<text::shaper> _textShaper;
@@ -137,6 +137,7 @@ Making use of reserved glyph slots
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/range.h>
+#include <crispy/trace.h>
 
 #include <libunicode/convert.h>
 #include <libunicode/utf8_grapheme_segmenter.h>
@@ -248,6 +249,13 @@ namespace
             return TextStyle::Italic;
         return TextStyle::Regular;
     }
+
+    constexpr atlas::TileSizeClass toTileSizeClass(unicode::PresentationStyle presentation) noexcept
+    {
+        // Emoji are usually colored and two cells wide, so keep them apart from narrow text glyphs.
+        return presentation == unicode::PresentationStyle::Emoji ? atlas::TileSizeClass::Wide
+                                                                 : atlas::TileSizeClass::Narrow;
+    }
 } // namespace
 
 text::font_locator& createFontLocator(FontLocatorEngine engine)
@@ -537,6 +545,9 @@ bool TextRenderer::renderBoxDrawingCell(vtbackend::CellLocation position,
                                         char32_t codepoint,
                                         vtbackend::RGBColor foregroundColor)
 {
+    if (!_fontDescriptions.builtinBraille && BoxDrawingRenderer::isBraille(codepoint))
+        return false;
+
     if (_fontDescriptions.builtinBoxDrawing)
         return _boxDrawingRenderer.render(position.line, position.column, codepoint, foregroundColor);
 
@@ -583,7 +594,8 @@ void TextRenderer::renderTextGroup(std::u32string_view codepoints,
             renderRasterizedGlyph(pen1, color, *attributes);
 
             auto xOffset = unbox(textureAtlas().tileSize().width);
-            while (AtlasTileAttributes const* subAttribs = textureAtlas().try_get(hash * xOffset))
+            auto const sizeClass = toTileSizeClass(glyphPosition.presentation);
+            while (AtlasTileAttributes const* subAttribs = textureAtlas().try_get(hash * xOffset, sizeClass))
             {
                 renderTile(atlas::RenderTile::X { pen1.x + int(xOffset) },
                            atlas::RenderTile::Y { pen1.y },
@@ -617,7 +629,8 @@ Renderable::AtlasTileAttributes const* TextRenderer::getOrCreateRasterizedMetada
         -> optional<TextureAtlas::TileCreateData>
         {
             return createSlicedRasterizedGlyph(tileLocation, glyphKey, presentationStyle, hash);
-        }
+        },
+        toTileSizeClass(presentationStyle)
     );
     // clang-format on
 }
@@ -676,7 +689,8 @@ auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
                                       RenderTileAttributes::X { 0 },
                                       createData.metadata.y,
                                       createData.metadata.fragmentShaderSelector);
-            });
+            },
+            toTileSizeClass(presentation));
     }
 
     // Construct head-tile
@@ -704,6 +718,8 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
                                          unicode::PresentationStyle presentation)
     -> optional<TextureAtlas::TileCreateData>
 {
+    auto const traceSpan = crispy::trace::span { "TextRenderer::rasterize" };
+
     auto theGlyphOpt = _textShaper.rasterize(glyphKey, _fontDescriptions.renderMode);
     if (!theGlyphOpt.has_value())
         return nullopt;
@@ -852,6 +868,8 @@ text::shape_result TextRenderer::shapeTextRun(unicode::run_segmenter::range cons
                                               gsl::span<unsigned> totalClusters,
                                               TextStyle style)
 {
+    auto const traceSpan = crispy::trace::span { "TextRenderer::shape" };
+
     // TODO(where to apply cell-advances) auto const advanceX = _gridMetrics.cellSize.width;
     auto const count = static_cast<size_t>(run.end - run.start);
     auto const codepoints = u32string_view(totalCodepoints.data() + run.start, count);
@@ -8,8 +8,12 @@
 #include <crispy/StrongLRUHashtable.h>
 #include <crispy/assert.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <format>
+#include <memory>
+#include <optional>
 #include <variant> // monostate
 #include <vector>
 
@@ -115,8 +119,28 @@ struct AtlasProperties
     // This can be for example [A-Za-z0-9], characters that are most often
     // used and least likely part of a ligature.
     uint32_t directMappingCount {};
+
+    // Number of pages the LRU-managed tiles are partitioned into.
+    //
+    // Each page has its own LRU and is owned by one TileSizeClass at a time.
+    uint32_t pageCount = 1;
+};
+
+/**
+ * Classifies tiles by the shape of what they are part of.
+ *
+ * Tiles of different size classes are kept in separate atlas pages,
+ * so that for example wide color emoji (sliced into multiple tiles each)
+ * or image fragments do not evict narrow text glyphs.
+ */
+enum class TileSizeClass : uint8_t
+{
+    Narrow, // text glyphs
+    Wide,   // color emoji and image fragments
 };
 
+constexpr size_t TileSizeClassCount = 2;
+
 // -----------------------------------------------------------------------
 // command data structures
 
@@ -159,6 +183,53 @@ struct RenderTile
     uint32_t fragmentShaderSelector {};
 };
 
+// Compact per-instance encoding of a RenderTile, to be used for instanced rendering.
+//
+// Expanding a RenderTile into two triangles costs 6 vertices of 11 floats each (264 bytes),
+// whereas this encoding costs 16 bytes. The quad and its texture coordinates are
+// reconstructed from position, tile location and extent on the GPU.
+//
+// The bitmap extent is stored as 12-bit width and height, which is plenty for a grid cell.
+// Tiles whose target size differs from their bitmap size (scaled tiles) cannot be encoded.
+struct RenderTileInstance
+{
+    int16_t x;                   // target X coordinate to start rendering to
+    int16_t y;                   // target Y coordinate to start rendering to
+    uint16_t tileX;              // X-offset of the tile into the texture atlas
+    uint16_t tileY;              // Y-offset of the tile into the texture atlas
+    uint32_t extent;             // bits 0..11: width, bits 12..23: height, bits 24..31: fragment selector
+    std::array<uint8_t, 4> rgba; // color being associated with this texture
+
+    static constexpr uint32_t MaxExtent = 0xFFF;
+
+    [[nodiscard]] constexpr uint32_t width() const noexcept { return extent & MaxExtent; }
+    [[nodiscard]] constexpr uint32_t height() const noexcept { return (extent >> 12) & MaxExtent; }
+    [[nodiscard]] constexpr uint32_t fragmentShaderSelector() const noexcept { return extent >> 24; }
+};
+
+static_assert(sizeof(RenderTileInstance) == 16);
+
+// Command structure for uploading a whole RGBA image into a texture of its own, outside of the atlas.
+//
+// The pixel data is shared with its owner (e.g. a vtbackend::Image), so scheduling the upload
+// does not copy it.
+struct UploadImage
+{
+    uint32_t imageId {};                  // identifies the image in subsequent render/release commands
+    std::shared_ptr<Buffer const> pixels; // RGBA pixel data, top row first
+    vtbackend::ImageSize size {};         // image dimensions in pixels
+};
+
+// Command structure for rendering a sub-rectangle of a previously uploaded image.
+struct RenderImage
+{
+    uint32_t imageId {};
+    RenderTile::X x {};                 // target X coordinate to start rendering to
+    RenderTile::Y y {};                 // target Y coordinate to start rendering to
+    vtbackend::ImageSize targetSize {}; // dimensions of the sub-rectangle on the render target surface
+    NormalizedTileLocation source {};   // sub-rectangle in normalized texture coordinates of the image
+};
+
 constexpr std::array<float, 4> normalize(vtbackend::RGBColor color, float alpha) noexcept
 {
     return std::array<float, 4> { static_cast<float>(color.red) / 255.f,
@@ -175,6 +246,69 @@ constexpr std::array<float, 4> normalize(vtbackend::RGBAColor color) noexcept
                                   static_cast<float>(color.alpha()) / 255.f };
 }
 
+/// Encodes the given RenderTile into its compact instance representation.
+///
+/// @returns the encoded instance or std::nullopt if the tile cannot be represented,
+///          e.g. because it is scaled or exceeds the encodable value ranges.
+constexpr std::optional<RenderTileInstance> encodeRenderTile(RenderTile const& tile) noexcept
+{
+    auto const bitmapWidth = unbox(tile.bitmapSize.width);
+    auto const bitmapHeight = unbox(tile.bitmapSize.height);
+
+    auto const targetWidth = unbox(tile.targetSize.width);
+    auto const targetHeight = unbox(tile.targetSize.height);
+    if ((targetWidth != 0 && targetWidth != bitmapWidth)
+        || (targetHeight != 0 && targetHeight != bitmapHeight))
+        return std::nullopt;
+
+    if (bitmapWidth > RenderTileInstance::MaxExtent || bitmapHeight > RenderTileInstance::MaxExtent
+        || tile.fragmentShaderSelector > 0xFF)
+        return std::nullopt;
+
+    if (tile.x.value < INT16_MIN || tile.x.value > INT16_MAX || tile.y.value < INT16_MIN
+        || tile.y.value > INT16_MAX)
+        return std::nullopt;
+
+    auto const toByte = [](float value) constexpr noexcept -> uint8_t {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+
+    auto instance = RenderTileInstance {};
+    instance.x = static_cast<int16_t>(tile.x.value);
+    instance.y = static_cast<int16_t>(tile.y.value);
+    instance.tileX = tile.tileLocation.x.value;
+    instance.tileY = tile.tileLocation.y.value;
+    instance.extent = bitmapWidth | (bitmapHeight << 12) | (tile.fragmentShaderSelector << 24);
+    instance.rgba = {
+        toByte(tile.color[0]), toByte(tile.color[1]), toByte(tile.color[2]), toByte(tile.color[3])
+    };
+    return instance;
+}
+
+/// Decodes the given compact instance back into a RenderTile for a texture atlas of the given size.
+constexpr RenderTile decodeRenderTile(RenderTileInstance const& instance,
+                                      vtbackend::ImageSize atlasSize) noexcept
+{
+    auto tile = RenderTile {};
+    tile.x = RenderTile::X { instance.x };
+    tile.y = RenderTile::Y { instance.y };
+    tile.bitmapSize = vtbackend::ImageSize { vtbackend::Width(instance.width()),
+                                             vtbackend::Height(instance.height()) };
+    tile.targetSize = tile.bitmapSize;
+    tile.color = { static_cast<float>(instance.rgba[0]) / 255.f,
+                   static_cast<float>(instance.rgba[1]) / 255.f,
+                   static_cast<float>(instance.rgba[2]) / 255.f,
+                   static_cast<float>(instance.rgba[3]) / 255.f };
+    tile.tileLocation =
+        TileLocation { TileLocation::X { instance.tileX }, TileLocation::Y { instance.tileY } };
+    tile.normalizedLocation.x = static_cast<float>(instance.tileX) / unbox<float>(atlasSize.width);
+    tile.normalizedLocation.y = static_cast<float>(instance.tileY) / unbox<float>(atlasSize.height);
+    tile.normalizedLocation.width = static_cast<float>(instance.width()) / unbox<float>(atlasSize.width);
+    tile.normalizedLocation.height = static_cast<float>(instance.height()) / unbox<float>(atlasSize.height);
+    tile.fragmentShaderSelector = instance.fragmentShaderSelector();
+    return tile;
+}
+
 // -----------------------------------------------------------------------
 // interface
 
@@ -199,6 +333,30 @@ class AtlasBackend
 
     /// Renders given texture from the atlas with the given target position parameters.
     virtual void renderTile(RenderTile tile) = 0;
+
+    /// Renders given compactly encoded texture from the atlas.
+    ///
+    /// Backends supporting instanced rendering should override this.
+    /// The default implementation decodes the instance and forwards it to renderTile().
+    virtual void renderTileInstance(RenderTileInstance const& instance)
+    {
+        renderTile(decodeRenderTile(instance, atlasSize()));
+    }
+
+    /// Tests whether this backend can keep whole images in textures of their own.
+    ///
+    /// If so, images are uploaded once via uploadImage() and each grid cell merely references
+    /// its sub-rectangle via renderImage(), instead of occupying an atlas tile per grid cell.
+    [[nodiscard]] virtual bool supportsImageTextures() const noexcept { return false; }
+
+    /// Uploads the given image into a texture of its own.
+    virtual void uploadImage(UploadImage /*image*/) {}
+
+    /// Renders a sub-rectangle of an image previously uploaded via uploadImage().
+    virtual void renderImage(RenderImage const& /*image*/) {}
+
+    /// Releases the texture of an image previously uploaded via uploadImage().
+    virtual void releaseImage(uint32_t /*imageId*/) {}
 };
 
 // Defines location of the tile in the atlas and its associated metadata
@@ -241,7 +399,8 @@ class TextureAtlas
     [[nodiscard]] vtbackend::ImageSize tileSize() const noexcept { return _atlasProperties.tileSize; }
 
     // Tests in LRU-cache if the tile
-    [[nodiscard]] constexpr bool contains(crispy::strong_hash const& id) const noexcept;
+    [[nodiscard]] bool contains(crispy::strong_hash const& id,
+                                TileSizeClass sizeClass = TileSizeClass::Narrow) const noexcept;
 
     // Return type for in-place tile-construction callback.
     struct TileCreateData
@@ -267,22 +426,42 @@ class TextureAtlas
 
     /// Always returns either the existing item by the given key, if found,
     /// or a newly created one by invoking constructValue().
+    ///
+    /// The tile is looked up in and created within the pages of the given @p sizeClass only.
     template <typename CreateTileDataFn>
     [[nodiscard]] TileAttributes<Metadata>& get_or_emplace(crispy::strong_hash const& key,
-                                                           CreateTileDataFn constructValue);
+                                                           CreateTileDataFn constructValue,
+                                                           TileSizeClass sizeClass = TileSizeClass::Narrow);
 
-    [[nodiscard]] TileAttributes<Metadata> const* try_get(crispy::strong_hash const& key);
+    [[nodiscard]] TileAttributes<Metadata> const* try_get(crispy::strong_hash const& key,
+                                                          TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     template <typename CreateTileDataFn>
-    [[nodiscard]] TileAttributes<Metadata> const* get_or_try_emplace(crispy::strong_hash const& key,
-                                                                     CreateTileDataFn constructValue);
+    [[nodiscard]] TileAttributes<Metadata> const* get_or_try_emplace(
+        crispy::strong_hash const& key,
+        CreateTileDataFn constructValue,
+        TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     /// Explicitly create or overwrites a tile for the given hash key.
     template <typename CreateTileDataFn>
-    void emplace(crispy::strong_hash const& key, CreateTileDataFn constructValue);
+    void emplace(crispy::strong_hash const& key,
+                 CreateTileDataFn constructValue,
+                 TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     void remove(crispy::strong_hash key);
 
+    /// Releases sparsely occupied pages whose tiles fit into the remaining pages
+    /// of the same size class, making them available to any size class again.
+    ///
+    /// Tiles of a released page are recreated on their next use, which effectively
+    /// moves hot tiles into fewer pages. This is cheap and meant to be invoked
+    /// periodically, e.g. between frames.
+    ///
+    /// @returns number of released pages.
+    size_t compact();
+
+    [[nodiscard]] size_t pageCount() const noexcept { return _pages.size(); }
+
     // Uploads tile data to a direct-mapped slot in the texture atlas
     // bypassing the LRU cache.
     //
@@ -310,9 +489,36 @@ class TextureAtlas
     using TileCache = crispy::strong_lru_hashtable<TileAttributes<Metadata>>;
     using TileCachePtr = typename TileCache::ptr;
 
+    // A contiguous range of LRU-managed tiles with its own LRU cache.
+    struct Page
+    {
+        TileCachePtr tileCache;
+        uint32_t baseTileIndex = 0;
+        std::optional<TileSizeClass> sizeClass {}; // std::nullopt if not owned by any size class
+        uint64_t lastUsed = 0;                      // value of _useCounter at the last access
+
+        // Statistics for introspection.
+        uint64_t hits = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+        uint64_t releases = 0;
+
+        [[nodiscard]] bool full() const noexcept { return tileCache->size() == tileCache->capacity(); }
+    };
+
+    struct TileLookup
+    {
+        Page* page = nullptr;
+        TileAttributes<Metadata>* tile = nullptr;
+    };
+
+    [[nodiscard]] TileLookup find(crispy::strong_hash const& key, TileSizeClass sizeClass);
+    [[nodiscard]] Page& pageForInsertion(TileSizeClass sizeClass);
+    void releasePage(Page& page);
+
     template <typename CreateTileDataFn>
     std::optional<TileAttributes<Metadata>> constructTile(CreateTileDataFn createTileData,
-                                                          uint32_t entryIndex);
+                                                          uint32_t tileIndex);
 
     AtlasBackend& _backend;
     AtlasProperties _atlasProperties;
@@ -320,9 +526,10 @@ class TextureAtlas
     uint32_t _tilesInX;
     uint32_t _tilesInY;
 
-    // The number of entries of this cache must at most match the number
+    // The total number of entries of all pages must at most match the number
     // of tiles that can be stored into the atlas.
-    TileCachePtr _tileCache;
+    std::vector<Page> _pages;
+    uint64_t _useCounter = 0;
 
     // A vector of precomputed mappings from entry index to TileLocation.
     std::vector<TileLocation> _tileLocations;
@@ -452,7 +659,8 @@ inline vtbackend::ImageSize computeAtlasSize(AtlasProperties const& atlasPropert
     using std::sqrt;
 
     // clang-format off
-    auto const totalTileCount = crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value + atlasProperties.directMappingCount);
+    // One extra tile per page accounts for the tiles lost when partitioning into pages.
+    auto const totalTileCount = crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value + atlasProperties.directMappingCount + atlasProperties.pageCount);
     //auto const totalTileCount = atlasProperties.tileCount.value + atlasProperties.directMappingCount;
     auto const squareEdgeCount = static_cast<uint32_t>(ceil(sqrt(totalTileCount)));
     auto const width = vtbackend::Width::cast_from(crispy::nextPowerOfTwo(static_cast<uint32_t>(
@@ -489,19 +697,31 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
         Require(tilesInY != 0);
         return tilesInY;
     }() },
-    _tileCache { TileCache::create(
-        atlasProperties.hashCount,
-        crispy::lru_capacity { // The LRU entry capacity is the number of total tiles availabe,
-                               // minus the number of reserved tiles for direct-mapping, and
-                               // minus one for the LRU-sentinel entry (which is why entryIndex
-                               // is between 1 and capacity inclusive)
-                               _tilesInX * _tilesInY - _atlasProperties.directMappingCount - 1 },
-        "LRU cache for texture atlas") },
     _tileLocations { static_cast<size_t>(_tilesInX * _tilesInY) }
 {
-    Require(_atlasProperties.tileCount.value <= _tileCache->capacity());
+    Require(_atlasProperties.pageCount >= 1);
     Require(_atlasProperties.directMappingCount + _atlasProperties.tileCount.value <= _tilesInX * _tilesInY);
 
+    // The LRU-managed tiles are the total tiles available minus the ones reserved for
+    // direct-mapping. Tile index 0 is never handed out, as its location (0, 0) is
+    // reserved to denote an invalid tile.
+    auto const firstTileIndex = std::max(1u, _atlasProperties.directMappingCount);
+    auto const tilesPerPage = (_tilesInX * _tilesInY - firstTileIndex) / _atlasProperties.pageCount;
+    auto const hashCountPerPage = crispy::strong_hashtable_size { crispy::nextPowerOfTwo(
+        std::max(1u, _atlasProperties.hashCount.value / _atlasProperties.pageCount)) };
+
+    Require(_atlasProperties.tileCount.value <= tilesPerPage * _atlasProperties.pageCount);
+
+    _pages.resize(_atlasProperties.pageCount);
+    for (uint32_t pageIndex = 0; pageIndex < _atlasProperties.pageCount; ++pageIndex)
+    {
+        Page& page = _pages[pageIndex];
+        page.baseTileIndex = firstTileIndex + (pageIndex * tilesPerPage);
+        page.tileCache = TileCache::create(hashCountPerPage,
+                                           crispy::lru_capacity { tilesPerPage },
+                                           std::format("LRU cache for texture atlas page {}", pageIndex));
+    }
+
     // std::cout << std::format("TextureAtlas: tiles {}x{} (locations: {} >= {}) texture {}; props {}\n",
     //            _tilesInX,
     //            _tilesInY,
@@ -534,18 +754,97 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
 }
 
 template <typename Metadata>
-constexpr bool TextureAtlas<Metadata>::contains(crispy::strong_hash const& id) const noexcept
+bool TextureAtlas<Metadata>::contains(crispy::strong_hash const& id, TileSizeClass sizeClass) const noexcept
+{
+    for (Page const& page: _pages)
+        if (page.sizeClass == sizeClass && page.tileCache->contains(id))
+            return true;
+    return false;
+}
+
+template <typename Metadata>
+auto TextureAtlas<Metadata>::find(crispy::strong_hash const& key, TileSizeClass sizeClass) -> TileLookup
+{
+    for (Page& page: _pages)
+    {
+        if (page.sizeClass != sizeClass)
+            continue;
+        if (auto* tile = page.tileCache->try_get(key))
+        {
+            page.lastUsed = ++_useCounter;
+            ++page.hits;
+            return TileLookup { .page = &page, .tile = tile };
+        }
+    }
+    return TileLookup {};
+}
+
+template <typename Metadata>
+auto TextureAtlas<Metadata>::pageForInsertion(TileSizeClass sizeClass) -> Page&
 {
-    return _tileCache->contains(id);
+    // Prefer the most recently used page of this size class that still has free tiles,
+    // which keeps hot tiles packed together.
+    Page* leastRecentlyUsedOwnPage = nullptr;
+    Page* mostRecentlyUsedFreePage = nullptr;
+    for (Page& page: _pages)
+    {
+        if (page.sizeClass != sizeClass)
+            continue;
+        if (!page.full() && (!mostRecentlyUsedFreePage || page.lastUsed > mostRecentlyUsedFreePage->lastUsed))
+            mostRecentlyUsedFreePage = &page;
+        if (!leastRecentlyUsedOwnPage || page.lastUsed < leastRecentlyUsedOwnPage->lastUsed)
+            leastRecentlyUsedOwnPage = &page;
+    }
+    if (mostRecentlyUsedFreePage)
+        return *mostRecentlyUsedFreePage;
+
+    // Claim a page that is not owned by any size class.
+    for (Page& page: _pages)
+    {
+        if (!page.sizeClass)
+        {
+            page.sizeClass = sizeClass;
+            return page;
+        }
+    }
+
+    // All pages of this size class are full: evict within the least recently used one.
+    if (leastRecentlyUsedOwnPage)
+        return *leastRecentlyUsedOwnPage;
+
+    // This size class owns no page at all: take over the least recently used page
+    // of another size class that owns more than one page, or any page otherwise.
+    auto pagesOwned = std::array<size_t, TileSizeClassCount> {};
+    for (Page const& page: _pages)
+        ++pagesOwned[static_cast<size_t>(*page.sizeClass)];
+    Page* victim = nullptr;
+    for (Page& page: _pages)
+    {
+        auto const shared = pagesOwned[static_cast<size_t>(*page.sizeClass)] > 1;
+        auto const victimShared = victim && pagesOwned[static_cast<size_t>(*victim->sizeClass)] > 1;
+        if (!victim || (shared && !victimShared)
+            || (shared == victimShared && page.lastUsed < victim->lastUsed))
+            victim = &page;
+    }
+    Require(victim != nullptr);
+    releasePage(*victim);
+    victim->sizeClass = sizeClass;
+    return *victim;
+}
+
+template <typename Metadata>
+void TextureAtlas<Metadata>::releasePage(Page& page)
+{
+    page.tileCache->clear();
+    page.sizeClass = std::nullopt;
+    ++page.releases;
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
 auto TextureAtlas<Metadata>::constructTile(CreateTileDataFn createTileData,
-                                           uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>>
+                                           uint32_t tileIndex) -> std::optional<TileAttributes<Metadata>>
 {
-    Require(1 <= entryIndex && entryIndex <= _tileCache->capacity());
-    auto const tileIndex = _atlasProperties.directMappingCount + entryIndex;
     Require(tileIndex < _tileLocations.size());
     auto const tileLocation = _tileLocations[tileIndex];
     Require(tileLocation.x.value != 0 || tileLocation.y.value != 0);
@@ -574,37 +873,69 @@ auto TextureAtlas<Metadata>::constructTile(CreateTileDataFn createTileData,
 template <typename Metadata>
 template <typename CreateTileDataFn>
 TileAttributes<Metadata>& TextureAtlas<Metadata>::get_or_emplace(crispy::strong_hash const& key,
-                                                                 CreateTileDataFn constructValue)
+                                                                 CreateTileDataFn constructValue,
+                                                                 TileSizeClass sizeClass)
 {
-    return _tileCache->get_or_emplace(key,
-                                      [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
-                                          return constructTile(std::move(constructValue), entryIndex);
-                                      });
+    if (auto const lookup = find(key, sizeClass); lookup.tile)
+        return *lookup.tile;
+
+    Page& page = pageForInsertion(sizeClass);
+    page.lastUsed = ++_useCounter;
+    ++page.inserts;
+    page.evictions += page.full() ? 1 : 0;
+    auto const baseTileIndex = page.baseTileIndex;
+    return page.tileCache->get_or_emplace(
+        key, [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
+            return constructTile(std::move(constructValue), baseTileIndex + entryIndex - 1);
+        });
 }
 
 template <typename Metadata>
-TileAttributes<Metadata> const* TextureAtlas<Metadata>::try_get(crispy::strong_hash const& key)
+TileAttributes<Metadata> const* TextureAtlas<Metadata>::try_get(crispy::strong_hash const& key,
+                                                                TileSizeClass sizeClass)
 {
-    return _tileCache->try_get(key);
+    return find(key, sizeClass).tile;
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
 [[nodiscard]] TileAttributes<Metadata> const* TextureAtlas<Metadata>::get_or_try_emplace(
-    crispy::strong_hash const& key, CreateTileDataFn constructValue)
+    crispy::strong_hash const& key, CreateTileDataFn constructValue, TileSizeClass sizeClass)
 {
-    return _tileCache->get_or_try_emplace(
+    if (auto const lookup = find(key, sizeClass); lookup.tile)
+        return lookup.tile;
+
+    Page& page = pageForInsertion(sizeClass);
+    page.lastUsed = ++_useCounter;
+    auto const evicting = page.full();
+    auto const baseTileIndex = page.baseTileIndex;
+    auto const* result = page.tileCache->get_or_try_emplace(
         key, [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
-            return constructTile(std::move(constructValue), entryIndex);
+            return constructTile(std::move(constructValue), baseTileIndex + entryIndex - 1);
         });
+    if (result)
+    {
+        ++page.inserts;
+        page.evictions += evicting ? 1 : 0;
+    }
+    return result;
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
-void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileDataFn constructValue)
+void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key,
+                                     CreateTileDataFn constructValue,
+                                     TileSizeClass sizeClass)
 {
+    Page* existingPage = find(key, sizeClass).page;
+    Page& page = existingPage ? *existingPage : pageForInsertion(sizeClass);
+    page.lastUsed = ++_useCounter;
+    ++page.inserts;
+    page.evictions += !existingPage && page.full() ? 1 : 0;
+    auto const baseTileIndex = page.baseTileIndex;
+
     // clang-format off
-    _tileCache->emplace(
+    page.tileCache->emplace(
         key,
         [&](uint32_t entryIndex) -> TileAttributes<Metadata>
         {
@@ -614,7 +945,7 @@ void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileD
                 {
                     return { constructValue(location) };
                 },
-                entryIndex
+                baseTileIndex + entryIndex - 1
             ).value();
         }
     );
@@ -624,14 +955,60 @@ void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileD
 template <typename Metadata>
 void TextureAtlas<Metadata>::remove(crispy::strong_hash key)
 {
-    _tileCache->remove(key);
+    for (Page& page: _pages)
+        page.tileCache->remove(key);
+}
+
+template <typename Metadata>
+size_t TextureAtlas<Metadata>::compact()
+{
+    auto released = size_t { 0 };
+
+    for (size_t sizeClassIndex = 0; sizeClassIndex < TileSizeClassCount; ++sizeClassIndex)
+    {
+        auto const sizeClass = static_cast<TileSizeClass>(sizeClassIndex);
+
+        auto pagesOwned = size_t { 0 };
+        auto tilesUsed = size_t { 0 };
+        Page* coldest = nullptr;
+        for (Page& page: _pages)
+        {
+            if (page.sizeClass != sizeClass)
+                continue;
+            ++pagesOwned;
+            tilesUsed += page.tileCache->size();
+            auto const size = page.tileCache->size();
+            if (!coldest || size < coldest->tileCache->size()
+                || (size == coldest->tileCache->size() && page.lastUsed < coldest->lastUsed))
+                coldest = &page;
+        }
+
+        if (pagesOwned < 2)
+            continue;
+
+        // Only release the page if it is sparsely used (below a quarter of its capacity)
+        // and its tiles comfortably fit into the free space of the remaining pages.
+        auto const pageCapacity = coldest->tileCache->capacity();
+        auto const remainingCapacity = (pagesOwned - 1) * pageCapacity;
+        if (coldest->tileCache->size() * 4 < pageCapacity && tilesUsed * 4 <= remainingCapacity * 3)
+        {
+            releasePage(*coldest);
+            ++released;
+        }
+    }
+
+    return released;
 }
 
 template <typename Metadata>
 void TextureAtlas<Metadata>::reset(AtlasProperties atlasProperties)
 {
     _atlasProperties = atlasProperties;
-    _tileCache->clear();
+    for (Page& page: _pages)
+    {
+        page.tileCache->clear();
+        page.sizeClass = std::nullopt;
+    }
 }
 
 template <typename Metadata>
@@ -671,8 +1048,26 @@ void TextureAtlas<Metadata>::inspect(std::ostream& output) const
     output << std::format("atlas size     : {}\n", _atlasSize);
     output << std::format("tile size      : {}\n", _atlasProperties.tileSize);
     output << std::format("direct mapped  : {}\n", _atlasProperties.directMappingCount);
+    output << std::format("pages          : {}\n", _pages.size());
+    output << '\n';
+    for (size_t pageIndex = 0; pageIndex < _pages.size(); ++pageIndex)
+    {
+        Page const& page = _pages[pageIndex];
+        output << std::format("page {:<2} {:<6}: {:>5}/{:<5} tiles ({:>5.1f}%), {} hits, {} inserts, "
+                              "{} evictions, {} releases\n",
+                              pageIndex,
+                              page.sizeClass ? (*page.sizeClass == TileSizeClass::Narrow ? "narrow" : "wide")
+                                             : "free",
+                              page.tileCache->size(),
+                              page.tileCache->capacity(),
+                              100.0 * static_cast<double>(page.tileCache->size())
+                                  / static_cast<double>(page.tileCache->capacity()),
+                              page.hits,
+                              page.inserts,
+                              page.evictions,
+                              page.releases);
+    }
     output << '\n';
-    _tileCache->inspect(output);
 }
 
 // }}}
@@ -720,11 +1115,13 @@ struct std::formatter<vtrasterizer::atlas::AtlasProperties>: std::formatter<std:
 {
     auto format(vtrasterizer::atlas::AtlasProperties const& value, auto& ctx) const
     {
-        return formatter<std::string>::format(std::format("tile size {}, format {}, direct-mapped {}",
-                                                          value.tileSize,
-                                                          value.format,
-                                                          value.directMappingCount),
-                                              ctx);
+        return formatter<std::string>::format(
+            std::format("tile size {}, format {}, direct-mapped {}, pages {}",
+                        value.tileSize,
+                        value.format,
+                        value.directMappingCount,
+                        value.pageCount),
+            ctx);
     }
 };
 // }}}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtrasterizer;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::Width;
+
+namespace
+{
+
+atlas::RenderTile makeRenderTile(int x, int y, ImageSize bitmapSize)
+{
+    auto tile = atlas::RenderTile {};
+    tile.x = atlas::RenderTile::X { x };
+    tile.y = atlas::RenderTile::Y { y };
+    tile.bitmapSize = bitmapSize;
+    tile.color = { 1.0f, 0.5f, 0.0f, 1.0f };
+    tile.tileLocation = atlas::TileLocation { atlas::TileLocation::X { 40 }, atlas::TileLocation::Y { 80 } };
+    tile.fragmentShaderSelector = 3;
+    return tile;
+}
+
+class MockAtlasBackend final: public atlas::AtlasBackend
+{
+  public:
+    ImageSize size {};
+    size_t uploads = 0;
+
+    [[nodiscard]] ImageSize atlasSize() const noexcept override { return size; }
+    void configureAtlas(atlas::ConfigureAtlas atlas) override { size = atlas.size; }
+    void uploadTile(atlas::UploadTile) override { ++uploads; }
+    void renderTile(atlas::RenderTile) override {}
+};
+
+// 16 tiles of 16x16 pixels, partitioned into 2 pages of 7 tiles each.
+atlas::AtlasProperties makePagedAtlasProperties()
+{
+    return atlas::AtlasProperties { .format = atlas::Format::RGBA,
+                                    .tileSize = ImageSize { Width(16), Height(16) },
+                                    .hashCount = crispy::strong_hashtable_size { 16 },
+                                    .tileCount = crispy::lru_capacity { 12 },
+                                    .directMappingCount = 0,
+                                    .pageCount = 2 };
+}
+
+crispy::strong_hash makeKey(uint32_t value)
+{
+    return crispy::strong_hash(0, 0, 0, value);
+}
+
+void insertTile(atlas::TextureAtlas<>& textureAtlas, uint32_t key, atlas::TileSizeClass sizeClass)
+{
+    auto const size = ImageSize { Width(16), Height(16) };
+    auto const* tile = textureAtlas.get_or_try_emplace(
+        makeKey(key),
+        [&](atlas::TileLocation) -> std::optional<atlas::TextureAtlas<>::TileCreateData> {
+            return atlas::TextureAtlas<>::TileCreateData {
+                atlas::Buffer(size.area() * 4), atlas::Format::RGBA, size, std::monostate {}
+            };
+        },
+        sizeClass);
+    REQUIRE(tile != nullptr);
+}
+
+} // namespace
+
+TEST_CASE("TextureAtlas.RenderTileInstance.roundtrip")
+{
+    auto const atlasSize = ImageSize { Width(1024), Height(512) };
+    auto const tile = makeRenderTile(-3, 1200, ImageSize { Width(10), Height(20) });
+
+    auto const instance = atlas::encodeRenderTile(tile);
+    REQUIRE(instance.has_value());
+    CHECK(instance->width() == 10);
+    CHECK(instance->height() == 20);
+    CHECK(instance->fragmentShaderSelector() == 3);
+    CHECK(instance->rgba == std::array<uint8_t, 4> { 0xFF, 0x80, 0x00, 0xFF });
+
+    auto const decoded = atlas::decodeRenderTile(*instance, atlasSize);
+    CHECK(decoded.x.value == -3);
+    CHECK(decoded.y.value == 1200);
+    CHECK(decoded.bitmapSize == tile.bitmapSize);
+    CHECK(decoded.tileLocation.x.value == 40);
+    CHECK(decoded.tileLocation.y.value == 80);
+    CHECK(decoded.fragmentShaderSelector == 3);
+    CHECK(decoded.normalizedLocation.x == 40.0f / 1024.0f);
+    CHECK(decoded.normalizedLocation.height == 20.0f / 512.0f);
+}
+
+TEST_CASE("TextureAtlas.RenderTileInstance.unencodable")
+{
+    // scaled tile
+    auto scaled = makeRenderTile(0, 0, ImageSize { Width(10), Height(20) });
+    scaled.targetSize = ImageSize { Width(20), Height(40) };
+    CHECK(!atlas::encodeRenderTile(scaled).has_value());
+
+    // position out of range
+    auto const farAway = makeRenderTile(40000, 0, ImageSize { Width(10), Height(20) });
+    CHECK(!atlas::encodeRenderTile(farAway).has_value());
+
+    // target size equal to bitmap size is fine
+    auto unscaled = makeRenderTile(0, 0, ImageSize { Width(10), Height(20) });
+    unscaled.targetSize = unscaled.bitmapSize;
+    CHECK(atlas::encodeRenderTile(unscaled).has_value());
+}
+
+TEST_CASE("TextureAtlas.pages.size_class_isolation")
+{
+    auto backend = MockAtlasBackend {};
+    auto textureAtlas = atlas::TextureAtlas<>(backend, makePagedAtlasProperties());
+    REQUIRE(textureAtlas.pageCount() == 2);
+
+    for (uint32_t i = 0; i < 7; ++i)
+        insertTile(textureAtlas, i, atlas::TileSizeClass::Narrow);
+    insertTile(textureAtlas, 100, atlas::TileSizeClass::Wide);
+
+    // The narrow page is full and the other page is owned by wide tiles,
+    // so inserting more narrow tiles must evict narrow tiles only.
+    for (uint32_t i = 7; i < 14; ++i)
+        insertTile(textureAtlas, i, atlas::TileSizeClass::Narrow);
+
+    CHECK(textureAtlas.contains(makeKey(100), atlas::TileSizeClass::Wide));
+    CHECK(!textureAtlas.contains(makeKey(0), atlas::TileSizeClass::Narrow));
+    CHECK(textureAtlas.contains(makeKey(13), atlas::TileSizeClass::Narrow));
+    CHECK(!textureAtlas.contains(makeKey(13), atlas::TileSizeClass::Wide));
+    CHECK(backend.uploads == 15);
+}
+
+TEST_CASE("TextureAtlas.pages.compact")
+{
+    auto backend = MockAtlasBackend {};
+    auto textureAtlas = atlas::TextureAtlas<>(backend, makePagedAtlasProperties());
+
+    // Fill the first page and spill one tile over into the second page.
+    for (uint32_t i = 0; i < 8; ++i)
+        insertTile(textureAtlas, i, atlas::TileSizeClass::Narrow);
+
+    // Both pages are still in use and do not fit into one page.
+    CHECK(textureAtlas.compact() == 0);
+
+    for (uint32_t i = 0; i < 5; ++i)
+        textureAtlas.remove(makeKey(i));
+
+    // Now the sparsely used second page can be released.
+    CHECK(textureAtlas.compact() == 1);
+    CHECK(!textureAtlas.contains(makeKey(7), atlas::TileSizeClass::Narrow));
+    CHECK(textureAtlas.contains(makeKey(6), atlas::TileSizeClass::Narrow));
+
+    // The released page can be claimed by any size class.
+    insertTile(textureAtlas, 100, atlas::TileSizeClass::Wide);
+    CHECK(textureAtlas.contains(makeKey(100), atlas::TileSizeClass::Wide));
+}
@@ -4,6 +4,7 @@
 #include <range/v3/view/iota.hpp>
 
 #include <algorithm> // max?
+#include <array>
 #include <cassert>
 
 namespace vtrasterizer
@@ -17,6 +18,7 @@ vector<uint8_t> downsampleRGBA(vector<uint8_t> const& bitmap,
 {
     assert(size.width >= newSize.width);
     assert(size.height >= newSize.height);
+    assert(numComponents <= 4);
 
     auto const ratioX = unbox<double>(size.width) / unbox<double>(newSize.width);
     auto const ratioY = unbox<double>(size.height) / unbox<double>(newSize.height);
@@ -73,6 +75,7 @@ vector<uint8_t> downsample(vector<uint8_t> const& bitmap,
 {
     assert(size.width >= newSize.width);
     assert(size.height >= newSize.height);
+    assert(numComponents <= 4);
 
     auto const ratioX = unbox<double>(size.width) / unbox<double>(newSize.width);
     auto const ratioY = unbox<double>(size.height) / unbox<double>(newSize.height);
@@ -96,20 +99,19 @@ vector<uint8_t> downsample(vector<uint8_t> const& bitmap,
         for (unsigned j = 0, sc = 0; j < *newSize.width; j++, sc += factor, d += numComponents)
         {
             // calculate area average
-            vector<unsigned> values;
-            values.resize(numComponents);
+            auto values = std::array<unsigned, 4> {};
             unsigned count = 0; // number of pixels being averaged
             for (auto y = sr; y < min(sr + factor, size.height.as<unsigned>()); y++)
             {
                 uint8_t const* p = bitmap.data() + (y * *size.width * numComponents) + (sc * numComponents);
                 for (auto x = sc; x < min(sc + factor, size.width.as<unsigned>()); x++, count++)
                     for (auto const k: ::ranges::views::iota(0u, numComponents))
-                        values.at(k) += *(p++);
+                        values[k] += *(p++);
             }
 
             if (count)
             {
-                for (auto const i: ::ranges::views::iota(0u, values.size()))
+                for (auto const i: ::ranges::views::iota(0u, unsigned(numComponents)))
                     d[i] = static_cast<uint8_t>(values[i] / count);
             }
         }